@@ -80,6 +80,19 @@ function(_gmock_find_library _name)
 endfunction()
 
 
+# GTestConfig.cmake (googletest >= 1.8) already exports the GMock targets.
+# Use them when available, so that headers and libraries always come from
+# the same googletest installation.
+if(TARGET GTest::gmock AND TARGET GTest::gmock_main)
+  set(GMOCK_FOUND TRUE)
+  get_target_property(GMOCK_INCLUDE_DIRS GTest::gmock
+    INTERFACE_INCLUDE_DIRECTORIES)
+  set(GMOCK_LIBRARIES GTest::gmock)
+  set(GMOCK_MAIN_LIBRARIES GTest::gmock_main)
+  set(GMOCK_BOTH_LIBRARIES ${GMOCK_MAIN_LIBRARIES} ${GMOCK_LIBRARIES})
+  return()
+endif()
+
 if(NOT DEFINED GMOCK_MSVC_SEARCH)
   set(GMOCK_MSVC_SEARCH MD)
 endif()
@@ -125,5 +138,5 @@ if(GMOCK_FOUND)
   set(GMOCK_INCLUDE_DIRS ${GMOCK_INCLUDE_DIR})
   _gmock_append_debugs(GMOCK_LIBRARIES      GMOCK_LIBRARY)
   _gmock_append_debugs(GMOCK_MAIN_LIBRARIES GMOCK_MAIN_LIBRARY)
-  set(GMOCK_BOTH_LIBRARIES ${GMOCK_LIBRARIES} ${GMOCK_MAIN_LIBRARIES})
+  set(GMOCK_BOTH_LIBRARIES ${GMOCK_MAIN_LIBRARIES} ${GMOCK_LIBRARIES})
 endif()
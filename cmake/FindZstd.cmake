@@ -0,0 +1,32 @@
+# - Try to find Zstd
+#
+# The following variables are optionally searched for defaults
+#  ZSTD_ROOT:            Base directory where all ZSTD components are found
+#
+# The following are set after configuration is done:
+#  ZSTD_FOUND
+#  ZSTD_INCLUDE_DIRS
+#  ZSTD_LIBRARIES
+
+include(FindPackageHandleStandardArgs)
+
+set(ZSTD_ROOT "" CACHE PATH "Root dir where zstd is installed.")
+
+find_path(ZSTD_INCLUDE_DIR zstd.h
+  HINTS
+  $ENV{ZSTD_ROOT}/include
+  ${ZSTD_ROOT}/include)
+
+find_library(ZSTD_LIBRARY zstd
+  PATHS ${ZSTD_ROOT}
+  PATH_SUFFIXES
+  lib
+  lib64)
+
+find_package_handle_standard_args(ZSTD DEFAULT_MSG
+  ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+
+if(ZSTD_FOUND)
+  set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+  set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+endif()
@@ -17,25 +17,51 @@
 namespace kws {
 namespace core {
 
+// Buffers used by GroupMatchesByQueryGroup. Grouping several times with the
+// same buffers reuses their memory.
+template<typename M>
+struct MatchGroupingBuffers {
+  std::unordered_map<typename M::RefEvent::QType, size_t> group2pos;
+  std::vector<size_t> match_group;
+  std::vector<size_t> group_size;
+};
+
+// The vectors of matches_by_group are reused, so grouping several times into
+// the same output (with the same buffers) does not allocate once they are
+// large enough.
 template<typename M, typename Map>
 void GroupMatchesByQueryGroup(
     const std::vector<M> &matches, const Map &query_to_group,
-    std::vector<std::vector<M>> *matches_by_group) {
-  typedef typename M::RefEvent::QType QType;
-  typedef typename Map::size_type SType;
-  matches_by_group->clear();
-  std::unordered_map<QType, SType> group2pos;
-  for (const auto &m : matches) {
+    std::vector<std::vector<M>> *matches_by_group,
+    MatchGroupingBuffers<M> *buffers = nullptr) {
+  MatchGroupingBuffers<M> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
+  // First, find the group of each match and count the matches of each
+  // group, so that the matches are copied only once to vectors of the
+  // right size.
+  auto &group2pos = buffers->group2pos;
+  auto &match_group = buffers->match_group;
+  auto &group_size = buffers->group_size;
+  group2pos.clear();
+  match_group.resize(matches.size());
+  group_size.clear();
+  for (size_t i = 0; i < matches.size(); ++i) {
+    const auto &m = matches[i];
     const auto &query = m.HasRef() ? m.GetRef().Query() : m.GetHyp().Query();
     auto it = query_to_group.find(query);
     const auto &group = it != query_to_group.end() ? it->second : query;
     const size_t pos = group2pos.emplace(group, group2pos.size()).first->second;
-    if (pos < matches_by_group->size()) {
-      (*matches_by_group)[pos].push_back(m);
-    } else {
-      matches_by_group->emplace_back();
-      matches_by_group->back().push_back(m);
-    }
+    if (pos == group_size.size()) group_size.push_back(0);
+    ++group_size[pos];
+    match_group[i] = pos;
+  }
+  matches_by_group->resize(group_size.size());
+  for (size_t pos = 0; pos < group_size.size(); ++pos) {
+    (*matches_by_group)[pos].clear();
+    (*matches_by_group)[pos].reserve(group_size[pos]);
+  }
+  for (size_t i = 0; i < matches.size(); ++i) {
+    (*matches_by_group)[match_group[i]].push_back(matches[i]);
   }
 }
 
@@ -58,39 +84,61 @@ size_t NumTotalReferences(const Container& match_errors) {
 // fp=1 fn=0 nh=2 nr=1 score=0.9
 // fp=0 fn=2 nh=0 nr=2 score=-inf
 template<typename Container>
-std::vector<MatchErrorCounts> CollapseMatches(const Container &matches) {
-  std::vector<std::pair<MatchErrorCounts, float>> collapsed_matches;
+void CollapseMatches(const Container &matches,
+                     std::vector<MatchErrorCounts> *output) {
+  output->clear();
+  float last_score = 0.0f;
   for (const auto &m : matches) {
     const float score = m.HasHyp()
                         ? m.GetHyp().Score()                         // score of the hypothesis
                         : -std::numeric_limits<float>::infinity();  // false negative
 
-    if (collapsed_matches.size() == 0 ||
-        score != collapsed_matches.back().second) {
-      // hypothesis with new score, add a new pair to the collapsed vector
-      collapsed_matches.emplace_back(
-          std::make_pair(MatchErrorCounts(m.GetError()), score));
+    if (output->empty() || score != last_score) {
+      // hypothesis with new score, add a new point to the collapsed vector
+      output->push_back(MatchErrorCounts(m.GetError()));
+      last_score = score;
     } else {
       // hypothesis with a repeated score, increment the tp, fp and fn rate.
-      collapsed_matches.back().first += m.GetError();
+      output->back() += m.GetError();
     }
   }
+}
+
+template<typename Container>
+std::vector<MatchErrorCounts> CollapseMatches(const Container &matches) {
   std::vector<MatchErrorCounts> output;
-  for (const auto &cm : collapsed_matches) {
-    output.push_back(cm.first);
-  }
+  CollapseMatches(matches, &output);
   return output;
 }
 
 template<typename Container>
-std::vector<MatchError> GetMatchErrors(const Container &matches) {
-  std::vector<MatchError> output;
+void GetMatchErrors(const Container &matches,
+                    std::vector<MatchError> *output) {
+  output->clear();
+  output->reserve(matches.size());
   for (const auto &m : matches) {
-    output.push_back(m.GetError());
+    output->push_back(m.GetError());
   }
+}
+
+template<typename Container>
+std::vector<MatchError> GetMatchErrors(const Container &matches) {
+  std::vector<MatchError> output;
+  GetMatchErrors(matches, &output);
   return output;
 }
 
+// Buffers used to compute the statistics of the matches. Computing the
+// statistics several times with the same buffers (e.g. for each query, or
+// for each bootstrap repetition) reuses their memory.
+template<typename Match>
+struct AssessmentBuffers {
+  std::vector<Match> matches;  // sorted or concatenated matches
+  std::vector<MatchErrorCounts> collapsed_errors;
+  std::vector<MatchError> errors;
+  std::vector<double> pr, rc;
+};
+
 template<typename Container>
 void SortMatchesDecreasingScore(Container *matches) {
   typedef typename Container::value_type Match;
@@ -146,16 +194,20 @@ template<typename Real, typename Match>
 void ComputePrecisionAndRecall(
     const std::vector<Match> &matches,
     bool collapse_matches, bool interpolate_precision,
-    std::vector<Real>* pr, std::vector<Real>* rc) {
+    std::vector<Real>* pr, std::vector<Real>* rc,
+    AssessmentBuffers<Match>* buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
   pr->clear();
   rc->clear();
   if (collapse_matches) {
-    const auto collapsed_errors = CollapseMatches(matches);
+    CollapseMatches(matches, &buffers->collapsed_errors);
     ComputePrecisionAndRecall(
-        collapsed_errors, interpolate_precision, pr, rc);
+        buffers->collapsed_errors, interpolate_precision, pr, rc);
   } else {
-    const auto errors = GetMatchErrors(matches);
-    ComputePrecisionAndRecall(errors, interpolate_precision, pr, rc);
+    GetMatchErrors(matches, &buffers->errors);
+    ComputePrecisionAndRecall(
+        buffers->errors, interpolate_precision, pr, rc);
   }
 }
 
@@ -224,46 +276,70 @@ Real ComputeNDCG(const Container &errors) {
 template<typename Match>
 double ComputeGlobalAP(
     const std::vector<Match> &matches, bool collapse_matches,
-    bool interpolate_precision, bool trapezoid_integral) {
-  std::vector<double> pr, rc;
+    bool interpolate_precision, bool trapezoid_integral,
+    AssessmentBuffers<Match> *buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
   ComputePrecisionAndRecall(
-      matches, collapse_matches, interpolate_precision, &pr, &rc);
-  return ComputeAP(pr, rc, trapezoid_integral);
+      matches, collapse_matches, interpolate_precision,
+      &buffers->pr, &buffers->rc, buffers);
+  return ComputeAP(buffers->pr, buffers->rc, trapezoid_integral);
 }
 
+// Put the matches of all queries into a single vector.
 template<typename Match>
-double ComputeGlobalAP(
+void ConcatenateMatches(
     const std::vector<std::vector<Match>> &matches_by_query,
-    bool collapse_matches, bool interpolate_precision,
-    bool trapezoid_integral, bool sort_matches) {
-  // Put matches per query into a single vector.
-  std::vector<Match> all_matches;
+    std::vector<Match> *all_matches) {
+  size_t num_matches = 0;
   for (const auto &matches_vector : matches_by_query) {
-    for (const auto &match : matches_vector) {
-      all_matches.push_back(match);
-    }
+    num_matches += matches_vector.size();
   }
-  if (sort_matches) { SortMatchesDecreasingScore(&all_matches); }
+  all_matches->clear();
+  all_matches->reserve(num_matches);
+  for (const auto &matches_vector : matches_by_query) {
+    all_matches->insert(all_matches->end(), matches_vector.begin(),
+                        matches_vector.end());
+  }
+}
+
+template<typename Match>
+double ComputeGlobalAP(
+    const std::vector<std::vector<Match>> &matches_by_query,
+    bool collapse_matches, bool interpolate_precision,
+    bool trapezoid_integral, bool sort_matches,
+    AssessmentBuffers<Match> *buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
+  ConcatenateMatches(matches_by_query, &buffers->matches);
+  if (sort_matches) { SortMatchesDecreasingScore(&buffers->matches); }
   // Compute precision and recall curves from the matches
-  std::vector<double> pr, rc;
   ComputePrecisionAndRecall(
-      all_matches, collapse_matches, interpolate_precision, &pr, &rc);
-  return ComputeAP(pr, rc, trapezoid_integral);
+      buffers->matches, collapse_matches, interpolate_precision,
+      &buffers->pr, &buffers->rc, buffers);
+  return ComputeAP(buffers->pr, buffers->rc, trapezoid_integral);
 }
 
 template<typename Match>
 double ComputeMeanAP(
     const std::vector<std::vector<Match>> &matches_by_query,
     bool collapse_matches, bool interpolate_precision,
-    bool trapezoid_integral, bool sort_matches) {
+    bool trapezoid_integral, bool sort_matches,
+    AssessmentBuffers<Match> *buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
   double sumAP = 0.0;
-  for (auto matches_vector : matches_by_query) {
-    if (sort_matches) { SortMatchesDecreasingScore(&matches_vector); }
+  for (const auto &matches_vector : matches_by_query) {
+    if (sort_matches) {
+      buffers->matches.assign(matches_vector.begin(), matches_vector.end());
+      SortMatchesDecreasingScore(&buffers->matches);
+    }
     // Compute precision and recall curves from the matches
-    std::vector<double> pr, rc;
     ComputePrecisionAndRecall(
-        matches_vector, collapse_matches, interpolate_precision, &pr, &rc);
-    sumAP += ComputeAP(pr, rc, trapezoid_integral);
+        sort_matches ? buffers->matches : matches_vector,
+        collapse_matches, interpolate_precision,
+        &buffers->pr, &buffers->rc, buffers);
+    sumAP += ComputeAP(buffers->pr, buffers->rc, trapezoid_integral);
   }
   // Average AP across all queries.
   return matches_by_query.size() > 0 ? sumAP / matches_by_query.size() : 0.0;
@@ -271,45 +347,47 @@ double ComputeMeanAP(
 
 template<typename Match>
 double ComputeGlobalNDCG(
-    const std::vector<Match> &matches, bool collapse_matches) {
+    const std::vector<Match> &matches, bool collapse_matches,
+    AssessmentBuffers<Match> *buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
   if (collapse_matches) {
-    return ComputeNDCG<double>(CollapseMatches(matches));
+    CollapseMatches(matches, &buffers->collapsed_errors);
+    return ComputeNDCG<double>(buffers->collapsed_errors);
   } else {
-    return ComputeNDCG<double>(GetMatchErrors(matches));
+    GetMatchErrors(matches, &buffers->errors);
+    return ComputeNDCG<double>(buffers->errors);
   }
 }
 
 template<typename Match>
 double ComputeGlobalNDCG(
     const std::vector<std::vector<Match>> &matches_by_query,
-    bool collapse_matches, bool sort_matches) {
-  // Put matches per query into a single vector.
-  std::vector<Match> all_matches;
-  for (const auto &matches_vector : matches_by_query) {
-    for (const auto &match : matches_vector) {
-      all_matches.push_back(match);
-    }
-  }
-  if (sort_matches) { SortMatchesDecreasingScore(&all_matches); }
-  if (collapse_matches) {
-    return ComputeNDCG<double>(CollapseMatches(all_matches));
-  } else {
-    return ComputeNDCG<double>(GetMatchErrors(all_matches));
-  }
+    bool collapse_matches, bool sort_matches,
+    AssessmentBuffers<Match> *buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
+  ConcatenateMatches(matches_by_query, &buffers->matches);
+  if (sort_matches) { SortMatchesDecreasingScore(&buffers->matches); }
+  return ComputeGlobalNDCG(buffers->matches, collapse_matches, buffers);
 }
 
 template<typename Match>
 double ComputeMeanNDCG(
     const std::vector<std::vector<Match>> &matches_by_query,
-    bool collapse_matches, bool sort_matches) {
+    bool collapse_matches, bool sort_matches,
+    AssessmentBuffers<Match> *buffers = nullptr) {
+  AssessmentBuffers<Match> local_buffers;
+  if (buffers == nullptr) buffers = &local_buffers;
   double sumNDCG = 0.0;
-  for (auto matches_vector : matches_by_query) {
-    if (sort_matches) { SortMatchesDecreasingScore(&matches_vector); }
-    if (collapse_matches) {
-      sumNDCG += ComputeNDCG<double>(CollapseMatches(matches_vector));
-    } else {
-      sumNDCG += ComputeNDCG<double>(GetMatchErrors(matches_vector));
+  for (const auto &matches_vector : matches_by_query) {
+    if (sort_matches) {
+      buffers->matches.assign(matches_vector.begin(), matches_vector.end());
+      SortMatchesDecreasingScore(&buffers->matches);
     }
+    sumNDCG += ComputeGlobalNDCG(
+        sort_matches ? buffers->matches : matches_vector, collapse_matches,
+        buffers);
   }
   // Average NDCG accross all queries.
   return matches_by_query.size() > 0 ? sumNDCG / matches_by_query.size() : 0.0;
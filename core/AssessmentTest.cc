@@ -1,15 +1,24 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <map>
+#include <vector>
+
 #include "core/Assessment.h"
 #include "core/DummyLocation.h"
 #include "core/Event.h"
+#include "core/IndexedMatch.h"
 #include "core/Match.h"
 #include "core/ScoredEvent.h"
 
 using kws::core::CollapseMatches;
 using kws::core::ComputePrecisionAndRecall;
+using kws::core::ComputeGlobalAP;
+using kws::core::ComputeMeanAP;
+using kws::core::ComputeMeanNDCG;
 using kws::core::Event;
+using kws::core::GroupMatchesByQueryGroup;
+using kws::core::IndexedMatch;
 using kws::core::Match;
 using kws::core::MatchError;
 using kws::core::MatchErrorCounts;
@@ -214,3 +223,97 @@ TEST(AssessmentTest, ComputeNDCG) {
           MatchErrorCounts(3.0, 1.0, 4, 2),
   }));
 }
+
+TEST(AssessmentTest, IndexedMatches) {
+  // Statistics computed from IndexedMatch objects are the same as the ones
+  // computed from Match objects.
+  typedef IndexedMatch<std::vector<RefEvent>, std::vector<HypEvent>>
+      DummyIndexedMatch;
+  const std::vector<RefEvent> refs{RefEvent(1, 1), RefEvent(2, 1),
+                                   RefEvent(1, 2)};
+  const std::vector<HypEvent> hyps{
+    HypEvent(2, 1, 0.9f), HypEvent(1, 3, 0.8f), HypEvent(1, 1, 0.8f),
+    HypEvent(2, 2, 0.2f)};
+  const std::vector<DummyMatch> matches{
+    DummyMatch(refs[1], hyps[0], MatchError(0.0, 0.0)),
+    DummyMatch::MakeFalsePositive(hyps[1]),
+    DummyMatch(refs[0], hyps[2], MatchError(0.2, 0.1)),
+    DummyMatch::MakeFalsePositive(hyps[3]),
+    DummyMatch::MakeFalseNegative(refs[2])};
+  const std::vector<DummyIndexedMatch> indexed_matches{
+    DummyIndexedMatch(&refs, &hyps, 1, 0, MatchError(0.0, 0.0)),
+    DummyIndexedMatch::MakeFalsePositive(&refs, &hyps, 1),
+    DummyIndexedMatch(&refs, &hyps, 0, 2, MatchError(0.2, 0.1)),
+    DummyIndexedMatch::MakeFalsePositive(&refs, &hyps, 3),
+    DummyIndexedMatch::MakeFalseNegative(&refs, &hyps, 2)};
+  EXPECT_EQ(CollapseMatches(matches), CollapseMatches(indexed_matches));
+
+  std::vector<std::vector<DummyMatch>> matches_by_group;
+  std::vector<std::vector<DummyIndexedMatch>> indexed_matches_by_group;
+  const std::map<int, int> query2group;
+  GroupMatchesByQueryGroup(matches, query2group, &matches_by_group);
+  GroupMatchesByQueryGroup(indexed_matches, query2group,
+                           &indexed_matches_by_group);
+  ASSERT_EQ(2, matches_by_group.size());
+  ASSERT_EQ(2, indexed_matches_by_group.size());
+  EXPECT_THAT(indexed_matches_by_group[0], ElementsAre(
+      indexed_matches[0], indexed_matches[3]));
+  EXPECT_THAT(indexed_matches_by_group[1], ElementsAre(
+      indexed_matches[1], indexed_matches[2], indexed_matches[4]));
+
+  EXPECT_DOUBLE_EQ(
+      ComputeGlobalAP(matches_by_group, true, true, false, true),
+      ComputeGlobalAP(indexed_matches_by_group, true, true, false, true));
+  EXPECT_DOUBLE_EQ(
+      ComputeMeanAP(matches_by_group, false, false, true, true),
+      ComputeMeanAP(indexed_matches_by_group, false, false, true, true));
+  EXPECT_DOUBLE_EQ(
+      ComputeMeanNDCG(matches_by_group, true, true),
+      ComputeMeanNDCG(indexed_matches_by_group, true, true));
+}
+
+TEST(AssessmentTest, ReusedBuffers) {
+  // Statistics computed with reused buffers are the same as the ones
+  // computed with fresh buffers, even if the buffers were used with a
+  // different (larger) set of matches before.
+  const std::vector<RefEvent> refs{RefEvent(1, 1), RefEvent(2, 1),
+                                   RefEvent(1, 2)};
+  const std::vector<HypEvent> hyps{
+    HypEvent(2, 1, 0.9f), HypEvent(1, 3, 0.8f), HypEvent(1, 1, 0.8f),
+    HypEvent(2, 2, 0.2f)};
+  const std::vector<DummyMatch> matches{
+    DummyMatch(refs[1], hyps[0], MatchError(0.0, 0.0)),
+    DummyMatch::MakeFalsePositive(hyps[1]),
+    DummyMatch(refs[0], hyps[2], MatchError(0.2, 0.1)),
+    DummyMatch::MakeFalsePositive(hyps[3]),
+    DummyMatch::MakeFalseNegative(refs[2])};
+  const std::vector<DummyMatch> fewer_matches{matches[1], matches[4]};
+  const std::map<int, int> query2group;
+  kws::core::MatchGroupingBuffers<DummyMatch> grouping_buffers;
+  kws::core::AssessmentBuffers<DummyMatch> buffers;
+  std::vector<std::vector<DummyMatch>> matches_by_group;
+  GroupMatchesByQueryGroup(matches, query2group, &matches_by_group,
+                           &grouping_buffers);
+  ComputeMeanAP(matches_by_group, true, true, false, true, &buffers);
+  ComputeGlobalAP(matches_by_group, false, false, false, true, &buffers);
+  ComputeMeanNDCG(matches_by_group, true, true, &buffers);
+
+  std::vector<std::vector<DummyMatch>> expected_by_group;
+  GroupMatchesByQueryGroup(fewer_matches, query2group, &expected_by_group);
+  GroupMatchesByQueryGroup(fewer_matches, query2group, &matches_by_group,
+                           &grouping_buffers);
+  EXPECT_EQ(expected_by_group, matches_by_group);
+  for (bool collapse : {false, true}) {
+    EXPECT_DOUBLE_EQ(
+        ComputeMeanAP(expected_by_group, collapse, true, false, true),
+        ComputeMeanAP(matches_by_group, collapse, true, false, true,
+                      &buffers));
+    EXPECT_DOUBLE_EQ(
+        ComputeGlobalAP(expected_by_group, collapse, true, false, true),
+        ComputeGlobalAP(matches_by_group, collapse, true, false, true,
+                        &buffers));
+    EXPECT_DOUBLE_EQ(
+        ComputeMeanNDCG(expected_by_group, collapse, true),
+        ComputeMeanNDCG(matches_by_group, collapse, true, &buffers));
+  }
+}
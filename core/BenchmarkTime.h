@@ -0,0 +1,27 @@
+#ifndef CORE_BENCHMARKTIME_H_
+#define CORE_BENCHMARKTIME_H_
+
+#include <chrono>
+#include <cstddef>
+
+namespace kws {
+namespace core {
+namespace benchmark {
+
+// Calls f() repeat times, and returns the time of each call in nanoseconds
+// per item, where num_items is the number of items (e.g. events) that each
+// call processes.
+template <typename F>
+double Time(size_t num_items, int repeat, F f) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r) f();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      (static_cast<double>(num_items) * repeat);
+}
+
+}  // namespace benchmark
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_BENCHMARKTIME_H_
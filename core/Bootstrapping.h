@@ -10,10 +10,14 @@
 namespace kws {
 namespace core {
 
-template<typename RefEvent, typename HypEvent>
+// The samplers reuse the memory of the sampled container, thus no memory is
+// allocated when the same container is sampled repeatedly (unless copying a
+// match does; copying an IndexedMatch never does).
+template<typename RefEvent, typename HypEvent,
+         typename M = Match<RefEvent, HypEvent>>
 class MatchesSampler {
  public:
-  typedef std::vector<Match<RefEvent, HypEvent>> Container;
+  typedef std::vector<M> Container;
 
   explicit MatchesSampler(const size_t random_seed)
       : rng_(random_seed) {}
@@ -21,7 +25,8 @@ class MatchesSampler {
   void operator()(const Container &original, Container *sampled) {
     const size_t num_matches = original.size();
     std::uniform_int_distribution <size_t> mdist(0, num_matches - 1);
-    sampled->resize(num_matches);
+    sampled->clear();
+    sampled->reserve(num_matches);
     for (size_t i = 0; i < num_matches; ++i) {
       sampled->push_back(original[mdist(rng_)]);
     }
@@ -31,10 +36,11 @@ class MatchesSampler {
   std::default_random_engine rng_;
 };
 
-template<typename RefEvent, typename HypEvent>
+template<typename RefEvent, typename HypEvent,
+         typename M = Match<RefEvent, HypEvent>>
 class MatchesByQuerySampler {
  public:
-  typedef std::vector<std::vector<Match<RefEvent, HypEvent>>> Container;
+  typedef std::vector<std::vector<M>> Container;
 
   explicit MatchesByQuerySampler(const size_t random_seed)
       : rng_(random_seed) {}
@@ -42,12 +48,13 @@ class MatchesByQuerySampler {
   void operator()(const Container &original, Container *sampled) {
     const size_t num_queries = original.size();
     std::uniform_int_distribution <size_t> qdist(0, num_queries - 1);
-    sampled->clear();
     sampled->resize(num_queries);
     for (size_t i = 0; i < num_queries; ++i) {
       const size_t q = qdist(rng_);
       const size_t num_matches_q = original[q].size();
       std::uniform_int_distribution <size_t> mdist(0, num_matches_q - 1);
+      (*sampled)[i].clear();
+      (*sampled)[i].reserve(num_matches_q);
       for (size_t j = 0; j < num_matches_q; ++j) {
         const auto &m = original[q][mdist(rng_)];
         (*sampled)[i].push_back(m);
@@ -67,9 +74,11 @@ double ComputePercentileBootstrapCI(
   // Compute observed statistic
   const double observed_statistic = statistic(original_samples);
   std::vector<double> statistics_diffs;
+  statistics_diffs.reserve(repetitions);
+  // The memory of the sample is reused across repetitions.
+  Container bootstrapped_sample;
   for (size_t r = 0; r < repetitions; ++r) {
     // Build bootstrapped sample
-    Container bootstrapped_sample;
     (*sampler)(original_samples, &bootstrapped_sample);
     // Compute the statistic for the bootstrapped sample
     const double sample_statistic = statistic(bootstrapped_sample);
@@ -91,7 +100,7 @@ double ComputePercentileBootstrapCI(
     double *lower_bound, double *upper_bound) {
   typedef typename M::RefEvent RefEvent;
   typedef typename M::HypEvent HypEvent;
-  MatchesByQuerySampler<RefEvent, HypEvent> sampler(random_seed);
+  MatchesByQuerySampler<RefEvent, HypEvent, M> sampler(random_seed);
   return ComputePercentileBootstrapCI(grouped_matches, repetitions,
                                       alpha, statistic, &sampler,
                                       lower_bound, upper_bound);
@@ -0,0 +1,71 @@
+#ifndef CORE_BOUNDEDQUEUE_H_
+#define CORE_BOUNDEDQUEUE_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace kws {
+namespace core {
+
+// FIFO queue with a maximum number of elements, used to pass data between
+// producer and consumer threads. Producers block while the queue is full and
+// consumers block while it is empty. Once the queue is closed, no more
+// elements can be pushed, but the remaining ones can still be popped.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(std::max<size_t>(capacity, 1)), closed_(false) {}
+
+  BoundedQueue(const BoundedQueue&) = delete;
+
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Adds an element at the end of the queue, waiting until there is space for
+  // it. Returns false (and the element is discarded) if the queue is closed.
+  bool Push(T value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]{ return closed_ || queue_.size() < capacity_; });
+    if (closed_) return false;
+    queue_.push_back(std::move(value));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Removes the first element of the queue, waiting until there is one.
+  // Returns false if the queue is closed and empty.
+  bool Pop(T* value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]{ return closed_ || !queue_.empty(); });
+    if (queue_.empty()) return false;
+    *value = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  // Closes the queue, waking up all the waiting threads.
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  inline size_t Capacity() const { return capacity_; }
+
+ private:
+  const size_t capacity_;
+  bool closed_;
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_BOUNDEDQUEUE_H_
@@ -0,0 +1,282 @@
+#ifndef CORE_BOXARRAY_H_
+#define CORE_BOXARRAY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KWS_BOXARRAY_X86 1
+#include <immintrin.h>
+#endif
+
+#include "core/BoundingBox.h"
+
+namespace kws {
+namespace core {
+
+namespace internal {
+
+// Vector instructions used to compute the intersection areas of many boxes.
+// The build does not target any particular CPU, thus the instruction set is
+// detected at runtime and the kernels are compiled with the corresponding
+// target attributes.
+enum class SimdLevel { kNone = 0, kSse41 = 1, kAvx2 = 2 };
+
+inline SimdLevel DetectSimdLevel() {
+#ifdef KWS_BOXARRAY_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return SimdLevel::kAvx2;
+  if (__builtin_cpu_supports("sse4.1")) return SimdLevel::kSse41;
+#endif
+  return SimdLevel::kNone;
+}
+
+inline SimdLevel CpuSimdLevel() {
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+// Writes to areas[i] the intersection area of the box (bx1, by1, bx2, by2)
+// with the box (x1[i], y1[i], x2[i], y2[i]), for i in [0, n), exactly as
+// BoundingBox::IntersectionArea() computes it (the box i being *this).
+template <typename T>
+inline void IntersectionAreasScalar(const T* x1, const T* y1, const T* x2,
+                                    const T* y2, size_t n, T bx1, T by1,
+                                    T bx2, T by2, T* areas) {
+  for (size_t i = 0; i < n; ++i) {
+    const T ix1 = std::max<T>(x1[i], bx1);
+    const T ix2 = std::min<T>(x2[i], bx2);
+    const T iy1 = std::max<T>(y1[i], by1);
+    const T iy2 = std::min<T>(y2[i], by2);
+    if (ix1 > ix2 || iy1 > iy2) areas[i] = 0;
+    else areas[i] = (ix2 - ix1) * (iy2 - iy1);
+  }
+}
+
+#ifdef KWS_BOXARRAY_X86
+
+// Unsigned coordinates: (x1 <= x2) is computed as (min(x1, x2) == x1), and
+// the area wraps around as the scalar product of uint32_t does. Returns the
+// number of boxes done, the rest must be done by the caller.
+
+__attribute__((target("sse4.1")))
+inline size_t IntersectionAreasSse41(const uint32_t* x1, const uint32_t* y1,
+                                     const uint32_t* x2, const uint32_t* y2,
+                                     size_t n, uint32_t bx1, uint32_t by1,
+                                     uint32_t bx2, uint32_t by2,
+                                     uint32_t* areas) {
+  const __m128i vbx1 = _mm_set1_epi32(static_cast<int>(bx1));
+  const __m128i vby1 = _mm_set1_epi32(static_cast<int>(by1));
+  const __m128i vbx2 = _mm_set1_epi32(static_cast<int>(bx2));
+  const __m128i vby2 = _mm_set1_epi32(static_cast<int>(by2));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128i ix1 = _mm_max_epu32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x1 + i)), vbx1);
+    const __m128i ix2 = _mm_min_epu32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x2 + i)), vbx2);
+    const __m128i iy1 = _mm_max_epu32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y1 + i)), vby1);
+    const __m128i iy2 = _mm_min_epu32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y2 + i)), vby2);
+    const __m128i valid = _mm_and_si128(
+        _mm_cmpeq_epi32(_mm_min_epu32(ix1, ix2), ix1),
+        _mm_cmpeq_epi32(_mm_min_epu32(iy1, iy2), iy1));
+    const __m128i area = _mm_mullo_epi32(_mm_sub_epi32(ix2, ix1),
+                                         _mm_sub_epi32(iy2, iy1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(areas + i),
+                     _mm_and_si128(area, valid));
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+inline size_t IntersectionAreasAvx2(const uint32_t* x1, const uint32_t* y1,
+                                    const uint32_t* x2, const uint32_t* y2,
+                                    size_t n, uint32_t bx1, uint32_t by1,
+                                    uint32_t bx2, uint32_t by2,
+                                    uint32_t* areas) {
+  const __m256i vbx1 = _mm256_set1_epi32(static_cast<int>(bx1));
+  const __m256i vby1 = _mm256_set1_epi32(static_cast<int>(by1));
+  const __m256i vbx2 = _mm256_set1_epi32(static_cast<int>(bx2));
+  const __m256i vby2 = _mm256_set1_epi32(static_cast<int>(by2));
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i ix1 = _mm256_max_epu32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x1 + i)), vbx1);
+    const __m256i ix2 = _mm256_min_epu32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x2 + i)), vbx2);
+    const __m256i iy1 = _mm256_max_epu32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y1 + i)), vby1);
+    const __m256i iy2 = _mm256_min_epu32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y2 + i)), vby2);
+    const __m256i valid = _mm256_and_si256(
+        _mm256_cmpeq_epi32(_mm256_min_epu32(ix1, ix2), ix1),
+        _mm256_cmpeq_epi32(_mm256_min_epu32(iy1, iy2), iy1));
+    const __m256i area = _mm256_mullo_epi32(_mm256_sub_epi32(ix2, ix1),
+                                            _mm256_sub_epi32(iy2, iy1));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(areas + i),
+                        _mm256_and_si256(area, valid));
+  }
+  return i;
+}
+
+// Float coordinates: the operands of max/min are swapped, and the test is
+// "not greater than", so that the result is the same as the scalar code
+// even for signed zeros and NaNs.
+
+__attribute__((target("sse4.1")))
+inline size_t IntersectionAreasSse41(const float* x1, const float* y1,
+                                     const float* x2, const float* y2,
+                                     size_t n, float bx1, float by1,
+                                     float bx2, float by2, float* areas) {
+  const __m128 vbx1 = _mm_set1_ps(bx1);
+  const __m128 vby1 = _mm_set1_ps(by1);
+  const __m128 vbx2 = _mm_set1_ps(bx2);
+  const __m128 vby2 = _mm_set1_ps(by2);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 ix1 = _mm_max_ps(vbx1, _mm_loadu_ps(x1 + i));
+    const __m128 ix2 = _mm_min_ps(vbx2, _mm_loadu_ps(x2 + i));
+    const __m128 iy1 = _mm_max_ps(vby1, _mm_loadu_ps(y1 + i));
+    const __m128 iy2 = _mm_min_ps(vby2, _mm_loadu_ps(y2 + i));
+    const __m128 valid = _mm_and_ps(_mm_cmpngt_ps(ix1, ix2),
+                                    _mm_cmpngt_ps(iy1, iy2));
+    const __m128 area = _mm_mul_ps(_mm_sub_ps(ix2, ix1),
+                                   _mm_sub_ps(iy2, iy1));
+    _mm_storeu_ps(areas + i, _mm_and_ps(area, valid));
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+inline size_t IntersectionAreasAvx2(const float* x1, const float* y1,
+                                    const float* x2, const float* y2,
+                                    size_t n, float bx1, float by1,
+                                    float bx2, float by2, float* areas) {
+  const __m256 vbx1 = _mm256_set1_ps(bx1);
+  const __m256 vby1 = _mm256_set1_ps(by1);
+  const __m256 vbx2 = _mm256_set1_ps(bx2);
+  const __m256 vby2 = _mm256_set1_ps(by2);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 ix1 = _mm256_max_ps(vbx1, _mm256_loadu_ps(x1 + i));
+    const __m256 ix2 = _mm256_min_ps(vbx2, _mm256_loadu_ps(x2 + i));
+    const __m256 iy1 = _mm256_max_ps(vby1, _mm256_loadu_ps(y1 + i));
+    const __m256 iy2 = _mm256_min_ps(vby2, _mm256_loadu_ps(y2 + i));
+    const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(ix1, ix2, _CMP_NGT_UQ),
+                                       _mm256_cmp_ps(iy1, iy2, _CMP_NGT_UQ));
+    const __m256 area = _mm256_mul_ps(_mm256_sub_ps(ix2, ix1),
+                                      _mm256_sub_ps(iy2, iy1));
+    _mm256_storeu_ps(areas + i, _mm256_and_ps(area, valid));
+  }
+  return i;
+}
+
+#endif  // KWS_BOXARRAY_X86
+
+// Same as IntersectionAreasScalar(), using the vector instructions of the
+// given level (if they are available for T) for most of the boxes.
+template <typename T>
+inline void IntersectionAreas(SimdLevel, const T* x1, const T* y1,
+                              const T* x2, const T* y2, size_t n, T bx1,
+                              T by1, T bx2, T by2, T* areas) {
+  IntersectionAreasScalar(x1, y1, x2, y2, n, bx1, by1, bx2, by2, areas);
+}
+
+#ifdef KWS_BOXARRAY_X86
+
+template <typename T>
+inline void IntersectionAreasSimd(SimdLevel level, const T* x1, const T* y1,
+                                  const T* x2, const T* y2, size_t n, T bx1,
+                                  T by1, T bx2, T by2, T* areas) {
+  size_t i = 0;
+  if (level >= SimdLevel::kAvx2 && n >= 8) {
+    i = IntersectionAreasAvx2(x1, y1, x2, y2, n, bx1, by1, bx2, by2, areas);
+  }
+  // Remaining boxes (at most 7, with AVX2), 4 at a time.
+  if (level >= SimdLevel::kSse41 && n - i >= 4) {
+    i += IntersectionAreasSse41(x1 + i, y1 + i, x2 + i, y2 + i, n - i,
+                                bx1, by1, bx2, by2, areas + i);
+  }
+  IntersectionAreasScalar(x1 + i, y1 + i, x2 + i, y2 + i, n - i,
+                          bx1, by1, bx2, by2, areas + i);
+}
+
+template <>
+inline void IntersectionAreas<uint32_t>(
+    SimdLevel level, const uint32_t* x1, const uint32_t* y1,
+    const uint32_t* x2, const uint32_t* y2, size_t n, uint32_t bx1,
+    uint32_t by1, uint32_t bx2, uint32_t by2, uint32_t* areas) {
+  IntersectionAreasSimd(level, x1, y1, x2, y2, n, bx1, by1, bx2, by2, areas);
+}
+
+template <>
+inline void IntersectionAreas<float>(
+    SimdLevel level, const float* x1, const float* y1, const float* x2,
+    const float* y2, size_t n, float bx1, float by1, float bx2, float by2,
+    float* areas) {
+  IntersectionAreasSimd(level, x1, y1, x2, y2, n, bx1, by1, bx2, by2, areas);
+}
+
+#endif  // KWS_BOXARRAY_X86
+
+}  // namespace internal
+
+// Bounding boxes stored as a structure of arrays (the coordinates of the
+// corners of all the boxes in separate contiguous arrays), so that the
+// intersection of a box with many others is computed with vector
+// instructions: AVX2 or SSE4.1 for uint32_t and float coordinates, and a
+// scalar loop for the other types. The results are exactly the same as
+// BoundingBox::IntersectionArea().
+template <typename T>
+class BoxArray {
+ public:
+  BoxArray() {}
+
+  void Clear() {
+    x1_.clear();
+    y1_.clear();
+    x2_.clear();
+    y2_.clear();
+  }
+
+  void Reserve(size_t n) {
+    x1_.reserve(n);
+    y1_.reserve(n);
+    x2_.reserve(n);
+    y2_.reserve(n);
+  }
+
+  void PushBack(const BoundingBox<T>& box) {
+    x1_.push_back(box.x);
+    y1_.push_back(box.y);
+    x2_.push_back(box.x + box.w);
+    y2_.push_back(box.y + box.h);
+  }
+
+  inline size_t Size() const { return x1_.size(); }
+
+  inline bool Empty() const { return x1_.empty(); }
+
+  // Writes to areas[i - begin] the intersection area of the box i with the
+  // given box, for i in [begin, end), i.e. the same value as
+  // box_i.IntersectionArea(box).
+  void IntersectionAreas(const BoundingBox<T>& box, size_t begin, size_t end,
+                         T* areas) const {
+    internal::IntersectionAreas(
+        internal::CpuSimdLevel(), x1_.data() + begin, y1_.data() + begin,
+        x2_.data() + begin, y2_.data() + begin, end - begin, box.x, box.y,
+        static_cast<T>(box.x + box.w), static_cast<T>(box.y + box.h), areas);
+  }
+
+ private:
+  std::vector<T> x1_, y1_, x2_, y2_;
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_BOXARRAY_H_
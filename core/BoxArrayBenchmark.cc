@@ -0,0 +1,126 @@
+// Compares the time to find the boxes overlapping a given one among the n
+// boxes of a page, computing the intersection areas with BoxArray (with the
+// scalar kernel, and with the vector kernel of this CPU) or searching a
+// PackedRTree. Used to choose the minimum number of events of the (query,
+// document) pairs indexed by the DocumentEventSet.
+//
+// Boxes are the words of a synthetic page (as in DocumentEventSetBenchmark),
+// and the queries are boxes at random positions of the page.
+//
+// Usage: BoxArrayBenchmark [--queries N] [--repeat N]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "core/BenchmarkTime.h"
+#include "core/BoundingBox.h"
+#include "core/BoxArray.h"
+#include "core/PackedRTree.h"
+
+using kws::core::BoundingBox;
+using kws::core::BoxArray;
+using kws::core::PackedRTree;
+using kws::core::benchmark::Time;
+using kws::core::internal::CpuSimdLevel;
+using kws::core::internal::SimdLevel;
+
+typedef BoundingBox<uint32_t> Box;
+
+// Counts the overlapping boxes, and sums their intersection areas, with the
+// kernel of the given level.
+static size_t Scan(SimdLevel level, const std::vector<uint32_t>& x1,
+                   const std::vector<uint32_t>& y1,
+                   const std::vector<uint32_t>& x2,
+                   const std::vector<uint32_t>& y2, const Box& q,
+                   std::vector<uint32_t>* areas) {
+  kws::core::internal::IntersectionAreas(
+      level, x1.data(), y1.data(), x2.data(), y2.data(), x1.size(), q.x, q.y,
+      q.x + q.w, q.y + q.h, areas->data());
+  size_t checksum = 0;
+  for (const uint32_t a : *areas) {
+    if (a > 0) checksum += 1 + a;
+  }
+  return checksum;
+}
+
+int main(int argc, char** argv) {
+  size_t num_queries = 100000;
+  int repeat = 3;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--queries") && i + 1 < argc) {
+      num_queries = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--queries N] [--repeat N]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (num_queries == 0 || repeat < 1) {
+    std::cerr << "ERROR: All the options must be positive!" << std::endl;
+    return 1;
+  }
+
+  std::cout << "SIMD level: " << static_cast<int>(CpuSimdLevel())
+            << " (0 = none, 1 = SSE4.1, 2 = AVX2)" << std::endl;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<uint32_t> width(100, 150), height(30, 40);
+  std::uniform_int_distribution<uint32_t> shift(0, 20), coord(0, 2000);
+  for (size_t n : {4, 8, 16, 32, 64, 128, 256, 1024}) {
+    std::vector<Box> boxes;
+    std::vector<uint32_t> x1, y1, x2, y2;
+    for (size_t w = 0; w < n; ++w) {
+      // Words spread over the page, in lines of 10 words.
+      const size_t s = w * 500 / n;
+      boxes.emplace_back(static_cast<uint32_t>(s % 10) * 160 + shift(rng),
+                         static_cast<uint32_t>(s / 10) * 50 + shift(rng),
+                         width(rng), height(rng));
+      x1.push_back(boxes.back().x);
+      y1.push_back(boxes.back().y);
+      x2.push_back(boxes.back().x + boxes.back().w);
+      y2.push_back(boxes.back().y + boxes.back().h);
+    }
+    std::vector<Box> queries;
+    for (size_t i = 0; i < num_queries; ++i) {
+      queries.emplace_back(coord(rng), coord(rng) * 25 / 20, width(rng),
+                           height(rng));
+    }
+    PackedRTree<uint32_t> tree;
+    tree.Build(boxes);
+    std::vector<uint32_t> areas(n);
+
+    size_t scalar_checksum = 0, simd_checksum = 0, tree_checksum = 0;
+    const double scalar_ns = Time(queries.size(), repeat, [&]() {
+        for (const Box& q : queries) {
+          scalar_checksum += Scan(SimdLevel::kNone, x1, y1, x2, y2, q, &areas);
+        }
+      });
+    const double simd_ns = Time(queries.size(), repeat, [&]() {
+        for (const Box& q : queries) {
+          simd_checksum += Scan(CpuSimdLevel(), x1, y1, x2, y2, q, &areas);
+        }
+      });
+    const double tree_ns = Time(queries.size(), repeat, [&]() {
+        for (const Box& q : queries) {
+          tree.Search(q, [&](uint32_t i) {
+              const uint32_t a = boxes[i].IntersectionArea(q);
+              if (a > 0) tree_checksum += 1 + a;
+            });
+        }
+      });
+    if (scalar_checksum != simd_checksum || scalar_checksum != tree_checksum) {
+      std::cerr << "ERROR: Different overlapping boxes found!" << std::endl;
+      return 1;
+    }
+    std::cout << n << " boxes: scalar = " << scalar_ns
+              << " ns/query, simd = " << simd_ns << " ns/query ("
+              << scalar_ns / simd_ns << "x), rtree = " << tree_ns
+              << " ns/query" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "core/BoundingBox.h"
+#include "core/BoxArray.h"
+
+using kws::core::BoundingBox;
+using kws::core::BoxArray;
+using kws::core::internal::CpuSimdLevel;
+using kws::core::internal::SimdLevel;
+
+// Every kernel available in this CPU (and the default one) gives exactly the
+// same intersection areas as BoundingBox::IntersectionArea(), for any span
+// of the array.
+template <typename T>
+static void ExpectSameAreas(const std::vector<BoundingBox<T>>& boxes,
+                            const std::vector<BoundingBox<T>>& queries) {
+  BoxArray<T> array;
+  for (const BoundingBox<T>& b : boxes) array.PushBack(b);
+  ASSERT_EQ(boxes.size(), array.Size());
+  std::vector<SimdLevel> levels{SimdLevel::kNone};
+  if (CpuSimdLevel() >= SimdLevel::kSse41) levels.push_back(SimdLevel::kSse41);
+  if (CpuSimdLevel() >= SimdLevel::kAvx2) levels.push_back(SimdLevel::kAvx2);
+  std::vector<T> x1, y1, x2, y2;
+  for (const BoundingBox<T>& b : boxes) {
+    x1.push_back(b.x);
+    y1.push_back(b.y);
+    x2.push_back(b.x + b.w);
+    y2.push_back(b.y + b.h);
+  }
+  std::vector<T> areas(boxes.size());
+  for (const BoundingBox<T>& q : queries) {
+    for (size_t begin : {size_t(0), size_t(1), size_t(3)}) {
+      if (begin > boxes.size()) continue;
+      const size_t n = boxes.size() - begin;
+      array.IntersectionAreas(q, begin, boxes.size(), areas.data());
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(boxes[begin + i].IntersectionArea(q), areas[i])
+            << "Box " << boxes[begin + i] << ", query " << q;
+      }
+      for (SimdLevel level : levels) {
+        kws::core::internal::IntersectionAreas(
+            level, x1.data() + begin, y1.data() + begin, x2.data() + begin,
+            y2.data() + begin, n, q.x, q.y, static_cast<T>(q.x + q.w),
+            static_cast<T>(q.y + q.h), areas.data());
+        for (size_t i = 0; i < n; ++i) {
+          ASSERT_EQ(boxes[begin + i].IntersectionArea(q), areas[i])
+              << "Box " << boxes[begin + i] << ", query " << q
+              << ", level " << static_cast<int>(level);
+        }
+      }
+    }
+  }
+}
+
+TEST(BoxArrayTest, Empty) {
+  BoxArray<uint32_t> array;
+  EXPECT_TRUE(array.Empty());
+  array.PushBack(BoundingBox<uint32_t>(1, 2, 3, 4));
+  EXPECT_FALSE(array.Empty());
+  array.Clear();
+  EXPECT_TRUE(array.Empty());
+  ExpectSameAreas<uint32_t>({}, {BoundingBox<uint32_t>(1, 2, 3, 4)});
+}
+
+TEST(BoxArrayTest, Uint32) {
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<uint32_t> coord(0, 100), size(0, 30);
+  std::vector<BoundingBox<uint32_t>> boxes, queries;
+  // Not a multiple of the vector width, to check the remainder.
+  for (int i = 0; i < 203; ++i) {
+    boxes.emplace_back(coord(rng), coord(rng), size(rng), size(rng));
+  }
+  for (int i = 0; i < 50; ++i) {
+    queries.emplace_back(coord(rng), coord(rng), size(rng), size(rng));
+  }
+  // Touching and contained boxes, and coordinates above 2^31 (compared as
+  // unsigned).
+  boxes.emplace_back(10, 10, 5, 5);
+  queries.emplace_back(15, 10, 5, 5);
+  queries.emplace_back(0, 0, 200, 200);
+  boxes.emplace_back(3000000000u, 3000000000u, 10, 10);
+  queries.emplace_back(3000000005u, 2999999990u, 100, 20);
+  ExpectSameAreas(boxes, queries);
+}
+
+TEST(BoxArrayTest, Float) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> coord(-50.0f, 100.0f),
+      size(0.0f, 30.0f);
+  std::vector<BoundingBox<float>> boxes, queries;
+  for (int i = 0; i < 203; ++i) {
+    boxes.emplace_back(coord(rng), coord(rng), size(rng), size(rng));
+  }
+  for (int i = 0; i < 50; ++i) {
+    queries.emplace_back(coord(rng), coord(rng), size(rng), size(rng));
+  }
+  boxes.emplace_back(-0.0f, 0.0f, 1.5f, 2.5f);
+  queries.emplace_back(0.0f, -0.0f, 1.5f, 0.0f);
+  ExpectSameAreas(boxes, queries);
+}
+
+TEST(BoxArrayTest, Int) {
+  // Scalar kernel.
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<int> coord(-50, 100), size(0, 30);
+  std::vector<BoundingBox<int>> boxes, queries;
+  for (int i = 0; i < 37; ++i) {
+    boxes.emplace_back(coord(rng), coord(rng), size(rng), size(rng));
+  }
+  for (int i = 0; i < 20; ++i) {
+    queries.emplace_back(coord(rng), coord(rng), size(rng), size(rng));
+  }
+  ExpectSameAreas(boxes, queries);
+}
@@ -2,100 +2,261 @@
 #define CORE_DOCUMENTBOUNDINGBOXEVENTSET_H
 
 #include <algorithm>
+#include <cstdint>
 #include <list>
-#include <set>
+#include <map>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "core/BoxArray.h"
 #include "core/DocumentBoundingBox.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/EventSet.h"
+#include "core/PackedRTree.h"
 
 namespace kws {
 namespace core {
 
-template <class Q, class T>
-class ShapedEvent;
+namespace internal {
 
-template <class E>
-class EventSet;
-
-// Specialization of the EventSet when the event objects are templated with
-// the DocumentBoundingBox location
-
-template <template <class, class> class E, class Q, typename T>
-class EventSet<E<Q, DocumentBoundingBox<T>>> {
+// Events located in documents, grouped by query and then by document. D is
+// the type used to identify the documents in the locations (LType::document).
+//
+// After the events are inserted, BuildIndex() builds a spatial index (a
+// PackedRTree) of the events of each (query, document) pair, so that
+// FindOverlapping() only computes the intersection with the events close to
+// the given one. Pairs with few events are scanned linearly, computing the
+// intersection with all their boxes at once (see BoxArray), and pairs
+// modified after the index was built are scanned event by event. All give
+// the same result.
+template <class E, class D>
+class DocumentEventSet {
  public:
-  typedef E<Q, DocumentBoundingBox<T>> EventType;
-  typedef Q QType;
-  typedef DocumentBoundingBox<T> LType;
+  typedef E EventType;
+  typedef typename E::QType QType;
+  typedef typename E::LType LType;
   typedef std::list<EventType> EventList;
-  typedef std::set<EventType> EventSetInternal;
+  // Id of each event, see EventSet.
+  typedef std::map<EventType, uint32_t> EventSetInternal;
+  typedef EventOverlap<EventType, typename LType::Type> Overlap;
+  // The overlap of the events found is their intersection area.
+  static const bool kOverlapIsIntersectionArea = true;
 
-  EventSet() : size_(0) {}
+  // Minimum number of events of a (query, document) pair to be indexed.
+  // Scanning fewer boxes with BoxArray is as fast (see BoxArrayBenchmark).
+  static const size_t kMinIndexedSize = 256;
+  // Number of intersection areas computed at once in linear scans.
+  static const size_t kScanChunkSize = 64;
 
-  virtual ~EventSet() {}
+  DocumentEventSet() : size_(0), next_id_(0), spatial_index_(true) {}
+
+  virtual ~DocumentEventSet() {}
 
   template <typename I>
-  EventSet(I begin, I end) {
+  DocumentEventSet(I begin, I end)
+      : size_(0), next_id_(0), spatial_index_(true) {
     for (I it = begin; it != end; ++it) { Insert(*it); }
   }
 
   virtual void Insert(const EventType &event) {
     DocumentToEventsMap &p = documents_by_query_.emplace(
             event.Query(), DocumentToEventsMap()).first->second;
-    EventSetInternal &l = p.emplace(
-            event.Location().document, EventSetInternal()).first->second;
-    if(l.insert(event).second) {
+    Bucket &l = p.emplace(
+            event.Location().document, Bucket()).first->second;
+    if(l.events.emplace(event, next_id_).second) {
+      l.indexed = false;
       ++size_;
+      ++next_id_;
     }
   }
 
   virtual void Clear() {
     documents_by_query_.clear();
     size_ = 0;
+    next_id_ = 0;
   }
 
   virtual void Remove(const EventType &event) {
     auto p = documents_by_query_.find(event.Query());
     if (p != documents_by_query_.end()) {
       auto l = p->second.find(event.Location().document);
-      if (l != p->second.end()) {
-        size_ -= l->second.erase(event);
+      if (l != p->second.end() && l->second.events.erase(event) > 0) {
+        l->second.indexed = false;
+        --size_;
+      }
+    }
+  }
+
+  // Builds the array of boxes of each (query, document) pair modified since
+  // the last call, and the spatial index of those with at least
+  // kMinIndexedSize events, unless it is disabled.
+  virtual void BuildIndex() {
+    std::vector<BoundingBox<typename LType::Type>> boxes;
+    for (auto &p : documents_by_query_) {
+      for (auto &l : p.second) {
+        Bucket &bucket = l.second;
+        if (bucket.indexed) continue;
+        bucket.indexed_events.clear();
+        bucket.boxes.Clear();
+        bucket.boxes.Reserve(bucket.events.size());
+        for (const auto &e : bucket.events) {
+          bucket.indexed_events.push_back(&e);
+          bucket.boxes.PushBack(e.first.Location());
+        }
+        bucket.index.Clear();
+        if (spatial_index_ && bucket.events.size() >= kMinIndexedSize) {
+          boxes.clear();
+          for (const auto &e : bucket.events) {
+            boxes.push_back(e.first.Location());
+          }
+          bucket.index.Build(boxes);
+        }
+        bucket.indexed = true;
+      }
+    }
+  }
+
+  // Enables or disables the spatial index (enabled by default). When it is
+  // disabled, FindOverlapping() always scans all the events of the same
+  // query and document. BuildIndex() must be called again after changing it.
+  void SetSpatialIndex(bool enabled) {
+    if (spatial_index_ == enabled) return;
+    spatial_index_ = enabled;
+    for (auto &p : documents_by_query_) {
+      for (auto &l : p.second) {
+        l.second.index.Clear();
+        l.second.indexed_events.clear();
+        l.second.boxes.Clear();
+        l.second.indexed = false;
       }
     }
   }
 
-  virtual EventList FindOverlapping(const ShapedEvent<QType, LType> &event) const {
-    // Find all events with an intersection area > 0.
-    std::vector<std::pair<typename LType::Type, EventType>> aux;
+  inline bool HasSpatialIndex() const { return spatial_index_; }
+
+  // Finds the events with a positive intersection area with the given one,
+  // sorted by decreasing intersection area, and writes them to the given
+  // buffer (which is cleared first). Each element is the intersection area,
+  // a pointer to the event in the set (which is valid until the set is
+  // modified) and its id. The buffer can be reused in subsequent calls, so
+  // that no memory is allocated.
+  virtual void FindOverlapping(const typename E::BaseEvent &event,
+                               std::vector<Overlap> *overlapping) const {
+    overlapping->clear();
     auto p = documents_by_query_.find(event.Query());
-    if (p != documents_by_query_.end()) {
-      auto l = p->second.find(event.Location().document);
-      if (l != p->second.end()) {
-        for (auto it = l->second.begin(); it != l->second.end(); ++it) {
-          const auto intersection_area =
-              it->Location().IntersectionArea(event.Location());
-          if (intersection_area > 0) {
-            aux.push_back(std::make_pair(intersection_area, *it));
+    if (p == documents_by_query_.end()) return;
+    auto l = p->second.find(event.Location().document);
+    if (l == p->second.end()) return;
+    const Bucket &bucket = l->second;
+    const auto &location = event.Location();
+    auto add = [overlapping, &location](const Entry &e) {
+      const auto intersection_area =
+          e.first.Location().IntersectionArea(location);
+      if (intersection_area > 0) {
+        overlapping->push_back(Overlap{intersection_area, &e.first, e.second});
+      }
+    };
+    if (!bucket.indexed) {
+      for (const Entry &e : bucket.events) add(e);
+    } else if (!bucket.index.empty()) {
+      bucket.index.Search(location, [&bucket, &add](uint32_t i) {
+          add(*bucket.indexed_events[i]);
+        });
+    } else {
+      // Same as add(), but computing the intersection areas of a chunk of
+      // boxes at once.
+      typename LType::Type areas[kScanChunkSize];
+      const size_t n = bucket.boxes.Size();
+      for (size_t begin = 0; begin < n; begin += kScanChunkSize) {
+        const size_t end = std::min<size_t>(n, begin + kScanChunkSize);
+        bucket.boxes.IntersectionAreas(location, begin, end, areas);
+        for (size_t i = begin; i < end; ++i) {
+          if (areas[i - begin] > 0) {
+            const Entry &e = *bucket.indexed_events[i];
+            overlapping->push_back(Overlap{areas[i - begin], &e.first,
+                                           e.second});
           }
         }
       }
     }
-    // Sort the events by decreasing intersection area.
-    std::sort(aux.begin(), aux.end(),
-              std::greater<std::pair<typename LType::Type, EventType>>());
+    // Sort the events by decreasing intersection area (and decreasing
+    // event, if the areas are equal).
+    std::sort(overlapping->begin(), overlapping->end(),
+              [](const Overlap &a, const Overlap &b) {
+                if (a.area != b.area) return a.area > b.area;
+                return *b.event < *a.event;
+              });
+  }
+
+  // Same as above, but returns copies of the overlapping events.
+  EventList FindOverlapping(const typename E::BaseEvent &event) const {
+    std::vector<Overlap> overlapping;
+    FindOverlapping(event, &overlapping);
     EventList result;
-    for (const auto& a : aux) { result.push_back(a.second); }
+    for (const auto& o : overlapping) { result.push_back(*o.event); }
     return result;
   }
 
   virtual size_t Size() const { return size_; }
 
  private:
-  typedef std::unordered_map<std::string, EventSetInternal> DocumentToEventsMap;
+  typedef typename EventSetInternal::value_type Entry;
+
+  // Events of a (query, document) pair.
+  struct Bucket {
+    Bucket() : indexed(false) {}
+
+    EventSetInternal events;
+    // Boxes of the events, the event of each box, and the spatial index of
+    // the boxes (empty if the pair has few events). Only valid if the events
+    // were not modified after building them.
+    BoxArray<typename LType::Type> boxes;
+    std::vector<const Entry*> indexed_events;
+    PackedRTree<typename LType::Type> index;
+    bool indexed;
+  };
+
+  typedef std::unordered_map<D, Bucket> DocumentToEventsMap;
   typedef std::unordered_map<QType, DocumentToEventsMap> QueryToDocumentsMap;
   QueryToDocumentsMap documents_by_query_;
   size_t size_;
+  uint32_t next_id_;
+  bool spatial_index_;
+};
+
+}  // namespace internal
+
+// Specializations of the EventSet when the event objects are templated with
+// the DocumentBoundingBox or the DocumentIdBoundingBox location.
+
+template <template <class, class> class E, class Q, typename T>
+class EventSet<E<Q, DocumentBoundingBox<T>>>
+    : public internal::DocumentEventSet<E<Q, DocumentBoundingBox<T>>,
+                                        std::string> {
+ public:
+  typedef internal::DocumentEventSet<E<Q, DocumentBoundingBox<T>>,
+                                     std::string> Base;
+
+  EventSet() : Base() {}
+
+  template <typename I>
+  EventSet(I begin, I end) : Base(begin, end) {}
+};
+
+template <template <class, class> class E, class Q, typename T>
+class EventSet<E<Q, DocumentIdBoundingBox<T>>>
+    : public internal::DocumentEventSet<E<Q, DocumentIdBoundingBox<T>>,
+                                        uint32_t> {
+ public:
+  typedef internal::DocumentEventSet<E<Q, DocumentIdBoundingBox<T>>,
+                                     uint32_t> Base;
+
+  EventSet() : Base() {}
+
+  template <typename I>
+  EventSet(I begin, I end) : Base(begin, end) {}
 };
 
 }  // namespace core
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <vector>
 
 #include "core/DocumentBoundingBoxEventSet.h"
 #include "core/ShapedEvent.h"
@@ -7,6 +11,8 @@ using kws::core::DocumentBoundingBox;
 using kws::core::EventSet;
 using kws::core::ShapedEvent;
 
+using testing::ElementsAreArray;
+
 typedef ShapedEvent<int, DocumentBoundingBox<int>> DummyDocEvent;
 
 TEST(DocumentBoundingBoxEventSetTest, Tests) {
@@ -50,3 +56,88 @@ TEST(DocumentBoundingBoxEventSetTest, Tests) {
   s.Clear();
   EXPECT_EQ(0, s.Size());
 }
+
+TEST(DocumentBoundingBoxEventSetTest, SpatialIndex) {
+  // Many events of the same query and document, so that they are indexed.
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<int> coord(0, 500), size(5, 50), query(1, 3);
+  auto random_event = [&]() {
+    return DummyDocEvent(
+        query(rng), DocumentBoundingBox<int>(
+            rng() % 2 ? "d1" : "d2", coord(rng), coord(rng), size(rng),
+            size(rng)));
+  };
+  EventSet<DummyDocEvent> indexed, linear;
+  linear.SetSpatialIndex(false);
+  EXPECT_TRUE(indexed.HasSpatialIndex());
+  EXPECT_FALSE(linear.HasSpatialIndex());
+  for (int i = 0; i < 3000; ++i) {
+    const DummyDocEvent e = random_event();
+    indexed.Insert(e);
+    linear.Insert(e);
+  }
+  indexed.BuildIndex();
+  linear.BuildIndex();
+  std::vector<DummyDocEvent> hyps;
+  for (int i = 0; i < 200; ++i) hyps.push_back(random_event());
+  size_t num_found = 0;
+  for (const auto& hyp : hyps) {
+    const auto expected = linear.FindOverlapping(hyp);
+    EXPECT_THAT(indexed.FindOverlapping(hyp), ElementsAreArray(expected));
+    num_found += expected.size();
+  }
+  EXPECT_GT(num_found, 0);
+  // Events inserted and removed after the index was built are also found
+  // (and not found, respectively).
+  for (const auto& hyp : hyps) {
+    indexed.Insert(hyp);
+    linear.Insert(hyp);
+  }
+  for (size_t i = 0; i < hyps.size(); i += 2) {
+    indexed.Remove(hyps[i]);
+    linear.Remove(hyps[i]);
+  }
+  EXPECT_EQ(linear.Size(), indexed.Size());
+  for (const auto& hyp : hyps) {
+    EXPECT_THAT(indexed.FindOverlapping(hyp),
+                ElementsAreArray(linear.FindOverlapping(hyp)));
+  }
+  indexed.BuildIndex();
+  for (const auto& hyp : hyps) {
+    EXPECT_THAT(indexed.FindOverlapping(hyp),
+                ElementsAreArray(linear.FindOverlapping(hyp)));
+  }
+}
+
+TEST(DocumentBoundingBoxEventSetTest, FindOverlappingBuffer) {
+  DummyDocEvent e1(1, DocumentBoundingBox<int>("d1", 0, 0, 10, 10));
+  DummyDocEvent e2(1, DocumentBoundingBox<int>("d1", 5, 5, 10, 10));
+  DummyDocEvent e3(1, DocumentBoundingBox<int>("d2", 0, 0, 10, 10));
+  EventSet<DummyDocEvent> s;
+  s.Insert(e1);
+  s.Insert(e2);
+  s.Insert(e3);
+  std::vector<EventSet<DummyDocEvent>::Overlap> overlapping;
+  s.FindOverlapping(
+      DummyDocEvent(1, DocumentBoundingBox<int>("d1", 6, 6, 10, 10)),
+      &overlapping);
+  ASSERT_EQ(2, overlapping.size());
+  EXPECT_EQ(81, overlapping[0].area);
+  EXPECT_EQ(e2, *overlapping[0].event);
+  EXPECT_EQ(1, overlapping[0].id);
+  EXPECT_EQ(16, overlapping[1].area);
+  EXPECT_EQ(e1, *overlapping[1].event);
+  EXPECT_EQ(0, overlapping[1].id);
+  // The buffer is cleared before adding the overlapping events.
+  s.FindOverlapping(
+      DummyDocEvent(2, DocumentBoundingBox<int>("d1", 6, 6, 10, 10)),
+      &overlapping);
+  EXPECT_TRUE(overlapping.empty());
+  s.FindOverlapping(
+      DummyDocEvent(1, DocumentBoundingBox<int>("d2", 8, 0, 10, 10)),
+      &overlapping);
+  ASSERT_EQ(1, overlapping.size());
+  EXPECT_EQ(20, overlapping[0].area);
+  EXPECT_EQ(e3, *overlapping[0].event);
+  EXPECT_EQ(2, overlapping[0].id);
+}
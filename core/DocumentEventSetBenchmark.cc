@@ -0,0 +1,141 @@
+// Compares the throughput of EventSet::FindOverlapping for events located
+// with a DocumentIdBoundingBox, using the spatial index of each (query,
+// document) pair or scanning all of its events (SetSpatialIndex(false)).
+//
+// References are the words of synthetic pages: each page has a number of
+// lines of words, and a few frequent queries (e.g. "and", "the") appear
+// many times in each page. Hypotheses are references shifted a few pixels,
+// or random boxes.
+//
+// Usage: DocumentEventSetBenchmark [--pages N] [--words N] [--queries N]
+//                                  [--hyps N] [--repeat N]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/BenchmarkTime.h"
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/ShapedEvent.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::DocumentTable;
+using kws::core::EventSet;
+using kws::core::ShapedEvent;
+using kws::core::benchmark::Time;
+
+typedef DocumentIdBoundingBox<uint32_t> Box;
+typedef ShapedEvent<int32_t, Box> BoxEvent;
+
+struct Result {
+  double build_ns;  // Per reference.
+  double find_ns;   // Per hypothesis.
+  size_t checksum;
+};
+
+static Result Run(const std::vector<BoxEvent>& refs,
+                  const std::vector<BoxEvent>& hyps, bool spatial_index,
+                  int repeat) {
+  Result result;
+  EventSet<BoxEvent> set;
+  set.SetSpatialIndex(spatial_index);
+  result.build_ns = Time(refs.size(), repeat, [&]() {
+      set.Clear();
+      for (const BoxEvent& ref : refs) set.Insert(ref);
+      set.BuildIndex();
+    });
+  result.checksum = 0;
+  std::vector<EventSet<BoxEvent>::Overlap> overlapping;
+  result.find_ns = Time(hyps.size(), repeat, [&]() {
+      for (const BoxEvent& hyp : hyps) {
+        set.FindOverlapping(hyp, &overlapping);
+        result.checksum += overlapping.size();
+        if (!overlapping.empty()) {
+          result.checksum += overlapping.front().event->Location().x;
+        }
+      }
+    });
+  return result;
+}
+
+int main(int argc, char** argv) {
+  size_t num_pages = 100, num_words = 500, num_hyps = 200000;
+  int32_t num_queries = 20;
+  int repeat = 3;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--pages") && i + 1 < argc) {
+      num_pages = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--words") && i + 1 < argc) {
+      num_words = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--queries") && i + 1 < argc) {
+      num_queries = std::atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--hyps") && i + 1 < argc) {
+      num_hyps = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--pages N] [--words N] [--queries N] [--hyps N]"
+                << " [--repeat N]" << std::endl;
+      return 1;
+    }
+  }
+  if (num_pages == 0 || num_words == 0 || num_queries < 1 || num_hyps == 0 ||
+      repeat < 1) {
+    std::cerr << "ERROR: All the options must be positive!" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(12345);
+  std::vector<uint32_t> pages;
+  for (size_t p = 0; p < num_pages; ++p) {
+    pages.push_back(DocumentTable::Global().Intern("page" + std::to_string(p)));
+  }
+  // Words of 100-150 x 30-40 pixels, in lines of 10 words.
+  std::uniform_int_distribution<int32_t> query(0, num_queries - 1);
+  std::uniform_int_distribution<uint32_t> width(100, 150), height(30, 40);
+  std::uniform_int_distribution<uint32_t> shift(0, 20), coord(0, 2000);
+  std::vector<BoxEvent> refs;
+  for (const uint32_t page : pages) {
+    for (size_t w = 0; w < num_words; ++w) {
+      const uint32_t x = static_cast<uint32_t>(w % 10) * 160 + shift(rng);
+      const uint32_t y = static_cast<uint32_t>(w / 10) * 50 + shift(rng);
+      refs.emplace_back(query(rng), Box(page, x, y, width(rng), height(rng)));
+    }
+  }
+  std::vector<BoxEvent> hyps;
+  for (size_t i = 0; i < num_hyps; ++i) {
+    if (i % 2 == 0) {
+      BoxEvent hyp = refs[rng() % refs.size()];
+      hyp.Location().x += shift(rng);
+      hyp.Location().y += shift(rng);
+      hyps.push_back(hyp);
+    } else {
+      hyps.emplace_back(query(rng),
+                        Box(pages[rng() % num_pages], coord(rng), coord(rng),
+                            width(rng), height(rng)));
+    }
+  }
+
+  const Result linear = Run(refs, hyps, false, repeat);
+  const Result indexed = Run(refs, hyps, true, repeat);
+  if (linear.checksum != indexed.checksum) {
+    std::cerr << "ERROR: Different overlapping events found!" << std::endl;
+    return 1;
+  }
+  std::cout << refs.size() << " references, " << hyps.size()
+            << " hypotheses, ~" << refs.size() / (num_pages * num_queries)
+            << " references per (query, page)" << std::endl
+            << "  Build: linear = " << linear.build_ns
+            << " ns/ref, indexed = " << indexed.build_ns << " ns/ref"
+            << std::endl
+            << "  Find:  linear = " << linear.find_ns
+            << " ns/hyp, indexed = " << indexed.find_ns << " ns/hyp ("
+            << linear.find_ns / indexed.find_ns << "x)" << std::endl;
+  return 0;
+}
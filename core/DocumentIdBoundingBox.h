@@ -0,0 +1,110 @@
+#ifndef CORE_DOCUMENTIDBOUNDINGBOX_H_
+#define CORE_DOCUMENTIDBOUNDINGBOX_H_
+
+#include <cstdint>
+#include <string>
+
+#include "core/BoundingBox.h"
+#include "core/DocumentTable.h"
+
+namespace kws {
+namespace core {
+
+// Same as DocumentBoundingBox, but the document is identified by its id in
+// the global DocumentTable, instead of its name. Names are translated to
+// ids (and back) only when locations are read (or written), thus checking
+// whether two boxes are in the same document compares two integers.
+//
+// The order of the boxes is the same as with DocumentBoundingBox (i.e.
+// documents are sorted by name), so results do not depend on the order
+// in which documents were interned.
+template <typename T>
+struct DocumentIdBoundingBox : public BoundingBox<T> {
+  uint32_t document;
+
+  // The document of a default-constructed box must be set before its name
+  // is used.
+  DocumentIdBoundingBox() : document(0) {}
+
+  DocumentIdBoundingBox(const std::string& p,
+                        const T& x, const T& y, const T& w, const T& h) :
+      BoundingBox<T>(x, y, w, h),
+      document(DocumentTable::Global().Intern(p)) { }
+
+  DocumentIdBoundingBox(uint32_t p,
+                        const T& x, const T& y, const T& w, const T& h) :
+      BoundingBox<T>(x, y, w, h), document(p) { }
+
+  inline const std::string& DocumentName() const {
+    return DocumentTable::Global().Name(document);
+  }
+
+  inline bool operator==(const DocumentIdBoundingBox& other) const {
+    return document == other.document && BoundingBox<T>::operator==(other);
+  }
+
+  inline bool operator!=(const DocumentIdBoundingBox& other) const {
+    return document != other.document || BoundingBox<T>::operator!=(other);
+  }
+
+  inline bool operator<(const DocumentIdBoundingBox& other) const {
+    if (document != other.document)
+      return DocumentName() < other.DocumentName();
+    return BoundingBox<T>::operator<(other);
+  }
+
+  inline bool operator>(const DocumentIdBoundingBox& other) const {
+    return (other < *this);
+  }
+
+  inline bool operator<=(const DocumentIdBoundingBox& other) const {
+    return !(*this > other);
+  }
+
+  inline bool operator>=(const DocumentIdBoundingBox& other) const {
+    return !(*this < other);
+  }
+
+  inline T IntersectionArea(const DocumentIdBoundingBox& other) const {
+    if (document == other.document)
+      return BoundingBox<T>::IntersectionArea(other);
+    else
+      return 0;
+  }
+
+  inline T UnionArea(const DocumentIdBoundingBox& other) const {
+    return BoundingBox<T>::Area() + other.Area() - IntersectionArea(other);
+  }
+};
+
+template <typename T>
+std::istream& operator>>(std::istream& is, DocumentIdBoundingBox<T>& bb) {
+  std::string document;
+  is >> document >> static_cast<BoundingBox<T>&>(bb);
+  if (is) bb.document = DocumentTable::Global().Intern(document);
+  return is;
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream& os,
+                         const DocumentIdBoundingBox<T>& bb) {
+  os << bb.DocumentName() << " " << static_cast<const BoundingBox<T>&>(bb);
+  return os;
+}
+
+template <typename T>
+inline T IntersectionArea(const DocumentIdBoundingBox<T>& a,
+                          const DocumentIdBoundingBox<T>& b) {
+  return a.IntersectionArea(b);
+}
+
+template <typename T>
+inline T UnionArea(const DocumentIdBoundingBox<T>& a,
+                   const DocumentIdBoundingBox<T>& b) {
+  return a.UnionArea(b);
+}
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_DOCUMENTIDBOUNDINGBOX_H_
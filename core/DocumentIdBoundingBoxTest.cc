@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/DocumentTable.h"
+#include "core/ShapedEvent.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::DocumentTable;
+using kws::core::EventSet;
+using kws::core::ShapedEvent;
+
+TEST(DocumentTableTest, Intern) {
+  DocumentTable table;
+  EXPECT_EQ(0, table.size());
+  EXPECT_EQ(0, table.Intern("doc1"));
+  EXPECT_EQ(1, table.Intern("doc2"));
+  EXPECT_EQ(0, table.Intern("doc1"));
+  EXPECT_EQ(2, table.Intern(""));
+  EXPECT_EQ(3, table.size());
+  EXPECT_EQ("doc1", table.Name(0));
+  EXPECT_EQ("doc2", table.Name(1));
+  EXPECT_EQ("", table.Name(2));
+}
+
+TEST(DocumentTableTest, ManyDocuments) {
+  // Names are stored in several chunks, and their references are stable.
+  DocumentTable table;
+  const std::string& first = table.Name(table.Intern("d0"));
+  for (uint32_t i = 0; i < 10000; ++i) {
+    EXPECT_EQ(i, table.Intern("d" + std::to_string(i)));
+  }
+  for (uint32_t i = 0; i < 10000; ++i) {
+    EXPECT_EQ("d" + std::to_string(i), table.Name(i));
+  }
+  EXPECT_EQ("d0", first);
+}
+
+TEST(DocumentTableTest, Concurrent) {
+  DocumentTable table;
+  const size_t num_threads = 4, num_docs = 1000;
+  std::vector<std::vector<uint32_t>> ids(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&table, &ids, t, num_docs]() {
+        for (size_t i = 0; i < num_docs; ++i) {
+          ids[t].push_back(table.Intern("d" + std::to_string(i)));
+        }
+      });
+  }
+  for (std::thread& th : threads) th.join();
+  EXPECT_EQ(num_docs, table.size());
+  for (size_t t = 0; t < num_threads; ++t) {
+    EXPECT_EQ(ids[0], ids[t]);
+    for (size_t i = 0; i < num_docs; ++i) {
+      EXPECT_EQ("d" + std::to_string(i), table.Name(ids[t][i]));
+    }
+  }
+}
+
+TEST(DocumentIdBoundingBoxTest, Constructor) {
+  DocumentIdBoundingBox<int> b1("doc", 1, 2, 3, 4);
+  EXPECT_EQ(b1.x, 1);
+  EXPECT_EQ(b1.y, 2);
+  EXPECT_EQ(b1.w, 3);
+  EXPECT_EQ(b1.h, 4);
+  EXPECT_EQ("doc", b1.DocumentName());
+  EXPECT_EQ(DocumentTable::Global().Intern("doc"), b1.document);
+
+  DocumentIdBoundingBox<int> b2(b1.document, 1, 2, 3, 4);
+  EXPECT_EQ(b1, b2);
+  EXPECT_EQ("doc", b2.DocumentName());
+  EXPECT_EQ(12, b2.Area());
+}
+
+TEST(DocumentIdBoundingBoxTest, Comparison) {
+  // Documents are sorted by name, regardless of their ids.
+  DocumentIdBoundingBox<int> b4("doc-z", 1, 2, 3, 4);
+  DocumentIdBoundingBox<int> b1("doc-a", 1, 2, 3, 4);
+  DocumentIdBoundingBox<int> b2("doc-a", 1, 2, 3, 5);
+  DocumentIdBoundingBox<int> b3(b2);
+  EXPECT_NE(b1, b2);
+  EXPECT_EQ(b2, b3);
+  EXPECT_LT(b1, b2);
+  EXPECT_GT(b2, b1);
+  EXPECT_LE(b2, b3);
+  EXPECT_GE(b2, b3);
+  EXPECT_NE(b1, b4);
+  EXPECT_LT(b1, b4);
+  EXPECT_GT(b4, b1);
+}
+
+TEST(DocumentIdBoundingBoxTest, Geometry) {
+  DocumentIdBoundingBox<int> b1("doc1", 0, 1, 4, 5);
+  DocumentIdBoundingBox<int> b2("doc1", -1, 0, 3, 4);
+  DocumentIdBoundingBox<int> b3("doc2", 0, 1, 4, 5);  // diff docs
+  EXPECT_EQ(b1.IntersectionArea(b1), b1.Area());
+  EXPECT_EQ(b1.IntersectionArea(b2), 6);
+  EXPECT_EQ(b1.IntersectionArea(b2), kws::core::IntersectionArea(b1, b2));
+  EXPECT_EQ(b1.IntersectionArea(b3), 0);
+  EXPECT_EQ(b1.UnionArea(b2), b1.Area() + b2.Area() - 6);
+  EXPECT_EQ(b1.UnionArea(b2), kws::core::UnionArea(b1, b2));
+  EXPECT_EQ(b1.UnionArea(b3), b1.Area() + b3.Area());
+}
+
+TEST(DocumentIdBoundingBoxTest, Streams) {
+  DocumentIdBoundingBox<int> b1("doc", 1, 2, 3, 4);
+  DocumentIdBoundingBox<int> b2;
+  std::ostringstream oss;
+  oss << b1;
+  EXPECT_EQ(oss.str(), "doc 1 2 3 4");
+  std::istringstream iss("doc 1 2 3 4");
+  iss >> b2;
+  EXPECT_EQ(b1, b2);
+}
+
+TEST(DocumentIdBoundingBoxTest, EventSet) {
+  typedef ShapedEvent<int, DocumentIdBoundingBox<int>> DocEvent;
+  const DocEvent e1(1, DocumentIdBoundingBox<int>("d1", 0, 0, 4, 4));
+  const DocEvent e2(1, DocumentIdBoundingBox<int>("d1", 3, 3, 4, 4));
+  const DocEvent e3(1, DocumentIdBoundingBox<int>("d2", 0, 0, 4, 4));
+  const DocEvent e4(2, DocumentIdBoundingBox<int>("d1", 0, 0, 4, 4));
+  EventSet<DocEvent> s;
+  s.Insert(e1);
+  s.Insert(e2);
+  s.Insert(e3);
+  s.Insert(e4);
+  s.Insert(e1);
+  EXPECT_EQ(4, s.Size());
+  // Only events of the same query and document overlap, sorted by
+  // decreasing intersection area.
+  const DocEvent h(1, DocumentIdBoundingBox<int>("d1", 1, 1, 4, 4));
+  const std::list<DocEvent> overlapping = s.FindOverlapping(h);
+  EXPECT_EQ((std::list<DocEvent>{e1, e2}), overlapping);
+  s.Remove(e1);
+  EXPECT_EQ(3, s.Size());
+  EXPECT_EQ((std::list<DocEvent>{e2}), s.FindOverlapping(h));
+}
@@ -0,0 +1,108 @@
+#ifndef CORE_DOCUMENTTABLE_H_
+#define CORE_DOCUMENTTABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "mapper/StringInternTable.h"
+
+namespace kws {
+namespace core {
+
+// Thread-safe table of document names, which assigns a dense id
+// (0, 1, 2, ...) to each distinct name. Locations store the id of their
+// document (see DocumentIdBoundingBox), so that comparing documents is an
+// integer comparison. Names are only interned when events are read, and
+// only looked up when events are written or documents are ordered.
+//
+// Interning is serialized with a mutex, but looking up the name of an id
+// does not lock: names are stored in chunks of increasing size that are
+// never moved nor freed while the table exists.
+class DocumentTable {
+ public:
+  DocumentTable() {
+    for (size_t k = 0; k < kNumChunks; ++k) chunks_[k] = nullptr;
+  }
+
+  DocumentTable(const DocumentTable&) = delete;
+
+  DocumentTable& operator=(const DocumentTable&) = delete;
+
+  ~DocumentTable() {
+    for (size_t k = 0; k < kNumChunks; ++k) delete [] chunks_[k].load();
+  }
+
+  // Table shared by all document locations.
+  static DocumentTable& Global() {
+    static DocumentTable table;
+    return table;
+  }
+
+  // Returns the id of the document [data, data + size), adding it to the
+  // table if necessary.
+  uint32_t Intern(const char* data, size_t size) {
+    const uint64_t h = mapper::StringInternTable<uint32_t>::Hash(data, size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t id;
+    if (table_.Find(data, size, h, &id)) return id;
+    if (table_.size() >= kMaxSize) {
+      throw std::range_error(
+          "Max number of documents reached (" + std::to_string(kMaxSize) +
+          ")");
+    }
+    size_t k, i;
+    Locate(table_.size(), &k, &i);
+    std::string* chunk = chunks_[k].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      chunk = new std::string[kFirstChunkSize << k];
+      chunks_[k].store(chunk, std::memory_order_release);
+    }
+    chunk[i].assign(data, size);
+    return table_.Insert(data, size, h);
+  }
+
+  uint32_t Intern(const std::string& name) {
+    return Intern(name.data(), name.size());
+  }
+
+  // Returns the name of the document with the given id, which must have
+  // been returned by Intern().
+  inline const std::string& Name(uint32_t id) const {
+    size_t k, i;
+    Locate(id, &k, &i);
+    return chunks_[k].load(std::memory_order_acquire)[i];
+  }
+
+  // Number of documents in the table.
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return table_.size();
+  }
+
+ private:
+  // Chunk k stores the names of kFirstChunkSize * 2^k documents.
+  static const size_t kFirstChunkSize = 1024;
+  static const size_t kNumChunks = 23;
+  static const size_t kMaxSize = std::numeric_limits<uint32_t>::max();
+
+  // Finds the chunk k and the position i in the chunk of the given id.
+  static inline void Locate(size_t id, size_t* k, size_t* i) {
+    const size_t v = id / kFirstChunkSize + 1;
+    *k = 0;
+    while ((v >> (*k + 1)) != 0) ++*k;
+    *i = id - kFirstChunkSize * ((size_t(1) << *k) - 1);
+  }
+
+  mutable std::mutex mutex_;
+  mapper::StringInternTable<uint32_t> table_;
+  std::atomic<std::string*> chunks_[kNumChunks];
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_DOCUMENTTABLE_H_
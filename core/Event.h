@@ -12,6 +12,10 @@ class Event {
  public:
   typedef Q QType;
   typedef L LType;
+  // Common base of the events with the same query and location types. Sets
+  // of references are searched with events of this type, so that any
+  // hypothesis derived from it can be given.
+  typedef Event<Q, L> BaseEvent;
 
   Event() {}
 
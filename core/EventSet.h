@@ -1,10 +1,11 @@
 #ifndef CORE_EVENTSET_H_
 #define CORE_EVENTSET_H_
 
+#include <cstdint>
 #include <list>
-#include <set>
+#include <map>
 #include <string>
-#include <set>
+#include <vector>
 
 namespace kws {
 namespace core {
@@ -15,6 +16,22 @@ class Event;
 template <typename Q, typename L>
 class ShapedEvent;
 
+// Event of an EventSet overlapping a given event (see
+// EventSet::FindOverlapping()). A is the type of the overlap.
+template <class E, typename A>
+struct EventOverlap {
+  A area;          // Overlap between the events.
+  const E* event;  // Event in the set, valid until the set is modified.
+  uint32_t id;     // Id of the event in the set.
+};
+
+// Set of events, which finds the events overlapping a given one.
+//
+// Each distinct event inserted in the set gets an id: 0, 1, 2, ... in the
+// order of insertion since the set was created (or cleared). Repeated
+// insertions of an event do not change its id, and removed ids are not
+// reused. Matchers use these ids to track the references with dense
+// arrays, instead of looking up the events.
 template <class E>
 class EventSet {
  public:
@@ -22,22 +39,29 @@ class EventSet {
   typedef typename E::QType QType;
   typedef typename E::LType LType;
   typedef std::list<E> EventList;
+  typedef EventOverlap<E, size_t> Overlap;
 
-  EventSet() {}
+  // Whether the overlap of the events found by FindOverlapping() is the
+  // intersection area of their locations, which scorers can use instead of
+  // computing it again (see Scorer::ScoreIntersection()).
+  static const bool kOverlapIsIntersectionArea = false;
+
+  EventSet() : next_id_(0) {}
 
   virtual ~EventSet() {}
 
   template <typename I>
-  EventSet(I begin, I end) {
+  EventSet(I begin, I end) : next_id_(0) {
     for (I it = begin; it != end; ++it) { Insert(*it); }
   }
 
   virtual void Insert(const EventType& event) {
-    event_set_.emplace(event);
+    if (event_set_.emplace(event, next_id_).second) ++next_id_;
   }
 
   virtual void Clear() {
     event_set_.clear();
+    next_id_ = 0;
   }
 
   virtual void Remove(const EventType& event) {
@@ -46,14 +70,38 @@ class EventSet {
 
   virtual size_t Size() const { return event_set_.size(); }
 
-  virtual EventList FindOverlapping(const Event<QType, LType>& event) const {
+  // Called once all the events are inserted, before FindOverlapping(), so
+  // that sets can build their search structures (see DocumentEventSet).
+  virtual void BuildIndex() {}
+
+  // Finds the events of the set overlapping the given one, sorted by
+  // decreasing overlap, and writes them to the given buffer (which is
+  // cleared first). The buffer can be reused in subsequent calls, so that
+  // no memory is allocated.
+  //
+  // This set only contains exact matches (with an overlap of 1).
+  virtual void FindOverlapping(const typename E::BaseEvent& event,
+                               std::vector<Overlap>* overlapping) const {
+    overlapping->clear();
     auto it = event_set_.find(event);
-    if (it != event_set_.end()) { return {*it}; }
-    else { return {}; }
+    if (it != event_set_.end()) {
+      overlapping->push_back(Overlap{1, &it->first, it->second});
+    }
+  }
+
+  // Same as above, but returns copies of the overlapping events.
+  EventList FindOverlapping(const typename E::BaseEvent& event) const {
+    std::vector<Overlap> overlapping;
+    FindOverlapping(event, &overlapping);
+    EventList result;
+    for (const Overlap& o : overlapping) { result.push_back(*o.event); }
+    return result;
   }
 
 protected:
-  std::set<E> event_set_;
+  // Id of each event.
+  std::map<E, uint32_t> event_set_;
+  uint32_t next_id_;
 };
 
 
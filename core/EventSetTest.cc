@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <list>
+#include <vector>
+
 #include "core/DummyLocation.h"
 #include "core/EventSet.h"
 #include "core/Event.h"
@@ -48,3 +51,22 @@ TEST(EventSetTest, Tests) {
   s.Clear();
   EXPECT_EQ(0, s.Size());
 }
+
+TEST(EventSetTest, FindOverlapping) {
+  DummyDocEvent e1(1, DummyLocation(1));
+  DummyDocEvent e2(1, DummyLocation(2));
+  EventSet<DummyDocEvent> s;
+  s.Insert(e1);
+  s.Insert(e2);
+  std::vector<EventSet<DummyDocEvent>::Overlap> overlapping;
+  s.FindOverlapping(e2, &overlapping);
+  ASSERT_EQ(1, overlapping.size());
+  EXPECT_EQ(1, overlapping[0].area);
+  EXPECT_EQ(e2, *overlapping[0].event);
+  EXPECT_EQ(1, overlapping[0].id);
+  EXPECT_EQ(std::list<DummyDocEvent>{e2}, s.FindOverlapping(e2));
+  // The buffer is cleared before adding the overlapping events.
+  s.FindOverlapping(DummyDocEvent(2, DummyLocation(1)), &overlapping);
+  EXPECT_TRUE(overlapping.empty());
+  EXPECT_TRUE(s.FindOverlapping(DummyDocEvent(2, DummyLocation(1))).empty());
+}
@@ -0,0 +1,303 @@
+#ifndef CORE_EVENTTABLE_H_
+#define CORE_EVENTTABLE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "core/DocumentIdBoundingBox.h"
+#include "core/PlainScoredEvent.h"
+#include "core/ScoredEvent.h"
+
+namespace kws {
+namespace core {
+
+template <typename Q, typename L>
+class EventRow;
+
+// Columnar (structure of arrays) collection of events located with a
+// DocumentIdBoundingBox<T>, and optionally scored. Each attribute (query,
+// document, x, y, w, h and score) is stored in its own array, so scans over
+// a single attribute (e.g. sorting by score, or selecting the events of a
+// query) only touch the memory of that attribute, and can be vectorized.
+//
+// Rows are accessed through lightweight handles (EventRow), which have the
+// interface of a ShapedEvent (and of a ScoredEvent, if the table is scored),
+// thus they can be matched and scored directly with the usual Matcher,
+// Scorer and EventSet templates, without building event objects.
+template <typename Q, typename T>
+class EventTable {
+ public:
+  typedef Q QType;
+  typedef T Type;
+  typedef DocumentIdBoundingBox<T> LType;
+  typedef EventRow<Q, LType> Row;
+
+  explicit EventTable(bool scored = false) : scored_(scored) {}
+
+  // Builds a table with the given events. The table is scored if the
+  // events are ScoredEvent or PlainScoredEvent.
+  template <typename E>
+  static EventTable FromEvents(const std::vector<E>& events) {
+    float score;
+    EventTable table(!events.empty() && GetScore(events.front(), &score));
+    table.Reserve(events.size());
+    for (const E& e : events) table.Append(e);
+    return table;
+  }
+
+  inline bool HasScores() const { return scored_; }
+
+  inline size_t size() const { return queries_.size(); }
+
+  inline bool empty() const { return queries_.empty(); }
+
+  void Reserve(size_t n) {
+    queries_.reserve(n);
+    documents_.reserve(n);
+    x_.reserve(n); y_.reserve(n); w_.reserve(n); h_.reserve(n);
+    if (scored_) scores_.reserve(n);
+  }
+
+  void Clear() {
+    queries_.clear();
+    documents_.clear();
+    x_.clear(); y_.clear(); w_.clear(); h_.clear();
+    scores_.clear();
+  }
+
+  // Adds a row. The score is ignored if the table is not scored.
+  void Append(const QType& query, uint32_t document,
+              const T& x, const T& y, const T& w, const T& h,
+              float score = 0.0f) {
+    queries_.push_back(query);
+    documents_.push_back(document);
+    x_.push_back(x); y_.push_back(y); w_.push_back(w); h_.push_back(h);
+    if (scored_) scores_.push_back(score);
+  }
+
+  // Adds a row with the query, location and score (if any) of the event.
+  template <typename E>
+  void Append(const E& event) {
+    float score = 0.0f;
+    GetScore(event, &score);
+    const LType& l = event.Location();
+    Append(event.Query(), l.document, l.x, l.y, l.w, l.h, score);
+  }
+
+  // Columns.
+  inline const std::vector<QType>& Queries() const { return queries_; }
+  inline const std::vector<uint32_t>& Documents() const { return documents_; }
+  inline const std::vector<T>& X() const { return x_; }
+  inline const std::vector<T>& Y() const { return y_; }
+  inline const std::vector<T>& W() const { return w_; }
+  inline const std::vector<T>& H() const { return h_; }
+  // Empty if the table is not scored.
+  inline const std::vector<float>& Scores() const { return scores_; }
+
+  inline Row operator[](size_t i) const { return Row(this, i); }
+
+  // Handles to all the rows, in order.
+  std::vector<Row> Rows() const {
+    std::vector<Row> rows;
+    rows.reserve(size());
+    for (size_t i = 0; i < size(); ++i) rows.push_back(Row(this, i));
+    return rows;
+  }
+
+  inline LType Location(size_t i) const {
+    return LType(documents_[i], x_[i], y_[i], w_[i], h_[i]);
+  }
+
+  // Builds an event of type E (e.g. ShapedEvent or ScoredEvent) with the
+  // contents of the row i.
+  template <typename E>
+  E ToEvent(size_t i) const {
+    E event;
+    event.Query() = queries_[i];
+    event.Location() = Location(i);
+    SetScore(i, &event);
+    return event;
+  }
+
+  // Same order as the events: by query, then by location.
+  inline bool Less(size_t i, size_t j) const {
+    if (queries_[i] != queries_[j]) return queries_[i] < queries_[j];
+    return Location(i) < Location(j);
+  }
+
+  inline bool Equal(size_t i, size_t j) const {
+    return queries_[i] == queries_[j] && documents_[i] == documents_[j] &&
+        x_[i] == x_[j] && y_[i] == y_[j] && w_[i] == w_[j] && h_[i] == h_[j];
+  }
+
+  // Returns the rows sorted by score (decreasing or increasing). Rows with
+  // the same score are sorted as the events (by query and location), thus
+  // the order is the same as sorting the ScoredEvents of the table. Only the
+  // score column is read, unless there are ties.
+  std::vector<uint32_t> ScoreOrder(bool descending) const {
+    std::vector<uint32_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+    if (!scored_) return order;
+    const float* s = scores_.data();
+    if (descending) {
+      std::sort(order.begin(), order.end(), [this, s](uint32_t a, uint32_t b) {
+          if (s[a] != s[b]) return s[a] > s[b];
+          return Less(b, a);
+        });
+    } else {
+      std::sort(order.begin(), order.end(), [this, s](uint32_t a, uint32_t b) {
+          if (s[a] != s[b]) return s[a] < s[b];
+          return Less(a, b);
+        });
+    }
+    return order;
+  }
+
+  // Returns the rows with the given query. Only the query column is read.
+  std::vector<uint32_t> RowsWithQuery(const QType& query) const {
+    std::vector<uint32_t> rows;
+    for (size_t i = 0; i < queries_.size(); ++i) {
+      if (queries_[i] == query) rows.push_back(static_cast<uint32_t>(i));
+    }
+    return rows;
+  }
+
+  // Keeps only the given rows, in the given order (e.g. the result of
+  // ScoreOrder() or RowsWithQuery()).
+  void Select(const std::vector<uint32_t>& rows) {
+    SelectColumn(rows, &queries_);
+    SelectColumn(rows, &documents_);
+    SelectColumn(rows, &x_);
+    SelectColumn(rows, &y_);
+    SelectColumn(rows, &w_);
+    SelectColumn(rows, &h_);
+    if (scored_) SelectColumn(rows, &scores_);
+  }
+
+ private:
+  template <typename E>
+  static bool GetScore(const ScoredEvent<E>& event, float* score) {
+    *score = event.Score();
+    return true;
+  }
+
+  template <typename E>
+  static bool GetScore(const PlainScoredEvent<E>& event, float* score) {
+    *score = event.score;
+    return true;
+  }
+
+  template <typename E>
+  static bool GetScore(const E&, float*) { return false; }
+
+  template <typename E>
+  void SetScore(size_t i, ScoredEvent<E>* event) const {
+    event->Score() = scored_ ? scores_[i] : 0.0f;
+  }
+
+  template <typename E>
+  void SetScore(size_t i, PlainScoredEvent<E>* event) const {
+    event->score = scored_ ? scores_[i] : 0.0f;
+  }
+
+  template <typename E>
+  void SetScore(size_t, E*) const {}
+
+  template <typename C>
+  static void SelectColumn(const std::vector<uint32_t>& rows,
+                           std::vector<C>* column) {
+    std::vector<C> selected;
+    selected.reserve(rows.size());
+    for (const uint32_t i : rows) selected.push_back((*column)[i]);
+    column->swap(selected);
+  }
+
+  bool scored_;
+  std::vector<QType> queries_;
+  std::vector<uint32_t> documents_;
+  std::vector<T> x_, y_, w_, h_;
+  std::vector<float> scores_;
+};
+
+// Handle to a row of an EventTable, with the interface of a ShapedEvent
+// (and of a ScoredEvent). Handles are compared by the contents of their
+// rows, like the events. The table must outlive its handles, and must not
+// be modified while they are used.
+template <typename Q, typename L>
+class EventRow {
+ public:
+  typedef typename L::Type Type;
+  typedef EventTable<Q, Type> Table;
+  typedef Q QType;
+  typedef L LType;
+  typedef EventRow<Q, L> BaseEvent;
+
+  EventRow() : table_(nullptr), index_(0) {}
+
+  EventRow(const Table* table, size_t index) :
+      table_(table), index_(static_cast<uint32_t>(index)) {}
+
+  inline const Table* GetTable() const { return table_; }
+
+  inline size_t Index() const { return index_; }
+
+  inline const QType& Query() const { return table_->Queries()[index_]; }
+
+  inline LType Location() const { return table_->Location(index_); }
+
+  inline Type Area() const {
+    return table_->W()[index_] * table_->H()[index_];
+  }
+
+  // 0 if the table is not scored.
+  inline float Score() const {
+    return table_->HasScores() ? table_->Scores()[index_] : 0.0f;
+  }
+
+  inline bool operator==(const EventRow& other) const {
+    return table_ == other.table_
+        ? (index_ == other.index_ || table_->Equal(index_, other.index_))
+        : Query() == other.Query() && Location() == other.Location();
+  }
+
+  inline bool operator!=(const EventRow& other) const {
+    return !(*this == other);
+  }
+
+  inline bool operator<(const EventRow& other) const {
+    if (table_ == other.table_) return table_->Less(index_, other.index_);
+    if (Query() != other.Query()) return Query() < other.Query();
+    return Location() < other.Location();
+  }
+
+  inline bool operator>(const EventRow& other) const {
+    return (other < *this);
+  }
+
+  inline bool operator<=(const EventRow& other) const {
+    return !(*this > other);
+  }
+
+  inline bool operator>=(const EventRow& other) const {
+    return !(*this < other);
+  }
+
+ private:
+  const Table* table_;
+  uint32_t index_;
+};
+
+template <typename Q, typename L>
+std::ostream& operator<<(std::ostream& os, const EventRow<Q, L>& row) {
+  os << row.Query() << " " << row.Location();
+  if (row.GetTable()->HasScores()) os << " " << row.Score();
+  return os;
+}
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_EVENTTABLE_H_
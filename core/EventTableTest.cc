@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/EventTable.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::EventSet;
+using kws::core::EventTable;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+
+typedef DocumentIdBoundingBox<int> Box;
+typedef ShapedEvent<std::string, Box> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+typedef EventTable<std::string, int> Table;
+
+static const std::vector<HypEvent> kHyps{
+  HypEvent("q2", Box("d1", 0, 0, 4, 4), 0.5f),
+  HypEvent("q1", Box("d2", 1, 1, 4, 4), 0.9f),
+  HypEvent("q1", Box("d1", 2, 2, 4, 4), 0.5f),
+  HypEvent("q3", Box("d1", 3, 3, 2, 2), 0.1f),
+  HypEvent("q1", Box("d1", 1, 1, 4, 4), 0.5f)};
+
+TEST(EventTableTest, Columns) {
+  const Table table = Table::FromEvents(kHyps);
+  EXPECT_TRUE(table.HasScores());
+  ASSERT_EQ(5, table.size());
+  EXPECT_EQ((std::vector<std::string>{"q2", "q1", "q1", "q3", "q1"}),
+            table.Queries());
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 1}), table.X());
+  EXPECT_EQ((std::vector<int>{4, 4, 4, 2, 4}), table.W());
+  EXPECT_EQ((std::vector<float>{0.5f, 0.9f, 0.5f, 0.1f, 0.5f}),
+            table.Scores());
+  for (size_t i = 0; i < kHyps.size(); ++i) {
+    EXPECT_EQ(kHyps[i], table.ToEvent<HypEvent>(i));
+    EXPECT_EQ(kHyps[i].Query(), table[i].Query());
+    EXPECT_EQ(kHyps[i].Location(), table[i].Location());
+    EXPECT_EQ(kHyps[i].Area(), table[i].Area());
+    EXPECT_EQ(kHyps[i].Score(), table[i].Score());
+  }
+  // References have no scores.
+  const std::vector<RefEvent> refs(kHyps.begin(), kHyps.end());
+  const Table ref_table = Table::FromEvents(refs);
+  EXPECT_FALSE(ref_table.HasScores());
+  EXPECT_TRUE(ref_table.Scores().empty());
+  EXPECT_EQ(refs[1], ref_table.ToEvent<RefEvent>(1));
+  EXPECT_EQ(0.0f, ref_table[1].Score());
+}
+
+TEST(EventTableTest, ScoreOrder) {
+  // Same order as sorting the events.
+  const Table table = Table::FromEvents(kHyps);
+  for (const bool descending : {true, false}) {
+    std::vector<HypEvent> sorted(kHyps);
+    if (descending) {
+      std::sort(sorted.begin(), sorted.end(), std::greater<HypEvent>());
+    } else {
+      std::sort(sorted.begin(), sorted.end(), std::less<HypEvent>());
+    }
+    Table selected(table);
+    selected.Select(table.ScoreOrder(descending));
+    ASSERT_EQ(sorted.size(), selected.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      EXPECT_EQ(sorted[i], selected.ToEvent<HypEvent>(i));
+    }
+  }
+}
+
+TEST(EventTableTest, RowsWithQuery) {
+  Table table = Table::FromEvents(kHyps);
+  EXPECT_EQ((std::vector<uint32_t>{1, 2, 4}), table.RowsWithQuery("q1"));
+  EXPECT_TRUE(table.RowsWithQuery("q4").empty());
+  table.Select(table.RowsWithQuery("q1"));
+  ASSERT_EQ(3, table.size());
+  EXPECT_EQ(kHyps[4], table.ToEvent<HypEvent>(2));
+}
+
+TEST(EventTableTest, Rows) {
+  const Table table = Table::FromEvents(kHyps);
+  const Table other = Table::FromEvents(kHyps);
+  // Rows are compared by their contents, like the events.
+  EXPECT_EQ(table[1], other[1]);
+  EXPECT_NE(table[1], table[2]);
+  EXPECT_LT(table[4], table[2]);
+  EXPECT_LT(other[4], table[2]);
+  EXPECT_GT(table[0], table[1]);
+  const std::vector<Table::Row> rows = table.Rows();
+  std::set<Table::Row> row_set(rows.begin(), rows.end());
+  // Like references, rows are sorted by query and location.
+  std::set<RefEvent> event_set(kHyps.begin(), kHyps.end());
+  ASSERT_EQ(event_set.size(), row_set.size());
+  auto e = event_set.begin();
+  for (auto r = row_set.begin(); r != row_set.end(); ++r, ++e) {
+    EXPECT_EQ(*e, table.ToEvent<RefEvent>(r->Index()));
+  }
+  std::ostringstream oss;
+  oss << table[1];
+  EXPECT_EQ("q1 d2 1 1 4 4 0.9", oss.str());
+}
+
+TEST(EventTableTest, EventSet) {
+  // Rows can be used as references in the EventSet of documents.
+  const Table table = Table::FromEvents(kHyps);
+  const std::vector<Table::Row> rows = table.Rows();
+  EventSet<Table::Row> set(rows.begin(), rows.end());
+  EXPECT_EQ(5, set.Size());
+  const Table hyps = Table::FromEvents(std::vector<HypEvent>{
+      HypEvent("q1", Box("d1", 2, 2, 2, 2), 0.5f)});
+  const std::list<Table::Row> overlapping = set.FindOverlapping(hyps[0]);
+  ASSERT_EQ(2, overlapping.size());
+  EXPECT_EQ(2, overlapping.front().Index());
+  EXPECT_EQ(4, overlapping.back().Index());
+}
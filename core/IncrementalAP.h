@@ -0,0 +1,127 @@
+#ifndef CORE_INCREMENTALAP_H_
+#define CORE_INCREMENTALAP_H_
+
+#include <cassert>
+#include <cstddef>
+
+#include "core/MatchError.h"
+
+namespace kws {
+namespace core {
+
+// Precision, recall and Average Precision of a ranking that grows one match
+// at a time, in decreasing order of score, updated in O(1) time and space
+// per match. The references that are not matched yet are the false
+// negatives, thus at any point the values are the same as those computed by
+// ComputePrecisionAndRecall() and ComputeAP() (see Assessment.h) with the
+// matches added so far followed by the false negatives.
+//
+// Interpolated precision depends on the matches that come after each point,
+// thus it is not supported: the AP is computed with the plain precision.
+class IncrementalAP {
+ public:
+  explicit IncrementalAP(bool collapse_matches = true,
+                         bool trapezoid_integral = true,
+                         size_t num_references = 0)
+      : collapse_matches_(collapse_matches),
+        trapezoid_integral_(trapezoid_integral),
+        num_references_(num_references) {
+    Clear();
+  }
+
+  // Removes all the matches, keeping the number of references.
+  void Clear() {
+    sum_nh_ = sum_nr_ = 0;
+    sum_fp_ = sum_fn_ = 0.0;
+    sum_ap_ = 0.0;
+    has_point_ = false;
+    has_group_ = false;
+    point_pr_ = point_rc_ = 0.0;
+  }
+
+  void SetNumReferences(size_t num_references) {
+    num_references_ = num_references;
+  }
+
+  inline size_t NumReferences() const { return num_references_; }
+
+  // Adds the errors of the next match of the ranking, whose hypothesis has
+  // the given score, which must not be greater than the score of the
+  // previous match. With collapse_matches, consecutive matches with the same
+  // score are a single point of the precision-recall curve.
+  void Add(float score, const MatchError& error) {
+    assert(!has_group_ || !(score > group_score_));
+    if (has_group_ && (!collapse_matches_ || score != group_score_)) {
+      // The previous point is complete.
+      sum_ap_ += PendingArea();
+      point_pr_ = Precision();
+      point_rc_ = Recall();
+      has_point_ = true;
+    }
+    has_group_ = true;
+    group_score_ = score;
+    sum_nh_ += error.NH();
+    sum_nr_ += error.NR();
+    sum_fp_ += error.FP();
+    sum_fn_ += error.FN();
+  }
+
+  // Number of matched hypotheses (fractional, if the scorer is).
+  inline double TP() const { return sum_nh_ - sum_fp_; }
+
+  inline double FP() const { return sum_fp_; }
+
+  // References not matched yet.
+  inline double FN() const {
+    return num_references_ - (sum_nr_ - sum_fn_);
+  }
+
+  // Precision and recall of the matches so far. As in Assessment.h, they are
+  // 1 if there are no hypotheses (references, respectively).
+  inline double Precision() const {
+    return sum_nh_ > 0 ? 1.0 - sum_fp_ / sum_nh_ : 1.0;
+  }
+
+  inline double Recall() const {
+    return num_references_ > 0
+        ? (sum_nr_ - sum_fn_) / num_references_ : 1.0;
+  }
+
+  // Average Precision of the matches so far (0 if there are no references).
+  inline double AP() const {
+    return num_references_ > 0 ? sum_ap_ + PendingArea() : 0.0;
+  }
+
+ private:
+  // Area under the precision-recall curve between the last complete point
+  // and the current one.
+  inline double PendingArea() const {
+    if (!has_group_) return 0.0;
+    const double pr = Precision();
+    const double rc = Recall();
+    if (!has_point_) return rc * pr;
+    return (rc - point_rc_) * (trapezoid_integral_ ? 0.5 * (pr + point_pr_)
+                                                  : pr);
+  }
+
+  bool collapse_matches_;
+  bool trapezoid_integral_;
+  size_t num_references_;
+  // Sums of the errors of the matches so far.
+  size_t sum_nh_, sum_nr_;
+  double sum_fp_, sum_fn_;
+  // Area under the curve up to the last complete point, and the precision
+  // and recall at that point.
+  double sum_ap_;
+  bool has_point_;
+  double point_pr_, point_rc_;
+  // Whether there are matches after the last complete point, and their
+  // score.
+  bool has_group_;
+  float group_score_;
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_INCREMENTALAP_H_
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "core/Assessment.h"
+#include "core/DummyLocation.h"
+#include "core/Event.h"
+#include "core/IncrementalAP.h"
+#include "core/Match.h"
+#include "core/ScoredEvent.h"
+
+using kws::core::ComputeGlobalAP;
+using kws::core::Event;
+using kws::core::IncrementalAP;
+using kws::core::Match;
+using kws::core::MatchError;
+using kws::core::ScoredEvent;
+using kws::core::testing::DummyLocation;
+
+typedef Event<int, DummyLocation> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+typedef Match<RefEvent, HypEvent> MatchType;
+
+TEST(IncrementalAPTest, Empty) {
+  IncrementalAP ap(true, true, 3);
+  EXPECT_EQ(3, ap.NumReferences());
+  EXPECT_EQ(0.0, ap.TP());
+  EXPECT_EQ(0.0, ap.FP());
+  EXPECT_EQ(3.0, ap.FN());
+  EXPECT_EQ(1.0, ap.Precision());
+  EXPECT_EQ(0.0, ap.Recall());
+  EXPECT_EQ(0.0, ap.AP());
+  // No references.
+  IncrementalAP no_refs;
+  no_refs.Add(0.5f, MatchError(1.0f, 0.0f));
+  EXPECT_EQ(0.0, no_refs.Precision());
+  EXPECT_EQ(1.0, no_refs.Recall());
+  EXPECT_EQ(0.0, no_refs.AP());
+}
+
+TEST(IncrementalAPTest, SameAsAssessment) {
+  // At each point, the AP is the same as the one computed from the matches
+  // so far followed by the remaining false negatives.
+  std::mt19937 rng(12345);
+  const size_t num_refs = 40;
+  for (bool collapse : {false, true}) {
+    for (bool trapezoid : {false, true}) {
+      IncrementalAP ap(collapse, trapezoid, num_refs);
+      std::vector<MatchType> matches;
+      size_t num_tp = 0;
+      // Scores with many ties, in decreasing order.
+      float score = 1.0f;
+      for (int i = 0; i < 100; ++i) {
+        if (rng() % 3 == 0) score -= 0.01f;
+        const bool tp = num_tp < num_refs && rng() % 2 == 0;
+        const HypEvent hyp(1, DummyLocation(), score);
+        if (tp) {
+          matches.emplace_back(RefEvent(1, DummyLocation()), hyp,
+                               MatchError(0.0f, 0.0f));
+          ++num_tp;
+        } else {
+          matches.push_back(MatchType::MakeFalsePositive(hyp));
+        }
+        ap.Add(score, matches.back().GetError());
+
+        std::vector<MatchType> all_matches = matches;
+        for (size_t r = num_tp; r < num_refs; ++r) {
+          all_matches.push_back(
+              MatchType::MakeFalseNegative(RefEvent(1, DummyLocation())));
+        }
+        EXPECT_NEAR(ComputeGlobalAP(all_matches, collapse, false, trapezoid),
+                    ap.AP(), 1e-9)
+            << "After " << i + 1 << " matches, collapse = " << collapse
+            << ", trapezoid = " << trapezoid;
+        EXPECT_EQ(num_tp, ap.TP());
+        EXPECT_EQ(matches.size() - num_tp, ap.FP());
+        EXPECT_EQ(num_refs - num_tp, ap.FN());
+      }
+    }
+  }
+}
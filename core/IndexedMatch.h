@@ -0,0 +1,118 @@
+#ifndef CORE_INDEXEDMATCH_H_
+#define CORE_INDEXEDMATCH_H_
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "core/MatchError.h"
+
+namespace kws {
+namespace core {
+
+// Compact version of Match: instead of copies of the events, it stores the
+// index of the reference and the hypothesis in their containers (e.g. a
+// std::vector of events, or an EventTable), together with the error.
+// Building, copying and sorting these matches never allocates memory, and
+// they have the same interface as Match, thus they can be used with the
+// functions in Assessment.h, the Statistic classes and the bootstrapping
+// samplers.
+//
+// The containers must outlive the matches, and must not be modified while
+// the matches are used.
+template <class RC, class HC>
+class IndexedMatch {
+ public:
+  typedef RC RefContainer;
+  typedef HC HypContainer;
+  typedef typename std::decay<
+    decltype(std::declval<const RC&>()[0])>::type RefEvent;
+  typedef typename std::decay<
+    decltype(std::declval<const HC&>()[0])>::type HypEvent;
+  // Reference to the event in the container (or the row handle, if the
+  // container is an EventTable).
+  typedef decltype(std::declval<const RC&>()[0]) RefType;
+  typedef decltype(std::declval<const HC&>()[0]) HypType;
+
+  // Index of a missing reference or hypothesis.
+  static const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  IndexedMatch() : refs_(nullptr), hyps_(nullptr), ref_(kNone), hyp_(kNone) {}
+
+  IndexedMatch(const RC* refs, const HC* hyps, size_t ref, size_t hyp,
+               const MatchError& error) :
+      refs_(refs), hyps_(hyps),
+      ref_(static_cast<uint32_t>(ref)), hyp_(static_cast<uint32_t>(hyp)),
+      error_(error) {}
+
+  inline bool HasHyp() const { return hyp_ != kNone; }
+
+  inline bool HasRef() const { return ref_ != kNone; }
+
+  inline size_t HypIndex() const { return hyp_; }
+
+  inline size_t RefIndex() const { return ref_; }
+
+  inline const RC* GetRefContainer() const { return refs_; }
+
+  inline const HC* GetHypContainer() const { return hyps_; }
+
+  inline void SetError(const MatchError& error) { error_ = error; }
+
+  inline const MatchError& GetError() const { return error_; }
+
+  inline HypType GetHyp() const {
+    assert(HasHyp());
+    return (*hyps_)[hyp_];
+  }
+
+  inline RefType GetRef() const {
+    assert(HasRef());
+    return (*refs_)[ref_];
+  }
+
+  // Matches are equal if they refer to the same events of the same
+  // containers, and have the same error.
+  bool operator==(const IndexedMatch& other) const {
+    return error_ == other.error_ &&
+        refs_ == other.refs_ && hyps_ == other.hyps_ &&
+        ref_ == other.ref_ && hyp_ == other.hyp_;
+  }
+
+  bool operator!=(const IndexedMatch& other) const {
+    return !(*this == other);
+  }
+
+  static IndexedMatch MakeFalsePositive(const RC* refs, const HC* hyps,
+                                        size_t hyp) {
+    return IndexedMatch(refs, hyps, kNone, hyp, MatchError{1.0f, 0.0f});
+  }
+
+  static IndexedMatch MakeFalseNegative(const RC* refs, const HC* hyps,
+                                        size_t ref) {
+    return IndexedMatch(refs, hyps, ref, kNone, MatchError{0.0f, 1.0f});
+  }
+
+ private:
+  const RC* refs_;
+  const HC* hyps_;
+  uint32_t ref_, hyp_;
+  MatchError error_;
+};
+
+template <class RC, class HC>
+std::ostream& operator<<(std::ostream& oss, const IndexedMatch<RC, HC>& m) {
+  oss << "Match[";
+  if (m.HasHyp()) oss << "Hyp=" << m.GetHyp() << ", ";
+  if (m.HasRef()) oss << "Ref=" << m.GetRef() << ", ";
+  oss << "Error=" << m.GetError() << "]";
+  return oss;
+}
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_INDEXEDMATCH_H_
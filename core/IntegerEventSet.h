@@ -0,0 +1,170 @@
+#ifndef CORE_INTEGEREVENTSET_H_
+#define CORE_INTEGEREVENTSET_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include "core/EventSet.h"
+
+namespace kws {
+namespace core {
+
+// Specialization of the EventSet when the query and the location of the
+// events are 32-bit integers (e.g. after mapping them with a
+// StringEventToIntMapper), which are only matched exactly.
+//
+// The (query, location) pair of each event is packed into a 64-bit key, and
+// the keys are stored in a flat open-addressing hash table (with linear
+// probing), which points to the events, stored contiguously. Thus finding
+// an event costs (on average) a hash and the comparison of a couple of
+// integers in the same cache line, instead of the O(log n) comparisons of
+// the std::set.
+template <template <class, class> class E>
+class EventSet<E<int32_t, int32_t>> {
+ public:
+  typedef E<int32_t, int32_t> EventType;
+  typedef typename EventType::QType QType;
+  typedef typename EventType::LType LType;
+  typedef std::list<EventType> EventList;
+  typedef EventOverlap<EventType, size_t> Overlap;
+
+  // Events are found by exact lookup, with an overlap of 1 (see EventSet).
+  static const bool kOverlapIsIntersectionArea = false;
+
+  EventSet() : bits_(0), next_id_(0) {}
+
+  virtual ~EventSet() {}
+
+  template <typename I>
+  EventSet(I begin, I end) : bits_(0), next_id_(0) {
+    for (I it = begin; it != end; ++it) { Insert(*it); }
+  }
+
+  virtual void Insert(const EventType& event) {
+    const uint64_t key = Key(event.Query(), event.Location());
+    if (FindSlot(key) != kNotFound) return;
+    // Keep the load factor below 1/2.
+    if (2 * (events_.size() + 1) > slots_.size()) Rehash(bits_ + 1);
+    size_t i = Home(key);
+    while (slots_[i].event != kEmpty) i = (i + 1) & Mask();
+    slots_[i].key = key;
+    slots_[i].event = static_cast<uint32_t>(events_.size());
+    events_.push_back(event);
+    ids_.push_back(next_id_++);
+  }
+
+  virtual void Clear() {
+    events_.clear();
+    ids_.clear();
+    next_id_ = 0;
+    for (Slot& s : slots_) s.event = kEmpty;
+  }
+
+  virtual void Remove(const EventType& event) {
+    size_t i = FindSlot(Key(event.Query(), event.Location()));
+    if (i == kNotFound) return;
+    // Move the last event to the position of the removed one.
+    const uint32_t pos = slots_[i].event;
+    if (pos + 1 < events_.size()) {
+      events_[pos] = events_.back();
+      ids_[pos] = ids_.back();
+      slots_[FindSlot(Key(events_[pos].Query(), events_[pos].Location()))]
+          .event = pos;
+    }
+    events_.pop_back();
+    ids_.pop_back();
+    // Shift back the following keys of the same cluster, if the removed
+    // slot is between their home slot and their current slot.
+    for (size_t j = (i + 1) & Mask(); slots_[j].event != kEmpty;
+         j = (j + 1) & Mask()) {
+      const size_t h = Home(slots_[j].key);
+      if (((j - h) & Mask()) >= ((j - i) & Mask())) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].event = kEmpty;
+  }
+
+  virtual size_t Size() const { return events_.size(); }
+
+  virtual void BuildIndex() {}
+
+  // Finds the event equal to the given one (if any), see EventSet. Ids are
+  // assigned as in the EventSet.
+  virtual void FindOverlapping(const typename EventType::BaseEvent& event,
+                               std::vector<Overlap>* overlapping) const {
+    overlapping->clear();
+    const size_t i = FindSlot(Key(event.Query(), event.Location()));
+    if (i != kNotFound) {
+      const uint32_t pos = slots_[i].event;
+      overlapping->push_back(Overlap{1, &events_[pos], ids_[pos]});
+    }
+  }
+
+  // Same as above, but returns copies of the overlapping events.
+  EventList FindOverlapping(const typename EventType::BaseEvent& event) const {
+    std::vector<Overlap> overlapping;
+    FindOverlapping(event, &overlapping);
+    EventList result;
+    for (const Overlap& o : overlapping) { result.push_back(*o.event); }
+    return result;
+  }
+
+ private:
+  static const uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+  static const size_t kNotFound = static_cast<size_t>(-1);
+
+  struct Slot {
+    uint64_t key;
+    uint32_t event;  // Position of the event in events_, or kEmpty.
+  };
+
+  static inline uint64_t Key(int32_t query, int32_t location) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(query)) << 32) |
+        static_cast<uint32_t>(location);
+  }
+
+  inline size_t Mask() const { return slots_.size() - 1; }
+
+  // Fibonacci hashing: the top bits of the key multiplied by 2^64 / phi.
+  inline size_t Home(uint64_t key) const {
+    return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> (64 - bits_));
+  }
+
+  inline size_t FindSlot(uint64_t key) const {
+    if (slots_.empty()) return kNotFound;
+    for (size_t i = Home(key); slots_[i].event != kEmpty;
+         i = (i + 1) & Mask()) {
+      if (slots_[i].key == key) return i;
+    }
+    return kNotFound;
+  }
+
+  // Resizes the table to 2^bits slots.
+  void Rehash(size_t bits) {
+    bits_ = std::max<size_t>(bits, 4);
+    slots_.assign(size_t(1) << bits_, Slot{0, kEmpty});
+    for (size_t e = 0; e < events_.size(); ++e) {
+      const uint64_t key = Key(events_[e].Query(), events_[e].Location());
+      size_t i = Home(key);
+      while (slots_[i].event != kEmpty) i = (i + 1) & Mask();
+      slots_[i].key = key;
+      slots_[i].event = static_cast<uint32_t>(e);
+    }
+  }
+
+  std::vector<EventType> events_;
+  std::vector<uint32_t> ids_;  // Id of each event in events_.
+  std::vector<Slot> slots_;
+  size_t bits_;  // log2(slots_.size()).
+  uint32_t next_id_;
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_INTEGEREVENTSET_H_
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "core/Event.h"
+#include "core/IntegerEventSet.h"
+#include "core/PlainEvent.h"
+#include "core/ScoredEvent.h"
+
+using kws::core::Event;
+using kws::core::EventSet;
+using kws::core::PlainEvent;
+using kws::core::ScoredEvent;
+
+typedef Event<int32_t, int32_t> IntEvent;
+typedef PlainEvent<int32_t, int32_t> PlainIntEvent;
+
+TEST(IntegerEventSetTest, Tests) {
+  IntEvent e1(1, 1);
+  IntEvent e2(1, 2);
+  IntEvent e3(2, 1);
+
+  EventSet<IntEvent> s;
+  EXPECT_EQ(0, s.Size());
+  EXPECT_TRUE(s.FindOverlapping(e1).empty());
+  s.Remove(e1);
+  EXPECT_EQ(0, s.Size());
+  s.Insert(e1);
+  EXPECT_EQ(1, s.Size());
+  // Same query, different location: remove does nothing
+  s.Remove(e2);
+  EXPECT_EQ(1, s.Size());
+  // Add the same event: it's a set, keep only one copy
+  s.Insert(e1);
+  EXPECT_EQ(1, s.Size());
+  s.Insert(e2);
+  s.Insert(e3);
+  EXPECT_EQ(3, s.Size());
+  EXPECT_EQ(std::list<IntEvent>{e2}, s.FindOverlapping(e2));
+  // Scored events are found by their query and location.
+  EXPECT_EQ(std::list<IntEvent>{e3},
+            s.FindOverlapping(ScoredEvent<IntEvent>(2, 1, 0.5f)));
+  EXPECT_TRUE(s.FindOverlapping(IntEvent(2, 2)).empty());
+  s.Remove(e1);
+  EXPECT_EQ(2, s.Size());
+  EXPECT_TRUE(s.FindOverlapping(e1).empty());
+  EXPECT_EQ(std::list<IntEvent>{e2}, s.FindOverlapping(e2));
+  EXPECT_EQ(std::list<IntEvent>{e3}, s.FindOverlapping(e3));
+  s.Clear();
+  EXPECT_EQ(0, s.Size());
+  EXPECT_TRUE(s.FindOverlapping(e2).empty());
+  s.Insert(e2);
+  EXPECT_EQ(std::list<IntEvent>{e2}, s.FindOverlapping(e2));
+}
+
+TEST(IntegerEventSetTest, NegativeValues) {
+  // Negative queries and locations do not collide with the positive ones.
+  EventSet<PlainIntEvent> s;
+  s.Insert(PlainIntEvent(-1, 1));
+  s.Insert(PlainIntEvent(1, -1));
+  s.Insert(PlainIntEvent(-1, -1));
+  EXPECT_EQ(3, s.Size());
+  EXPECT_TRUE(s.FindOverlapping(PlainIntEvent(1, 1)).empty());
+  EXPECT_EQ(std::list<PlainIntEvent>{PlainIntEvent(-1, -1)},
+            s.FindOverlapping(PlainIntEvent(-1, -1)));
+}
+
+TEST(IntegerEventSetTest, RandomOperations) {
+  // The set behaves as a std::set of the events, after many insertions and
+  // removals (with collisions and growth of the hash table), and the events
+  // keep the id given when they were inserted.
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<int32_t> value(-50, 50);
+  EventSet<PlainIntEvent> s;
+  std::map<PlainIntEvent, uint32_t> expected;
+  uint32_t next_id = 0;
+  std::vector<EventSet<PlainIntEvent>::Overlap> overlapping;
+  for (int i = 0; i < 20000; ++i) {
+    const PlainIntEvent e(value(rng), value(rng));
+    if (rng() % 3 == 0) {
+      s.Remove(e);
+      expected.erase(e);
+    } else {
+      s.Insert(e);
+      if (expected.emplace(e, next_id).second) ++next_id;
+    }
+    ASSERT_EQ(expected.size(), s.Size());
+    const PlainIntEvent f(value(rng), value(rng));
+    s.FindOverlapping(f, &overlapping);
+    ASSERT_EQ(expected.count(f), overlapping.size());
+    if (!overlapping.empty()) {
+      EXPECT_EQ(f, *overlapping[0].event);
+      EXPECT_EQ(expected[f], overlapping[0].id);
+    }
+  }
+  for (const auto& e : expected) {
+    s.FindOverlapping(e.first, &overlapping);
+    ASSERT_EQ(1, overlapping.size());
+    EXPECT_EQ(e.first, *overlapping[0].event);
+    EXPECT_EQ(e.second, overlapping[0].id);
+  }
+}
@@ -2,68 +2,69 @@
 #define CORE_MATCH_H_
 
 #include <cassert>
-#include <memory>
+#include <utility>
 
 #include "core/MatchError.h"
 
 namespace kws {
 namespace core {
 
+// Match between a reference and a hypothesis, or a false positive (only the
+// hypothesis) or a false negative (only the reference). The events are
+// stored by value, so that matches can be copied, moved and sorted without
+// allocating memory (unless copying the events does). See IndexedMatch for
+// a more compact representation.
 template <class RE, class HE>
 class Match {
  public:
   typedef RE RefEvent;
   typedef HE HypEvent;
 
-  Match() {}
+  Match() : has_ref_(false), has_hyp_(false) {}
 
-  Match(const Match& other) : error_(other.error_) {
-    if (other.HasRef()) SetRef(other.GetRef());
-    if (other.HasHyp()) SetHyp(other.GetHyp());
-  }
-
-  Match(float fp, float fn) : error_(fp, fn) {}
+  Match(float fp, float fn) :
+      has_ref_(false), has_hyp_(false), error_(fp, fn) {}
 
   Match(const RefEvent& ref, const HypEvent& hyp, const MatchError& error) :
-      error_(error) {
-    ref_.reset(new RefEvent(ref));
-    hyp_.reset(new HypEvent(hyp));
-  }
+      ref_(ref), hyp_(hyp), has_ref_(true), has_hyp_(true), error_(error) {}
+
+  Match(const Match& other) = default;
+
+  Match(Match&& other) :
+      ref_(std::move(other.ref_)), hyp_(std::move(other.hyp_)),
+      has_ref_(other.has_ref_), has_hyp_(other.has_hyp_),
+      error_(other.error_) {}
 
-  inline bool HasHyp() const { return hyp_ != nullptr; }
+  inline bool HasHyp() const { return has_hyp_; }
 
-  inline bool HasRef() const { return ref_ != nullptr; }
+  inline bool HasRef() const { return has_ref_; }
 
   inline void SetError(const MatchError& error) { error_ = error; }
 
-  inline void SetHyp(const HypEvent& hyp) { hyp_.reset(new HypEvent(hyp)); }
+  inline void SetHyp(const HypEvent& hyp) { hyp_ = hyp; has_hyp_ = true; }
 
-  inline void SetRef(const RefEvent& ref) { ref_.reset(new RefEvent(ref)); }
+  inline void SetRef(const RefEvent& ref) { ref_ = ref; has_ref_ = true; }
 
   inline const MatchError& GetError() const { return error_; }
 
   inline const HypEvent& GetHyp() const {
-    assert(hyp_ != nullptr);
-    return *hyp_;
+    assert(has_hyp_);
+    return hyp_;
   }
 
   inline const RefEvent& GetRef() const {
-    assert(ref_ != nullptr);
-    return *ref_;
+    assert(has_ref_);
+    return ref_;
   }
 
-  Match& operator=(const Match& other) {
-    error_ = other.error_;
-    ref_.release(); hyp_.release();
-    if (other.HasRef()) SetRef(other.GetRef());
-    if (other.HasHyp()) SetHyp(other.GetHyp());
-    return *this;
-  }
+  Match& operator=(const Match& other) = default;
 
   Match& operator=(Match&& other) {
-    error_ = std::move(other.error_);
     ref_ = std::move(other.ref_);
     hyp_ = std::move(other.hyp_);
+    has_ref_ = other.has_ref_;
+    has_hyp_ = other.has_hyp_;
+    error_ = other.error_;
     return *this;
   }
 
@@ -76,7 +77,7 @@ class Match {
   }
 
   bool operator!=(const Match& other) const {
-    return !(*this != other);
+    return !(*this == other);
   }
 
   static Match<RE, HE> MakeFalsePositive(const HE& hyp) {
@@ -94,8 +95,9 @@ class Match {
   };
 
  private:
-  std::unique_ptr<RE> ref_;
-  std::unique_ptr<HE> hyp_;
+  RE ref_;
+  HE hyp_;
+  bool has_ref_, has_hyp_;
   MatchError error_;
 };
 
@@ -0,0 +1,159 @@
+#ifndef CORE_PACKEDRTREE_H_
+#define CORE_PACKEDRTREE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "core/BoundingBox.h"
+
+namespace kws {
+namespace core {
+
+// Static R-tree of bounding boxes, built at once with the Sort-Tile-Recursive
+// packing: boxes are sorted by the x coordinate of their center, split into
+// vertical slices, sorted by the y coordinate within each slice, and grouped
+// into leaves of kNodeSize boxes. The leaves are packed in the same way to
+// build the upper levels, until a single root remains. All nodes are full
+// (except the last one of each level), and are stored contiguously.
+//
+// The tree cannot be modified after it is built: Build() must be called
+// again to add or remove boxes.
+template <typename T>
+class PackedRTree {
+ public:
+  static const size_t kNodeSize = 8;
+
+  PackedRTree() {}
+
+  // Builds the tree with the given boxes, replacing the previous ones.
+  void Build(const std::vector<BoundingBox<T>>& boxes) {
+    items_.clear();
+    levels_.clear();
+    items_.reserve(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      const BoundingBox<T>& b = boxes[i];
+      const Rect r{b.x, b.y, static_cast<T>(b.x + b.w),
+                   static_cast<T>(b.y + b.h)};
+      items_.push_back(Item{r, static_cast<uint32_t>(i)});
+    }
+    if (items_.empty()) return;
+    SortTileRecursive(&items_);
+    std::vector<Node> level = Pack(items_);
+    while (level.size() > 1) {
+      SortTileRecursive(&level);
+      levels_.push_back(std::move(level));
+      level = Pack(levels_.back());
+    }
+    levels_.push_back(std::move(level));
+  }
+
+  void Clear() {
+    items_.clear();
+    levels_.clear();
+  }
+
+  inline size_t size() const { return items_.size(); }
+
+  inline bool empty() const { return items_.empty(); }
+
+  // Calls f(i) for each box that may intersect the given box, where i is
+  // the position of the box in the vector given to Build(). All the boxes
+  // with a positive intersection area are visited, but some boxes that
+  // only touch the given box (with a zero intersection area) may be
+  // visited as well. Boxes are visited in no particular order.
+  template <typename F>
+  void Search(const BoundingBox<T>& box, F f) const {
+    if (items_.empty()) return;
+    const Rect r{box.x, box.y, static_cast<T>(box.x + box.w),
+                 static_cast<T>(box.y + box.h)};
+    Search(r, levels_.size() - 1, 0, &f);
+  }
+
+ private:
+  struct Rect {
+    T x1, y1, x2, y2;
+
+    inline bool Intersects(const Rect& o) const {
+      return x1 <= o.x2 && o.x1 <= x2 && y1 <= o.y2 && o.y1 <= y2;
+    }
+
+    inline void Extend(const Rect& o) {
+      x1 = std::min(x1, o.x1); y1 = std::min(y1, o.y1);
+      x2 = std::max(x2, o.x2); y2 = std::max(y2, o.y2);
+    }
+  };
+
+  struct Item {
+    Rect rect;
+    uint32_t id;    // Position of the box in the vector given to Build().
+  };
+
+  struct Node {
+    Rect rect;      // Bounding box of the children.
+    uint32_t first; // Children are [first, last) in the level below (or in
+    uint32_t last;  // items_, for the leaves).
+  };
+
+  // Sorts the entries (items or nodes) in the order in which they are
+  // grouped into parent nodes.
+  template <typename E>
+  static void SortTileRecursive(std::vector<E>* entries) {
+    const size_t n = entries->size();
+    const size_t num_nodes = (n + kNodeSize - 1) / kNodeSize;
+    const size_t num_slices = static_cast<size_t>(
+        std::ceil(std::sqrt(static_cast<double>(num_nodes))));
+    const size_t slice_size = num_slices * kNodeSize;
+    // Twice the center of the box, to avoid divisions.
+    std::sort(entries->begin(), entries->end(), [](const E& a, const E& b) {
+        return a.rect.x1 + a.rect.x2 < b.rect.x1 + b.rect.x2;
+      });
+    for (size_t s = 0; s < n; s += slice_size) {
+      std::sort(entries->begin() + s,
+                entries->begin() + std::min(n, s + slice_size),
+                [](const E& a, const E& b) {
+                  return a.rect.y1 + a.rect.y2 < b.rect.y1 + b.rect.y2;
+                });
+    }
+  }
+
+  // Groups consecutive entries into nodes.
+  template <typename E>
+  static std::vector<Node> Pack(const std::vector<E>& entries) {
+    std::vector<Node> nodes;
+    nodes.reserve((entries.size() + kNodeSize - 1) / kNodeSize);
+    for (size_t i = 0; i < entries.size(); i += kNodeSize) {
+      const size_t last = std::min(entries.size(), i + kNodeSize);
+      Node node{entries[i].rect, static_cast<uint32_t>(i),
+                static_cast<uint32_t>(last)};
+      for (size_t j = i + 1; j < last; ++j) node.rect.Extend(entries[j].rect);
+      nodes.push_back(node);
+    }
+    return nodes;
+  }
+
+  template <typename F>
+  void Search(const Rect& r, size_t level, size_t n, F* f) const {
+    const Node& node = levels_[level][n];
+    if (!node.rect.Intersects(r)) return;
+    if (level == 0) {
+      for (uint32_t i = node.first; i < node.last; ++i) {
+        if (items_[i].rect.Intersects(r)) (*f)(items_[i].id);
+      }
+    } else {
+      for (uint32_t i = node.first; i < node.last; ++i) {
+        Search(r, level - 1, i, f);
+      }
+    }
+  }
+
+  std::vector<Item> items_;
+  // levels_[0] are the leaves, levels_.back() has only the root.
+  std::vector<std::vector<Node>> levels_;
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_PACKEDRTREE_H_
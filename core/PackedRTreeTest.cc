@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "core/BoundingBox.h"
+#include "core/PackedRTree.h"
+
+using kws::core::BoundingBox;
+using kws::core::PackedRTree;
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+template <typename T>
+static std::set<uint32_t> Search(const PackedRTree<T>& tree,
+                                 const BoundingBox<T>& box) {
+  std::set<uint32_t> result;
+  tree.Search(box, [&result](uint32_t i) {
+      EXPECT_TRUE(result.insert(i).second) << "Box " << i << " repeated";
+    });
+  return result;
+}
+
+TEST(PackedRTreeTest, Empty) {
+  PackedRTree<int> tree;
+  EXPECT_TRUE(tree.empty());
+  EXPECT_THAT(Search(tree, BoundingBox<int>(0, 0, 10, 10)), IsEmpty());
+  tree.Build({});
+  EXPECT_THAT(Search(tree, BoundingBox<int>(0, 0, 10, 10)), IsEmpty());
+}
+
+TEST(PackedRTreeTest, Small) {
+  PackedRTree<int> tree;
+  tree.Build({BoundingBox<int>(0, 0, 10, 10),
+              BoundingBox<int>(20, 0, 10, 10),
+              BoundingBox<int>(5, 5, 10, 10)});
+  EXPECT_EQ(3, tree.size());
+  EXPECT_THAT(Search(tree, BoundingBox<int>(1, 1, 2, 2)), ElementsAre(0));
+  EXPECT_THAT(Search(tree, BoundingBox<int>(8, 8, 2, 2)), ElementsAre(0, 2));
+  EXPECT_THAT(Search(tree, BoundingBox<int>(0, 0, 50, 50)),
+              ElementsAre(0, 1, 2));
+  EXPECT_THAT(Search(tree, BoundingBox<int>(0, 30, 50, 50)), IsEmpty());
+  // Build again, with other boxes.
+  tree.Build({BoundingBox<int>(40, 40, 10, 10)});
+  EXPECT_THAT(Search(tree, BoundingBox<int>(0, 0, 50, 50)), ElementsAre(0));
+  tree.Clear();
+  EXPECT_THAT(Search(tree, BoundingBox<int>(0, 0, 50, 50)), IsEmpty());
+}
+
+template <typename T>
+static void CheckRandomBoxes(size_t num_boxes) {
+  std::mt19937 rng(num_boxes);
+  std::uniform_int_distribution<uint32_t> coord(0, 1000), size(1, 100);
+  auto random_box = [&]() {
+    return BoundingBox<T>(coord(rng), coord(rng), size(rng), size(rng));
+  };
+  std::vector<BoundingBox<T>> boxes(num_boxes);
+  for (auto& b : boxes) b = random_box();
+  PackedRTree<T> tree;
+  tree.Build(boxes);
+  ASSERT_EQ(num_boxes, tree.size());
+  for (int q = 0; q < 200; ++q) {
+    const BoundingBox<T> query = random_box();
+    const std::set<uint32_t> found = Search(tree, query);
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      // All boxes with a positive intersection area must be found.
+      if (boxes[i].IntersectionArea(query) > 0) {
+        EXPECT_EQ(1, found.count(i)) << boxes[i] << " vs. " << query;
+      }
+    }
+    for (const uint32_t i : found) {
+      ASSERT_LT(i, boxes.size());
+      EXPECT_LE(query.x, boxes[i].x + boxes[i].w);
+      EXPECT_LE(boxes[i].x, query.x + query.w);
+      EXPECT_LE(query.y, boxes[i].y + boxes[i].h);
+      EXPECT_LE(boxes[i].y, query.y + query.h);
+    }
+  }
+}
+
+TEST(PackedRTreeTest, RandomBoxes) {
+  // Different number of levels, and incomplete nodes.
+  for (const size_t n : {1, 7, 8, 9, 64, 65, 500, 5000}) {
+    CheckRandomBoxes<int>(n);
+    CheckRandomBoxes<uint16_t>(n);
+    CheckRandomBoxes<uint32_t>(n);
+    CheckRandomBoxes<float>(n);
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef CORE_PLAINEVENT_H_
+#define CORE_PLAINEVENT_H_
+
+#include <iostream>
+#include <string>
+
+namespace kws {
+namespace core {
+
+// Non-virtual counterpart of Event. It has the same interface (thus it can
+// be used with the same Matcher, Scorer and EventSet templates), but no
+// vtable: accessors and comparisons are inlined in sort and matching loops,
+// and events with trivially copyable query and location types (e.g.
+// PlainEvent<int32_t, int32_t>) are trivially copyable themselves.
+//
+// Plain events must not be mixed with the events of the Event hierarchy,
+// and they must not be deleted through a pointer to a base class.
+template <typename Q, typename L>
+struct PlainEvent {
+  typedef Q QType;
+  typedef L LType;
+  typedef PlainEvent<Q, L> BaseEvent;
+
+  QType query;
+  LType location;
+
+  PlainEvent() = default;
+
+  PlainEvent(const QType& query, const LType& location) :
+      query(query), location(location) {}
+
+  inline const QType& Query() const { return query; }
+
+  inline QType& Query() { return query; }
+
+  inline const LType& Location() const { return location; }
+
+  inline LType& Location() { return location; }
+
+  inline bool operator==(const PlainEvent& other) const {
+    return query == other.query && location == other.location;
+  }
+
+  inline bool operator!=(const PlainEvent& other) const {
+    return query != other.query || location != other.location;
+  }
+
+  inline bool operator<(const PlainEvent& other) const {
+    if (query != other.query) return query < other.query;
+    return location < other.location;
+  }
+
+  inline bool operator>(const PlainEvent& other) const {
+    return (other < *this);
+  }
+
+  inline bool operator<=(const PlainEvent& other) const {
+    return !(*this > other);
+  }
+
+  inline bool operator>=(const PlainEvent& other) const {
+    return !(*this < other);
+  }
+};
+
+template <typename Q, typename L>
+std::istream& operator>>(std::istream& is, PlainEvent<Q, L>& event) {
+  is >> event.query >> event.location;
+  return is;
+}
+
+template <typename Q, typename L>
+std::ostream& operator<<(std::ostream& os, const PlainEvent<Q, L>& event) {
+  os << event.query << " " << event.location;
+  return os;
+}
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_PLAINEVENT_H_
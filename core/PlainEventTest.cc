@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include "core/BoundingBox.h"
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/EventSet.h"
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
+#include "core/PlainShapedEvent.h"
+
+using kws::core::BoundingBox;
+using kws::core::DocumentIdBoundingBox;
+using kws::core::EventSet;
+using kws::core::PlainEvent;
+using kws::core::PlainScoredEvent;
+using kws::core::PlainShapedEvent;
+
+typedef PlainEvent<int32_t, int32_t> IntEvent;
+typedef PlainScoredEvent<IntEvent> ScoredIntEvent;
+typedef PlainShapedEvent<int32_t, DocumentIdBoundingBox<int>> BoxEvent;
+typedef PlainScoredEvent<BoxEvent> ScoredBoxEvent;
+
+TEST(PlainEventTest, TriviallyCopyable) {
+  EXPECT_TRUE(std::is_trivially_copyable<IntEvent>::value);
+  EXPECT_TRUE(std::is_trivially_copyable<ScoredIntEvent>::value);
+  EXPECT_TRUE(std::is_trivially_copyable<BoxEvent>::value);
+  EXPECT_TRUE(std::is_trivially_copyable<ScoredBoxEvent>::value);
+  EXPECT_FALSE(std::is_polymorphic<ScoredBoxEvent>::value);
+  EXPECT_EQ(3 * sizeof(int32_t), sizeof(ScoredIntEvent));
+}
+
+TEST(PlainEventTest, Comparisons) {
+  const IntEvent e1(1, 1), e2(1, 1), e3(1, 2), e4(2, 0);
+  EXPECT_EQ(e1, e2);
+  EXPECT_NE(e1, e3);
+  EXPECT_NE(e1, e4);
+  EXPECT_LT(e1, e3);  // Same query, lower location
+  EXPECT_LT(e3, e4);  // Lower query
+  EXPECT_GT(e4, e1);
+  EXPECT_LE(e1, e2);
+  EXPECT_GE(e1, e2);
+  EXPECT_FALSE(e1 <= e4 && e1 >= e4);
+}
+
+TEST(PlainEventTest, ScoredComparisons) {
+  const ScoredIntEvent e1(1, 1, 0.5f), e2(1, 1, 0.5f), e3(1, 1, 0.9f),
+      e4(0, 0, 0.9f);
+  EXPECT_EQ(e1, e2);
+  EXPECT_NE(e1, e3);
+  EXPECT_LT(e1, e3);  // Lower score
+  EXPECT_LT(e4, e3);  // Same score, lower event
+  EXPECT_GT(e3, e1);
+  EXPECT_LE(e1, e2);
+  EXPECT_LE(e1, e3);
+  EXPECT_GE(e3, e1);
+  EXPECT_FALSE(e3 <= e1);
+  std::vector<ScoredIntEvent> v{e1, e3, e4};
+  std::sort(v.begin(), v.end(), std::greater<ScoredIntEvent>());
+  EXPECT_EQ((std::vector<ScoredIntEvent>{e3, e4, e1}), v);
+}
+
+TEST(PlainEventTest, Geometry) {
+  const BoxEvent e1(1, DocumentIdBoundingBox<int>("doc1", 0, 0, 4, 4));
+  const ScoredBoxEvent e2(1, DocumentIdBoundingBox<int>("doc1", 2, 2, 4, 4),
+                          0.5f);
+  EXPECT_EQ(16, e1.Area());
+  EXPECT_EQ(4, IntersectionArea(e1, e2));
+  EXPECT_EQ(28, UnionArea(e1, e2));
+}
+
+TEST(PlainEventTest, Streams) {
+  const ScoredBoxEvent e1(1, DocumentIdBoundingBox<int>("doc", 1, 2, 3, 4),
+                          0.5f);
+  std::ostringstream oss;
+  oss << e1;
+  EXPECT_EQ("1 doc 1 2 3 4 0.5", oss.str());
+  ScoredBoxEvent e2;
+  std::istringstream iss("1 doc 1 2 3 4 0.5");
+  iss >> e2;
+  EXPECT_EQ(e1, e2);
+}
+
+TEST(PlainEventTest, EventSet) {
+  // Hypotheses are looked up directly in the sets of references.
+  EventSet<IntEvent> refs;
+  refs.Insert(IntEvent(1, 1));
+  refs.Insert(IntEvent(1, 2));
+  EXPECT_EQ(2, refs.Size());
+  EXPECT_EQ(std::list<IntEvent>{IntEvent(1, 2)},
+            refs.FindOverlapping(ScoredIntEvent(1, 2, 0.5f)));
+  EXPECT_TRUE(refs.FindOverlapping(ScoredIntEvent(2, 2, 0.5f)).empty());
+
+  EventSet<BoxEvent> boxes;
+  const BoxEvent b1(1, DocumentIdBoundingBox<int>("doc1", 0, 0, 4, 4));
+  const BoxEvent b2(1, DocumentIdBoundingBox<int>("doc2", 0, 0, 4, 4));
+  boxes.Insert(b1);
+  boxes.Insert(b2);
+  EXPECT_EQ(std::list<BoxEvent>{b1}, boxes.FindOverlapping(ScoredBoxEvent(
+      1, DocumentIdBoundingBox<int>("doc1", 1, 1, 2, 2), 0.5f)));
+}
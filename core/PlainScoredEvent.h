@@ -0,0 +1,75 @@
+#ifndef CORE_PLAINSCOREDEVENT_H_
+#define CORE_PLAINSCOREDEVENT_H_
+
+#include <iostream>
+
+#include "core/PlainEvent.h"
+
+namespace kws {
+namespace core {
+
+// Non-virtual counterpart of ScoredEvent, for PlainEvent and
+// PlainShapedEvent (see PlainEvent).
+template <typename E>
+struct PlainScoredEvent : public E {
+  typedef E Base;
+  typedef typename E::QType QType;
+  typedef typename E::LType LType;
+
+  float score;
+
+  PlainScoredEvent() = default;
+
+  explicit PlainScoredEvent(float s) : E(), score(s) {}
+
+  PlainScoredEvent(const QType& query, const LType& location, float s) :
+      E(query, location), score(s) {}
+
+  PlainScoredEvent(const E& event, float s) : E(event), score(s) {}
+
+  inline bool operator==(const PlainScoredEvent& other) const {
+    return score == other.score && Base::operator==(other);
+  }
+
+  inline bool operator!=(const PlainScoredEvent& other) const {
+    return score != other.score || Base::operator!=(other);
+  }
+
+  inline bool operator<(const PlainScoredEvent& other) const {
+    if (score != other.score) return score < other.score;
+    return Base::operator<(other);
+  }
+
+  inline bool operator>(const PlainScoredEvent& other) const {
+    return (other < *this);
+  }
+
+  inline bool operator<=(const PlainScoredEvent& other) const {
+    return !(*this > other);
+  }
+
+  inline bool operator>=(const PlainScoredEvent& other) const {
+    return !(*this < other);
+  }
+
+  inline float Score() const { return score; }
+
+  inline float& Score() { return score; }
+};
+
+template <class E>
+std::istream& operator>>(std::istream& is, PlainScoredEvent<E>& event) {
+  is >> event.Query() >> event.Location() >> event.score;
+  return is;
+}
+
+template <class E>
+std::ostream& operator<<(std::ostream& os, const PlainScoredEvent<E>& event) {
+  os << event.Query() << " " << event.Location() << " " << event.score;
+  return os;
+}
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_PLAINSCOREDEVENT_H_
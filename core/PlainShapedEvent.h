@@ -0,0 +1,26 @@
+#ifndef CORE_PLAINSHAPEDEVENT_H_
+#define CORE_PLAINSHAPEDEVENT_H_
+
+#include "core/PlainEvent.h"
+#include "core/ShapedEvent.h"
+
+namespace kws {
+namespace core {
+
+// Non-virtual counterpart of ShapedEvent (see PlainEvent).
+template <typename Q, typename L>
+struct PlainShapedEvent : public PlainEvent<Q, L> {
+  typedef typename L::Type Type;
+
+  PlainShapedEvent() = default;
+
+  PlainShapedEvent(const Q& query, const L& location) :
+      PlainEvent<Q, L>(query, location) {}
+
+  inline Type Area() const { return this->location.Area(); }
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_PLAINSHAPEDEVENT_H_
@@ -22,6 +22,10 @@ class Statistic {
 
  protected:
   bool collapse_matches_;
+  // Buffers reused by successive evaluations of the statistic (e.g. in each
+  // bootstrap repetition). Thus, the same object must not be evaluated
+  // concurrently from several threads.
+  mutable AssessmentBuffers<Match> buffers_;
 };
 
 template<typename Match>
@@ -47,7 +51,8 @@ class GlobalAP : public GlobalStatistic<Match> {
   double operator()(const std::vector<Match> &matches) const override {
     return ComputeGlobalAP<Match>(
         matches, GlobalStatistic<Match>::collapse_matches_,
-        interpolate_precision_, trapezoid_integral_);
+        interpolate_precision_, trapezoid_integral_,
+        &this->buffers_);
   }
 
   double operator()(
@@ -55,7 +60,8 @@ class GlobalAP : public GlobalStatistic<Match> {
       bool sort_matches) const override {
     return ComputeGlobalAP<Match>(
         grouped_matches, GlobalStatistic<Match>::collapse_matches_,
-        interpolate_precision_, trapezoid_integral_, sort_matches);
+        interpolate_precision_, trapezoid_integral_, sort_matches,
+        &this->buffers_);
   }
 
  private:
@@ -76,7 +82,7 @@ class MeanAP : public Statistic<Match> {
       bool sort_matches) const override {
     return ComputeMeanAP(grouped_matches, Statistic<Match>::collapse_matches_,
                          interpolate_precision_, trapezoid_integral_,
-                         sort_matches);
+                         sort_matches, &this->buffers_);
   }
 
  private:
@@ -90,7 +96,8 @@ class GlobalNDCG : public GlobalStatistic<Match> {
       : GlobalStatistic<Match>(collapse_matches) {}
 
   double operator()(const std::vector<Match> &matches) const override {
-    return ComputeGlobalNDCG(matches, GlobalStatistic<Match>::collapse_matches_);
+    return ComputeGlobalNDCG(matches, GlobalStatistic<Match>::collapse_matches_,
+                             &this->buffers_);
   }
 
   double operator()(
@@ -98,7 +105,7 @@ class GlobalNDCG : public GlobalStatistic<Match> {
       bool sort_matches) const override {
     return ComputeGlobalNDCG(grouped_matches,
                              GlobalStatistic<Match>::collapse_matches_,
-                             sort_matches);
+                             sort_matches, &this->buffers_);
   }
 };
 
@@ -112,7 +119,7 @@ class MeanNDCG : public Statistic<Match> {
       const std::vector<std::vector<Match>> &grouped_matches,
       bool sort_matches) const override {
     return ComputeMeanNDCG(grouped_matches, Statistic<Match>::collapse_matches_,
-                           sort_matches);
+                           sort_matches, &this->buffers_);
   }
 };
 
@@ -0,0 +1,190 @@
+#ifndef CORE_WORKSTEALINGPOOL_H_
+#define CORE_WORKSTEALINGPOOL_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace kws {
+namespace core {
+
+// Runs a fixed set of independent tasks of uneven (estimated) cost on several
+// threads. The tasks are sorted by decreasing cost and dealt to the workers
+// in turns, each worker keeping its own deque of tasks. A worker runs the
+// tasks of its deque from the front (the most expensive first), and when its
+// deque is empty it steals tasks from the back of the deques of the other
+// workers, thus workers that got cheaper tasks (or ran faster) help the
+// others until all the tasks are done.
+//
+// All the tasks of a Run() are known beforehand, thus a worker finishes as
+// soon as it cannot find any task to steal. The worker threads are started
+// by the first Run() and wait for the tasks of the next one, until the pool
+// is destroyed, thus running small sets of tasks (e.g. one set per batch of
+// hypotheses) does not create threads each time.
+class WorkStealingPool {
+ public:
+  // If num_threads is 0, use as many threads as hardware threads.
+  explicit WorkStealingPool(size_t num_threads = 0)
+      : num_threads_(ResolveNumThreads(num_threads)), work_(nullptr),
+        generation_(0), pending_(0), stop_(false) {}
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  ~WorkStealingPool() { Stop(); }
+
+  inline size_t NumThreads() const { return num_threads_; }
+
+  // Stops the current workers, the new ones are started by the next Run().
+  void SetNumThreads(size_t num_threads) {
+    Stop();
+    num_threads_ = ResolveNumThreads(num_threads);
+  }
+
+  // Calls f(task, worker) once for each task in [0, costs.size()), where
+  // costs[task] is the estimated cost of the task and worker is the number
+  // of the worker running it, in [0, NumThreads()). Tasks run by the same
+  // worker never run concurrently, thus f can use per-worker state. The
+  // calling thread is worker 0. Returns once all the tasks are done.
+  // Run() must not be called concurrently on the same pool.
+  template <typename F>
+  void Run(const std::vector<size_t>& costs, F f) {
+    const size_t num_workers = std::min(num_threads_, costs.size());
+    if (num_workers <= 1) {
+      for (size_t t = 0; t < costs.size(); ++t) f(t, 0);
+      return;
+    }
+    std::vector<uint32_t> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&costs](uint32_t a, uint32_t b) {
+                       return costs[a] > costs[b];
+                     });
+    if (threads_.empty()) Start();
+    for (size_t i = 0; i < order.size(); ++i) {
+      deques_[i % num_workers]->tasks.push_back(order[i]);
+    }
+    // Workers beyond num_workers have no tasks, and do not steal either.
+    const std::function<void(size_t)> work =
+        [this, &f, num_workers](size_t w) {
+          if (w >= num_workers) return;
+          uint32_t task;
+          while (deques_[w]->PopFront(&task) ||
+                 Steal(w, num_workers, &task)) {
+            f(task, w);
+          }
+        };
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      work_ = &work;
+      pending_ = threads_.size();
+      ++generation_;
+    }
+    start_.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]{ return pending_ == 0; });
+    work_ = nullptr;
+  }
+
+ private:
+  struct TaskDeque {
+    std::mutex mutex;
+    std::deque<uint32_t> tasks;
+
+    bool PopFront(uint32_t* task) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (tasks.empty()) return false;
+      *task = tasks.front();
+      tasks.pop_front();
+      return true;
+    }
+
+    bool PopBack(uint32_t* task) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (tasks.empty()) return false;
+      *task = tasks.back();
+      tasks.pop_back();
+      return true;
+    }
+  };
+
+  static size_t ResolveNumThreads(size_t num_threads) {
+    return num_threads > 0
+        ? num_threads
+        : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+  // Steals a task from the other workers, starting with the next one.
+  bool Steal(size_t w, size_t num_workers, uint32_t* task) const {
+    for (size_t i = 1; i < num_workers; ++i) {
+      if (deques_[(w + i) % num_workers]->PopBack(task)) return true;
+    }
+    return false;
+  }
+
+  void Start() {
+    for (size_t w = 0; w < num_threads_; ++w) {
+      deques_.emplace_back(new TaskDeque());
+    }
+    for (size_t w = 1; w < num_threads_; ++w) {
+      threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, w,
+                            generation_);
+    }
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+    deques_.clear();
+    stop_ = false;
+  }
+
+  // Runs the work of each Run() after the given generation as worker w,
+  // until the pool is stopped.
+  void WorkerLoop(size_t w, uint64_t seen) {
+    for (;;) {
+      const std::function<void(size_t)>* work;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock, [this, seen]{ return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        work = work_;
+      }
+      (*work)(w);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_ == 0) done_.notify_one();
+    }
+  }
+
+  size_t num_threads_;
+  std::vector<std::unique_ptr<TaskDeque>> deques_;
+  std::vector<std::thread> threads_;
+  // Protects the fields below, which describe the current Run().
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  const std::function<void(size_t)>* work_;
+  uint64_t generation_;
+  size_t pending_;
+  bool stop_;
+};
+
+}  // namespace core
+}  // namespace kws
+
+#endif  // CORE_WORKSTEALINGPOOL_H_
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "core/WorkStealingPool.h"
+
+using kws::core::WorkStealingPool;
+
+TEST(WorkStealingPoolTest, NoTasks) {
+  WorkStealingPool pool(4);
+  size_t calls = 0;
+  pool.Run({}, [&calls](size_t, size_t) { ++calls; });
+  EXPECT_EQ(0, calls);
+}
+
+TEST(WorkStealingPoolTest, SingleThread) {
+  // Tasks run in order, by the calling thread.
+  WorkStealingPool pool(1);
+  std::vector<size_t> tasks;
+  pool.Run({1, 5, 3}, [&tasks](size_t t, size_t w) {
+      EXPECT_EQ(0, w);
+      tasks.push_back(t);
+    });
+  EXPECT_EQ((std::vector<size_t>{0, 1, 2}), tasks);
+}
+
+TEST(WorkStealingPoolTest, EachTaskRunsOnce) {
+  // Very uneven costs, and more threads than tasks in some cases.
+  for (size_t num_threads : {2, 3, 8}) {
+    for (size_t num_tasks : {1, 2, 7, 1000}) {
+      std::vector<size_t> costs(num_tasks);
+      for (size_t t = 0; t < num_tasks; ++t) costs[t] = (t * 7919) % 100;
+      costs[num_tasks / 2] = 1000000;
+      std::vector<std::atomic<int>> calls(num_tasks);
+      for (auto& c : calls) c = 0;
+      std::vector<std::atomic<int>> running(num_threads);
+      for (auto& r : running) r = 0;
+      WorkStealingPool pool(num_threads);
+      pool.Run(costs, [&](size_t t, size_t w) {
+          ASSERT_LT(w, num_threads);
+          // Tasks of the same worker never run concurrently.
+          EXPECT_EQ(0, running[w]++);
+          ++calls[t];
+          --running[w];
+        });
+      for (size_t t = 0; t < num_tasks; ++t) {
+        EXPECT_EQ(1, calls[t]) << "Task " << t << " with " << num_threads
+                               << " threads";
+      }
+    }
+  }
+}
+
+TEST(WorkStealingPoolTest, ThreadsAreReused) {
+  // Many small runs, as with batches of hypotheses, share the same threads.
+  WorkStealingPool pool(4);
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  size_t calls = 0;
+  for (int r = 0; r < 100; ++r) {
+    pool.Run({1, 2, 3, 4, 5, 6}, [&](size_t, size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+        ++calls;
+      });
+  }
+  EXPECT_EQ(600, calls);
+  EXPECT_LE(ids.size(), 4);
+
+  // New workers are started after changing the number of threads.
+  pool.SetNumThreads(2);
+  EXPECT_EQ(2, pool.NumThreads());
+  ids.clear();
+  pool.Run({1, 2, 3, 4, 5, 6}, [&](size_t, size_t w) {
+      std::lock_guard<std::mutex> lock(mutex);
+      EXPECT_LT(w, 2);
+      ids.insert(std::this_thread::get_id());
+      ++calls;
+    });
+  EXPECT_EQ(606, calls);
+  EXPECT_LE(ids.size(), 2);
+}
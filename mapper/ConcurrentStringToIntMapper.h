@@ -0,0 +1,189 @@
+#ifndef MAPPER_CONCURRENTSTRINGTOINTMAPPER_H_
+#define MAPPER_CONCURRENTSTRINGTOINTMAPPER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mapper/FrozenVocabulary.h"
+#include "mapper/Mapper.h"
+#include "mapper/StringInternTable.h"
+
+namespace kws {
+namespace mapper {
+
+// Thread-safe version of StringToIntMapper: different threads can map
+// strings concurrently (e.g. the references and the hypotheses can be
+// parsed at the same time).
+//
+// The strings are distributed among shards, by their hash, and each shard
+// is protected by its own mutex. Ids are dense (0, 1, 2, ...), but when
+// strings are mapped concurrently the order in which they get their ids
+// depends on the interleaving of the threads. Renumber() assigns the final
+// ids once all the strings have been mapped, so that results are
+// reproducible regardless of the number of threads.
+//
+// Optionally, the strings in a FrozenVocabulary keep their ids from the
+// vocabulary, which are the same in every run. Other strings get ids after
+// them.
+template <typename Int>
+class ConcurrentStringToIntMapper : public Mapper<std::string, Int> {
+ public:
+  static_assert(std::is_integral<Int>::value, "Integral type required");
+
+  typedef typename Mapper<std::string, Int>::InputType InputType;
+  typedef typename Mapper<std::string, Int>::OutputType OutputType;
+
+  // The number of shards is rounded up to a power of two.
+  explicit ConcurrentStringToIntMapper(size_t num_shards = 64)
+      : vocabulary_(nullptr), shard_bits_(0), next_id_(0) {
+    while ((size_t(1) << shard_bits_) < num_shards) ++shard_bits_;
+    shards_.reset(new Shard[size_t(1) << shard_bits_]);
+  }
+
+  ConcurrentStringToIntMapper(const ConcurrentStringToIntMapper&) = delete;
+
+  ConcurrentStringToIntMapper& operator=(
+      const ConcurrentStringToIntMapper&) = delete;
+
+  OutputType operator()(const InputType &input) override {
+    return (*this)(input.data(), input.size());
+  }
+
+  // Same as above, for the string [data, data + size).
+  OutputType operator()(const char* data, size_t size) {
+    const uint64_t h = StringInternTable<uint32_t>::Hash(data, size);
+    uint32_t vocabulary_id;
+    if (vocabulary_ != nullptr &&
+        vocabulary_->Find(data, size, h, &vocabulary_id)) {
+      return static_cast<Int>(vocabulary_id);
+    }
+    Shard& shard = shards_[ShardIndex(h)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    uint32_t local_id;
+    if (shard.table.Find(data, size, h, &local_id)) {
+      return shard.ids[local_id];
+    }
+    const size_t id = next_id_++;
+    if (id >= kMaxSize) {
+      --next_id_;
+      throw std::range_error(
+          "Max size reached (" + std::to_string(kMaxSize) + ")");
+    }
+    shard.table.Insert(data, size, h);
+    shard.ids.push_back(static_cast<Int>(id));
+    return static_cast<Int>(id);
+  }
+
+  bool IsThreadSafe() const override { return true; }
+
+  // Strings in the vocabulary are mapped to their ids in the vocabulary,
+  // which must outlive this object. This must be called before mapping any
+  // string. Returns false if the ids of the vocabulary do not fit in Int.
+  bool SetVocabulary(const FrozenVocabulary* vocabulary) {
+    if (vocabulary->size() > kMaxSize) return false;
+    vocabulary_ = vocabulary;
+    next_id_ = vocabulary->size();
+    return true;
+  }
+
+  inline const FrozenVocabulary* Vocabulary() const { return vocabulary_; }
+
+  // Number of mapped strings.
+  inline size_t size() const { return next_id_; }
+
+  // The following methods must not be called while other threads are
+  // mapping strings.
+
+  // Returns the strings mapped so far, indexed by their id.
+  std::vector<std::string> Strings() const {
+    std::vector<std::string> strings(size());
+    for (size_t i = 0; vocabulary_ != nullptr && i < vocabulary_->size();
+         ++i) {
+      strings[i] = vocabulary_->String(static_cast<uint32_t>(i));
+    }
+    for (size_t s = 0; s < NumShards(); ++s) {
+      const Shard& shard = shards_[s];
+      for (size_t i = 0; i < shard.ids.size(); ++i) {
+        strings[shard.ids[i]] = shard.table.String(static_cast<uint32_t>(i));
+      }
+    }
+    return strings;
+  }
+
+  // Changes the ids of the strings. The ids in `order` get the new ids
+  // 0, 1, 2, ..., in the order of their first occurrence in `order`; the
+  // rest of ids are numbered after them, in the lexicographic order of
+  // their strings. Returns the new id of each old id. The ids of the strings
+  // in the vocabulary do not change, the rest are numbered after them.
+  //
+  // If `order` lists the ids in the same order as they were first mapped
+  // by a sequential program, the final ids are the same that a
+  // StringToIntMapper would have assigned.
+  std::vector<Int> Renumber(const std::vector<Int>& order) {
+    const size_t n = size();
+    std::vector<Int> new_id(n);
+    std::vector<char> assigned(n, 0);
+    size_t next = 0;
+    for (; vocabulary_ != nullptr && next < vocabulary_->size(); ++next) {
+      new_id[next] = static_cast<Int>(next);
+      assigned[next] = 1;
+    }
+    for (const Int id : order) {
+      if (!assigned[id]) {
+        assigned[id] = 1;
+        new_id[id] = static_cast<Int>(next++);
+      }
+    }
+    if (next < n) {
+      const std::vector<std::string> strings = Strings();
+      std::vector<Int> rest;
+      for (size_t id = 0; id < n; ++id) {
+        if (!assigned[id]) rest.push_back(static_cast<Int>(id));
+      }
+      std::sort(rest.begin(), rest.end(), [&strings](Int a, Int b) {
+          return strings[a] < strings[b];
+        });
+      for (const Int id : rest) new_id[id] = static_cast<Int>(next++);
+    }
+    for (size_t s = 0; s < NumShards(); ++s) {
+      for (Int& id : shards_[s].ids) id = new_id[id];
+    }
+    return new_id;
+  }
+
+ private:
+  static constexpr size_t kMaxSize =
+      1 + static_cast<size_t>(std::numeric_limits<Int>::max());
+
+  struct Shard {
+    std::mutex mutex;
+    StringInternTable<uint32_t> table;
+    std::vector<Int> ids;  // Id of each string in the table.
+  };
+
+  inline size_t NumShards() const { return size_t(1) << shard_bits_; }
+
+  // The hash is mixed again, so that the shard is not correlated with the
+  // bits used by the tables of the shards.
+  inline size_t ShardIndex(uint64_t h) const {
+    return shard_bits_ == 0
+        ? 0 : (h * 0x9e3779b97f4a7c15ull) >> (64 - shard_bits_);
+  }
+
+  const FrozenVocabulary* vocabulary_;
+  size_t shard_bits_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> next_id_;
+};
+
+}  // namespace mapper
+}  // namespace kws
+
+#endif  // MAPPER_CONCURRENTSTRINGTOINTMAPPER_H_
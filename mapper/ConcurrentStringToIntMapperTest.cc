@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+#include "mapper/ConcurrentStringToIntMapper.h"
+#include "mapper/StringToIntMapper.h"
+
+using kws::mapper::ConcurrentStringToIntMapper;
+using kws::mapper::StringToIntMapper;
+
+using testing::ElementsAre;
+
+TEST(ConcurrentStringToIntMapper, Simple) {
+  ConcurrentStringToIntMapper<int> m(4);
+  EXPECT_TRUE(m.IsThreadSafe());
+  EXPECT_EQ(m("s1"), 0);
+  EXPECT_EQ(m("s2"), 1);
+  EXPECT_EQ(m("s1"), 0);
+  EXPECT_EQ(m("s3", 2), 2);
+  EXPECT_EQ(m.size(), 3);
+  EXPECT_THAT(m.Strings(), ElementsAre("s1", "s2", "s3"));
+}
+
+TEST(ConcurrentStringToIntMapper, RangeErrorException) {
+  ConcurrentStringToIntMapper<int8_t> m;
+  for (uint8_t i = 0; i <= 127; ++i) {
+    EXPECT_EQ(m("s" + std::to_string(i)), i);
+  }
+  EXPECT_THROW(m("except"), std::range_error);
+  EXPECT_EQ(m.size(), 128);
+}
+
+TEST(ConcurrentStringToIntMapper, Renumber) {
+  ConcurrentStringToIntMapper<int> m;
+  m("d"); m("c"); m("b"); m("a");
+  // Ids 2 and 0 come first, the rest are sorted by their string.
+  EXPECT_THAT(m.Renumber({2, 0, 2}), ElementsAre(1, 3, 0, 2));
+  EXPECT_EQ(m("b"), 0);
+  EXPECT_EQ(m("d"), 1);
+  EXPECT_EQ(m("a"), 2);
+  EXPECT_EQ(m("c"), 3);
+  EXPECT_EQ(m("e"), 4);
+  EXPECT_THAT(m.Strings(), ElementsAre("b", "d", "a", "c", "e"));
+}
+
+TEST(ConcurrentStringToIntMapper, ConcurrentAndDeterministic) {
+  const size_t kThreads = 4, kStrings = 5000;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < kStrings; ++i) {
+    strings.push_back("string" + std::to_string(i * 7919 % kStrings));
+  }
+  ConcurrentStringToIntMapper<int> m;
+  std::vector<std::vector<int>> ids(kThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    // All threads map all strings, starting at different positions.
+    threads.emplace_back([&, t]() {
+        for (size_t i = 0; i < kStrings; ++i) {
+          ids[t].push_back(m(strings[(i + t * kStrings / kThreads) %
+                                     kStrings]));
+        }
+      });
+  }
+  for (auto& th : threads) th.join();
+  EXPECT_EQ(m.size(), kStrings);
+  const std::vector<std::string> mapped = m.Strings();
+  for (size_t t = 0; t < kThreads; ++t) {
+    for (size_t i = 0; i < kStrings; ++i) {
+      EXPECT_EQ(strings[(i + t * kStrings / kThreads) % kStrings],
+                mapped[ids[t][i]]);
+    }
+  }
+
+  // After renumbering, ids are the same as a sequential StringToIntMapper.
+  std::vector<int> order;
+  for (const auto& s : strings) order.push_back(m(s));
+  m.Renumber(order);
+  StringToIntMapper<int> sequential;
+  for (const auto& s : strings) EXPECT_EQ(sequential(s), m(s));
+}
@@ -0,0 +1,258 @@
+#ifndef MAPPER_FROZENVOCABULARY_H_
+#define MAPPER_FROZENVOCABULARY_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mapper/StringInternTable.h"
+
+namespace kws {
+namespace mapper {
+
+// Read-only set of strings with fixed ids (0, 1, 2, ...), stored in a file
+// that is used in place (e.g. memory-mapped by the caller), thus it can be
+// shared across processes and loaded without building any table.
+//
+// Strings are looked up through a minimal perfect hash function (hash and
+// displace): each string falls into a bucket by its hash, and the
+// displacement stored for the bucket places all the strings of the bucket in
+// distinct slots 0, ..., N - 1. Each slot stores the id of its string, and
+// the strings are compared to detect strings that are not in the
+// vocabulary.
+//
+// File layout (integers in the byte order of the writer, which must be the
+// same as the reader's):
+//   char     magic[8]            "KWSVOC02"
+//   uint32_t byte_order          0x01020304, in the byte order of the writer
+//   uint32_t reserved            0
+//   uint64_t num_strings         N
+//   uint64_t num_buckets         B
+//   uint32_t displacement[B]
+//   uint32_t slot_id[N]          padded to a multiple of 8 bytes
+//   uint64_t offset[N + 1]       offset of each string in chars
+//   char     chars[offset[N]]
+class FrozenVocabulary {
+ public:
+  FrozenVocabulary()
+      : num_strings_(0), num_buckets_(0), displacement_(nullptr),
+        slot_id_(nullptr), offset_(nullptr), chars_(nullptr) {}
+
+  FrozenVocabulary(const FrozenVocabulary&) = delete;
+
+  FrozenVocabulary& operator=(const FrozenVocabulary&) = delete;
+
+  // Uses the vocabulary stored in the buffer [begin, end), which must
+  // outlive this object and be aligned to 8 bytes. All the ids and offsets
+  // are checked, thus Find() and String() stay within the buffer even if its
+  // content is corrupted.
+  bool Load(const char* begin, const char* end) {
+    const size_t size = end - begin;
+    if (size < kHeaderSize || std::memcmp(begin, kMagic, 8) != 0) {
+      return false;
+    }
+    uint32_t byte_order;
+    uint64_t n, b;
+    std::memcpy(&byte_order, begin + 8, sizeof(byte_order));
+    std::memcpy(&n, begin + 16, sizeof(n));
+    std::memcpy(&b, begin + 24, sizeof(b));
+    if (byte_order != kByteOrder) return false;
+    if (n >= (uint64_t(1) << 32) || b > n || (n > 0 && b == 0)) return false;
+    const size_t offset_pos = OffsetPosition(n, b);
+    if (size < offset_pos + 8 * (n + 1)) return false;
+    const uint32_t* displacement =
+        reinterpret_cast<const uint32_t*>(begin + kHeaderSize);
+    const uint32_t* slot_id = displacement + b;
+    for (uint64_t i = 0; i < n; ++i) {
+      if (slot_id[i] >= n) return false;
+    }
+    const uint64_t* offset =
+        reinterpret_cast<const uint64_t*>(begin + offset_pos);
+    const size_t chars_pos = offset_pos + 8 * (n + 1);
+    if (offset[0] != 0 || size - chars_pos < offset[n]) return false;
+    for (uint64_t i = 0; i < n; ++i) {
+      if (offset[i] > offset[i + 1]) return false;
+    }
+    num_strings_ = n;
+    num_buckets_ = b;
+    displacement_ = displacement;
+    slot_id_ = slot_id;
+    offset_ = offset;
+    chars_ = begin + chars_pos;
+    return true;
+  }
+
+  // Returns true and sets *id if the string [data, data + size) is in the
+  // vocabulary.
+  bool Find(const char* data, size_t size, uint32_t* id) const {
+    return Find(data, size, StringInternTable<uint32_t>::Hash(data, size), id);
+  }
+
+  // Same as above, given the hash of the string (see
+  // StringInternTable::Hash()).
+  bool Find(const char* data, size_t size, uint64_t h, uint32_t* id) const {
+    if (num_strings_ == 0) return false;
+    const uint32_t i = slot_id_[Slot(h, displacement_[Bucket(h, num_buckets_)],
+                                     num_strings_)];
+    if (offset_[i + 1] - offset_[i] != size ||
+        std::memcmp(chars_ + offset_[i], data, size) != 0) {
+      return false;
+    }
+    *id = i;
+    return true;
+  }
+
+  std::string String(uint32_t id) const {
+    return std::string(chars_ + offset_[id], offset_[id + 1] - offset_[id]);
+  }
+
+  inline size_t size() const { return num_strings_; }
+
+  inline bool empty() const { return num_strings_ == 0; }
+
+  // Writes a vocabulary file with the given strings, which must be distinct.
+  // The id of each string is its position in the vector.
+  static bool Write(const std::vector<std::string>& strings,
+                    const std::string& filepath) {
+    const uint64_t n = strings.size(), b = NumBuckets(n);
+    std::vector<uint64_t> hashes(n);
+    for (size_t i = 0; i < n; ++i) {
+      hashes[i] = StringInternTable<uint32_t>::Hash(strings[i].data(),
+                                                    strings[i].size());
+    }
+    std::vector<uint64_t> sorted_hashes(hashes);
+    std::sort(sorted_hashes.begin(), sorted_hashes.end());
+    if (std::adjacent_find(sorted_hashes.begin(), sorted_hashes.end()) !=
+        sorted_hashes.end()) {
+      std::cerr << "ERROR: The vocabulary contains repeated strings!"
+                << std::endl;
+      return false;
+    }
+    std::vector<uint32_t> displacement(b, 0), slot_id(n, 0);
+    if (!BuildHash(hashes, &displacement, &slot_id)) {
+      std::cerr << "ERROR: The vocabulary could not be hashed!" << std::endl;
+      return false;
+    }
+    std::vector<uint64_t> offset{0};
+    for (const std::string& s : strings) {
+      offset.push_back(offset.back() + s.size());
+    }
+
+    std::ofstream fs(filepath, std::ios_base::out | std::ios_base::binary);
+    if (!fs.is_open()) {
+      std::cerr << "ERROR: Vocabulary file \"" << filepath
+                << "\" could not be opened for write!" << std::endl;
+      return false;
+    }
+    const uint32_t header[2] = {kByteOrder, 0};
+    fs.write(kMagic, 8);
+    fs.write(reinterpret_cast<const char*>(header), sizeof(header));
+    fs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    fs.write(reinterpret_cast<const char*>(&b), sizeof(b));
+    fs.write(reinterpret_cast<const char*>(displacement.data()), 4 * b);
+    fs.write(reinterpret_cast<const char*>(slot_id.data()), 4 * n);
+    const char padding[8] = {0};
+    fs.write(padding, OffsetPosition(n, b) - kHeaderSize - 4 * (b + n));
+    fs.write(reinterpret_cast<const char*>(offset.data()), 8 * (n + 1));
+    for (const std::string& s : strings) fs.write(s.data(), s.size());
+    fs.close();
+    if (fs.fail()) {
+      std::cerr << "ERROR: Failed writing vocabulary file \"" << filepath
+                << "\"!" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr const char* kMagic = "KWSVOC02";
+  static const uint32_t kByteOrder = 0x01020304;
+  static const size_t kHeaderSize = 32;
+  // Average number of strings per bucket.
+  static const size_t kBucketSize = 4;
+  static const uint32_t kMaxDisplacement = 1u << 30;
+
+  static uint64_t NumBuckets(uint64_t n) {
+    return n == 0 ? 0 : (n + kBucketSize - 1) / kBucketSize;
+  }
+
+  static size_t OffsetPosition(uint64_t n, uint64_t b) {
+    return (kHeaderSize + 4 * (b + n) + 7) / 8 * 8;
+  }
+
+  static inline size_t Bucket(uint64_t h, uint64_t num_buckets) {
+    return (h >> 32) % num_buckets;
+  }
+
+  static inline size_t Slot(uint64_t h, uint32_t displacement,
+                            uint64_t num_slots) {
+    h ^= (displacement + 1) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h % num_slots;
+  }
+
+  // Finds a displacement for each bucket, processing the largest buckets
+  // first, such that all strings land in different slots.
+  static bool BuildHash(const std::vector<uint64_t>& hashes,
+                        std::vector<uint32_t>* displacement,
+                        std::vector<uint32_t>* slot_id) {
+    const size_t n = hashes.size(), b = displacement->size();
+    std::vector<std::vector<uint32_t>> buckets(b);
+    for (size_t i = 0; i < n; ++i) {
+      buckets[Bucket(hashes[i], b)].push_back(static_cast<uint32_t>(i));
+    }
+    std::vector<uint32_t> order(b);
+    for (size_t i = 0; i < b; ++i) order[i] = static_cast<uint32_t>(i);
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t x,
+                                                            uint32_t y) {
+        return buckets[x].size() > buckets[y].size();
+      });
+    std::vector<char> used(n, 0);
+    std::vector<size_t> slots;
+    for (const uint32_t k : order) {
+      const std::vector<uint32_t>& bucket = buckets[k];
+      if (bucket.empty()) break;
+      uint32_t d = 0;
+      for (; d < kMaxDisplacement; ++d) {
+        slots.clear();
+        bool ok = true;
+        for (const uint32_t i : bucket) {
+          const size_t s = Slot(hashes[i], d, n);
+          if (used[s] || std::find(slots.begin(), slots.end(), s) !=
+              slots.end()) {
+            ok = false;
+            break;
+          }
+          slots.push_back(s);
+        }
+        if (ok) break;
+      }
+      if (d == kMaxDisplacement) return false;
+      (*displacement)[k] = d;
+      for (size_t j = 0; j < bucket.size(); ++j) {
+        used[slots[j]] = 1;
+        (*slot_id)[slots[j]] = bucket[j];
+      }
+    }
+    return true;
+  }
+
+  uint64_t num_strings_;
+  uint64_t num_buckets_;
+  const uint32_t* displacement_;
+  const uint32_t* slot_id_;
+  const uint64_t* offset_;
+  const char* chars_;
+};
+
+}  // namespace mapper
+}  // namespace kws
+
+#endif  // MAPPER_FROZENVOCABULARY_H_
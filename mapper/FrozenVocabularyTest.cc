@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "mapper/ConcurrentStringToIntMapper.h"
+#include "mapper/FrozenVocabulary.h"
+
+using kws::mapper::ConcurrentStringToIntMapper;
+using kws::mapper::FrozenVocabulary;
+
+using testing::ElementsAre;
+
+class FrozenVocabularyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/FrozenVocabularyTest.XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    path_ = path;
+  }
+
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  // Reads the file into buffer_, aligned to 8 bytes, and loads it.
+  bool Load(FrozenVocabulary* vocabulary) {
+    std::ifstream fs(path_, std::ios_base::in | std::ios_base::binary);
+    data_.assign(std::istreambuf_iterator<char>(fs),
+                 std::istreambuf_iterator<char>());
+    return LoadData(vocabulary);
+  }
+
+  // Loads the (possibly modified) content of the file in data_.
+  bool LoadData(FrozenVocabulary* vocabulary) {
+    buffer_.assign((data_.size() + 7) / 8, 0);
+    if (!data_.empty()) std::memcpy(buffer_.data(), data_.data(), data_.size());
+    const char* begin = reinterpret_cast<const char*>(buffer_.data());
+    return vocabulary->Load(begin, begin + data_.size());
+  }
+
+  std::string path_;
+  std::string data_;
+  std::vector<uint64_t> buffer_;
+};
+
+TEST_F(FrozenVocabularyTest, WriteAndLoad) {
+  std::vector<std::string> strings;
+  for (int i = 0; i < 10000; ++i) {
+    strings.push_back("w" + std::to_string(i * 31 % 10000));
+  }
+  strings.push_back("");
+  ASSERT_TRUE(FrozenVocabulary::Write(strings, path_));
+  FrozenVocabulary vocabulary;
+  ASSERT_TRUE(Load(&vocabulary));
+  EXPECT_EQ(strings.size(), vocabulary.size());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    uint32_t id = 0;
+    EXPECT_TRUE(vocabulary.Find(strings[i].data(), strings[i].size(), &id));
+    EXPECT_EQ(i, id);
+    EXPECT_EQ(strings[i], vocabulary.String(id));
+  }
+  uint32_t id;
+  EXPECT_FALSE(vocabulary.Find("w10000", 6, &id));
+  EXPECT_FALSE(vocabulary.Find("x", 1, &id));
+}
+
+TEST_F(FrozenVocabularyTest, Empty) {
+  ASSERT_TRUE(FrozenVocabulary::Write({}, path_));
+  FrozenVocabulary vocabulary;
+  ASSERT_TRUE(Load(&vocabulary));
+  EXPECT_TRUE(vocabulary.empty());
+  uint32_t id;
+  EXPECT_FALSE(vocabulary.Find("a", 1, &id));
+}
+
+TEST_F(FrozenVocabularyTest, Errors) {
+  EXPECT_FALSE(FrozenVocabulary::Write({"a", "b", "a"}, path_));
+  std::ofstream(path_) << "not a vocabulary file";
+  FrozenVocabulary vocabulary;
+  EXPECT_FALSE(Load(&vocabulary));
+}
+
+TEST_F(FrozenVocabularyTest, Corrupted) {
+  // 8 strings, in 2 buckets: displacement[2] and slot_id[8] end at byte
+  // 72, followed by offset[9] and the chars.
+  const std::vector<std::string> strings{"a", "bb", "c", "dd", "e", "ff",
+                                         "g", "hh"};
+  ASSERT_TRUE(FrozenVocabulary::Write(strings, path_));
+  FrozenVocabulary vocabulary;
+  ASSERT_TRUE(Load(&vocabulary));
+  const std::string original = data_;
+  const size_t slot_id_pos = 32 + 4 * 2, offset_pos = 72;
+  // Slot with an invalid id.
+  const uint32_t bad_id = 8;
+  std::memcpy(&data_[slot_id_pos + 4 * 3], &bad_id, sizeof(bad_id));
+  EXPECT_FALSE(LoadData(&vocabulary));
+  // Decreasing offsets.
+  data_ = original;
+  const uint64_t bad_offset = 5;
+  std::memcpy(&data_[offset_pos + 8 * 2], &bad_offset, sizeof(bad_offset));
+  EXPECT_FALSE(LoadData(&vocabulary));
+  // Strings beyond the end of the file.
+  data_ = original;
+  data_.resize(data_.size() - 1);
+  EXPECT_FALSE(LoadData(&vocabulary));
+  // Different byte order.
+  data_ = original;
+  std::swap(data_[8], data_[11]);
+  std::swap(data_[9], data_[10]);
+  EXPECT_FALSE(LoadData(&vocabulary));
+  data_ = original;
+  EXPECT_TRUE(LoadData(&vocabulary));
+}
+
+TEST_F(FrozenVocabularyTest, ConcurrentStringToIntMapper) {
+  ASSERT_TRUE(FrozenVocabulary::Write({"c", "a"}, path_));
+  FrozenVocabulary vocabulary;
+  ASSERT_TRUE(Load(&vocabulary));
+  ConcurrentStringToIntMapper<int> m;
+  EXPECT_TRUE(m.SetVocabulary(&vocabulary));
+  EXPECT_EQ(m("a"), 1);
+  EXPECT_EQ(m("d"), 2);
+  EXPECT_EQ(m("b"), 3);
+  EXPECT_EQ(m("c"), 0);
+  EXPECT_EQ(m.size(), 4);
+  EXPECT_THAT(m.Strings(), ElementsAre("c", "a", "d", "b"));
+  // The ids of the vocabulary do not change.
+  EXPECT_THAT(m.Renumber({3, 1}), ElementsAre(0, 1, 3, 2));
+  EXPECT_THAT(m.Strings(), ElementsAre("c", "a", "b", "d"));
+  ConcurrentStringToIntMapper<int8_t> small;
+  EXPECT_TRUE(small.SetVocabulary(&vocabulary));
+}
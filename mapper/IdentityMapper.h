@@ -13,6 +13,8 @@ class IdentityMapper : public Mapper<T, T> {
   typedef T OutputType;
 
   OutputType operator()(const InputType &input) override { return input; }
+
+  bool IsStateless() const override { return true; }
 };
 
 }  // namespace mapper
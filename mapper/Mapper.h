@@ -10,7 +10,19 @@ class Mapper {
   using InputType = I;
   using OutputType = O;
 
+  virtual ~Mapper() {}
+
   virtual OutputType operator()(const InputType &input) = 0;
+
+  // Returns true if the output only depends on the input (e.g. it does not
+  // depend on the previous calls), so the mapper can be used concurrently
+  // from different threads.
+  virtual bool IsStateless() const { return false; }
+
+  // Returns true if the mapper can be used concurrently from different
+  // threads, even if it is not stateless (e.g. it is internally
+  // synchronized).
+  virtual bool IsThreadSafe() const { return IsStateless(); }
 };
 
 }  // namespace mapper
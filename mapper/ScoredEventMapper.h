@@ -23,6 +23,12 @@ class ScoredEventMapper : public Mapper<ScoredEvent<typename M::InputType>,
     return OutputType((*map_)(input), input.Score());
   }
 
+  EventMapper* GetEventMapper() const { return map_; }
+
+  bool IsStateless() const override { return map_->IsStateless(); }
+
+  bool IsThreadSafe() const override { return map_->IsThreadSafe(); }
+
  private:
   EventMapper *map_;
 };
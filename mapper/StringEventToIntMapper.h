@@ -12,32 +12,90 @@ namespace mapper {
 
 using kws::core::Event;
 
-template<typename Int>
+// Maps the query and the location of the events to integers, through string
+// mappers (by default, StringToIntMapper).
+//
+// By default, queries and locations are mapped by different string mappers,
+// thus query ids are dense in [0, NumQueries()) and location ids are dense
+// in [0, NumLocations()), so per-query state can be kept in flat vectors.
+// Alternatively, a single string mapper can be shared by queries and
+// locations.
+template<typename Int, typename StrMapper = StringToIntMapper<Int>>
 class StringEventToIntMapper :
     public Mapper<Event<std::string, std::string>, Event<Int, Int>> {
  public:
   typedef Event<std::string, std::string> InputType;
   typedef Event<Int, Int> OutputType;
+  typedef StrMapper StringMapper;
 
-  StringEventToIntMapper() : map_(new StringToIntMapper<Int>()), own_(true) {}
+  StringEventToIntMapper()
+      : query_map_(new StringMapper()), location_map_(new StringMapper()),
+        own_(true) {}
 
   StringEventToIntMapper(const StringEventToIntMapper &other)
-      : map_(other.map_), own_(false) {}
+      : query_map_(other.query_map_), location_map_(other.location_map_),
+        own_(false) {}
 
-  explicit StringEventToIntMapper(StringToIntMapper<Int> *map)
-      : map_(map), own_(false) {}
+  // Queries and locations share the same string mapper.
+  explicit StringEventToIntMapper(StringMapper *map)
+      : query_map_(map), location_map_(map), own_(false) {}
 
-  StringEventToIntMapper(StringToIntMapper<Int> *map, bool own)
-      : map_(map), own_(own) {}
+  StringEventToIntMapper(StringMapper *map, bool own)
+      : query_map_(map), location_map_(map), own_(own) {}
 
+  // Queries and locations are mapped by different string mappers.
+  StringEventToIntMapper(StringMapper *query_map, StringMapper *location_map,
+                         bool own = false)
+      : query_map_(query_map), location_map_(location_map), own_(own) {}
+
+  ~StringEventToIntMapper() {
+    if (own_) {
+      if (location_map_ != query_map_) delete location_map_;
+      delete query_map_;
+    }
+  }
+
+  // The location is mapped before the query. When the string mapper is
+  // shared, this is the order in which the ids were always assigned (by
+  // compilers evaluating function arguments from right to left), now
+  // explicit so that it can be reproduced (see
+  // ConcurrentStringToIntMapper::Renumber()).
   OutputType operator()(const InputType &input) override {
-    return OutputType((*map_)(input.Query()), (*map_)(input.Location()));
+    const Int location = (*location_map_)(input.Location());
+    return OutputType((*query_map_)(input.Query()), location);
+  }
+
+  // Same as above, for the query [query, query + query_size) and the
+  // location [location, location + location_size), e.g. tokens of the text
+  // being parsed, which are looked up without building strings.
+  OutputType operator()(const char* query, size_t query_size,
+                        const char* location, size_t location_size) {
+    const Int location_id = (*location_map_)(location, location_size);
+    return OutputType((*query_map_)(query, query_size), location_id);
+  }
+
+  bool IsThreadSafe() const override {
+    return query_map_->IsThreadSafe() && location_map_->IsThreadSafe();
   }
 
-  StringToIntMapper<Int>* GetMapper() const { return map_; }
+  // Same as GetQueryMapper().
+  StringMapper* GetMapper() const { return query_map_; }
+
+  StringMapper* GetQueryMapper() const { return query_map_; }
+
+  StringMapper* GetLocationMapper() const { return location_map_; }
+
+  inline bool SharesMapper() const { return query_map_ == location_map_; }
+
+  // Query ids are in the range [0, NumQueries()).
+  inline size_t NumQueries() const { return query_map_->size(); }
+
+  // Location ids are in the range [0, NumLocations()).
+  inline size_t NumLocations() const { return location_map_->size(); }
 
  private:
-  StringToIntMapper<Int> *map_;
+  StringMapper *query_map_;
+  StringMapper *location_map_;
   bool own_;
 };
 
@@ -14,6 +14,10 @@ TEST(StringEventToIntMapper, Constructor) {
   StringEventToIntMapper<int> m3(&sm);
   StringEventToIntMapper<int> m4(&sm, false);
   StringEventToIntMapper<int> m5(new StringToIntMapper<int>(), true);
+  StringToIntMapper<int> lm;
+  StringEventToIntMapper<int> m6(&sm, &lm);
+  StringEventToIntMapper<int> m7(new StringToIntMapper<int>(),
+                                 new StringToIntMapper<int>(), true);
 }
 
 TEST(StringEventToIntMapper, GetMapper) {
@@ -23,13 +27,22 @@ TEST(StringEventToIntMapper, GetMapper) {
   StringToIntMapper<int> sm;
   StringEventToIntMapper<int> m2(&sm);
   EXPECT_EQ(m2.GetMapper(), &sm);
+  EXPECT_EQ(m2.GetQueryMapper(), &sm);
+  EXPECT_EQ(m2.GetLocationMapper(), &sm);
+  EXPECT_TRUE(m2.SharesMapper());
+
+  StringToIntMapper<int> lm;
+  StringEventToIntMapper<int> m3(&sm, &lm);
+  EXPECT_EQ(m3.GetQueryMapper(), &sm);
+  EXPECT_EQ(m3.GetLocationMapper(), &lm);
+  EXPECT_FALSE(m3.SharesMapper());
 }
 
 TEST(StringEventToIntMapper, Simple) {
   typedef StringEventToIntMapper<int>::InputType InputEvent;
   typedef StringEventToIntMapper<int>::OutputType OutputEvent;
 
-  std::unordered_map<std::string, int> ht;
+  StringToIntMapper<int>::Impl ht;
   StringToIntMapper<int> sm(&ht);
   StringEventToIntMapper<int> em(&sm);
 
@@ -37,3 +50,17 @@ TEST(StringEventToIntMapper, Simple) {
   EXPECT_EQ(em(InputEvent("foo", "bar")), OutputEvent(0, 1));
   EXPECT_EQ(em(InputEvent("bar", "foo")), OutputEvent(1, 0));
 }
+
+TEST(StringEventToIntMapper, SeparateIdSpaces) {
+  typedef StringEventToIntMapper<int>::InputType InputEvent;
+  typedef StringEventToIntMapper<int>::OutputType OutputEvent;
+
+  StringEventToIntMapper<int> em;
+  EXPECT_FALSE(em.SharesMapper());
+  EXPECT_EQ(em(InputEvent("foo", "l1")), OutputEvent(0, 0));
+  EXPECT_EQ(em(InputEvent("foo", "l2")), OutputEvent(0, 1));
+  EXPECT_EQ(em(InputEvent("bar", "l3")), OutputEvent(1, 2));
+  EXPECT_EQ(em(InputEvent("l1", "foo")), OutputEvent(2, 3));
+  EXPECT_EQ(em.NumQueries(), 3);
+  EXPECT_EQ(em.NumLocations(), 4);
+}
@@ -0,0 +1,139 @@
+#ifndef MAPPER_STRINGINTERNTABLE_H_
+#define MAPPER_STRINGINTERNTABLE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace kws {
+namespace mapper {
+
+// Hash table assigning consecutive ids (0, 1, 2, ...) to strings, in the
+// order they are inserted.
+//
+// The characters of all strings are stored contiguously in a single arena,
+// and the table itself is a flat array of slots, resolved with linear
+// probing. Each slot keeps (part of) the hash of its string, so most
+// mismatching slots are skipped without comparing the strings. Lookups take
+// a pointer and a size, thus tokens do not need to be copied into a
+// std::string to be looked up.
+template <typename Int>
+class StringInternTable {
+ public:
+  StringInternTable() : offsets_{0}, slots_(kMinSlots), mask_(kMinSlots - 1) {}
+
+  // Returns true and sets *id if the string [data, data + size) is in the
+  // table.
+  bool Find(const char* data, size_t size, Int* id) const {
+    return Find(data, size, Hash(data, size), id);
+  }
+
+  // Same as above, given the hash of the string (see Hash()).
+  bool Find(const char* data, size_t size, uint64_t h, Int* id) const {
+    for (size_t i = h & mask_; slots_[i].id != 0; i = (i + 1) & mask_) {
+      if (slots_[i].hash == static_cast<uint32_t>(h >> 32) &&
+          Equals(slots_[i].id - 1, data, size)) {
+        *id = static_cast<Int>(slots_[i].id - 1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Adds the string [data, data + size), which must not be in the table, and
+  // returns its id.
+  Int Insert(const char* data, size_t size) {
+    return Insert(data, size, Hash(data, size));
+  }
+
+  // Same as above, given the hash of the string (see Hash()).
+  Int Insert(const char* data, size_t size, uint64_t h) {
+    const uint32_t id = static_cast<uint32_t>(offsets_.size() - 1);
+    arena_.append(data, size);
+    offsets_.push_back(arena_.size());
+    if (2 * offsets_.size() > slots_.size()) {
+      Rehash(2 * slots_.size());
+    } else {
+      Place(id, h);
+    }
+    return static_cast<Int>(id);
+  }
+
+  // Returns the string with the given id.
+  std::string String(Int id) const {
+    return arena_.substr(offsets_[id], offsets_[id + 1] - offsets_[id]);
+  }
+
+  inline size_t size() const { return offsets_.size() - 1; }
+
+  inline bool empty() const { return size() == 0; }
+
+  // Hashes the string 8 bytes at a time, followed by a final avalanche (from
+  // MurmurHash3). The low bits select the slot, the high bits are kept in
+  // the slot.
+  static uint64_t Hash(const char* data, size_t size) {
+    const uint64_t k1 = 0x87c37b91114253d5ull, k2 = 0x4cf5ad432745937full;
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ size;
+    for (; size >= 8; data += 8, size -= 8) {
+      uint64_t w;
+      std::memcpy(&w, data, sizeof(w));
+      h ^= w * k1;
+      h = ((h << 31) | (h >> 33)) * k2;
+    }
+    uint64_t w = 0;
+    std::memcpy(&w, data, size);
+    h ^= w * k1;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  void clear() {
+    arena_.clear();
+    offsets_.assign(1, 0);
+    slots_.assign(kMinSlots, Slot());
+    mask_ = kMinSlots - 1;
+  }
+
+ private:
+  static const size_t kMinSlots = 64;
+
+  struct Slot {
+    Slot() : hash(0), id(0) {}
+    uint32_t hash;  // High bits of the hash of the string.
+    uint32_t id;    // id + 1 of the string, 0 if the slot is empty.
+  };
+
+  bool Equals(uint32_t id, const char* data, size_t size) const {
+    return offsets_[id + 1] - offsets_[id] == size &&
+        std::memcmp(arena_.data() + offsets_[id], data, size) == 0;
+  }
+
+  void Place(uint32_t id, uint64_t h) {
+    size_t i = h & mask_;
+    while (slots_[i].id != 0) i = (i + 1) & mask_;
+    slots_[i].hash = static_cast<uint32_t>(h >> 32);
+    slots_[i].id = id + 1;
+  }
+
+  void Rehash(size_t num_slots) {
+    slots_.assign(num_slots, Slot());
+    mask_ = num_slots - 1;
+    for (uint32_t id = 0; id < size(); ++id) {
+      Place(id, Hash(arena_.data() + offsets_[id],
+                     offsets_[id + 1] - offsets_[id]));
+    }
+  }
+
+  std::string arena_;
+  std::vector<uint64_t> offsets_;
+  std::vector<Slot> slots_;
+  size_t mask_;
+};
+
+}  // namespace mapper
+}  // namespace kws
+
+#endif  // MAPPER_STRINGINTERNTABLE_H_
@@ -1,17 +1,21 @@
 #ifndef MAPPER_STRINGTOINTMAPPER_H_
 #define MAPPER_STRINGTOINTMAPPER_H_
 
-#include <exception>
+#include <stdexcept>
 #include <limits>
 #include <string>
 #include <unordered_map>
 
 #include "mapper/Mapper.h"
+#include "mapper/StringInternTable.h"
 
 namespace kws {
 namespace mapper {
 
-template<typename Int, typename M = std::unordered_map<std::string, Int>>
+// Assigns consecutive integer ids to strings, in the order they are first
+// seen. By default, the strings are stored in a StringInternTable, but any
+// map from std::string to Int (e.g. std::unordered_map) can be used.
+template<typename Int, typename M = StringInternTable<Int>>
 class StringToIntMapper : public Mapper<std::string, Int> {
  public:
   static_assert(std::is_integral<Int>::value, "Integral type required");
@@ -36,23 +40,54 @@ class StringToIntMapper : public Mapper<std::string, Int> {
   }
 
   OutputType operator()(const InputType &input) override {
-    const auto it = impl_->find(input);
-    if (it != impl_->end()) {
-      return it->second;
-    } else {
-      if (impl_->size() < kMaxSize) {
-        return impl_->emplace_hint(it, input, impl_->size())->second;
-      } else {
-        throw std::range_error(
-            "Max size reached (" + std::to_string(kMaxSize) + ")");
-      }
-    }
+    return Lookup(impl_, input);
+  }
+
+  // Same as above, for the string [data, data + size).
+  OutputType operator()(const char* data, size_t size) {
+    return Lookup(impl_, data, size);
   }
 
+  // Number of mapped strings.
+  inline size_t size() const { return impl_->size(); }
+
  private:
   static constexpr size_t kMaxSize =
       1 + static_cast<size_t>(std::numeric_limits<Int>::max());
 
+  static void CheckMaxSize(size_t size) {
+    if (size >= kMaxSize) {
+      throw std::range_error(
+          "Max size reached (" + std::to_string(kMaxSize) + ")");
+    }
+  }
+
+  template <typename T>
+  static OutputType Lookup(T* impl, const std::string& input) {
+    const auto it = impl->find(input);
+    if (it != impl->end()) return it->second;
+    CheckMaxSize(impl->size());
+    return impl->emplace_hint(it, input, impl->size())->second;
+  }
+
+  template <typename T>
+  static OutputType Lookup(T* impl, const char* data, size_t size) {
+    return Lookup(impl, std::string(data, size));
+  }
+
+  static OutputType Lookup(StringInternTable<Int>* impl,
+                           const std::string& input) {
+    return Lookup(impl, input.data(), input.size());
+  }
+
+  static OutputType Lookup(StringInternTable<Int>* impl,
+                           const char* data, size_t size) {
+    Int id;
+    if (impl->Find(data, size, &id)) return id;
+    CheckMaxSize(impl->size());
+    return impl->Insert(data, size);
+  }
+
   Impl *impl_;
   bool own_;
 };
@@ -0,0 +1,107 @@
+// Compares the time needed to map the tokens of some files (e.g. the
+// reference files in examples/SimpleKwsEval) to integers, using the default
+// StringToIntMapper (backed by a StringInternTable) and a StringToIntMapper
+// backed by a std::unordered_map.
+//
+// The tokens are mapped both from std::string objects and directly from the
+// buffer where the files were read (the way the text readers see them).
+//
+// Usage: StringToIntMapperBenchmark [--repeat N] file1 [file2 ...]
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/BenchmarkTime.h"
+#include "mapper/StringToIntMapper.h"
+
+using kws::core::benchmark::Time;
+using kws::mapper::StringToIntMapper;
+
+typedef StringToIntMapper<int32_t> InternMapper;
+typedef StringToIntMapper<int32_t, std::unordered_map<std::string, int32_t>>
+    HashMapMapper;
+typedef std::vector<std::pair<const char*, size_t>> Tokens;
+
+int main(int argc, char** argv) {
+  int repeat = 20;
+  std::string buffer;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = std::atoi(argv[++i]);
+      continue;
+    }
+    std::ifstream fs(argv[i]);
+    if (!fs.is_open()) {
+      std::cerr << "ERROR: File \"" << argv[i] << "\" could not be opened!"
+                << std::endl;
+      return 1;
+    }
+    std::ostringstream oss;
+    oss << fs.rdbuf();
+    buffer += oss.str();
+    buffer += '\n';
+  }
+
+  Tokens tokens;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < buffer.size();) {
+    while (i < buffer.size() && std::isspace(buffer[i])) ++i;
+    const size_t start = i;
+    while (i < buffer.size() && !std::isspace(buffer[i])) ++i;
+    if (i > start) {
+      tokens.emplace_back(buffer.data() + start, i - start);
+      strings.emplace_back(buffer.data() + start, i - start);
+    }
+  }
+  if (tokens.empty() || repeat < 1) {
+    std::cerr << "Usage: " << argv[0] << " [--repeat N] file1 [file2 ...]"
+              << std::endl;
+    return 1;
+  }
+
+  int64_t checksum[4] = {0, 0, 0, 0};
+  const double t_intern_buffer = Time(tokens.size(), repeat, [&]() {
+      InternMapper m;
+      for (const auto& t : tokens) checksum[0] += m(t.first, t.second);
+    });
+  const double t_hashmap_buffer = Time(tokens.size(), repeat, [&]() {
+      HashMapMapper m;
+      for (const auto& t : tokens) {
+        checksum[1] += m(std::string(t.first, t.second));
+      }
+    });
+  const double t_intern_string = Time(tokens.size(), repeat, [&]() {
+      InternMapper m;
+      for (const auto& s : strings) checksum[2] += m(s);
+    });
+  const double t_hashmap_string = Time(tokens.size(), repeat, [&]() {
+      HashMapMapper m;
+      for (const auto& s : strings) checksum[3] += m(s);
+    });
+  if (checksum[0] != checksum[1] || checksum[0] != checksum[2] ||
+      checksum[0] != checksum[3]) {
+    std::cerr << "ERROR: Mappers assigned different ids!" << std::endl;
+    return 1;
+  }
+
+  InternMapper::Impl table;
+  InternMapper mapper(&table);
+  for (const auto& t : tokens) mapper(t.first, t.second);
+  std::cout << "tokens = " << tokens.size()
+            << ", distinct = " << table.size() << std::endl;
+  std::cout << "From buffer:      StringInternTable = " << t_intern_buffer
+            << " ns/token, std::unordered_map = " << t_hashmap_buffer
+            << " ns/token" << std::endl;
+  std::cout << "From std::string: StringInternTable = " << t_intern_string
+            << " ns/token, std::unordered_map = " << t_hashmap_string
+            << " ns/token" << std::endl;
+  return 0;
+}
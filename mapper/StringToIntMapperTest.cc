@@ -1,32 +1,88 @@
 #include <gtest/gtest.h>
 
+#include <unordered_map>
+
+#include "mapper/StringInternTable.h"
 #include "mapper/StringToIntMapper.h"
 
+using kws::mapper::StringInternTable;
 using kws::mapper::StringToIntMapper;
 
 TEST(StringToIntMapper, Constructors) {
   StringToIntMapper<int> m1;
   StringToIntMapper<int> m2(m1);
-  std::unordered_map<std::string, int> ht;
+  StringInternTable<int> ht;
   StringToIntMapper<int> m3(&ht);
   StringToIntMapper<int> m4(&ht, false);
-  StringToIntMapper<int> m5(new std::unordered_map<std::string, int>(), true);
+  StringToIntMapper<int> m5(new StringInternTable<int>(), true);
 }
 
 TEST(StringToIntMapper, Simple) {
-  std::unordered_map<std::string, int> ht;
+  StringInternTable<int> ht;
   StringToIntMapper<int> m(&ht);
   EXPECT_EQ(m("s1"), 0);
   EXPECT_EQ(m("s2"), 1);
   EXPECT_EQ(m("s1"), 0);
   EXPECT_EQ(m("s3"), 2);
+  const std::string s = "s2s4";
+  EXPECT_EQ(m(s.data(), 2), 1);
+  EXPECT_EQ(m(s.data() + 2, 2), 3);
+  EXPECT_EQ(ht.String(3), "s4");
+}
+
+TEST(StringToIntMapper, UnorderedMap) {
+  typedef StringToIntMapper<int, std::unordered_map<std::string, int>> M;
+  M::Impl ht;
+  M m(&ht);
+  EXPECT_EQ(m("s1"), 0);
+  EXPECT_EQ(m("s2"), 1);
+  EXPECT_EQ(m("s1"), 0);
+  EXPECT_EQ(m("s3", 2), 2);
+  EXPECT_EQ(ht.size(), 3);
 }
 
 TEST(StringToIntMapper, RangeErrorException) {
-  std::unordered_map<std::string, int8_t> ht;
+  StringInternTable<int8_t> ht;
   StringToIntMapper<int8_t> m(&ht);
   for (uint8_t i = 0; i <= 127; ++i) {
     EXPECT_EQ(m("s" + std::to_string(i)), i);
   }
   EXPECT_THROW(m("except"), std::range_error);
 }
+
+TEST(StringInternTable, FindAndInsert) {
+  StringInternTable<int> t;
+  int id = -1;
+  EXPECT_TRUE(t.empty());
+  EXPECT_FALSE(t.Find("", 0, &id));
+  EXPECT_EQ(t.Insert("", 0), 0);
+  EXPECT_EQ(t.Insert("ab", 2), 1);
+  EXPECT_TRUE(t.Find("", 0, &id));
+  EXPECT_EQ(id, 0);
+  EXPECT_TRUE(t.Find("abc", 2, &id));
+  EXPECT_EQ(id, 1);
+  EXPECT_FALSE(t.Find("abc", 3, &id));
+  EXPECT_EQ(t.size(), 2);
+  EXPECT_EQ(t.String(0), "");
+  EXPECT_EQ(t.String(1), "ab");
+  t.clear();
+  EXPECT_TRUE(t.empty());
+  EXPECT_FALSE(t.Find("ab", 2, &id));
+}
+
+TEST(StringInternTable, Rehash) {
+  StringInternTable<int> t;
+  for (int i = 0; i < 10000; ++i) {
+    const std::string s = std::to_string(i);
+    EXPECT_EQ(t.Insert(s.data(), s.size()), i);
+  }
+  for (int i = 0; i < 10000; ++i) {
+    const std::string s = std::to_string(i);
+    int id = -1;
+    EXPECT_TRUE(t.Find(s.data(), s.size(), &id));
+    EXPECT_EQ(id, i);
+    EXPECT_EQ(t.String(i), s);
+  }
+  int id;
+  EXPECT_FALSE(t.Find("10000", 5, &id));
+}
@@ -1,6 +1,8 @@
 #ifndef MATCHER_MATCHER_H_
 #define MATCHER_MATCHER_H_
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
 #include "core/Match.h"
@@ -20,6 +22,34 @@ class Matcher {
 
   virtual Result Match(const std::vector<RE>& refs,
                        const std::vector<HE>& hyps) = 0;
+
+  // Incremental interface: the hypotheses are given in several batches,
+  // after calling BeginMatch() with all the references. Matches are appended
+  // to *result as they are known, and the final result is the same as the
+  // one obtained calling Match() with all the hypotheses.
+  //
+  // By default, all the hypotheses are kept until EndMatch() is called, and
+  // then Match() is used. Matchers that can process the hypotheses as they
+  // arrive should override these methods.
+  virtual void BeginMatch(const std::vector<RE>& refs) {
+    pending_refs_ = refs;
+    pending_hyps_.clear();
+  }
+
+  virtual void MatchBatch(const std::vector<HE>& hyps, Result* result) {
+    pending_hyps_.insert(pending_hyps_.end(), hyps.begin(), hyps.end());
+  }
+
+  virtual void EndMatch(Result* result) {
+    Result r = Match(pending_refs_, pending_hyps_);
+    std::move(r.begin(), r.end(), std::back_inserter(*result));
+    pending_refs_.clear();
+    pending_hyps_.clear();
+  }
+
+ private:
+  std::vector<RE> pending_refs_;
+  std::vector<HE> pending_hyps_;
 };
 
 }  // namespace matcher
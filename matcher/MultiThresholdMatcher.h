@@ -0,0 +1,202 @@
+#ifndef MATCHER_MULTITHRESHOLDMATCHER_H_
+#define MATCHER_MULTITHRESHOLDMATCHER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/EventSet.h"
+#include "core/Match.h"
+#include "core/MatchError.h"
+#include "matcher/Matcher.h"
+#include "scorer/OverlapScorer.h"
+
+namespace kws {
+namespace matcher {
+
+using kws::core::EventSet;
+using kws::core::MatchError;
+using kws::scorer::OverlapScorer;
+
+// Matches the hypotheses against the references with several overlap
+// thresholds at once, giving for each threshold the same matches (and
+// repeated matches) as the SimpleMatcher with an OverlapScorer using that
+// threshold.
+//
+// The references overlapping each hypothesis are found, and their overlap
+// computed, only once. Then, the greedy assignment of the SimpleMatcher is
+// resolved for each threshold, keeping the matched references of each
+// threshold in a separate bitset.
+//
+// As a Matcher, the result are the matches with the threshold of the scorer.
+// The matches with all thresholds are available with GetMatches(), after
+// EndMatch() (or Match()) is called.
+template <class RE, class HE>
+class MultiThresholdMatcher : public Matcher<RE, HE> {
+ public:
+  typedef RE RefEvent;
+  typedef HE HypEvent;
+  typedef typename Matcher<RE, HE>::MatchType MatchType;
+  typedef typename Matcher<RE, HE>::Result Result;
+
+  explicit MultiThresholdMatcher(OverlapScorer<RE, HE>* scorer,
+                                 const std::vector<float>& thresholds = {})
+      : scorer_(scorer), refs_set_(new EventSet<RE>()), words_(0) {
+    SetThresholds(thresholds);
+  }
+
+  // Sets the thresholds to match with, in addition to the threshold of the
+  // scorer, which is always used.
+  void SetThresholds(const std::vector<float>& thresholds) {
+    thresholds_ = thresholds;
+    thresholds_.push_back(scorer_->Threshold());
+    std::sort(thresholds_.begin(), thresholds_.end());
+    thresholds_.erase(std::unique(thresholds_.begin(), thresholds_.end()),
+                      thresholds_.end());
+    scorer_threshold_ = std::lower_bound(
+        thresholds_.begin(), thresholds_.end(), scorer_->Threshold()) -
+        thresholds_.begin();
+  }
+
+  // All the thresholds, sorted in increasing order.
+  inline const std::vector<float>& Thresholds() const { return thresholds_; }
+
+  inline size_t NumThresholds() const { return thresholds_.size(); }
+
+  // Position of the threshold of the scorer in Thresholds().
+  inline size_t ScorerThreshold() const { return scorer_threshold_; }
+
+  Result Match(const std::vector<RE>& refs, const std::vector<HE>& hyps)
+      override {
+    Result result;
+    BeginMatch(refs);
+    MatchBatch(hyps, &result);
+    EndMatch(&result);
+    return result;
+  }
+
+  void BeginMatch(const std::vector<RE>& refs) override {
+    // The set gives ids 0, 1, ... to the distinct references, in order, thus
+    // the id of each reference is its position in refs_.
+    refs_set_->Clear();
+    refs_.clear();
+    for (const RE& ref : refs) {
+      refs_set_->Insert(ref);
+      if (refs_set_->Size() > refs_.size()) refs_.push_back(ref);
+    }
+    refs_set_->BuildIndex();
+    words_ = (refs_.size() + 63) / 64;
+    matched_.assign(thresholds_.size() * words_, 0);
+    matches_.assign(thresholds_.size(), Result());
+    repeated_matches_.assign(thresholds_.size(), Result());
+  }
+
+  // Appends the matches with the threshold of the scorer to *result.
+  void MatchBatch(const std::vector<HE>& hyps, Result* result) override {
+    Result& scorer_matches = matches_[scorer_threshold_];
+    const size_t first = scorer_matches.size();
+    for (const HE& hyp : hyps) {
+      refs_set_->FindOverlapping(hyp, &overlapping_refs_);
+      overlaps_.clear();
+      for (const auto& overlap : overlapping_refs_) {
+        overlaps_.push_back(
+            EventSet<RE>::kOverlapIsIntersectionArea
+            ? scorer_->IntersectionOverlap(*overlap.event, hyp, overlap.area)
+            : scorer_->Overlap(*overlap.event, hyp));
+      }
+      for (size_t t = 0; t < thresholds_.size(); ++t) {
+        MatchHypothesis(hyp, t);
+      }
+    }
+    result->insert(result->end(), scorer_matches.begin() + first,
+                   scorer_matches.end());
+  }
+
+  // Appends the false negatives with the threshold of the scorer to *result.
+  void EndMatch(Result* result) override {
+    // False negatives are sorted as in the SimpleMatcher.
+    std::vector<uint32_t> order(refs_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(order.begin(), order.end(),
+              [this](uint32_t a, uint32_t b) { return refs_[a] < refs_[b]; });
+    for (size_t t = 0; t < thresholds_.size(); ++t) {
+      for (const uint32_t id : order) {
+        if (!IsMatched(t, id)) {
+          matches_[t].push_back(MatchType::MakeFalseNegative(refs_[id]));
+          if (t == scorer_threshold_) result->push_back(matches_[t].back());
+        }
+      }
+    }
+    refs_.clear();
+    matched_.clear();
+  }
+
+  // Repeated matches with the threshold of the scorer.
+  const Result& GetRepeatedMatches() const {
+    return repeated_matches_[scorer_threshold_];
+  }
+
+  // Matches and repeated matches with Thresholds()[t].
+  const Result& GetMatches(size_t t) const { return matches_[t]; }
+
+  const Result& GetRepeatedMatches(size_t t) const {
+    return repeated_matches_[t];
+  }
+
+ private:
+  inline bool IsMatched(size_t t, uint32_t id) const {
+    return (matched_[t * words_ + id / 64] >> (id % 64)) & 1;
+  }
+
+  inline void SetMatched(size_t t, uint32_t id) {
+    matched_[t * words_ + id / 64] |= uint64_t(1) << (id % 64);
+  }
+
+  // Matches the hypothesis with the threshold t, as the SimpleMatcher does,
+  // using the overlaps computed for the references in overlapping_refs_.
+  void MatchHypothesis(const HE& hyp, size_t t) {
+    const float threshold = thresholds_[t];
+    bool matched_hyp = false;
+    for (size_t i = 0; i < overlapping_refs_.size(); ++i) {
+      if (overlaps_[i] < threshold) continue;
+      matched_hyp = true;
+      const auto& overlap = overlapping_refs_[i];
+      if (!IsMatched(t, overlap.id)) {
+        SetMatched(t, overlap.id);
+        matches_[t].emplace_back(*overlap.event, hyp, MatchError{0.0f, 0.0f});
+        return;
+      }
+      repeated_matches_[t].emplace_back(*overlap.event, hyp,
+                                        MatchError{0.0f, 0.0f});
+    }
+    if (!matched_hyp) {
+      matches_[t].push_back(MatchType::MakeFalsePositive(hyp));
+    }
+  }
+
+  OverlapScorer<RE, HE>* scorer_;
+  std::vector<float> thresholds_;
+  size_t scorer_threshold_;
+  std::unique_ptr<EventSet<RE>> refs_set_;
+  // Buffers reused to find the references overlapping each hypothesis, and
+  // their overlap.
+  std::vector<typename EventSet<RE>::Overlap> overlapping_refs_;
+  std::vector<float> overlaps_;
+  // Distinct references given to BeginMatch(), by id.
+  std::vector<RE> refs_;
+  // Bitsets of the matched references (by id) with each threshold, of
+  // words_ words each.
+  std::vector<uint64_t> matched_;
+  size_t words_;
+  // Matches and repeated matches with each threshold.
+  std::vector<Result> matches_;
+  std::vector<Result> repeated_matches_;
+};
+
+}  // namespace matcher
+}  // namespace kws
+
+#endif  // MATCHER_MULTITHRESHOLDMATCHER_H_
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "matcher/MultiThresholdMatcher.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/IntersectionOverHypothesisAreaScorer.h"
+#include "scorer/IntersectionOverUnionAreaScorer.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::matcher::MultiThresholdMatcher;
+using kws::matcher::SimpleMatcher;
+using kws::scorer::IntersectionOverHypothesisAreaScorer;
+using kws::scorer::IntersectionOverUnionAreaScorer;
+
+typedef DocumentIdBoundingBox<int> Box;
+typedef ShapedEvent<int32_t, Box> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+
+class MultiThresholdMatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Hypotheses overlapping several references (and each other), with
+    // repeated references.
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int32_t> query(0, 9);
+    std::uniform_int_distribution<int> coord(0, 100), size(10, 40);
+    const char* documents[] = {"d1", "d2"};
+    auto random_box = [&]() {
+      return Box(documents[rng() % 2], coord(rng), coord(rng), size(rng),
+                 size(rng));
+    };
+    for (int i = 0; i < 300; ++i) refs_.emplace_back(query(rng), random_box());
+    refs_.push_back(refs_[0]);
+    for (int i = 0; i < 1000; ++i) {
+      hyps_.emplace_back(query(rng), random_box(), (rng() % 100) / 100.0f);
+    }
+    thresholds_ = {0.1f, 0.25f, 0.75f, 0.9f, 0.5f};
+  }
+
+  // Each threshold gives the same matches as the SimpleMatcher.
+  template <template <class, class> class S>
+  void ExpectSameMatches() {
+    S<RefEvent, HypEvent> scorer(0.5f);
+    MultiThresholdMatcher<RefEvent, HypEvent> matcher(&scorer, thresholds_);
+    ASSERT_EQ(5, matcher.NumThresholds());
+    EXPECT_EQ(0.5f, matcher.Thresholds()[matcher.ScorerThreshold()]);
+    const auto result = matcher.Match(refs_, hyps_);
+    EXPECT_EQ(matcher.GetMatches(matcher.ScorerThreshold()), result);
+    for (size_t t = 0; t < matcher.NumThresholds(); ++t) {
+      S<RefEvent, HypEvent> threshold_scorer(matcher.Thresholds()[t]);
+      SimpleMatcher<RefEvent, HypEvent> simple(&threshold_scorer);
+      EXPECT_EQ(simple.Match(refs_, hyps_), matcher.GetMatches(t))
+          << "Threshold " << matcher.Thresholds()[t];
+      EXPECT_EQ(simple.GetRepeatedMatches(), matcher.GetRepeatedMatches(t))
+          << "Threshold " << matcher.Thresholds()[t];
+    }
+  }
+
+  std::vector<RefEvent> refs_;
+  std::vector<HypEvent> hyps_;
+  std::vector<float> thresholds_;
+};
+
+TEST_F(MultiThresholdMatcherTest, IntersectionOverHypothesisArea) {
+  ExpectSameMatches<IntersectionOverHypothesisAreaScorer>();
+}
+
+TEST_F(MultiThresholdMatcherTest, IntersectionOverUnionArea) {
+  ExpectSameMatches<IntersectionOverUnionAreaScorer>();
+}
+
+TEST_F(MultiThresholdMatcherTest, ScorerThresholdIsAlwaysUsed) {
+  IntersectionOverUnionAreaScorer<RefEvent, HypEvent> scorer(0.3f);
+  MultiThresholdMatcher<RefEvent, HypEvent> matcher(&scorer, {0.5f, 0.1f});
+  EXPECT_EQ((std::vector<float>{0.1f, 0.3f, 0.5f}), matcher.Thresholds());
+  EXPECT_EQ(1, matcher.ScorerThreshold());
+  // Incremental interface.
+  std::vector<kws::core::Match<RefEvent, HypEvent>> result;
+  matcher.BeginMatch(refs_);
+  matcher.MatchBatch(std::vector<HypEvent>(hyps_.begin(), hyps_.begin() + 10),
+                     &result);
+  matcher.MatchBatch(std::vector<HypEvent>(hyps_.begin() + 10, hyps_.end()),
+                     &result);
+  matcher.EndMatch(&result);
+  SimpleMatcher<RefEvent, HypEvent> simple(&scorer);
+  EXPECT_EQ(simple.Match(refs_, hyps_), result);
+  EXPECT_EQ(simple.GetRepeatedMatches(), matcher.GetRepeatedMatches());
+}
@@ -0,0 +1,141 @@
+#ifndef MATCHER_ONLINEMATCHER_H_
+#define MATCHER_ONLINEMATCHER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "core/IncrementalAP.h"
+#include "core/MatchError.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/Scorer.h"
+
+namespace kws {
+namespace matcher {
+
+using kws::core::IncrementalAP;
+using kws::core::MatchError;
+using kws::scorer::Scorer;
+
+// Matches a stream of hypotheses, given one at a time in decreasing order of
+// score (e.g. as a retrieval engine produces them), against a fixed set of
+// references, and keeps the running counts of true positives, false
+// positives and false negatives, and the Average Precision, of each query
+// and of all the queries (global AP and mean AP). All of them can be read
+// at any point in O(1) time, and are the same as the ones computed from the
+// matches of the SimpleMatcher with the hypotheses given so far.
+//
+// The matches themselves are not kept, thus the memory used is bounded by
+// the number of references (and queries), regardless of the number of
+// hypotheses. Queries are not grouped (see GroupMatchesByQueryGroup), and
+// the AP uses the plain (not interpolated) precision, see IncrementalAP.
+//
+// S is the type of the scorer, as in the SimpleMatcher.
+template <class RE, class HE, class S = Scorer<RE, HE>>
+class OnlineMatcher {
+ public:
+  typedef RE RefEvent;
+  typedef HE HypEvent;
+  typedef typename RE::QType QType;
+
+  explicit OnlineMatcher(S* scorer, bool collapse_matches = true,
+                         bool trapezoid_integral = true)
+      : matcher_(scorer), collapse_matches_(collapse_matches),
+        trapezoid_integral_(trapezoid_integral),
+        global_(collapse_matches, trapezoid_integral), sum_ap_(0.0),
+        num_updates_(0), num_hyps_(0),
+        last_score_(std::numeric_limits<float>::infinity()) {}
+
+  // Indexes the references, and resets all the metrics.
+  void BeginMatch(const std::vector<RE>& refs) {
+    matcher_.BeginMatch(refs);
+    queries_.clear();
+    const std::vector<RE>& distinct_refs = matcher_.GetReferences();
+    for (const RE& ref : distinct_refs) {
+      IncrementalAP& ap = GetQuery(ref.Query());
+      ap.SetNumReferences(ap.NumReferences() + 1);
+    }
+    global_ = IncrementalAP(collapse_matches_, trapezoid_integral_,
+                            distinct_refs.size());
+    sum_ap_ = 0.0;
+    num_updates_ = 0;
+    num_hyps_ = 0;
+    last_score_ = std::numeric_limits<float>::infinity();
+  }
+
+  // Matches the next hypothesis of the stream, whose score must not be
+  // greater than the score of the previous one, and updates the metrics of
+  // its query and the global ones. Returns false if the hypothesis gives no
+  // match (see SimpleMatcher::MatchOne()).
+  bool Add(const HE& hyp) {
+    assert(!(hyp.Score() > last_score_));
+    last_score_ = hyp.Score();
+    ++num_hyps_;
+    MatchError errors;
+    if (!matcher_.MatchOne(hyp, &errors)) return false;
+    IncrementalAP& ap = GetQuery(hyp.Query());
+    sum_ap_ -= ap.AP();
+    ap.Add(hyp.Score(), errors);
+    sum_ap_ += ap.AP();
+    // Each update of the running sum adds a rounding error, thus the sum is
+    // recomputed from scratch after as many updates as queries. This bounds
+    // the error of MeanAP() to a few NumQueries() ulps, independently of
+    // the number of hypotheses, in O(1) amortized time per hypothesis.
+    if (++num_updates_ >= queries_.size()) {
+      sum_ap_ = 0.0;
+      for (const auto& query_ap : queries_) sum_ap_ += query_ap.second.AP();
+      num_updates_ = 0;
+    }
+    global_.Add(hyp.Score(), errors);
+    return true;
+  }
+
+  // Number of hypotheses given to Add() since BeginMatch().
+  inline size_t NumHypotheses() const { return num_hyps_; }
+
+  // Metrics of all the matches (TP, FP, FN, precision, recall and global
+  // AP).
+  inline const IncrementalAP& Global() const { return global_; }
+
+  // Metrics of the given query, or null if the query has no references and
+  // no hypothesis has matched it yet.
+  const IncrementalAP* Query(const QType& query) const {
+    const auto it = queries_.find(query);
+    return it != queries_.end() ? &it->second : nullptr;
+  }
+
+  // Number of queries with references or matches, which are the ones
+  // averaged by MeanAP().
+  inline size_t NumQueries() const { return queries_.size(); }
+
+  inline double MeanAP() const {
+    return queries_.empty() ? 0.0 : sum_ap_ / queries_.size();
+  }
+
+ private:
+  IncrementalAP& GetQuery(const QType& query) {
+    return queries_.emplace(
+        query, IncrementalAP(collapse_matches_, trapezoid_integral_))
+        .first->second;
+  }
+
+  SimpleMatcher<RE, HE, S> matcher_;
+  bool collapse_matches_;
+  bool trapezoid_integral_;
+  IncrementalAP global_;
+  std::unordered_map<QType, IncrementalAP> queries_;
+  // Sum of the AP of all the queries, and number of updates since it was
+  // last recomputed.
+  double sum_ap_;
+  size_t num_updates_;
+  size_t num_hyps_;
+  // Score of the last hypothesis given to Add().
+  float last_score_;
+};
+
+}  // namespace matcher
+}  // namespace kws
+
+#endif  // MATCHER_ONLINEMATCHER_H_
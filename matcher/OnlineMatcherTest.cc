@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "core/Assessment.h"
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/Event.h"
+#include "core/IntegerEventSet.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "matcher/OnlineMatcher.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/IntersectionOverHypothesisAreaScorer.h"
+#include "scorer/TrivialScorer.h"
+
+using kws::core::ComputeGlobalAP;
+using kws::core::ComputeMeanAP;
+using kws::core::DocumentIdBoundingBox;
+using kws::core::Event;
+using kws::core::GroupMatchesByQueryGroup;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::matcher::OnlineMatcher;
+using kws::matcher::SimpleMatcher;
+using kws::scorer::IntersectionOverHypothesisAreaScorer;
+using kws::scorer::TrivialScorer;
+
+// After each hypothesis of the stream, the metrics of the OnlineMatcher are
+// the same as the ones computed from the matches of the SimpleMatcher with
+// the hypotheses given so far.
+template <class RE, class HE, class S>
+static void ExpectSameMetrics(const std::vector<RE>& refs,
+                              std::vector<HE> hyps, S* scorer) {
+  std::stable_sort(hyps.begin(), hyps.end(),
+                   [](const HE& a, const HE& b) {
+                     return a.Score() > b.Score();
+                   });
+  for (bool collapse : {false, true}) {
+    for (bool trapezoid : {false, true}) {
+      OnlineMatcher<RE, HE, S> online(scorer, collapse, trapezoid);
+      online.BeginMatch(refs);
+      SimpleMatcher<RE, HE> simple(scorer);
+      std::vector<HE> prefix;
+      for (size_t h = 0; h < hyps.size(); ++h) {
+        online.Add(hyps[h]);
+        prefix.push_back(hyps[h]);
+        // Check every few hypotheses, and always the last one.
+        if (h % 7 != 0 && h + 1 != hyps.size()) continue;
+        const auto matches = simple.Match(refs, prefix);
+        size_t tp = 0, fp = 0, fn = 0;
+        for (const auto& m : matches) {
+          if (m.HasRef() && m.HasHyp()) ++tp;
+          else if (m.HasHyp()) ++fp;
+          else ++fn;
+        }
+        std::vector<typename std::decay<decltype(matches)>::type>
+            matches_by_query;
+        GroupMatchesByQueryGroup(matches, std::map<int32_t, int32_t>(),
+                                 &matches_by_query);
+        EXPECT_EQ(prefix.size(), online.NumHypotheses());
+        EXPECT_EQ(tp, online.Global().TP());
+        EXPECT_EQ(fp, online.Global().FP());
+        EXPECT_EQ(fn, online.Global().FN());
+        EXPECT_NEAR(ComputeGlobalAP(matches, collapse, false, trapezoid),
+                    online.Global().AP(), 1e-9)
+            << "After " << h + 1 << " hypotheses";
+        EXPECT_EQ(matches_by_query.size(), online.NumQueries());
+        EXPECT_NEAR(ComputeMeanAP(matches_by_query, collapse, false,
+                                  trapezoid, false),
+                    online.MeanAP(), 1e-9)
+            << "After " << h + 1 << " hypotheses";
+        for (const auto& query_matches : matches_by_query) {
+          const auto& m = query_matches.front();
+          const int32_t query =
+              m.HasRef() ? m.GetRef().Query() : m.GetHyp().Query();
+          ASSERT_NE(nullptr, online.Query(query));
+          EXPECT_NEAR(ComputeGlobalAP(query_matches, collapse, false,
+                                      trapezoid),
+                      online.Query(query)->AP(), 1e-9)
+              << "Query " << query << " after " << h + 1 << " hypotheses";
+        }
+      }
+    }
+  }
+}
+
+TEST(OnlineMatcherTest, Empty) {
+  typedef Event<int32_t, int32_t> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  TrivialScorer<RefEvent, HypEvent> scorer;
+  OnlineMatcher<RefEvent, HypEvent> online(&scorer);
+  online.BeginMatch({});
+  EXPECT_EQ(0, online.NumQueries());
+  EXPECT_EQ(0.0, online.MeanAP());
+  EXPECT_EQ(0.0, online.Global().AP());
+  EXPECT_EQ(nullptr, online.Query(1));
+  online.BeginMatch({RefEvent(1, 1), RefEvent(1, 1), RefEvent(2, 1)});
+  EXPECT_EQ(2, online.NumQueries());
+  EXPECT_EQ(2, online.Global().NumReferences());
+  EXPECT_EQ(1, online.Query(1)->NumReferences());
+  EXPECT_EQ(0.0, online.MeanAP());
+  // A hypothesis matching an already matched reference gives no match.
+  EXPECT_TRUE(online.Add(HypEvent(1, 1, 0.9f)));
+  EXPECT_FALSE(online.Add(HypEvent(1, 1, 0.8f)));
+  EXPECT_TRUE(online.Add(HypEvent(3, 1, 0.7f)));
+  EXPECT_EQ(3, online.NumQueries());
+  EXPECT_EQ(1.0, online.Query(1)->AP());
+  EXPECT_EQ(0.0, online.Query(2)->AP());
+  EXPECT_EQ(0.0, online.Query(3)->AP());
+}
+
+TEST(OnlineMatcherTest, IntegerEvents) {
+  typedef Event<int32_t, int32_t> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  std::mt19937 rng(12345);
+  std::geometric_distribution<int32_t> query(0.2);
+  std::uniform_int_distribution<int32_t> location(0, 30);
+  std::vector<RefEvent> refs;
+  std::vector<HypEvent> hyps;
+  for (int i = 0; i < 150; ++i) refs.emplace_back(query(rng), location(rng));
+  // Scores with ties.
+  for (int i = 0; i < 300; ++i) {
+    hyps.emplace_back(query(rng), location(rng), (rng() % 20) / 20.0f);
+  }
+  TrivialScorer<RefEvent, HypEvent> scorer;
+  ExpectSameMetrics(refs, hyps, &scorer);
+}
+
+TEST(OnlineMatcherTest, DocumentBoxEvents) {
+  typedef DocumentIdBoundingBox<uint32_t> Box;
+  typedef ShapedEvent<int32_t, Box> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  std::mt19937 rng(12345);
+  std::geometric_distribution<int32_t> query(0.3);
+  std::uniform_int_distribution<uint32_t> coord(0, 100), size(10, 40);
+  auto random_box = [&]() {
+    return Box(rng() % 2 ? "d1" : "d2", coord(rng), coord(rng), size(rng),
+               size(rng));
+  };
+  std::vector<RefEvent> refs;
+  std::vector<HypEvent> hyps;
+  for (int i = 0; i < 100; ++i) refs.emplace_back(query(rng), random_box());
+  for (int i = 0; i < 300; ++i) {
+    hyps.emplace_back(query(rng), random_box(), (rng() % 100) / 100.0f);
+  }
+  IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> scorer(0.5);
+  ExpectSameMetrics(refs, hyps, &scorer);
+}
@@ -0,0 +1,320 @@
+#ifndef MATCHER_PARALLELMATCHER_H_
+#define MATCHER_PARALLELMATCHER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "core/Match.h"
+#include "core/WorkStealingPool.h"
+#include "matcher/Matcher.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/Scorer.h"
+
+namespace kws {
+namespace matcher {
+
+using kws::core::WorkStealingPool;
+using kws::scorer::Scorer;
+
+// Matcher that gives exactly the same result as the SimpleMatcher (including
+// the repeated matches), computed in parallel.
+//
+// Hypotheses are only matched against references of the same query (the
+// EventSets only return events of the same query), thus the events are
+// partitioned by query and each partition is matched independently with a
+// SimpleMatcher, on a WorkStealingPool (the size of the partitions is usually
+// very uneven). The matches of all partitions are then merged following the
+// order of the hypotheses, and the false negatives are sorted as the
+// SimpleMatcher does.
+//
+// The scorer is shared by all threads, thus it must be thread-safe (all the
+// scorers in this library are). S is the type of the scorer, as in the
+// SimpleMatcher.
+template <class RE, class HE, class S = Scorer<RE, HE>>
+class ParallelMatcher : public Matcher<RE, HE> {
+ public:
+  typedef RE RefEvent;
+  typedef HE HypEvent;
+  typedef typename Matcher<RE, HE>::MatchType MatchType;
+  typedef typename Matcher<RE, HE>::Result Result;
+
+  // If num_threads is 0, use as many threads as hardware threads.
+  explicit ParallelMatcher(S* scorer, size_t num_threads = 0)
+      : scorer_(scorer), serial_(scorer), pool_(num_threads) {}
+
+  inline size_t NumThreads() const { return pool_.NumThreads(); }
+
+  void SetNumThreads(size_t num_threads) {
+    pool_.SetNumThreads(num_threads);
+  }
+
+  Result Match(const std::vector<RE>& refs, const std::vector<HE>& hyps)
+      override {
+    repeated_matches_.clear();
+    if (pool_.NumThreads() == 1) {
+      Result result = serial_.Match(refs, hyps);
+      repeated_matches_ = serial_.GetRepeatedMatches();
+      return result;
+    }
+
+    std::vector<Partition> partitions;
+    std::vector<uint32_t> hyp_partition;
+    MakePartitions(refs, hyps, &partitions, &hyp_partition);
+    std::vector<size_t> costs;
+    costs.reserve(partitions.size());
+    for (const Partition& p : partitions) {
+      // The EventSets are indexed, thus the cost of matching is roughly
+      // linear in the number of events.
+      costs.push_back(p.refs.size() + p.hyps.size());
+    }
+    std::vector<std::unique_ptr<SimpleMatcher<RE, HE, S>>> matchers(
+        std::min(pool_.NumThreads(), partitions.size()));
+    pool_.Run(costs, [this, &partitions, &matchers](size_t p, size_t w) {
+        if (!matchers[w]) {
+          matchers[w].reset(new SimpleMatcher<RE, HE, S>(scorer_));
+        }
+        Partition& partition = partitions[p];
+        matchers[w]->MatchIndexed(partition.refs, partition.hyps,
+                                  &partition.result, &partition.repeated);
+      });
+    Result result;
+    Merge(partitions, hyp_partition, &result);
+    return result;
+  }
+
+  // The incremental interface of the SimpleMatcher is used when there is a
+  // single thread. Otherwise, the references are partitioned by query in
+  // BeginMatch(), and each batch of hypotheses is split among the matchers
+  // of their queries, which match them in parallel. The matches of each
+  // batch are appended in the order of its hypotheses, as the SimpleMatcher
+  // does, thus the hypotheses are not kept after their batch is matched.
+  void BeginMatch(const std::vector<RE>& refs) override {
+    repeated_matches_.clear();
+    streams_.clear();
+    query_stream_.clear();
+    if (pool_.NumThreads() == 1) {
+      serial_.BeginMatch(refs);
+      return;
+    }
+    for (const RE& ref : refs) {
+      const auto it = query_stream_.emplace(
+          ref.Query(), static_cast<uint32_t>(streams_.size())).first;
+      if (it->second == streams_.size()) streams_.emplace_back();
+      streams_[it->second].refs.push_back(ref);
+    }
+    std::vector<size_t> costs;
+    costs.reserve(streams_.size());
+    for (const Stream& stream : streams_) costs.push_back(stream.refs.size());
+    pool_.Run(costs, [this](size_t s, size_t) {
+        Stream& stream = streams_[s];
+        stream.matcher.reset(new SimpleMatcher<RE, HE, S>(scorer_));
+        stream.matcher->BeginMatch(stream.refs);
+        std::vector<RE>().swap(stream.refs);
+      });
+  }
+
+  void MatchBatch(const std::vector<HE>& hyps, Result* result) override {
+    if (pool_.NumThreads() == 1) {
+      serial_.MatchBatch(hyps, result);
+      return;
+    }
+    // Stream of each hypothesis, or streams_.size() if its query has no
+    // references (then, it is a false positive).
+    const uint32_t no_stream = static_cast<uint32_t>(streams_.size());
+    std::vector<uint32_t> hyp_stream;
+    std::vector<uint32_t> active;
+    hyp_stream.reserve(hyps.size());
+    for (const HE& hyp : hyps) {
+      const auto it = query_stream_.find(hyp.Query());
+      if (it == query_stream_.end()) {
+        hyp_stream.push_back(no_stream);
+        continue;
+      }
+      Stream& stream = streams_[it->second];
+      if (stream.hyps.empty()) active.push_back(it->second);
+      stream.hyps.push_back(hyp);
+      hyp_stream.push_back(it->second);
+    }
+    std::vector<size_t> costs;
+    costs.reserve(active.size());
+    for (const uint32_t s : active) costs.push_back(streams_[s].hyps.size());
+    pool_.Run(costs, [this, &active](size_t a, size_t) {
+        Stream& stream = streams_[active[a]];
+        for (const HE& hyp : stream.hyps) {
+          stream.matcher->MatchNext(hyp, &stream.result, &stream.repeated);
+          stream.result_end.push_back(stream.result.size());
+          stream.repeated_end.push_back(stream.repeated.size());
+        }
+      });
+    // Merge the matches of the batch, following the order of the hypotheses.
+    for (size_t h = 0; h < hyps.size(); ++h) {
+      if (hyp_stream[h] == no_stream) {
+        result->push_back(MatchType::MakeFalsePositive(hyps[h]));
+        continue;
+      }
+      Stream& stream = streams_[hyp_stream[h]];
+      const size_t k = stream.next++;
+      const size_t repeated_begin = k > 0 ? stream.repeated_end[k - 1] : 0;
+      const size_t result_begin = k > 0 ? stream.result_end[k - 1] : 0;
+      std::move(stream.repeated.begin() + repeated_begin,
+                stream.repeated.begin() + stream.repeated_end[k],
+                std::back_inserter(repeated_matches_));
+      std::move(stream.result.begin() + result_begin,
+                stream.result.begin() + stream.result_end[k],
+                std::back_inserter(*result));
+    }
+    for (const uint32_t s : active) streams_[s].ClearBatch();
+  }
+
+  void EndMatch(Result* result) override {
+    if (pool_.NumThreads() == 1) {
+      serial_.EndMatch(result);
+      repeated_matches_ = serial_.GetRepeatedMatches();
+      return;
+    }
+    // The false negatives of all queries, sorted as the SimpleMatcher does.
+    std::vector<size_t> costs(streams_.size(), 1);
+    pool_.Run(costs, [this](size_t s, size_t) {
+        streams_[s].matcher->EndMatch(&streams_[s].result);
+      });
+    const size_t first_false_negative = result->size();
+    for (Stream& stream : streams_) {
+      std::move(stream.result.begin(), stream.result.end(),
+                std::back_inserter(*result));
+    }
+    std::sort(result->begin() + first_false_negative, result->end(),
+              [](const MatchType& a, const MatchType& b) {
+                return a.GetRef() < b.GetRef();
+              });
+    streams_.clear();
+    query_stream_.clear();
+  }
+
+  const Result& GetRepeatedMatches() const {
+    return repeated_matches_;
+  }
+
+ private:
+  typedef typename SimpleMatcher<RE, HE, S>::IndexedMatchType
+      IndexedMatchType;
+  typedef typename SimpleMatcher<RE, HE, S>::IndexedResult IndexedResult;
+
+  // Events of a query, and their matches.
+  struct Partition {
+    std::vector<RE> refs;
+    std::vector<HE> hyps;
+    // Position of each hypothesis in the hypotheses given to Match().
+    std::vector<uint32_t> hyp_index;
+    IndexedResult result;
+    IndexedResult repeated;
+  };
+
+  // Groups the events by query, keeping their order within each partition,
+  // and fills the partition of each hypothesis.
+  static void MakePartitions(const std::vector<RE>& refs,
+                             const std::vector<HE>& hyps,
+                             std::vector<Partition>* partitions,
+                             std::vector<uint32_t>* hyp_partition) {
+    std::unordered_map<typename RE::QType, uint32_t> query_partition;
+    auto partition = [&](const typename RE::QType& query) -> uint32_t {
+      const auto it = query_partition.emplace(
+          query, static_cast<uint32_t>(partitions->size())).first;
+      if (it->second == partitions->size()) partitions->emplace_back();
+      return it->second;
+    };
+    for (const RE& ref : refs) {
+      (*partitions)[partition(ref.Query())].refs.push_back(ref);
+    }
+    hyp_partition->reserve(hyps.size());
+    for (size_t h = 0; h < hyps.size(); ++h) {
+      const uint32_t p = partition(hyps[h].Query());
+      (*partitions)[p].hyps.push_back(hyps[h]);
+      (*partitions)[p].hyp_index.push_back(static_cast<uint32_t>(h));
+      hyp_partition->push_back(p);
+    }
+  }
+
+  static MatchType ToMatch(const IndexedMatchType& m) {
+    if (!m.HasRef()) return MatchType::MakeFalsePositive(m.GetHyp());
+    if (!m.HasHyp()) return MatchType::MakeFalseNegative(m.GetRef());
+    return MatchType(m.GetRef(), m.GetHyp(), m.GetError());
+  }
+
+  // Merges the matches of the partitions in the order of the SimpleMatcher:
+  // the matches of each hypothesis in the order of the hypotheses, followed
+  // by the false negatives, sorted.
+  void Merge(const std::vector<Partition>& partitions,
+             const std::vector<uint32_t>& hyp_partition, Result* result) {
+    // The matches of each partition are sorted by hypothesis, followed by
+    // its false negatives.
+    std::vector<size_t> next_match(partitions.size(), 0);
+    std::vector<size_t> next_repeated(partitions.size(), 0);
+    size_t num_matches = 0;
+    for (const Partition& p : partitions) num_matches += p.result.size();
+    result->reserve(num_matches);
+    for (size_t h = 0; h < hyp_partition.size(); ++h) {
+      const Partition& p = partitions[hyp_partition[h]];
+      size_t& r = next_repeated[hyp_partition[h]];
+      for (; r < p.repeated.size() &&
+               p.hyp_index[p.repeated[r].HypIndex()] == h; ++r) {
+        repeated_matches_.push_back(ToMatch(p.repeated[r]));
+      }
+      size_t& m = next_match[hyp_partition[h]];
+      if (m < p.result.size() && p.result[m].HasHyp() &&
+          p.hyp_index[p.result[m].HypIndex()] == h) {
+        result->push_back(ToMatch(p.result[m++]));
+      }
+    }
+    const size_t first_false_negative = result->size();
+    for (size_t p = 0; p < partitions.size(); ++p) {
+      for (size_t m = next_match[p]; m < partitions[p].result.size(); ++m) {
+        result->push_back(ToMatch(partitions[p].result[m]));
+      }
+    }
+    std::sort(result->begin() + first_false_negative, result->end(),
+              [](const MatchType& a, const MatchType& b) {
+                return a.GetRef() < b.GetRef();
+              });
+  }
+
+  // Matcher of the references of a query, used by the incremental
+  // interface, and the matches of the hypotheses of the current batch.
+  struct Stream {
+    std::unique_ptr<SimpleMatcher<RE, HE, S>> matcher;
+    // References of the query, only until BeginMatch() is done.
+    std::vector<RE> refs;
+    // Hypotheses of the batch, and their matches and repeated matches. The
+    // matches of the k-th hypothesis end at result_end[k] (repeated_end[k]).
+    std::vector<HE> hyps;
+    Result result, repeated;
+    std::vector<size_t> result_end, repeated_end;
+    // Next hypothesis of the batch to merge.
+    size_t next = 0;
+
+    void ClearBatch() {
+      hyps.clear();
+      result.clear();
+      repeated.clear();
+      result_end.clear();
+      repeated_end.clear();
+      next = 0;
+    }
+  };
+
+  S* scorer_;
+  // Used when there is a single thread.
+  SimpleMatcher<RE, HE, S> serial_;
+  WorkStealingPool pool_;
+  Result repeated_matches_;
+  std::vector<Stream> streams_;
+  std::unordered_map<typename RE::QType, uint32_t> query_stream_;
+};
+
+}  // namespace matcher
+}  // namespace kws
+
+#endif  // MATCHER_PARALLELMATCHER_H_
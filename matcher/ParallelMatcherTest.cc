@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/Event.h"
+#include "core/IntegerEventSet.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "matcher/ParallelMatcher.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/IntersectionOverHypothesisAreaScorer.h"
+#include "scorer/TrivialScorer.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::Event;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::matcher::ParallelMatcher;
+using kws::matcher::SimpleMatcher;
+using kws::scorer::IntersectionOverHypothesisAreaScorer;
+using kws::scorer::TrivialScorer;
+
+// The ParallelMatcher gives exactly the same matches (and repeated matches)
+// as the SimpleMatcher, with any number of threads. M is ParallelMatcher
+// with or without the scorer type.
+template <class M, class RE, class HE, class S>
+static void ExpectSameMatchesWith(const std::vector<RE>& refs,
+                                  const std::vector<HE>& hyps, S* scorer) {
+  SimpleMatcher<RE, HE> simple(scorer);
+  const auto expected = simple.Match(refs, hyps);
+  // Matches of the first half of the hypotheses, given as a batch.
+  decltype(simple.Match(refs, hyps)) first_half;
+  SimpleMatcher<RE, HE> simple_batch(scorer);
+  simple_batch.BeginMatch(refs);
+  simple_batch.MatchBatch(std::vector<HE>(hyps.begin(),
+                                          hyps.begin() + hyps.size() / 2),
+                          &first_half);
+  for (size_t num_threads : {1, 2, 3, 8}) {
+    M matcher(scorer, num_threads);
+    EXPECT_EQ(expected, matcher.Match(refs, hyps))
+        << "With " << num_threads << " threads";
+    EXPECT_EQ(simple.GetRepeatedMatches(), matcher.GetRepeatedMatches())
+        << "With " << num_threads << " threads";
+    // Incremental interface. The matches of each batch are known as soon
+    // as it is matched.
+    decltype(matcher.Match(refs, hyps)) result;
+    matcher.BeginMatch(refs);
+    matcher.MatchBatch(std::vector<HE>(hyps.begin(),
+                                       hyps.begin() + hyps.size() / 2),
+                       &result);
+    EXPECT_EQ(first_half, result) << "With " << num_threads << " threads";
+    matcher.MatchBatch(std::vector<HE>(hyps.begin() + hyps.size() / 2,
+                                       hyps.end()),
+                       &result);
+    matcher.EndMatch(&result);
+    EXPECT_EQ(expected, result) << "With " << num_threads << " threads";
+    EXPECT_EQ(simple.GetRepeatedMatches(), matcher.GetRepeatedMatches())
+        << "With " << num_threads << " threads";
+  }
+}
+
+template <class RE, class HE, class S>
+static void ExpectSameMatches(const std::vector<RE>& refs,
+                              const std::vector<HE>& hyps, S* scorer) {
+  ExpectSameMatchesWith<ParallelMatcher<RE, HE>>(refs, hyps, scorer);
+  ExpectSameMatchesWith<ParallelMatcher<RE, HE, S>>(refs, hyps, scorer);
+}
+
+TEST(ParallelMatcherTest, Empty) {
+  typedef Event<int32_t, int32_t> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  TrivialScorer<RefEvent, HypEvent> scorer;
+  ExpectSameMatches<RefEvent, HypEvent>({}, {}, &scorer);
+  ExpectSameMatches<RefEvent, HypEvent>({RefEvent(1, 1)}, {}, &scorer);
+  ExpectSameMatches<RefEvent, HypEvent>({}, {HypEvent(1, 1, 0.5f)}, &scorer);
+}
+
+TEST(ParallelMatcherTest, IntegerEvents) {
+  // Queries with very different number of events, repeated references and
+  // hypotheses matching the same reference several times.
+  typedef Event<int32_t, int32_t> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  std::mt19937 rng(12345);
+  std::geometric_distribution<int32_t> query(0.2);
+  std::uniform_int_distribution<int32_t> location(0, 30);
+  std::vector<RefEvent> refs;
+  std::vector<HypEvent> hyps;
+  for (int i = 0; i < 500; ++i) refs.emplace_back(query(rng), location(rng));
+  for (int i = 0; i < 2000; ++i) {
+    hyps.emplace_back(query(rng), location(rng), (rng() % 100) / 100.0f);
+  }
+  TrivialScorer<RefEvent, HypEvent> scorer;
+  ExpectSameMatches(refs, hyps, &scorer);
+}
+
+TEST(ParallelMatcherTest, DocumentBoxEvents) {
+  typedef DocumentIdBoundingBox<int> Box;
+  typedef ShapedEvent<int32_t, Box> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  std::mt19937 rng(12345);
+  std::geometric_distribution<int32_t> query(0.1);
+  std::uniform_int_distribution<int> coord(0, 200), size(10, 40);
+  const char* documents[] = {"d1", "d2", "d3"};
+  auto random_box = [&]() {
+    return Box(documents[rng() % 3], coord(rng), coord(rng), size(rng),
+               size(rng));
+  };
+  std::vector<RefEvent> refs;
+  std::vector<HypEvent> hyps;
+  for (int i = 0; i < 500; ++i) refs.emplace_back(query(rng), random_box());
+  for (int i = 0; i < 2000; ++i) {
+    hyps.emplace_back(query(rng), random_box(), (rng() % 100) / 100.0f);
+  }
+  IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> scorer(0.5);
+  ExpectSameMatches(refs, hyps, &scorer);
+}
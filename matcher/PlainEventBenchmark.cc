@@ -0,0 +1,218 @@
+// Compares the throughput of sorting and matching events of the virtual
+// Event hierarchy (Event, ShapedEvent, ScoredEvent) with their non-virtual
+// counterparts (PlainEvent, PlainShapedEvent, PlainScoredEvent), using the
+// same SimpleMatcher, scorers and EventSets.
+//
+// Two kinds of synthetic collections are used:
+//  - Integer queries and locations, matched exactly (as in SimpleKwsEval).
+//  - Integer queries located with a DocumentIdBoundingBox, matched with the
+//    IntersectionOverHypothesisAreaScorer (as in Icdar17KwsEval).
+//
+// Usage: PlainEventBenchmark [--refs N] [--hyps N] [--repeat N]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "core/BenchmarkTime.h"
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/Event.h"
+#include "core/IntegerEventSet.h"
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
+#include "core/PlainShapedEvent.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/IntersectionOverHypothesisAreaScorer.h"
+#include "scorer/TrivialScorer.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::Event;
+using kws::core::PlainEvent;
+using kws::core::PlainScoredEvent;
+using kws::core::PlainShapedEvent;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::core::benchmark::Time;
+using kws::matcher::SimpleMatcher;
+using kws::scorer::IntersectionOverHypothesisAreaScorer;
+using kws::scorer::TrivialScorer;
+
+typedef DocumentIdBoundingBox<uint32_t> Box;
+
+typedef Event<int32_t, int32_t> IntEvent;
+typedef PlainEvent<int32_t, int32_t> PlainIntEvent;
+typedef ShapedEvent<int32_t, Box> BoxEvent;
+typedef PlainShapedEvent<int32_t, Box> PlainBoxEvent;
+
+static_assert(
+    std::is_trivially_copyable<PlainScoredEvent<PlainIntEvent>>::value,
+    "Plain integer events must be trivially copyable");
+static_assert(
+    std::is_trivially_copyable<PlainScoredEvent<PlainBoxEvent>>::value,
+    "Plain box events must be trivially copyable");
+
+// Builds the events of type RE and HE from the raw (query, location, score)
+// tuples, so that both hierarchies work on identical collections.
+template <class RE, class HE, class L>
+static void Build(const std::vector<std::pair<int32_t, L>>& raw_refs,
+                  const std::vector<std::pair<int32_t, L>>& raw_hyps,
+                  const std::vector<float>& scores,
+                  std::vector<RE>* refs, std::vector<HE>* hyps) {
+  for (const auto& r : raw_refs) refs->emplace_back(r.first, r.second);
+  for (size_t i = 0; i < raw_hyps.size(); ++i) {
+    hyps->emplace_back(raw_hyps[i].first, raw_hyps[i].second, scores[i]);
+  }
+}
+
+struct Result {
+  double sort_ns;   // Per hypothesis.
+  double match_ns;  // Per hypothesis.
+  size_t checksum;
+};
+
+template <class RE, class HE, class S, class L>
+static Result Run(const std::vector<std::pair<int32_t, L>>& raw_refs,
+                  const std::vector<std::pair<int32_t, L>>& raw_hyps,
+                  const std::vector<float>& scores, int repeat, S* scorer) {
+  std::vector<RE> refs;
+  std::vector<HE> hyps;
+  Build(raw_refs, raw_hyps, scores, &refs, &hyps);
+  Result result;
+  std::vector<HE> sorted;
+  result.sort_ns = Time(hyps.size(), repeat, [&]() {
+      sorted = hyps;
+      std::sort(sorted.begin(), sorted.end(), std::greater<HE>());
+    });
+  result.checksum = 0;
+  result.match_ns = Time(hyps.size(), repeat, [&]() {
+      SimpleMatcher<RE, HE> matcher(scorer);
+      const auto matches = matcher.Match(refs, sorted);
+      for (const auto& m : matches) {
+        result.checksum += m.HasRef() && m.HasHyp();
+      }
+    });
+  return result;
+}
+
+static void Print(const std::string& name, const Result& virt,
+                  const Result& plain) {
+  std::cout << name << ":" << std::endl
+            << "  Sort:  virtual = " << virt.sort_ns
+            << " ns/hyp, plain = " << plain.sort_ns << " ns/hyp ("
+            << virt.sort_ns / plain.sort_ns << "x)" << std::endl
+            << "  Match: virtual = " << virt.match_ns
+            << " ns/hyp, plain = " << plain.match_ns << " ns/hyp ("
+            << virt.match_ns / plain.match_ns << "x)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  size_t num_refs = 100000, num_hyps = 500000;
+  int repeat = 5;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--refs") && i + 1 < argc) {
+      num_refs = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--hyps") && i + 1 < argc) {
+      num_hyps = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--refs N] [--hyps N] [--repeat N]" << std::endl;
+      return 1;
+    }
+  }
+  if (num_refs == 0 || num_hyps == 0 || repeat < 1) {
+    std::cerr << "ERROR: The number of events and repetitions must be "
+              << "positive!" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(12345);
+  const int32_t num_queries = 1000;
+  std::uniform_int_distribution<int32_t> query(0, num_queries - 1);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+  std::vector<float> scores(num_hyps);
+  for (float& s : scores) s = score(rng);
+
+  {
+    // Exact matches of integer locations; half of the hypotheses are
+    // references.
+    std::uniform_int_distribution<int32_t> location(0, 10000);
+    std::vector<std::pair<int32_t, int32_t>> refs(num_refs), hyps(num_hyps);
+    for (auto& r : refs) r = std::make_pair(query(rng), location(rng));
+    for (size_t i = 0; i < num_hyps; ++i) {
+      hyps[i] = i % 2 == 0
+          ? refs[rng() % num_refs]
+          : std::make_pair(query(rng), location(rng));
+    }
+    TrivialScorer<IntEvent, ScoredEvent<IntEvent>> virt_scorer;
+    TrivialScorer<PlainIntEvent, PlainScoredEvent<PlainIntEvent>>
+        plain_scorer;
+    const Result virt = Run<IntEvent, ScoredEvent<IntEvent>>(
+        refs, hyps, scores, repeat, &virt_scorer);
+    const Result plain = Run<PlainIntEvent, PlainScoredEvent<PlainIntEvent>>(
+        refs, hyps, scores, repeat, &plain_scorer);
+    if (virt.checksum != plain.checksum) {
+      std::cerr << "ERROR: Different matches found!" << std::endl;
+      return 1;
+    }
+    Print("Integer events", virt, plain);
+  }
+
+  {
+    // Boxes in 100 documents; hypotheses are references shifted a few
+    // pixels, or random boxes.
+    const uint32_t num_documents = 100;
+    std::vector<uint32_t> documents;
+    for (uint32_t d = 0; d < num_documents; ++d) {
+      documents.push_back(kws::core::DocumentTable::Global().Intern(
+          "document" + std::to_string(d)));
+    }
+    std::uniform_int_distribution<uint32_t> coord(0, 2000), shift(0, 20);
+    auto random_box = [&]() {
+      return Box(documents[rng() % num_documents], coord(rng), coord(rng),
+                 100 + shift(rng), 30 + shift(rng));
+    };
+    std::vector<std::pair<int32_t, Box>> refs(num_refs), hyps(num_hyps);
+    for (auto& r : refs) r = std::make_pair(query(rng), random_box());
+    for (size_t i = 0; i < num_hyps; ++i) {
+      if (i % 2 == 0) {
+        hyps[i] = refs[rng() % num_refs];
+        hyps[i].second.x += shift(rng);
+        hyps[i].second.y += shift(rng);
+      } else {
+        hyps[i] = std::make_pair(query(rng), random_box());
+      }
+    }
+    IntersectionOverHypothesisAreaScorer<BoxEvent, ScoredEvent<BoxEvent>>
+        virt_scorer(0.5);
+    IntersectionOverHypothesisAreaScorer<PlainBoxEvent,
+                                         PlainScoredEvent<PlainBoxEvent>>
+        plain_scorer(0.5);
+    const Result virt = Run<BoxEvent, ScoredEvent<BoxEvent>>(
+        refs, hyps, scores, repeat, &virt_scorer);
+    const Result plain = Run<PlainBoxEvent, PlainScoredEvent<PlainBoxEvent>>(
+        refs, hyps, scores, repeat, &plain_scorer);
+    if (virt.checksum != plain.checksum) {
+      std::cerr << "ERROR: Different matches found!" << std::endl;
+      return 1;
+    }
+    Print("Document box events", virt, plain);
+  }
+
+  std::cout << "sizeof(ScoredEvent<IntEvent>) = "
+            << sizeof(ScoredEvent<IntEvent>)
+            << ", sizeof(PlainScoredEvent<PlainIntEvent>) = "
+            << sizeof(PlainScoredEvent<PlainIntEvent>) << std::endl;
+  return 0;
+}
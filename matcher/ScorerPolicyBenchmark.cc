@@ -0,0 +1,228 @@
+// Compares the throughput of the SimpleMatcher calling the scorer through the
+// virtual Scorer interface (SimpleMatcher<RE, HE>) or with the scorer type
+// given as a template argument (SimpleMatcher<RE, HE, S>), which calls the
+// final operator() of the scorer without virtual dispatch.
+//
+// The synthetic collections are the same as in PlainEventBenchmark:
+//  - Integer queries and locations, matched with the TrivialScorer (as in
+//    SimpleKwsEval).
+//  - Integer queries located with a DocumentIdBoundingBox, matched with the
+//    IntersectionOverHypothesisAreaScorer (as in Icdar17KwsEval), with the
+//    virtual and the plain event hierarchies.
+// Besides matching, the time to score the candidate pairs alone (the
+// references overlapping each hypothesis) is measured, since it is only a
+// part of the matching time.
+//
+// Usage: ScorerPolicyBenchmark [--refs N] [--hyps N] [--repeat N]
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/BenchmarkTime.h"
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/Event.h"
+#include "core/IntegerEventSet.h"
+#include "core/PlainScoredEvent.h"
+#include "core/PlainShapedEvent.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "matcher/SimpleMatcher.h"
+#include "scorer/IntersectionOverHypothesisAreaScorer.h"
+#include "scorer/TrivialScorer.h"
+
+using kws::core::DocumentIdBoundingBox;
+using kws::core::DocumentTable;
+using kws::core::Event;
+using kws::core::PlainScoredEvent;
+using kws::core::PlainShapedEvent;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::core::benchmark::Time;
+using kws::matcher::SimpleMatcher;
+using kws::scorer::IntersectionOverHypothesisAreaScorer;
+using kws::scorer::TrivialScorer;
+
+typedef DocumentIdBoundingBox<uint32_t> Box;
+
+struct Result {
+  double score_ns;  // Per candidate pair.
+  double match_ns;  // Per hypothesis.
+  size_t checksum;
+};
+
+// Scores all the candidate pairs with the scorer of type S. Not inlined, so
+// that the compiler cannot find the type of the scorer when S is the Scorer
+// interface, as in the matcher.
+template <class RE, class HE, class S>
+__attribute__((noinline)) static size_t ScorePairs(
+    const std::vector<std::pair<const RE*, const HE*>>& pairs, S* scorer) {
+  size_t num_matched = 0;
+  for (const auto& p : pairs) {
+    num_matched += (*scorer)(*p.first, *p.second).FP() < 1.0f;
+  }
+  return num_matched;
+}
+
+// Matches with the SimpleMatcher<RE, HE, S>, where S is either the Scorer
+// interface or the actual type of the scorer.
+template <class RE, class HE, class S>
+static Result Run(const std::vector<RE>& refs, const std::vector<HE>& hyps,
+                  const std::vector<std::pair<const RE*, const HE*>>& pairs,
+                  int repeat, S* scorer) {
+  Result result;
+  result.checksum = 0;
+  result.score_ns = Time(pairs.size(), repeat, [&]() {
+      result.checksum += ScorePairs<RE, HE, S>(pairs, scorer);
+    });
+  SimpleMatcher<RE, HE, S> matcher(scorer);
+  result.match_ns = Time(hyps.size(), repeat, [&]() {
+      const auto matches = matcher.Match(refs, hyps);
+      for (const auto& m : matches) {
+        result.checksum += m.HasRef() && m.HasHyp();
+      }
+      result.checksum += matcher.GetRepeatedMatches().size();
+    });
+  return result;
+}
+
+// Compares both matchers with the given scorer, returns false if they give
+// different matches.
+template <class RE, class HE, class S>
+static bool Compare(const std::string& name, const std::vector<RE>& refs,
+                    const std::vector<HE>& hyps, int repeat, S* scorer) {
+  // Candidate pairs: the references overlapping each hypothesis.
+  kws::core::EventSet<RE> refs_set(refs.begin(), refs.end());
+  refs_set.BuildIndex();
+  std::vector<typename kws::core::EventSet<RE>::Overlap> overlapping;
+  std::vector<std::pair<const RE*, const HE*>> pairs;
+  for (const HE& hyp : hyps) {
+    refs_set.FindOverlapping(hyp, &overlapping);
+    for (const auto& o : overlapping) pairs.emplace_back(o.event, &hyp);
+  }
+  const Result virt = Run<RE, HE, kws::scorer::Scorer<RE, HE>>(
+      refs, hyps, pairs, repeat, scorer);
+  const Result policy = Run<RE, HE, S>(refs, hyps, pairs, repeat, scorer);
+  if (virt.checksum != policy.checksum) {
+    std::cerr << "ERROR: Different matches found!" << std::endl;
+    return false;
+  }
+  std::cout << name << ", " << pairs.size() << " candidate pairs:"
+            << std::endl
+            << "  Score: virtual = " << virt.score_ns
+            << " ns/pair, policy = " << policy.score_ns << " ns/pair ("
+            << virt.score_ns / policy.score_ns << "x)" << std::endl
+            << "  Match: virtual = " << virt.match_ns
+            << " ns/hyp, policy = " << policy.match_ns << " ns/hyp ("
+            << virt.match_ns / policy.match_ns << "x)" << std::endl;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  size_t num_refs = 20000, num_hyps = 200000;
+  int repeat = 5;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--refs") && i + 1 < argc) {
+      num_refs = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--hyps") && i + 1 < argc) {
+      num_hyps = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+      repeat = std::atoi(argv[++i]);
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--refs N] [--hyps N] [--repeat N]" << std::endl;
+      return 1;
+    }
+  }
+  if (num_refs == 0 || num_hyps == 0 || repeat < 1) {
+    std::cerr << "ERROR: The number of events and repetitions must be "
+              << "positive!" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(12345);
+  const int32_t num_queries = 100;
+  std::uniform_int_distribution<int32_t> query(0, num_queries - 1);
+  std::uniform_real_distribution<float> score(0.0f, 1.0f);
+
+  {
+    // Exact matches of integer locations; half of the hypotheses are
+    // references.
+    typedef Event<int32_t, int32_t> RefEvent;
+    typedef ScoredEvent<RefEvent> HypEvent;
+    std::uniform_int_distribution<int32_t> location(0, 10000);
+    std::vector<RefEvent> refs;
+    std::vector<HypEvent> hyps;
+    for (size_t i = 0; i < num_refs; ++i) {
+      refs.emplace_back(query(rng), location(rng));
+    }
+    for (size_t i = 0; i < num_hyps; ++i) {
+      const RefEvent e = i % 2 == 0 ? refs[rng() % num_refs]
+                                    : RefEvent(query(rng), location(rng));
+      hyps.emplace_back(e.Query(), e.Location(), score(rng));
+    }
+    TrivialScorer<RefEvent, HypEvent> scorer;
+    if (!Compare("Integer events", refs, hyps, repeat, &scorer)) return 1;
+  }
+
+  // Boxes in 10 documents, clustered in a small area of each document so
+  // that each hypothesis overlaps many references of its query.
+  std::vector<uint32_t> documents;
+  for (uint32_t d = 0; d < 10; ++d) {
+    documents.push_back(
+        DocumentTable::Global().Intern("document" + std::to_string(d)));
+  }
+  std::uniform_int_distribution<uint32_t> coord(0, 300), shift(0, 20);
+  std::vector<std::pair<int32_t, Box>> raw_refs, raw_hyps;
+  for (size_t i = 0; i < num_refs; ++i) {
+    raw_refs.emplace_back(query(rng),
+                          Box(documents[rng() % documents.size()],
+                              coord(rng), coord(rng), 100 + shift(rng),
+                              30 + shift(rng)));
+  }
+  for (size_t i = 0; i < num_hyps; ++i) {
+    std::pair<int32_t, Box> hyp = raw_refs[rng() % num_refs];
+    hyp.second.x += shift(rng);
+    hyp.second.y += shift(rng);
+    raw_hyps.push_back(hyp);
+  }
+  std::vector<float> scores(num_hyps);
+  for (float& s : scores) s = score(rng);
+
+  {
+    typedef ShapedEvent<int32_t, Box> RefEvent;
+    typedef ScoredEvent<RefEvent> HypEvent;
+    std::vector<RefEvent> refs;
+    std::vector<HypEvent> hyps;
+    for (const auto& r : raw_refs) refs.emplace_back(r.first, r.second);
+    for (size_t i = 0; i < num_hyps; ++i) {
+      hyps.emplace_back(raw_hyps[i].first, raw_hyps[i].second, scores[i]);
+    }
+    IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> scorer(0.5);
+    if (!Compare("Document box events", refs, hyps, repeat, &scorer)) {
+      return 1;
+    }
+  }
+
+  {
+    typedef PlainShapedEvent<int32_t, Box> RefEvent;
+    typedef PlainScoredEvent<RefEvent> HypEvent;
+    std::vector<RefEvent> refs;
+    std::vector<HypEvent> hyps;
+    for (const auto& r : raw_refs) refs.emplace_back(r.first, r.second);
+    for (size_t i = 0; i < num_hyps; ++i) {
+      hyps.emplace_back(raw_hyps[i].first, raw_hyps[i].second, scores[i]);
+    }
+    IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> scorer(0.5);
+    if (!Compare("Plain document box events", refs, hyps, repeat, &scorer)) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -2,10 +2,12 @@
 #define MATCHER_SIMPLEMATCHER_H_
 
 #include <algorithm>
-#include <set>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "core/EventSet.h"
+#include "core/IndexedMatch.h"
 #include "core/Match.h"
 #include "core/MatchError.h"
 #include "matcher/Matcher.h"
@@ -18,77 +20,229 @@ using kws::core::EventSet;
 using kws::core::MatchError;
 using kws::scorer::Scorer;
 
-template <class RE, class HE>
+// S is the type of the scorer. By default, it is any Scorer, called through
+// its virtual interface. When it is a concrete scorer whose operator() is
+// final (e.g. IntersectionOverHypothesisAreaScorer), the scorer is called
+// without virtual dispatch, and can be inlined in the matching loop.
+template <class RE, class HE, class S = Scorer<RE, HE>>
 class SimpleMatcher : public Matcher<RE, HE> {
  public:
   typedef RE RefEvent;
   typedef HE HypEvent;
+  typedef S ScorerType;
   typedef typename Matcher<RE, HE>::Result Result;
+  typedef kws::core::IndexedMatch<std::vector<RE>, std::vector<HE>>
+      IndexedMatchType;
+  typedef std::vector<IndexedMatchType> IndexedResult;
 
-  explicit SimpleMatcher(Scorer<RefEvent, HypEvent>* scorer) :
+  explicit SimpleMatcher(S* scorer) :
       scorer_(scorer), refs_set_(new EventSet<RE>()) {}
 
-  SimpleMatcher(Scorer<RefEvent, HypEvent>* scorer, EventSet<RE>* refs_set)
+  SimpleMatcher(S* scorer, EventSet<RE>* refs_set)
       : scorer_(scorer), refs_set_(refs_set) {}
 
   Result Match(const std::vector<RE>& refs, const std::vector<HE>& hyps)
       override {
+    Result result;
+    BeginMatch(refs);
+    MatchBatch(hyps, &result);
+    EndMatch(&result);
+    return result;
+  }
+
+  void BeginMatch(const std::vector<RE>& refs) override {
     // Add references to the EventSet, for fast overlapping calculations.
+    // The set gives ids 0, 1, ... to the distinct references, in order,
+    // thus the id of each reference is its position in refs_.
     refs_set_->Clear();
-    for (const RE& ref : refs) refs_set_->Insert(ref);
-    // Add all references to the unmatched references set.
-    std::set<RE> unmatched_refs(refs.begin(), refs.end());
+    refs_.clear();
+    ref_index_.clear();
+    for (size_t i = 0; i < refs.size(); ++i) {
+      refs_set_->Insert(refs[i]);
+      if (refs_set_->Size() > refs_.size()) {
+        refs_.push_back(refs[i]);
+        ref_index_.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    refs_set_->BuildIndex();
+    // All (distinct) references are unmatched, initially.
+    matched_.assign((refs_.size() + 63) / 64, 0);
     // Store matched hypothesis with already matched reference here.
     repeated_matches_.clear();
-    Result result;
-    for (const HE& hyp : hyps) {
-      const auto overlapping_refs = refs_set_->FindOverlapping(hyp);
-      bool matched_hyp = false;
-      for (const RE &ref : overlapping_refs) {
-        // Score the match
-        const auto errors = scorer_->operator()(ref, hyp);
-        if (errors.FP() < 1.0f) {
-          // If the hypothesis matches (tp > 0) ANY reference, we will NOT
-          // penalize either precision or recall, even if the reference was
-          // matched before...
-          matched_hyp = true;
-          const auto m = kws::core::Match<RE,HE>(ref, hyp, errors);
-          // ... although, we don't penalize multiple matches against the
-          // same reference, we MUST NOT increase the precision/recall either.
-          if (unmatched_refs.find(ref) != unmatched_refs.end()) {
-            unmatched_refs.erase(ref);
-            result.push_back(m);
-            // This hypothesis cannot be matched again.
-            break;
-          } else {
-            // Keep the match, just for debugging purposes.
-            repeated_matches_.push_back(m);
-          }
-        }
-      }
-      // This hyp is a false positive, since it was not matched against any
-      // reference.
-      if (!matched_hyp) {
-        result.push_back(kws::core::Match<RE,HE>::MakeFalsePositive(hyp));
-      }
+  }
+
+  void MatchBatch(const std::vector<HE>& hyps, Result* result) override {
+    for (const HE& hyp : hyps) MatchNext(hyp, result, &repeated_matches_);
+  }
+
+  // Matches the next hypothesis, as MatchBatch() does, but its repeated
+  // matches are appended to *repeated instead of GetRepeatedMatches().
+  void MatchNext(const HE& hyp, Result* result, Result* repeated) {
+    const bool matched_hyp = MatchHypothesis(
+        hyp, [&](const RE& ref, uint32_t, const MatchError& errors,
+                 bool is_repeated) {
+          (is_repeated ? *repeated : *result).emplace_back(ref, hyp, errors);
+        });
+    // This hyp is a false positive, since it was not matched against any
+    // reference.
+    if (!matched_hyp) {
+      result->push_back(kws::core::Match<RE,HE>::MakeFalsePositive(hyp));
     }
+  }
 
+  void EndMatch(Result* result) override {
     // Process false negatives, i.e. reference objects that were not matched
     // with any hypothesis.
-    for (const RE& ref : unmatched_refs) {
-      result.push_back(kws::core::Match<RE,HE>::MakeFalseNegative(ref));
+    for (const uint32_t id : UnmatchedReferences()) {
+      result->push_back(kws::core::Match<RE,HE>::MakeFalseNegative(refs_[id]));
     }
-
-    return result;
+    ClearReferences();
   }
 
   const Result& GetRepeatedMatches() const {
     return repeated_matches_;
   }
 
+  // Matches a single hypothesis against the references given to
+  // BeginMatch(), as MatchBatch() does, but without keeping its match (nor
+  // its repeated matches), thus the memory used does not grow with the
+  // number of hypotheses. Returns false if the hypothesis gives no match
+  // (i.e. it only matched references that were already matched), otherwise
+  // sets *errors to the errors of its match (a false positive, if it did
+  // not match any reference).
+  bool MatchOne(const HE& hyp, MatchError* errors) {
+    bool has_match = false;
+    const bool matched_hyp = MatchHypothesis(
+        hyp, [&](const RE&, uint32_t, const MatchError& e, bool repeated) {
+          if (!repeated) {
+            *errors = e;
+            has_match = true;
+          }
+        });
+    if (!matched_hyp) {
+      *errors = kws::core::Match<RE,HE>::MakeFalsePositive(hyp).GetError();
+      return true;
+    }
+    return has_match;
+  }
+
+  // Distinct references given to BeginMatch(), until EndMatch() is called.
+  const std::vector<RE>& GetReferences() const { return refs_; }
+
+  // Same as Match(), but the matches are IndexedMatch objects, which refer
+  // to the given events by their index instead of copying them. The
+  // matches (and the repeated matches, if `repeated` is not null) are in
+  // the same order as the ones returned by Match().
+  void MatchIndexed(const std::vector<RE>& refs, const std::vector<HE>& hyps,
+                    IndexedResult* result, IndexedResult* repeated = nullptr) {
+    BeginMatch(refs);
+    for (size_t h = 0; h < hyps.size(); ++h) {
+      const bool matched_hyp = MatchHypothesis(
+          hyps[h], [&](const RE&, uint32_t id, const MatchError& errors,
+                       bool is_repeated) {
+            if (!is_repeated) {
+              result->emplace_back(&refs, &hyps, ref_index_[id], h, errors);
+            } else if (repeated != nullptr) {
+              repeated->emplace_back(&refs, &hyps, ref_index_[id], h, errors);
+            }
+          });
+      if (!matched_hyp) {
+        result->push_back(
+            IndexedMatchType::MakeFalsePositive(&refs, &hyps, h));
+      }
+    }
+    for (const uint32_t id : UnmatchedReferences()) {
+      result->push_back(
+          IndexedMatchType::MakeFalseNegative(&refs, &hyps, ref_index_[id]));
+    }
+    ClearReferences();
+  }
+
  private:
-  Scorer<RE, HE>* scorer_;
+  inline bool IsMatched(uint32_t id) const {
+    return (matched_[id / 64] >> (id % 64)) & 1;
+  }
+
+  inline void SetMatched(uint32_t id) {
+    matched_[id / 64] |= uint64_t(1) << (id % 64);
+  }
+
+  // Ids of the references that were not matched, sorted as the references
+  // (which is the order in which the false negatives are reported). Only
+  // the unmatched references are sorted.
+  const std::vector<uint32_t>& UnmatchedReferences() {
+    unmatched_.clear();
+    for (size_t w = 0; w < matched_.size(); ++w) {
+      // Bits of the unmatched references in this word (the last word may
+      // have fewer references).
+      uint64_t bits = ~matched_[w];
+      const size_t num_bits = std::min<size_t>(64, refs_.size() - 64 * w);
+      if (num_bits < 64) bits &= (uint64_t(1) << num_bits) - 1;
+      for (; bits != 0; bits &= bits - 1) {
+        unmatched_.push_back(
+            static_cast<uint32_t>(64 * w + __builtin_ctzll(bits)));
+      }
+    }
+    std::sort(unmatched_.begin(), unmatched_.end(),
+              [this](uint32_t a, uint32_t b) { return refs_[a] < refs_[b]; });
+    return unmatched_;
+  }
+
+  void ClearReferences() {
+    refs_.clear();
+    ref_index_.clear();
+    matched_.clear();
+    unmatched_.clear();
+  }
+
+  // Matches the hypothesis against the overlapping references, and calls
+  // f(ref, id, errors, repeated) with the matched reference, its id in
+  // refs_set_ and the errors of the match. Returns false if the hypothesis
+  // is a false positive.
+  template <typename F>
+  bool MatchHypothesis(const HE& hyp, F f) {
+    refs_set_->FindOverlapping(hyp, &overlapping_refs_);
+    bool matched_hyp = false;
+    for (const auto &overlap : overlapping_refs_) {
+      const RE &ref = *overlap.event;
+      // Score the match, reusing the intersection area computed by the set
+      // when it is available.
+      const auto errors = EventSet<RE>::kOverlapIsIntersectionArea
+          ? scorer_->ScoreIntersection(ref, hyp, overlap.area)
+          : (*scorer_)(ref, hyp);
+      if (errors.FP() < 1.0f) {
+        // If the hypothesis matches (tp > 0) ANY reference, we will NOT
+        // penalize either precision or recall, even if the reference was
+        // matched before...
+        matched_hyp = true;
+        // ... although, we don't penalize multiple matches against the
+        // same reference, we MUST NOT increase the precision/recall either.
+        if (!IsMatched(overlap.id)) {
+          SetMatched(overlap.id);
+          f(ref, overlap.id, errors, false);
+          // This hypothesis cannot be matched again.
+          break;
+        } else {
+          // Keep the match, just for debugging purposes.
+          f(ref, overlap.id, errors, true);
+        }
+      }
+    }
+    return matched_hyp;
+  }
+
+  S* scorer_;
   std::unique_ptr<EventSet<RE>> refs_set_;
+  // Buffer reused to find the references overlapping each hypothesis.
+  std::vector<typename EventSet<RE>::Overlap> overlapping_refs_;
+  // Distinct references given to BeginMatch(), by id, and the index of each
+  // one in the references given to BeginMatch().
+  std::vector<RE> refs_;
+  std::vector<uint32_t> ref_index_;
+  // Bitset of the matched references, by id.
+  std::vector<uint64_t> matched_;
+  // Buffer reused to sort the unmatched references.
+  std::vector<uint32_t> unmatched_;
   Result repeated_matches_;
 };
 
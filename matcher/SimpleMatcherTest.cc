@@ -1,44 +1,76 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <cstdint>
+#include <random>
+#include <vector>
+
 #include "core/BoundingBox.h"
+#include "core/DocumentBoundingBoxEventSet.h"
+#include "core/DocumentIdBoundingBox.h"
 #include "core/Event.h"
+#include "core/EventTable.h"
+#include "core/IntegerEventSet.h"
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
 #include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
 #include "matcher/SimpleMatcher.h"
+#include "scorer/IntersectionOverHypothesisAreaScorer.h"
 #include "scorer/MockScorer.h"
+#include "scorer/OverlapScorer.h"
+#include "scorer/TrivialScorer.h"
 #include "core/DummyLocation.h"
 
 using kws::core::BoundingBox;
+using kws::core::DocumentIdBoundingBox;
 using kws::core::Event;
+using kws::core::EventTable;
+using kws::core::PlainEvent;
+using kws::core::PlainScoredEvent;
 using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
 using kws::core::Match;
 using kws::core::MatchError;
 using kws::core::testing::DummyLocation;
 using kws::matcher::SimpleMatcher;
+using kws::scorer::IntersectionOverHypothesisAreaScorer;
+using kws::scorer::OverlapScorer;
+using kws::scorer::TrivialScorer;
 using kws::scorer::testing::MockScorer;
 
 using testing::ElementsAre;
 using testing::NiceMock;
 using testing::Return;
+using testing::SetArgPointee;
+using testing::_;
 
 template <class E>
 class MockEventSet : public kws::core::EventSet<E> {
 public:
   typedef typename E::QType QType;
   typedef typename E::LType LType;
-  typedef std::list<E> EventList;
+  typedef typename kws::core::EventSet<E>::Overlap Overlap;
 
   virtual ~MockEventSet() {}
 
-  MOCK_METHOD1_T(Insert, void(const E&));
-  MOCK_METHOD0(Clear, void());
-  MOCK_METHOD1_T(Remove, void(const E&));
-  MOCK_CONST_METHOD1_T(FindOverlapping, EventList(const Event<QType, LType>&));
+  MOCK_CONST_METHOD2_T(FindOverlapping, void(const Event<QType, LType>&,
+                                             std::vector<Overlap>*));
 };
 
 
 typedef Event<int, DummyLocation> DummyEvent;
 
+// Overlaps of the given (distinct) references, as returned by
+// EventSet::FindOverlapping. The id of each reference is its position, since
+// they are inserted in order.
+static std::vector<MockEventSet<DummyEvent>::Overlap> Overlaps(
+    const std::vector<DummyEvent>& refs, std::initializer_list<uint32_t> ids) {
+  std::vector<MockEventSet<DummyEvent>::Overlap> overlaps;
+  for (const uint32_t i : ids) overlaps.push_back({1, &refs[i], i});
+  return overlaps;
+}
+
 TEST(SimpleMatcherTest, AllEmpty) {
   MockScorer<DummyEvent, DummyEvent> scorer;
   SimpleMatcher<DummyEvent, DummyEvent> matcher(&scorer);
@@ -83,8 +115,8 @@ TEST(SimpleMatcherTest, PerfectMatch) {
   const std::vector<DummyEvent> refs{DummyEvent(1, 1)};
   const std::vector<DummyEvent> hyps{DummyEvent(1, 1)};
 
-  EXPECT_CALL(*refs_set, FindOverlapping(hyps[0]))
-      .WillOnce(Return(std::list<DummyEvent>{refs[0]}));
+  EXPECT_CALL(*refs_set, FindOverlapping(hyps[0], _))
+      .WillOnce(SetArgPointee<1>(Overlaps(refs, {0})));
   EXPECT_CALL(scorer, ComputeError(refs[0], hyps[0]))
       .WillOnce(Return(MatchError(0, 0)));
 
@@ -103,8 +135,8 @@ TEST(SimpleMatcherTest, NotPerfectMatches) {
     const std::vector<DummyEvent> hyps{DummyEvent(1, 1)};
 
     // Suppose that the location overlaps with the two reference events.
-    EXPECT_CALL(*refs_set, FindOverlapping(hyps[0]))
-        .WillOnce(Return(std::list<DummyEvent>{refs[0], refs[1]}));
+    EXPECT_CALL(*refs_set, FindOverlapping(hyps[0], _))
+        .WillOnce(SetArgPointee<1>(Overlaps(refs, {0, 1})));
     // The scorer gives a null true positive ratio for the first event.
     EXPECT_CALL(scorer, ComputeError(refs[0], hyps[0]))
         .WillOnce(Return(MatchError(1, 1)));
@@ -127,8 +159,8 @@ TEST(SimpleMatcherTest, NotPerfectMatches) {
     // Suppose that the location overlaps with the two reference events.
     // The intersection area with the second reference is > than with
     // the first reference.
-    EXPECT_CALL(*refs_set, FindOverlapping(hyps[0]))
-        .WillOnce(Return(std::list<DummyEvent>{refs[1], refs[0]}));
+    EXPECT_CALL(*refs_set, FindOverlapping(hyps[0], _))
+        .WillOnce(SetArgPointee<1>(Overlaps(refs, {1, 0})));
     // Since we match against refs[1], refs[0] will not be considered
     EXPECT_CALL(scorer, ComputeError(refs[1], hyps[0]))
         .WillOnce(Return(MatchError(0, 0.2)));
@@ -145,10 +177,10 @@ TEST(SimpleMatcherTest, NotPerfectMatches) {
     const std::vector<DummyEvent> refs{DummyEvent(1, 1)};
     const std::vector<DummyEvent> hyps{DummyEvent(1, 1), DummyEvent(1, 2)};
 
-    EXPECT_CALL(*refs_set, FindOverlapping(hyps[0]))
-        .WillOnce(Return(std::list<DummyEvent>{refs[0]}));
-    EXPECT_CALL(*refs_set, FindOverlapping(hyps[1]))
-        .WillOnce(Return(std::list<DummyEvent>{refs[0]}));
+    EXPECT_CALL(*refs_set, FindOverlapping(hyps[0], _))
+        .WillOnce(SetArgPointee<1>(Overlaps(refs, {0})));
+    EXPECT_CALL(*refs_set, FindOverlapping(hyps[1], _))
+        .WillOnce(SetArgPointee<1>(Overlaps(refs, {0})));
 
     // Notice that the match against hyp2 would be better, however since the
     // reference was already matched we won't increase precision or recall.
@@ -163,3 +195,212 @@ TEST(SimpleMatcherTest, NotPerfectMatches) {
         Match<DummyEvent, DummyEvent>(refs[0], hyps[0], MatchError(0.4, 0.5))));
   }
 }
+
+typedef Match<DummyEvent, DummyEvent> DummyMatch;
+
+TEST(SimpleMatcherTest, MatchInBatches) {
+  MockScorer<DummyEvent, DummyEvent> scorer;
+  SimpleMatcher<DummyEvent, DummyEvent> matcher(&scorer);
+  const std::vector<DummyEvent> refs{DummyEvent(1, 1), DummyEvent(2, 1)};
+  const std::vector<DummyEvent> hyps1{DummyEvent(1, 1), DummyEvent(1, 2)};
+  const std::vector<DummyEvent> hyps2{DummyEvent(1, 1)};
+  EXPECT_CALL(scorer, ComputeError(refs[0], hyps1[0]))
+      .WillRepeatedly(Return(MatchError(0, 0)));
+
+  std::vector<DummyMatch> result;
+  matcher.BeginMatch(refs);
+  matcher.MatchBatch(hyps1, &result);
+  EXPECT_THAT(result, ElementsAre(
+      DummyMatch(refs[0], hyps1[0], MatchError(0, 0)),
+      DummyMatch::MakeFalsePositive(hyps1[1])));
+  // The reference was already matched in the previous batch, so the
+  // hypothesis is only kept as a repeated match.
+  matcher.MatchBatch(hyps2, &result);
+  EXPECT_EQ(2, result.size());
+  EXPECT_THAT(matcher.GetRepeatedMatches(), ElementsAre(
+      DummyMatch(refs[0], hyps2[0], MatchError(0, 0))));
+  matcher.EndMatch(&result);
+  EXPECT_EQ(3, result.size());
+  EXPECT_EQ(DummyMatch::MakeFalseNegative(refs[1]), result.back());
+}
+
+TEST(SimpleMatcherTest, PlainEvents) {
+  typedef PlainEvent<int, int> RefEvent;
+  typedef PlainScoredEvent<RefEvent> HypEvent;
+  typedef Match<RefEvent, HypEvent> PlainMatch;
+  TrivialScorer<RefEvent, HypEvent> scorer;
+  SimpleMatcher<RefEvent, HypEvent> matcher(&scorer);
+  const std::vector<RefEvent> refs{RefEvent(1, 1), RefEvent(2, 1)};
+  const std::vector<HypEvent> hyps{
+    HypEvent(1, 1, 0.9f), HypEvent(1, 2, 0.8f), HypEvent(1, 1, 0.7f)};
+  EXPECT_THAT(matcher.Match(refs, hyps), ElementsAre(
+      PlainMatch(refs[0], hyps[0], MatchError(0, 0)),
+      PlainMatch::MakeFalsePositive(hyps[1]),
+      PlainMatch::MakeFalseNegative(refs[1])));
+  EXPECT_THAT(matcher.GetRepeatedMatches(), ElementsAre(
+      PlainMatch(refs[0], hyps[2], MatchError(0, 0))));
+}
+
+TEST(SimpleMatcherTest, ScorerPolicy) {
+  // Giving the scorer type to the matcher does not change the matches.
+  typedef ShapedEvent<int, DocumentIdBoundingBox<uint32_t>> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  typedef IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> Scorer;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<uint32_t> coord(0, 100), size(5, 30);
+  auto random_box = [&]() {
+    return DocumentIdBoundingBox<uint32_t>(
+        rng() % 2 ? "d1" : "d2", coord(rng), coord(rng), size(rng),
+        size(rng));
+  };
+  std::vector<RefEvent> refs;
+  std::vector<HypEvent> hyps;
+  for (int i = 0; i < 200; ++i) refs.emplace_back(rng() % 3, random_box());
+  for (int i = 0; i < 500; ++i) {
+    hyps.emplace_back(rng() % 3, random_box(), (rng() % 100) / 100.0f);
+  }
+  Scorer scorer(0.5);
+  SimpleMatcher<RefEvent, HypEvent> virtual_matcher(&scorer);
+  SimpleMatcher<RefEvent, HypEvent, Scorer> static_matcher(&scorer);
+  const auto expected = virtual_matcher.Match(refs, hyps);
+  EXPECT_EQ(expected, static_matcher.Match(refs, hyps));
+  EXPECT_EQ(virtual_matcher.GetRepeatedMatches(),
+            static_matcher.GetRepeatedMatches());
+}
+
+// Scorer that checks the intersection areas given by the matcher, and
+// otherwise scores as the IntersectionOverHypothesisAreaScorer.
+template <class RE, class HE>
+class IntersectionCheckingScorer : public OverlapScorer<RE, HE> {
+ public:
+  IntersectionCheckingScorer()
+      : OverlapScorer<RE, HE>(0.5), num_scored(0), scorer_(0.5) {}
+
+  float Overlap(const RE& ref, const HE& hyp) const override {
+    return scorer_.Overlap(ref, hyp);
+  }
+
+  float IntersectionOverlap(const RE& ref, const HE& hyp,
+                            double intersection_area) const override {
+    ++num_scored;
+    EXPECT_EQ(IntersectionArea(ref, hyp), intersection_area);
+    return scorer_.IntersectionOverlap(ref, hyp, intersection_area);
+  }
+
+  mutable size_t num_scored;
+
+ private:
+  IntersectionOverHypothesisAreaScorer<RE, HE> scorer_;
+};
+
+TEST(SimpleMatcherTest, IntersectionAreasOfTheEventSet) {
+  // With box events, the intersection areas found by the EventSet are given
+  // to the scorer, instead of computing them again.
+  typedef ShapedEvent<int, DocumentIdBoundingBox<uint32_t>> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  typedef IntersectionCheckingScorer<RefEvent, HypEvent> Scorer;
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<uint32_t> coord(0, 100), size(5, 30);
+  std::vector<RefEvent> refs;
+  std::vector<HypEvent> hyps;
+  for (int i = 0; i < 100; ++i) {
+    refs.emplace_back(rng() % 3, DocumentIdBoundingBox<uint32_t>(
+        "d1", coord(rng), coord(rng), size(rng), size(rng)));
+  }
+  for (int i = 0; i < 300; ++i) {
+    hyps.emplace_back(rng() % 3, DocumentIdBoundingBox<uint32_t>(
+        "d1", coord(rng), coord(rng), size(rng), size(rng)), 0.5f);
+  }
+  IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> box_scorer(0.5);
+  Scorer scorer;
+  SimpleMatcher<RefEvent, HypEvent> expected_matcher(&box_scorer);
+  SimpleMatcher<RefEvent, HypEvent> matcher(&scorer);
+  EXPECT_EQ(expected_matcher.Match(refs, hyps), matcher.Match(refs, hyps));
+  EXPECT_LT(0, scorer.num_scored);
+}
+
+TEST(SimpleMatcherTest, EventTableRows) {
+  // Matching the rows of the tables gives the same matches as matching the
+  // events.
+  typedef DocumentIdBoundingBox<int> Box;
+  typedef ShapedEvent<int, Box> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  typedef EventTable<int, int> Table;
+  const std::vector<RefEvent> refs{
+    RefEvent(1, Box("d1", 0, 0, 10, 10)),
+    RefEvent(1, Box("d1", 20, 0, 10, 10)),
+    RefEvent(2, Box("d1", 0, 0, 10, 10)),
+    RefEvent(1, Box("d2", 0, 0, 10, 10))};
+  const std::vector<HypEvent> hyps{
+    HypEvent(1, Box("d1", 1, 1, 10, 10), 0.9f),
+    HypEvent(1, Box("d1", 2, 2, 10, 10), 0.8f),
+    HypEvent(2, Box("d1", 8, 8, 10, 10), 0.7f),
+    HypEvent(1, Box("d2", 0, 0, 5, 5), 0.6f)};
+  IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> scorer(0.5);
+  SimpleMatcher<RefEvent, HypEvent> matcher(&scorer);
+  const auto expected = matcher.Match(refs, hyps);
+
+  const Table ref_table = Table::FromEvents(refs);
+  const Table hyp_table = Table::FromEvents(hyps);
+  IntersectionOverHypothesisAreaScorer<Table::Row, Table::Row> row_scorer(0.5);
+  SimpleMatcher<Table::Row, Table::Row> row_matcher(&row_scorer);
+  const auto result = row_matcher.Match(ref_table.Rows(), hyp_table.Rows());
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t i = 0; i < result.size(); ++i) {
+    EXPECT_EQ(expected[i].GetError(), result[i].GetError());
+    ASSERT_EQ(expected[i].HasRef(), result[i].HasRef());
+    ASSERT_EQ(expected[i].HasHyp(), result[i].HasHyp());
+    if (result[i].HasRef()) {
+      EXPECT_EQ(expected[i].GetRef(),
+                ref_table.ToEvent<RefEvent>(result[i].GetRef().Index()));
+    }
+    if (result[i].HasHyp()) {
+      EXPECT_EQ(expected[i].GetHyp(),
+                hyp_table.ToEvent<HypEvent>(result[i].GetHyp().Index()));
+    }
+  }
+}
+
+TEST(SimpleMatcherTest, MatchIndexed) {
+  typedef PlainEvent<int, int> RefEvent;
+  typedef PlainScoredEvent<RefEvent> HypEvent;
+  typedef Match<RefEvent, HypEvent> PlainMatch;
+  TrivialScorer<RefEvent, HypEvent> scorer;
+  SimpleMatcher<RefEvent, HypEvent> matcher(&scorer);
+  // The second reference is repeated, thus it can only be matched once.
+  const std::vector<RefEvent> refs{
+    RefEvent(2, 1), RefEvent(1, 1), RefEvent(1, 1), RefEvent(3, 1)};
+  const std::vector<HypEvent> hyps{
+    HypEvent(1, 1, 0.9f), HypEvent(1, 2, 0.8f), HypEvent(1, 1, 0.7f),
+    HypEvent(3, 1, 0.6f)};
+  const auto expected = matcher.Match(refs, hyps);
+  const auto expected_repeated = matcher.GetRepeatedMatches();
+  EXPECT_THAT(expected, ElementsAre(
+      PlainMatch(refs[1], hyps[0], MatchError(0, 0)),
+      PlainMatch::MakeFalsePositive(hyps[1]),
+      PlainMatch(refs[3], hyps[3], MatchError(0, 0)),
+      PlainMatch::MakeFalseNegative(refs[0])));
+
+  SimpleMatcher<RefEvent, HypEvent>::IndexedResult result, repeated;
+  matcher.MatchIndexed(refs, hyps, &result, &repeated);
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t i = 0; i < result.size(); ++i) {
+    EXPECT_EQ(expected[i].GetError(), result[i].GetError());
+    ASSERT_EQ(expected[i].HasRef(), result[i].HasRef());
+    ASSERT_EQ(expected[i].HasHyp(), result[i].HasHyp());
+    if (result[i].HasRef()) {
+      EXPECT_EQ(expected[i].GetRef(), result[i].GetRef());
+    }
+    if (result[i].HasHyp()) {
+      EXPECT_EQ(expected[i].GetHyp(), result[i].GetHyp());
+    }
+  }
+  // References are identified by their first occurrence.
+  EXPECT_EQ(1, result[0].RefIndex());
+  EXPECT_EQ(0, result[0].HypIndex());
+  EXPECT_EQ(0, result[3].RefIndex());
+  ASSERT_EQ(1, repeated.size());
+  EXPECT_EQ(1, repeated[0].RefIndex());
+  EXPECT_EQ(2, repeated[0].HypIndex());
+  EXPECT_EQ(expected_repeated[0].GetHyp(), repeated[0].GetHyp());
+}
@@ -0,0 +1,191 @@
+#ifndef READER_AUTOFORMATREADER_H_
+#define READER_AUTOFORMATREADER_H_
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "reader/BinaryReader.h"
+#include "reader/DecompressingStream.h"
+#include "reader/MappedFile.h"
+#include "reader/ParallelTextReader.h"
+#include "reader/Reader.h"
+#include "reader/SnapshotCache.h"
+#include "reader/TextBatchReader.h"
+
+namespace kws {
+namespace reader {
+
+// Reads events either from the plain text format or from the binary
+// columnar format, possibly compressed. The format is detected from the first
+// bytes of the input.
+template <typename E>
+class AutoFormatReader : public Reader<E> {
+ public:
+  explicit AutoFormatReader(size_t num_threads = 0)
+      : text_reader_(num_threads) {}
+
+  bool Read(std::istream* is, std::vector<E>* events) const override {
+    DecompressingIstream dis(is);
+    return ReadDecompressed(&dis, events);
+  }
+
+  bool Read(const std::string& filepath, std::vector<E>* events) const override {
+    if (snapshots_ != nullptr) return ReadSnapshot(filepath, events);
+    MappedFile file;
+    if (!file.Open(filepath, false)) return false;
+    if (DetectCompression(file.Begin(), file.End()) == kNoCompression) {
+      return Read(file.Begin(), file.End(), events);
+    }
+    DecompressingIstream dis(file.Begin(), file.End());
+    return ReadDecompressed(&dis, events);
+  }
+
+  // The first bytes of the stream are read to detect its format. Binary
+  // inputs are loaded into memory, text inputs are read incrementally.
+  // Compressed streams are decompressed before detecting their format.
+  std::unique_ptr<BatchReader<E>> OpenBatches(std::istream* is) const override {
+    std::unique_ptr<std::istream> dis(new DecompressingIstream(is));
+    const std::string magic = ReadMagic(dis.get());
+    if (!IsBinaryEventData(magic.data(), magic.data() + magic.size())) {
+      return std::unique_ptr<BatchReader<E>>(
+          new TextMapEventBatchReader<IdentityMapper<E>>(
+              &mapper_, std::move(dis), magic, this->filter_));
+    }
+    std::unique_ptr<MappedFile> buffer(new MappedFile);
+    if (!buffer->Open(dis.get(), magic)) buffer.reset();
+    return std::unique_ptr<BatchReader<E>>(
+        new BinaryBatchReader<E>(std::move(buffer), this->filter_));
+  }
+
+  std::unique_ptr<BatchReader<E>> OpenBatches(
+      const std::string& filepath) const override {
+    std::unique_ptr<MappedFile> file(new MappedFile);
+    if (!file->Open(filepath, false)) file.reset();
+    if (file != nullptr &&
+        DetectCompression(file->Begin(), file->End()) != kNoCompression) {
+      // Only the binary format needs the whole decompressed content.
+      DecompressingIstream dis(file->Begin(), file->End());
+      const std::string magic = ReadMagic(&dis);
+      if (IsBinaryEventData(magic.data(), magic.data() + magic.size())) {
+        std::unique_ptr<MappedFile> buffer(new MappedFile);
+        if (!buffer->Open(&dis, magic)) buffer.reset();
+        return std::unique_ptr<BatchReader<E>>(
+            new BinaryBatchReader<E>(std::move(buffer), this->filter_));
+      }
+    } else if (file != nullptr &&
+               IsBinaryEventData(file->Begin(), file->End())) {
+      return std::unique_ptr<BatchReader<E>>(
+          new BinaryBatchReader<E>(std::move(file), this->filter_));
+    }
+    return std::unique_ptr<BatchReader<E>>(
+        new TextMapEventBatchReader<IdentityMapper<E>>(
+            &mapper_, std::move(file), this->filter_));
+  }
+
+  bool Read(const char* begin, const char* end, std::vector<E>* events) const {
+    if (IsBinaryEventData(begin, end)) {
+      return binary_reader_.Read(begin, end, events);
+    } else {
+      return text_reader_.Read(begin, end, events);
+    }
+  }
+
+  bool IsThreadSafe() const override { return true; }
+
+  // Text files are read from their snapshot, in the binary format, if it
+  // exists. Otherwise, the snapshot is created after parsing them.
+  bool SetSnapshotDirectory(const std::string& directory) override {
+    snapshots_.reset(
+        directory.empty() ? nullptr : new SnapshotCache<E>(directory));
+    return true;
+  }
+
+  void SetFilter(const EventFilter* filter) override {
+    Reader<E>::SetFilter(filter);
+    text_reader_.SetFilter(filter);
+    binary_reader_.SetFilter(filter);
+  }
+
+ private:
+  // Text streams are parsed as they are read, only the binary format needs
+  // the whole decompressed content.
+  bool ReadDecompressed(std::istream* is, std::vector<E>* events) const {
+    const std::string magic = ReadMagic(is);
+    if (!IsBinaryEventData(magic.data(), magic.data() + magic.size())) {
+      return text_reader_.ReadStream(is, magic, events);
+    }
+    MappedFile buffer;
+    if (!buffer.Open(is, magic)) return false;
+    return binary_reader_.Read(buffer.Begin(), buffer.End(), events);
+  }
+
+  bool ReadSnapshot(const std::string& filepath, std::vector<E>* events) const {
+    MappedFile file;
+    if (!file.Open(filepath, false)) return false;
+    if (IsBinaryEventData(file.Begin(), file.End())) {
+      return binary_reader_.Read(file.Begin(), file.End(), events);
+    }
+    const std::string path = snapshots_->Path(file.Begin(), file.End());
+    if (ReadExistingSnapshot(path, events)) return true;
+    // The snapshot contains all the events, regardless of the filter, which
+    // is applied afterwards to the parsed events.
+    std::vector<E> all;
+    ParallelTextReader<E> parser(text_reader_.NumThreads());
+    if (!parser.Read(filepath, &all)) return false;
+    if (!snapshots_->Store(path, all)) {
+      std::cerr << "WARN: Snapshot \"" << path << "\" could not be written."
+                << std::endl;
+    }
+    RemoveFiltered(&all);
+    events->swap(all);
+    return true;
+  }
+
+  // Removes, in place, the events discarded by the filter.
+  void RemoveFiltered(std::vector<E>* events) const {
+    const EventFilter* filter = this->filter_;
+    if (filter == nullptr) return;
+    auto last = std::remove_if(
+        events->begin(), events->end(), [filter](const E& e) {
+          return !filter->KeepQuery(e.Query()) || !filter->KeepParsed(e);
+        });
+    filter->AddRejected(events->end() - last);
+    events->erase(last, events->end());
+  }
+
+  // Reads the events from the snapshot in the given path, if it exists.
+  // Snapshots that cannot be read (e.g. truncated or corrupted) are reported,
+  // and the caller parses the text file again, replacing them.
+  bool ReadExistingSnapshot(const std::string& path,
+                            std::vector<E>* events) const {
+    MappedFile snapshot;
+    if (!snapshot.Open(path)) return false;
+    if (IsBinaryEventData(snapshot.Begin(), snapshot.End()) &&
+        binary_reader_.Read(snapshot.Begin(), snapshot.End(), events)) {
+      return true;
+    }
+    std::cerr << "WARN: Snapshot \"" << path << "\" is not valid, it will be "
+              << "replaced." << std::endl;
+    return false;
+  }
+
+  static std::string ReadMagic(std::istream* is) {
+    std::string magic(sizeof(kBinaryEventMagic), '\0');
+    is->read(&magic[0], magic.size());
+    magic.resize(is->gcount());
+    return magic;
+  }
+
+  ParallelTextReader<E> text_reader_;
+  BinaryReader<E> binary_reader_;
+  mutable IdentityMapper<E> mapper_;
+  std::unique_ptr<SnapshotCache<E>> snapshots_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_AUTOFORMATREADER_H_
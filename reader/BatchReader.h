@@ -0,0 +1,78 @@
+#ifndef READER_BATCHREADER_H_
+#define READER_BATCHREADER_H_
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace kws {
+namespace reader {
+
+template <typename E> class Reader;
+
+// Pull-based interface to read a collection of events in batches, so that
+// the whole collection does not need to be kept in memory.
+template <typename E>
+class BatchReader {
+ public:
+  virtual ~BatchReader() {}
+
+  // Reads the next (at most max_events) events into *events, replacing its
+  // previous content. Returns false when there are no more events to read,
+  // either because the input was exhausted or because some error happened
+  // (see Fail()).
+  virtual bool Next(size_t max_events, std::vector<E>* events) = 0;
+
+  // Returns true if some error happened while reading the input.
+  virtual bool Fail() const = 0;
+};
+
+// Adapter that allows any Reader to be used as a BatchReader. All the events
+// are read with Reader::Read() on the first call to Next(), and then they
+// are returned in batches. Readers that can actually stream their input
+// should provide their own BatchReader instead.
+template <typename E>
+class ReaderBatchAdapter : public BatchReader<E> {
+ public:
+  ReaderBatchAdapter(const Reader<E>* reader, std::istream* is)
+      : reader_(reader), is_(is), loaded_(false), failed_(false), pos_(0) {}
+
+  ReaderBatchAdapter(const Reader<E>* reader, const std::string& filepath)
+      : reader_(reader), is_(nullptr), filepath_(filepath), loaded_(false),
+        failed_(false), pos_(0) {}
+
+  bool Next(size_t max_events, std::vector<E>* events) override {
+    events->clear();
+    if (!loaded_) {
+      loaded_ = true;
+      failed_ = !(is_ != nullptr ? reader_->Read(is_, &events_)
+                                 : reader_->Read(filepath_, &events_));
+    }
+    if (failed_ || pos_ >= events_.size()) return false;
+    const size_t n = std::min(std::max<size_t>(max_events, 1),
+                              events_.size() - pos_);
+    std::move(events_.begin() + pos_, events_.begin() + pos_ + n,
+              std::back_inserter(*events));
+    pos_ += n;
+    if (pos_ == events_.size()) std::vector<E>().swap(events_);
+    return true;
+  }
+
+  bool Fail() const override { return failed_; }
+
+ private:
+  const Reader<E>* reader_;
+  std::istream* is_;
+  std::string filepath_;
+  bool loaded_;
+  bool failed_;
+  size_t pos_;
+  std::vector<E> events_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_BATCHREADER_H_
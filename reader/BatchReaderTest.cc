@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "reader/AutoFormatReader.h"
+#include "reader/BinaryEventFormat.h"
+#include "reader/PlainTextReader.h"
+#include "reader/TextBatchReader.h"
+
+using kws::core::DocumentBoundingBox;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::mapper::IdentityMapper;
+using kws::reader::AutoFormatReader;
+using kws::reader::BatchReader;
+using kws::reader::PlainTextReader;
+using kws::reader::TextMapEventBatchReader;
+using kws::reader::WriteBinaryEvents;
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+
+// Reads all the batches, checking that none of them is larger than
+// batch_size.
+template <typename E>
+static std::vector<E> ReadAllBatches(BatchReader<E>* reader,
+                                     size_t batch_size) {
+  std::vector<E> all, batch;
+  while (reader->Next(batch_size, &batch)) {
+    EXPECT_GT(batch.size(), 0);
+    EXPECT_LE(batch.size(), batch_size);
+    all.insert(all.end(), batch.begin(), batch.end());
+  }
+  EXPECT_THAT(batch, IsEmpty());
+  return all;
+}
+
+static std::string MakeInput(size_t num_lines) {
+  std::ostringstream oss;
+  oss << "# header\n";
+  for (size_t i = 0; i < num_lines; ++i) {
+    if (i % 7 == 0) oss << "  # comment " << i << "\n";
+    if (i % 11 == 0) oss << "\n";
+    oss << "q" << i % 13 << " d" << i % 17 << " " << i << " " << i + 1
+        << " 10 20 " << 0.5f / (i + 1) << "\r\n";
+  }
+  return oss.str();
+}
+
+TEST(ReaderBatchAdapter, SameAsRead) {
+  const std::string input = MakeInput(100);
+  PlainTextReader<HypEvent> reader;
+  std::istringstream iss1(input), iss2(input);
+  std::vector<HypEvent> expected;
+  EXPECT_TRUE(reader.Read(&iss1, &expected));
+  auto batches = reader.OpenBatches(&iss2);
+  EXPECT_EQ(expected, ReadAllBatches(batches.get(), 7));
+  EXPECT_FALSE(batches->Fail());
+}
+
+TEST(TextMapEventBatchReader, SameAsRead) {
+  const std::string input = MakeInput(10000);
+  PlainTextReader<HypEvent> reader;
+  std::istringstream iss(input);
+  std::vector<HypEvent> expected;
+  EXPECT_TRUE(reader.Read(&iss, &expected));
+  IdentityMapper<HypEvent> mapper;
+  for (size_t batch_size : {1, 13, 1000, 100000}) {
+    std::istringstream iss(input);
+    TextMapEventBatchReader<IdentityMapper<HypEvent>> batches(&mapper, &iss);
+    EXPECT_EQ(expected, ReadAllBatches<HypEvent>(&batches, batch_size));
+    EXPECT_FALSE(batches.Fail());
+  }
+  // The first characters can be given separately.
+  std::istringstream rest(input.substr(5));
+  TextMapEventBatchReader<IdentityMapper<HypEvent>> batches(
+      &mapper, &rest, input.substr(0, 5));
+  EXPECT_EQ(expected, ReadAllBatches<HypEvent>(&batches, 100));
+}
+
+TEST(TextMapEventBatchReader, Empty) {
+  IdentityMapper<RefEvent> mapper;
+  std::istringstream iss("# comment\n\n   \n");
+  TextMapEventBatchReader<IdentityMapper<RefEvent>> batches(&mapper, &iss);
+  EXPECT_THAT(ReadAllBatches<RefEvent>(&batches, 10), IsEmpty());
+  EXPECT_FALSE(batches.Fail());
+}
+
+TEST(TextMapEventBatchReader, ErrorLine) {
+  IdentityMapper<RefEvent> mapper;
+  std::istringstream iss("q1 d1 1 2 3 4\n# comment\nq2 d2 1 2 3 4\n"
+                         "q3 d3 1 2 3\n");
+  TextMapEventBatchReader<IdentityMapper<RefEvent>> batches(&mapper, &iss);
+  std::vector<RefEvent> batch;
+  EXPECT_TRUE(batches.Next(1, &batch));
+  EXPECT_THAT(batch, ElementsAre(
+      RefEvent("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4))));
+  ::testing::internal::CaptureStderr();
+  EXPECT_FALSE(batches.Next(10, &batch));
+  EXPECT_EQ("ERROR: Failed to read event from line 4\n",
+            ::testing::internal::GetCapturedStderr());
+  EXPECT_TRUE(batches.Fail());
+  EXPECT_THAT(batch, IsEmpty());
+}
+
+TEST(AutoFormatReader, Batches) {
+  std::vector<RefEvent> refs;
+  for (uint32_t i = 0; i < 100; ++i) {
+    refs.push_back(RefEvent(
+        "q" + std::to_string(i % 3),
+        DocumentBoundingBox<uint32_t>("d" + std::to_string(i % 5),
+                                      i, i, 10, 10)));
+  }
+  AutoFormatReader<RefEvent> reader;
+  std::stringstream binary;
+  EXPECT_TRUE(WriteBinaryEvents(refs, &binary));
+  auto binary_batches = reader.OpenBatches(&binary);
+  EXPECT_EQ(refs, ReadAllBatches(binary_batches.get(), 8));
+  EXPECT_FALSE(binary_batches->Fail());
+
+  std::stringstream text;
+  for (const RefEvent& e : refs) text << e << "\n";
+  auto text_batches = reader.OpenBatches(&text);
+  EXPECT_EQ(refs, ReadAllBatches(text_batches.get(), 8));
+  EXPECT_FALSE(text_batches->Fail());
+
+  // Inputs shorter than the magic bytes.
+  std::istringstream short_text("a");
+  auto short_batches = reader.OpenBatches(&short_text);
+  std::vector<RefEvent> batch;
+  ::testing::internal::CaptureStderr();
+  EXPECT_FALSE(short_batches->Next(10, &batch));
+  ::testing::internal::GetCapturedStderr();
+  EXPECT_TRUE(short_batches->Fail());
+}
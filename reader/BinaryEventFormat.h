@@ -0,0 +1,248 @@
+#ifndef READER_BINARYEVENTFORMAT_H_
+#define READER_BINARYEVENTFORMAT_H_
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/PlainScoredEvent.h"
+#include "core/ScoredEvent.h"
+
+namespace kws {
+namespace reader {
+
+using kws::core::DocumentBoundingBox;
+using kws::core::DocumentIdBoundingBox;
+using kws::core::DocumentTable;
+using kws::core::PlainScoredEvent;
+using kws::core::ScoredEvent;
+
+// Binary columnar format for collections of events located with a
+// DocumentBoundingBox or a DocumentIdBoundingBox (and, optionally, scored).
+// Documents are always stored by name, so files do not depend on the ids
+// of the DocumentTable. The file contains:
+//
+//  - A fixed-size header (BinaryEventHeader).
+//  - A string table, shared by queries and documents: (num_strings + 1)
+//    uint64_t offsets into the string data, followed by the string data.
+//  - The query and document columns: num_events uint32_t string ids each.
+//  - The x, y, w and h columns: num_events coordinates each.
+//  - The score column: num_events floats (only if kBinaryEventScored).
+//
+// Sections start at offsets multiple of 8 bytes, so that columns can be
+// accessed directly from a memory-mapped file. Numbers are stored in the
+// byte order of the machine that wrote the file; readers reject files
+// written with a different byte order.
+
+static const char kBinaryEventMagic[8] = {'K', 'W', 'S', 'E', 'V', 'B', 'I', 'N'};
+static const uint32_t kBinaryEventVersion = 1;
+static const uint32_t kBinaryEventByteOrder = 0x01020304;
+static const uint32_t kBinaryEventScored = 0x1;
+
+struct BinaryEventHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t flags;
+  uint32_t coord_type;
+  uint64_t num_events;
+  uint64_t num_strings;
+  uint64_t string_offsets_pos;
+  uint64_t string_data_pos;
+  uint64_t query_pos;
+  uint64_t document_pos;
+  uint64_t x_pos, y_pos, w_pos, h_pos;
+  uint64_t score_pos;
+};
+
+// Code used to identify the type of the coordinates in the file.
+template <typename T> struct BinaryCoordType;
+template <> struct BinaryCoordType<int16_t>  { enum { kCode = 1 }; };
+template <> struct BinaryCoordType<uint16_t> { enum { kCode = 2 }; };
+template <> struct BinaryCoordType<int32_t>  { enum { kCode = 3 }; };
+template <> struct BinaryCoordType<uint32_t> { enum { kCode = 4 }; };
+template <> struct BinaryCoordType<int64_t>  { enum { kCode = 5 }; };
+template <> struct BinaryCoordType<uint64_t> { enum { kCode = 6 }; };
+template <> struct BinaryCoordType<float>    { enum { kCode = 7 }; };
+template <> struct BinaryCoordType<double>   { enum { kCode = 8 }; };
+
+// Name of the document of a location.
+template <typename T>
+inline const std::string& BinaryDocumentName(const DocumentBoundingBox<T>& l) {
+  return l.document;
+}
+
+template <typename T>
+inline const std::string& BinaryDocumentName(
+    const DocumentIdBoundingBox<T>& l) {
+  return l.DocumentName();
+}
+
+// Describes how events of type E are stored in the binary format.
+// E must be an event with a std::string query and a DocumentBoundingBox or
+// DocumentIdBoundingBox location (e.g.
+// ShapedEvent<std::string, DocumentBoundingBox<T>>), or a ScoredEvent (or
+// PlainScoredEvent) of such an event.
+template <typename E>
+struct BinaryEventTraits {
+  typedef typename E::QType QType;
+  typedef typename E::LType LType;
+  typedef typename LType::Type CoordType;
+  static_assert(std::is_same<QType, std::string>::value,
+                "Binary events must have std::string queries");
+  static_assert(
+      std::is_same<LType, DocumentBoundingBox<CoordType>>::value ||
+      std::is_same<LType, DocumentIdBoundingBox<CoordType>>::value,
+      "Binary events must be located with a DocumentBoundingBox or a "
+      "DocumentIdBoundingBox");
+  // True if the locations store the ids of their documents in the
+  // DocumentTable, instead of their names.
+  static const bool kDocumentIds =
+      std::is_same<LType, DocumentIdBoundingBox<CoordType>>::value;
+  static const bool kScored = false;
+
+  static float Score(const E&) { return 0.0f; }
+
+  static E Make(const QType& query, const LType& location, float) {
+    return E(query, location);
+  }
+};
+
+template <typename E>
+struct BinaryEventTraits<ScoredEvent<E>> : public BinaryEventTraits<E> {
+  typedef typename E::QType QType;
+  typedef typename E::LType LType;
+  static const bool kScored = true;
+
+  static float Score(const ScoredEvent<E>& e) { return e.Score(); }
+
+  static ScoredEvent<E> Make(const QType& query, const LType& location,
+                             float score) {
+    return ScoredEvent<E>(query, location, score);
+  }
+};
+
+template <typename E>
+struct BinaryEventTraits<PlainScoredEvent<E>> : public BinaryEventTraits<E> {
+  typedef typename E::QType QType;
+  typedef typename E::LType LType;
+  static const bool kScored = true;
+
+  static float Score(const PlainScoredEvent<E>& e) { return e.score; }
+
+  static PlainScoredEvent<E> Make(const QType& query, const LType& location,
+                                  float score) {
+    return PlainScoredEvent<E>(query, location, score);
+  }
+};
+
+inline uint64_t AlignBinaryPos(uint64_t pos) { return (pos + 7) & ~7ull; }
+
+// Writes the given events to a binary file. Returns false on I/O errors.
+template <typename E>
+bool WriteBinaryEvents(const std::vector<E>& events, std::ostream* os) {
+  typedef BinaryEventTraits<E> Traits;
+  typedef typename Traits::CoordType T;
+  // Build string table
+  std::unordered_map<std::string, uint32_t> string_ids;
+  std::vector<const std::string*> strings;
+  std::vector<uint32_t> queries, documents;
+  std::vector<T> x, y, w, h;
+  std::vector<float> scores;
+  auto intern = [&string_ids, &strings](const std::string& s) -> uint32_t {
+    auto r = string_ids.emplace(s, static_cast<uint32_t>(strings.size()));
+    if (r.second) strings.push_back(&r.first->first);
+    return r.first->second;
+  };
+  for (const E& e : events) {
+    queries.push_back(intern(e.Query()));
+    documents.push_back(intern(BinaryDocumentName(e.Location())));
+    x.push_back(e.Location().x);
+    y.push_back(e.Location().y);
+    w.push_back(e.Location().w);
+    h.push_back(e.Location().h);
+    if (Traits::kScored) scores.push_back(Traits::Score(e));
+  }
+  std::vector<uint64_t> offsets{0};
+  for (const std::string* s : strings) {
+    offsets.push_back(offsets.back() + s->size());
+  }
+
+  BinaryEventHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kBinaryEventMagic, sizeof(header.magic));
+  header.version = kBinaryEventVersion;
+  header.byte_order = kBinaryEventByteOrder;
+  header.flags = Traits::kScored ? kBinaryEventScored : 0;
+  header.coord_type = BinaryCoordType<T>::kCode;
+  header.num_events = events.size();
+  header.num_strings = strings.size();
+  header.string_offsets_pos = AlignBinaryPos(sizeof(header));
+  header.string_data_pos = AlignBinaryPos(
+      header.string_offsets_pos + offsets.size() * sizeof(uint64_t));
+  header.query_pos = AlignBinaryPos(header.string_data_pos + offsets.back());
+  header.document_pos = AlignBinaryPos(
+      header.query_pos + events.size() * sizeof(uint32_t));
+  header.x_pos = AlignBinaryPos(
+      header.document_pos + events.size() * sizeof(uint32_t));
+  header.y_pos = AlignBinaryPos(header.x_pos + events.size() * sizeof(T));
+  header.w_pos = AlignBinaryPos(header.y_pos + events.size() * sizeof(T));
+  header.h_pos = AlignBinaryPos(header.w_pos + events.size() * sizeof(T));
+  header.score_pos = Traits::kScored
+      ? AlignBinaryPos(header.h_pos + events.size() * sizeof(T)) : 0;
+
+  uint64_t pos = 0;
+  auto write = [os, &pos](uint64_t section_pos, const void* data, size_t n) {
+    static const char padding[8] = {0};
+    os->write(padding, section_pos - pos);
+    os->write(static_cast<const char*>(data), n);
+    pos = section_pos + n;
+  };
+  write(0, &header, sizeof(header));
+  write(header.string_offsets_pos, offsets.data(),
+        offsets.size() * sizeof(uint64_t));
+  pos = header.string_data_pos;
+  for (const std::string* s : strings) {
+    os->write(s->data(), s->size());
+  }
+  pos = header.string_data_pos + offsets.back();
+  write(header.query_pos, queries.data(), queries.size() * sizeof(uint32_t));
+  write(header.document_pos, documents.data(),
+        documents.size() * sizeof(uint32_t));
+  write(header.x_pos, x.data(), x.size() * sizeof(T));
+  write(header.y_pos, y.data(), y.size() * sizeof(T));
+  write(header.w_pos, w.data(), w.size() * sizeof(T));
+  write(header.h_pos, h.data(), h.size() * sizeof(T));
+  if (Traits::kScored) {
+    write(header.score_pos, scores.data(), scores.size() * sizeof(float));
+  }
+  return static_cast<bool>(*os);
+}
+
+template <typename E>
+bool WriteBinaryEvents(const std::vector<E>& events,
+                       const std::string& filepath) {
+  std::ofstream fs(filepath, std::ios_base::out | std::ios_base::binary);
+  if (!fs.is_open()) return false;
+  const bool r = WriteBinaryEvents(events, &fs);
+  fs.close();
+  return r && !fs.fail();
+}
+
+// Returns true if the buffer [begin, end) starts with the magic bytes of the
+// binary event format.
+inline bool IsBinaryEventData(const char* begin, const char* end) {
+  return end - begin >= static_cast<ptrdiff_t>(sizeof(kBinaryEventMagic)) &&
+      std::memcmp(begin, kBinaryEventMagic, sizeof(kBinaryEventMagic)) == 0;
+}
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_BINARYEVENTFORMAT_H_
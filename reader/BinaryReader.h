@@ -0,0 +1,321 @@
+#ifndef READER_BINARYREADER_H_
+#define READER_BINARYREADER_H_
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/EventTable.h"
+#include "reader/BatchReader.h"
+#include "reader/BinaryEventFormat.h"
+#include "reader/EventFilter.h"
+#include "reader/MappedFile.h"
+#include "reader/Reader.h"
+
+namespace kws {
+namespace reader {
+
+// Validated view of the columns of a buffer in the binary columnar format
+// (see BinaryEventFormat.h). The buffer must outlive this object.
+template <typename E>
+class BinaryEventColumns {
+ public:
+  typedef BinaryEventTraits<E> Traits;
+  typedef typename Traits::CoordType T;
+  typedef typename Traits::QType QType;
+  typedef typename Traits::LType LType;
+
+  BinaryEventColumns() : num_events_(0), filter_(nullptr) {}
+
+  // Checks the header and the layout of the buffer [begin, end). Returns
+  // false (and prints an error message) if the buffer is not valid.
+  // The events discarded by the filter (if not null) are skipped by Get().
+  bool Load(const char* begin, const char* end,
+            const EventFilter* filter = nullptr) {
+    strings_.clear();
+    keep_string_.clear();
+    document_ids_.clear();
+    num_events_ = 0;
+    filter_ = filter;
+    const uint64_t size = end - begin;
+    BinaryEventHeader header;
+    if (size < sizeof(header) || !IsBinaryEventData(begin, end)) {
+      return Error("Not a binary events file");
+    }
+    std::memcpy(&header, begin, sizeof(header));
+    if (header.version != kBinaryEventVersion) {
+      return Error("Unsupported version " + std::to_string(header.version));
+    }
+    if (header.byte_order != kBinaryEventByteOrder) {
+      return Error("Unsupported byte order");
+    }
+    if (header.coord_type != static_cast<uint32_t>(BinaryCoordType<T>::kCode)) {
+      return Error("Unexpected type of coordinates");
+    }
+    if (Traits::kScored && !(header.flags & kBinaryEventScored)) {
+      return Error("Events do not have scores");
+    }
+    const uint64_t N = header.num_events, S = header.num_strings;
+    if (N > size || S > size ||
+        !InBounds(header.string_offsets_pos, (S + 1) * sizeof(uint64_t), size) ||
+        !InBounds(header.query_pos, N * sizeof(uint32_t), size) ||
+        !InBounds(header.document_pos, N * sizeof(uint32_t), size) ||
+        !InBounds(header.x_pos, N * sizeof(T), size) ||
+        !InBounds(header.y_pos, N * sizeof(T), size) ||
+        !InBounds(header.w_pos, N * sizeof(T), size) ||
+        !InBounds(header.h_pos, N * sizeof(T), size) ||
+        (Traits::kScored &&
+         !InBounds(header.score_pos, N * sizeof(float), size))) {
+      return Error("Truncated or corrupted file");
+    }
+    // Decode string table.
+    const uint64_t* offsets =
+        Column<uint64_t>(begin, header.string_offsets_pos);
+    if (offsets[0] != 0 ||
+        !InBounds(header.string_data_pos, offsets[S], size)) {
+      return Error("Corrupted string table");
+    }
+    strings_.reserve(S);
+    for (uint64_t s = 0; s < S; ++s) {
+      if (offsets[s] > offsets[s + 1]) {
+        strings_.clear();
+        return Error("Corrupted string table");
+      }
+      strings_.emplace_back(begin + header.string_data_pos + offsets[s],
+                            offsets[s + 1] - offsets[s]);
+    }
+    query_ = Column<uint32_t>(begin, header.query_pos);
+    document_ = Column<uint32_t>(begin, header.document_pos);
+    x_ = Column<T>(begin, header.x_pos);
+    y_ = Column<T>(begin, header.y_pos);
+    w_ = Column<T>(begin, header.w_pos);
+    h_ = Column<T>(begin, header.h_pos);
+    score_ = Traits::kScored ? Column<float>(begin, header.score_pos) : nullptr;
+    num_events_ = N;
+    // Documents are interned once per string, instead of once per event.
+    if (Traits::kDocumentIds) {
+      document_ids_.assign(S, uint32_t(kNotInterned));
+      for (uint64_t i = 0; i < N; ++i) {
+        const uint32_t s = document_[i];
+        if (s < S && document_ids_[s] == kNotInterned) {
+          document_ids_[s] = DocumentTable::Global().Intern(strings_[s]);
+        }
+      }
+    }
+    // Queries are checked once per string, instead of once per event.
+    if (filter_ != nullptr && filter_->FiltersQueries()) {
+      keep_string_.reserve(S);
+      for (const std::string& str : strings_) {
+        keep_string_.push_back(filter_->KeepQuery(str));
+      }
+    }
+    return true;
+  }
+
+  inline size_t NumEvents() const { return num_events_; }
+
+  // Builds the events in the range [first, last) kept by the filter and
+  // appends them to *events. Returns false if some event refers to an
+  // invalid string.
+  bool Get(size_t first, size_t last, std::vector<E>* events) const {
+    return ForEachKept(first, last, [this, events](size_t i) {
+        events->push_back(Traits::Make(
+            strings_[query_[i]],
+            LType(Document(document_[i], static_cast<DocumentType*>(nullptr)),
+                  x_[i], y_[i], w_[i], h_[i]),
+            score_ != nullptr ? score_[i] : 0.0f));
+      });
+  }
+
+  // Same as above, but the rows are appended directly to the columns of the
+  // table, without building the events. Requires locations with document
+  // ids (i.e. DocumentIdBoundingBox).
+  bool Get(size_t first, size_t last,
+           kws::core::EventTable<QType, T>* table) const {
+    static_assert(Traits::kDocumentIds,
+                  "Event tables require a DocumentIdBoundingBox location");
+    return ForEachKept(first, last, [this, table](size_t i) {
+        table->Append(strings_[query_[i]], document_ids_[document_[i]],
+                      x_[i], y_[i], w_[i], h_[i],
+                      score_ != nullptr ? score_[i] : 0.0f);
+      });
+  }
+
+ private:
+  // Type used to identify the document in the locations.
+  typedef decltype(LType::document) DocumentType;
+
+  static const uint32_t kNotInterned = 0xffffffffu;
+
+  // Calls f(i) for each event i in [first, last) kept by the filter.
+  // Returns false if some event refers to an invalid string.
+  template <typename F>
+  bool ForEachKept(size_t first, size_t last, F f) const {
+    size_t num_rejected = 0;
+    for (size_t i = first; i < last; ++i) {
+      if (query_[i] >= strings_.size() || document_[i] >= strings_.size()) {
+        return Error("Invalid string id in event " + std::to_string(i));
+      }
+      if (filter_ != nullptr &&
+          ((!keep_string_.empty() && !keep_string_[query_[i]]) ||
+           (score_ != nullptr && !filter_->KeepScore(score_[i])))) {
+        ++num_rejected;
+        continue;
+      }
+      f(i);
+    }
+    if (filter_ != nullptr) filter_->AddRejected(num_rejected);
+    return true;
+  }
+
+  inline const std::string& Document(uint32_t s, const std::string*) const {
+    return strings_[s];
+  }
+
+  inline uint32_t Document(uint32_t s, const uint32_t*) const {
+    return document_ids_[s];
+  }
+
+  template <typename C>
+  static const C* Column(const char* begin, uint64_t pos) {
+    return reinterpret_cast<const C*>(begin + pos);
+  }
+
+  static bool InBounds(uint64_t pos, uint64_t length, uint64_t size) {
+    return pos % 8 == 0 && pos <= size && length <= size - pos;
+  }
+
+  static bool Error(const std::string& msg) {
+    std::cerr << "ERROR: " << msg << std::endl;
+    return false;
+  }
+
+  size_t num_events_;
+  std::vector<std::string> strings_;
+  const uint32_t* query_;
+  const uint32_t* document_;
+  const T *x_, *y_, *w_, *h_;
+  const float* score_;
+  const EventFilter* filter_;
+  std::vector<char> keep_string_;
+  // Id in the DocumentTable of each string used as a document (only if the
+  // locations store document ids).
+  std::vector<uint32_t> document_ids_;
+};
+
+// Reads the events from a binary file in batches, directly from the
+// memory-mapped columns.
+template <typename E>
+class BinaryBatchReader : public BatchReader<E> {
+ public:
+  // If file is null, the reader is created in a failed state.
+  explicit BinaryBatchReader(std::unique_ptr<MappedFile> file,
+                             const EventFilter* filter = nullptr)
+      : file_(std::move(file)), pos_(0) {
+    failed_ = file_ == nullptr ||
+        !columns_.Load(file_->Begin(), file_->End(), filter);
+  }
+
+  bool Next(size_t max_events, std::vector<E>* events) override {
+    events->clear();
+    // Filtered out events may leave some ranges of events empty.
+    while (!failed_ && events->empty() && pos_ < columns_.NumEvents()) {
+      const size_t last = std::min(pos_ + std::max<size_t>(max_events, 1),
+                                   columns_.NumEvents());
+      if (!columns_.Get(pos_, last, events)) {
+        events->clear();
+        failed_ = true;
+      }
+      pos_ = last;
+    }
+    return !events->empty();
+  }
+
+  bool Fail() const override { return failed_; }
+
+ private:
+  std::unique_ptr<MappedFile> file_;
+  BinaryEventColumns<E> columns_;
+  size_t pos_;
+  bool failed_;
+};
+
+// Reads events from the binary columnar format (see BinaryEventFormat.h).
+// Files are memory-mapped and events are built directly from the columns.
+template <typename E>
+class BinaryReader : public Reader<E> {
+ public:
+  // Streams cannot be mapped, their content is loaded into memory first.
+  bool Read(std::istream* is, std::vector<E>* events) const override {
+    MappedFile buffer;
+    if (!buffer.Open(is)) return false;
+    return Read(buffer.Begin(), buffer.End(), events);
+  }
+
+  bool Read(const std::string& filepath, std::vector<E>* events) const override {
+    MappedFile file;
+    if (!file.Open(filepath)) return false;
+    return Read(file.Begin(), file.End(), events);
+  }
+
+  bool Read(const char* begin, const char* end, std::vector<E>* events) const {
+    events->clear();
+    BinaryEventColumns<E> columns;
+    if (!columns.Load(begin, end, this->filter_)) return false;
+    events->reserve(columns.NumEvents());
+    if (!columns.Get(0, columns.NumEvents(), events)) {
+      events->clear();
+      return false;
+    }
+    return true;
+  }
+
+  // Reads the events directly into the columns of an EventTable (E must be
+  // located with a DocumentIdBoundingBox).
+  template <typename Q, typename T>
+  bool Read(const std::string& filepath,
+            kws::core::EventTable<Q, T>* table) const {
+    MappedFile file;
+    if (!file.Open(filepath)) return false;
+    return Read(file.Begin(), file.End(), table);
+  }
+
+  template <typename Q, typename T>
+  bool Read(const char* begin, const char* end,
+            kws::core::EventTable<Q, T>* table) const {
+    *table = kws::core::EventTable<Q, T>(BinaryEventTraits<E>::kScored);
+    BinaryEventColumns<E> columns;
+    if (!columns.Load(begin, end, this->filter_)) return false;
+    table->Reserve(columns.NumEvents());
+    if (!columns.Get(0, columns.NumEvents(), table)) {
+      table->Clear();
+      return false;
+    }
+    return true;
+  }
+
+  bool IsThreadSafe() const override { return true; }
+
+  std::unique_ptr<BatchReader<E>> OpenBatches(std::istream* is) const override {
+    std::unique_ptr<MappedFile> buffer(new MappedFile);
+    if (!buffer->Open(is)) buffer.reset();
+    return std::unique_ptr<BatchReader<E>>(
+        new BinaryBatchReader<E>(std::move(buffer), this->filter_));
+  }
+
+  std::unique_ptr<BatchReader<E>> OpenBatches(
+      const std::string& filepath) const override {
+    std::unique_ptr<MappedFile> file(new MappedFile);
+    if (!file->Open(filepath)) file.reset();
+    return std::unique_ptr<BatchReader<E>>(
+        new BinaryBatchReader<E>(std::move(file), this->filter_));
+  }
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_BINARYREADER_H_
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/EventTable.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "reader/AutoFormatReader.h"
+#include "reader/BinaryEventFormat.h"
+#include "reader/BinaryReader.h"
+
+using kws::core::DocumentBoundingBox;
+using kws::core::DocumentIdBoundingBox;
+using kws::core::EventTable;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::reader::AutoFormatReader;
+using kws::reader::BinaryReader;
+using kws::reader::WriteBinaryEvents;
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+
+TEST(BinaryReader, RoundTrip) {
+  const std::vector<HypEvent> hyps{
+    HypEvent("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4), 0.5f),
+    HypEvent("q2", DocumentBoundingBox<uint32_t>("d1", 5, 6, 7, 8), -1.0f),
+    HypEvent("d1", DocumentBoundingBox<uint32_t>("q1", 9, 10, 11, 12), 2.0f),
+    HypEvent("", DocumentBoundingBox<uint32_t>("", 0, 0, 0, 0), 0.0f)};
+  std::stringstream ss;
+  EXPECT_TRUE(WriteBinaryEvents(hyps, &ss));
+  const std::string data = ss.str();
+  {
+    BinaryReader<HypEvent> reader;
+    std::vector<HypEvent> v;
+    EXPECT_TRUE(reader.Read(data.data(), data.data() + data.size(), &v));
+    EXPECT_EQ(hyps, v);
+  }
+  {
+    // Scores are ignored when reading unscored events.
+    BinaryReader<RefEvent> reader;
+    std::vector<RefEvent> v;
+    EXPECT_TRUE(reader.Read(data.data(), data.data() + data.size(), &v));
+    EXPECT_THAT(v, ElementsAre(hyps[0], hyps[1], hyps[2], hyps[3]));
+  }
+}
+
+TEST(BinaryReader, DocumentIds) {
+  // Files store the names of the documents, thus they can be read with
+  // either type of location.
+  typedef ShapedEvent<std::string, DocumentIdBoundingBox<uint32_t>> IdEvent;
+  typedef ScoredEvent<IdEvent> IdHypEvent;
+  const std::vector<IdHypEvent> hyps{
+    IdHypEvent("q1", DocumentIdBoundingBox<uint32_t>("d1", 1, 2, 3, 4), 0.5f),
+    IdHypEvent("q2", DocumentIdBoundingBox<uint32_t>("d2", 5, 6, 7, 8), 1.0f),
+    IdHypEvent("q1", DocumentIdBoundingBox<uint32_t>("d1", 9, 9, 9, 9), 2.0f)};
+  std::stringstream ss;
+  EXPECT_TRUE(WriteBinaryEvents(hyps, &ss));
+  const std::string data = ss.str();
+  std::vector<IdHypEvent> v;
+  EXPECT_TRUE(BinaryReader<IdHypEvent>().Read(
+      data.data(), data.data() + data.size(), &v));
+  EXPECT_EQ(hyps, v);
+  std::vector<HypEvent> w;
+  EXPECT_TRUE(BinaryReader<HypEvent>().Read(
+      data.data(), data.data() + data.size(), &w));
+  EXPECT_THAT(w, ElementsAre(
+      HypEvent("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4), 0.5f),
+      HypEvent("q2", DocumentBoundingBox<uint32_t>("d2", 5, 6, 7, 8), 1.0f),
+      HypEvent("q1", DocumentBoundingBox<uint32_t>("d1", 9, 9, 9, 9), 2.0f)));
+  // The columns can also be read directly into an EventTable.
+  EventTable<std::string, uint32_t> table;
+  EXPECT_TRUE(BinaryReader<IdHypEvent>().Read(
+      data.data(), data.data() + data.size(), &table));
+  EXPECT_TRUE(table.HasScores());
+  ASSERT_EQ(hyps.size(), table.size());
+  for (size_t i = 0; i < hyps.size(); ++i) {
+    EXPECT_EQ(hyps[i], table.ToEvent<IdHypEvent>(i));
+  }
+}
+
+TEST(BinaryReader, Empty) {
+  std::stringstream ss;
+  EXPECT_TRUE(WriteBinaryEvents(std::vector<RefEvent>(), &ss));
+  BinaryReader<RefEvent> reader;
+  std::vector<RefEvent> v;
+  EXPECT_TRUE(reader.Read(&ss, &v));
+  EXPECT_THAT(v, IsEmpty());
+}
+
+TEST(BinaryReader, InvalidFiles) {
+  const std::vector<RefEvent> refs{
+    RefEvent("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4))};
+  std::stringstream ss;
+  EXPECT_TRUE(WriteBinaryEvents(refs, &ss));
+  const std::string data = ss.str();
+  std::vector<HypEvent> hyps;
+  std::vector<RefEvent> v;
+  ::testing::internal::CaptureStderr();
+  // Hypotheses need scores.
+  EXPECT_FALSE(BinaryReader<HypEvent>().Read(
+      data.data(), data.data() + data.size(), &hyps));
+  // Different type of coordinates.
+  typedef ShapedEvent<std::string, DocumentBoundingBox<float>> FloatEvent;
+  std::vector<FloatEvent> f;
+  EXPECT_FALSE(BinaryReader<FloatEvent>().Read(
+      data.data(), data.data() + data.size(), &f));
+  // Truncated file.
+  EXPECT_FALSE(BinaryReader<RefEvent>().Read(
+      data.data(), data.data() + data.size() - 1, &v));
+  // Plain text.
+  const std::string text = "q1 d1 1 2 3 4\n";
+  EXPECT_FALSE(BinaryReader<RefEvent>().Read(
+      text.data(), text.data() + text.size(), &v));
+  ::testing::internal::GetCapturedStderr();
+}
+
+TEST(AutoFormatReader, DetectFormat) {
+  const std::vector<RefEvent> refs{
+    RefEvent("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4)),
+    RefEvent("q1", DocumentBoundingBox<uint32_t>("d2", 4, 3, 2, 1))};
+  AutoFormatReader<RefEvent> reader;
+  std::vector<RefEvent> v;
+  std::stringstream binary;
+  EXPECT_TRUE(WriteBinaryEvents(refs, &binary));
+  EXPECT_TRUE(reader.Read(&binary, &v));
+  EXPECT_EQ(refs, v);
+  std::istringstream text("# comment\nq1 d1 1 2 3 4\nq1 d2 4 3 2 1\n");
+  EXPECT_TRUE(reader.Read(&text, &v));
+  EXPECT_EQ(refs, v);
+}
@@ -0,0 +1,373 @@
+#ifndef READER_DECOMPRESSINGSTREAM_H_
+#define READER_DECOMPRESSINGSTREAM_H_
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace kws {
+namespace reader {
+
+enum CompressionType {
+  kNoCompression = 0,
+  kGzipCompression,
+  kZstdCompression
+};
+
+// Detects the compression format of some data from its first bytes.
+inline CompressionType DetectCompression(const char* begin, const char* end) {
+  static const unsigned char kGzipMagic[] = {0x1f, 0x8b};
+  static const unsigned char kZstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+  const size_t size = end - begin;
+  if (size >= sizeof(kGzipMagic) &&
+      std::memcmp(begin, kGzipMagic, sizeof(kGzipMagic)) == 0) {
+    return kGzipCompression;
+  }
+  if (size >= sizeof(kZstdMagic) &&
+      std::memcmp(begin, kZstdMagic, sizeof(kZstdMagic)) == 0) {
+    return kZstdCompression;
+  }
+  return kNoCompression;
+}
+
+namespace internal {
+
+// Decompresses data incrementally. Errors are reported with exceptions.
+class Decoder {
+ public:
+  virtual ~Decoder() {}
+
+  // Decompresses the given input, appending the output to *out.
+  virtual void Decode(const char* in, size_t size, std::string* out) = 0;
+
+  // Returns true if the input seen so far ends with a complete stream.
+  virtual bool Finished() const = 0;
+
+ protected:
+  static const size_t kBlockSize = 1 << 16;
+};
+
+class PassThroughDecoder : public Decoder {
+ public:
+  void Decode(const char* in, size_t size, std::string* out) override {
+    out->append(in, size);
+  }
+
+  bool Finished() const override { return true; }
+};
+
+#ifdef WITH_ZLIB
+// Decompresses gzip data. Concatenated gzip members (e.g. from pigz or
+// "cat a.gz b.gz") are decompressed one after the other.
+class GzipDecoder : public Decoder {
+ public:
+  GzipDecoder() : ended_(false) {
+    std::memset(&zs_, 0, sizeof(zs_));
+    if (inflateInit2(&zs_, 15 + 32) != Z_OK) {
+      throw std::runtime_error("Failed to initialize zlib");
+    }
+  }
+
+  ~GzipDecoder() { inflateEnd(&zs_); }
+
+  void Decode(const char* in, size_t size, std::string* out) override {
+    zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+    zs_.avail_in = size;
+    zs_.avail_out = 0;
+    while (zs_.avail_in > 0 || zs_.avail_out == 0) {
+      if (ended_) {
+        if (zs_.avail_in == 0) break;
+        inflateReset(&zs_);
+        ended_ = false;
+      }
+      const size_t pos = out->size();
+      out->resize(pos + kBlockSize);
+      zs_.next_out = reinterpret_cast<Bytef*>(&(*out)[pos]);
+      zs_.avail_out = kBlockSize;
+      const int r = inflate(&zs_, Z_NO_FLUSH);
+      out->resize(pos + kBlockSize - zs_.avail_out);
+      if (r == Z_STREAM_END) {
+        ended_ = true;
+      } else if (r == Z_BUF_ERROR) {
+        break;  // No progress possible, more input is needed.
+      } else if (r != Z_OK) {
+        throw std::runtime_error(
+            std::string("Corrupted gzip data") +
+            (zs_.msg != nullptr ? std::string(": ") + zs_.msg : ""));
+      }
+    }
+  }
+
+  bool Finished() const override { return ended_; }
+
+ private:
+  z_stream zs_;
+  bool ended_;
+};
+#endif  // WITH_ZLIB
+
+#ifdef WITH_ZSTD
+// Decompresses zstd data, possibly made of several concatenated frames.
+class ZstdDecoder : public Decoder {
+ public:
+  ZstdDecoder() : ds_(ZSTD_createDStream()), ended_(false) {
+    if (ds_ == nullptr || ZSTD_isError(ZSTD_initDStream(ds_))) {
+      ZSTD_freeDStream(ds_);
+      throw std::runtime_error("Failed to initialize zstd");
+    }
+  }
+
+  ~ZstdDecoder() { ZSTD_freeDStream(ds_); }
+
+  void Decode(const char* in, size_t size, std::string* out) override {
+    ZSTD_inBuffer input = {in, size, 0};
+    bool full = false;
+    while (input.pos < input.size || full) {
+      const size_t pos = out->size();
+      out->resize(pos + kBlockSize);
+      ZSTD_outBuffer output = {&(*out)[pos], kBlockSize, 0};
+      const size_t r = ZSTD_decompressStream(ds_, &output, &input);
+      out->resize(pos + output.pos);
+      if (ZSTD_isError(r)) {
+        throw std::runtime_error(
+            std::string("Corrupted zstd data: ") + ZSTD_getErrorName(r));
+      }
+      ended_ = (r == 0);
+      full = (output.pos == output.size);
+    }
+  }
+
+  bool Finished() const override { return ended_; }
+
+ private:
+  ZSTD_DStream* ds_;
+  bool ended_;
+};
+#endif  // WITH_ZSTD
+
+inline Decoder* MakeDecoder(CompressionType type) {
+  switch (type) {
+    case kNoCompression:
+      return new PassThroughDecoder;
+#ifdef WITH_ZLIB
+    case kGzipCompression:
+      return new GzipDecoder;
+#endif
+#ifdef WITH_ZSTD
+    case kZstdCompression:
+      return new ZstdDecoder;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+inline const char* CompressionName(CompressionType type) {
+  switch (type) {
+    case kGzipCompression:
+      return "gzip";
+    case kZstdCompression:
+      return "zstd";
+    default:
+      return "plain";
+  }
+}
+
+}  // namespace internal
+
+// Stream buffer that decompresses its source on the fly. The compression
+// format is detected from the first bytes of the source, and uncompressed
+// sources are passed through unchanged.
+//
+// Decompression runs on a separate thread, one chunk ahead of the reader:
+// while the caller parses a chunk, the next one is being decompressed, so
+// that both costs overlap. Uncompressed sources are read directly instead,
+// without copying memory sources.
+// Decompression errors are printed to stderr and thrown from underflow(),
+// which makes the std::istream reading from this buffer set its badbit.
+class DecompressingStreamBuf : public std::streambuf {
+ public:
+  // Reads from the given stream. The characters in prefix are processed
+  // before those in the stream (i.e. they were already extracted from it).
+  // Since the source is read ahead, it should not be used by anyone else.
+  explicit DecompressingStreamBuf(std::istream* source,
+                                  const std::string& prefix = "")
+      : source_(source), begin_(nullptr), end_(nullptr), prefix_(prefix) {
+    char c;
+    while (prefix_.size() < kMagicSize && source_->get(c)) prefix_.push_back(c);
+    Start();
+  }
+
+  // Reads from the memory range [begin, end), which must outlive this object.
+  DecompressingStreamBuf(const char* begin, const char* end)
+      : source_(nullptr), begin_(begin), end_(end) {
+    Start();
+  }
+
+  DecompressingStreamBuf(const DecompressingStreamBuf&) = delete;
+
+  DecompressingStreamBuf& operator=(const DecompressingStreamBuf&) = delete;
+
+  ~DecompressingStreamBuf() {
+    if (pending_.valid()) pending_.wait();
+  }
+
+  inline CompressionType Compression() const { return type_; }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if (type_ == kNoCompression) return ReadUncompressed();
+    while (pending_.valid()) {
+      try {
+        chunk_ = pending_.get();
+      } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        throw;
+      }
+      if (!input_ended_) {
+        pending_ = std::async(std::launch::async,
+                              &DecompressingStreamBuf::DecodeChunk, this);
+      }
+      if (!chunk_.empty()) {
+        char* p = &chunk_[0];
+        setg(p, p, p + chunk_.size());
+        return traits_type::to_int_type(*p);
+      }
+    }
+    return traits_type::eof();
+  }
+
+ private:
+  static const size_t kMagicSize = 4;
+  static const size_t kChunkSize = 1 << 18;
+
+  void Start() {
+    const char* magic = source_ != nullptr ? prefix_.data() : begin_;
+    const size_t size = source_ != nullptr ? prefix_.size() : end_ - begin_;
+    type_ = DetectCompression(magic, magic + size);
+    input_ended_ = false;
+    if (type_ == kNoCompression) return;
+    pending_ = std::async(std::launch::async,
+                          &DecompressingStreamBuf::DecodeChunk, this);
+  }
+
+  // Makes the next block of the uncompressed source the get area.
+  int_type ReadUncompressed() {
+    const char* data;
+    size_t size;
+    try {
+      size = ReadInput(&data);
+    } catch (const std::exception& e) {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      throw;
+    }
+    if (size == 0) return traits_type::eof();
+    // The get area is never written, since pbackfail() is not overridden.
+    char* p = const_cast<char*>(data);
+    setg(p, p, p + size);
+    return traits_type::to_int_type(*p);
+  }
+
+  // Returns the next block of input data, or an empty block at the end.
+  size_t ReadInput(const char** data) {
+    if (!prefix_.empty()) {
+      input_.swap(prefix_);
+      prefix_.clear();
+    } else if (source_ != nullptr) {
+      input_.resize(kChunkSize);
+      source_->read(&input_[0], kChunkSize);
+      input_.resize(source_->gcount());
+      if (source_->bad()) throw std::runtime_error("Failed reading input");
+    } else {
+      *data = begin_;
+      const size_t size =
+          std::min(static_cast<size_t>(end_ - begin_), size_t(kChunkSize));
+      begin_ += size;
+      return size;
+    }
+    *data = input_.data();
+    return input_.size();
+  }
+
+  // Produces the next chunk of output, with (at least) kChunkSize
+  // characters unless the input ends. Runs on a separate thread, but never
+  // concurrently with itself.
+  std::string DecodeChunk() {
+    if (decoder_ == nullptr) {
+      decoder_.reset(internal::MakeDecoder(type_));
+      if (decoder_ == nullptr) {
+        throw std::runtime_error(
+            std::string("Cannot read ") + internal::CompressionName(type_) +
+            "-compressed input, compile with -DWITH_" +
+            (type_ == kGzipCompression ? "ZLIB" : "ZSTD") + "=ON");
+      }
+    }
+    std::string out;
+    out.reserve(kChunkSize + (1 << 16));
+    while (out.size() < kChunkSize) {
+      const char* data;
+      const size_t size = ReadInput(&data);
+      if (size == 0) {
+        input_ended_ = true;
+        if (!decoder_->Finished()) {
+          throw std::runtime_error(
+              std::string("Unexpected end of ") +
+              internal::CompressionName(type_) + "-compressed input");
+        }
+        break;
+      }
+      decoder_->Decode(data, size, &out);
+    }
+    return out;
+  }
+
+  std::istream* source_;
+  const char* begin_;
+  const char* end_;
+  std::string prefix_;
+  std::string input_;
+  std::string chunk_;
+  CompressionType type_;
+  bool input_ended_;
+  std::unique_ptr<internal::Decoder> decoder_;
+  std::future<std::string> pending_;
+};
+
+// Input stream that decompresses its source transparently, see
+// DecompressingStreamBuf.
+class DecompressingIstream : public std::istream {
+ public:
+  explicit DecompressingIstream(std::istream* source,
+                                const std::string& prefix = "")
+      : std::istream(nullptr), buf_(source, prefix) {
+    rdbuf(&buf_);
+  }
+
+  DecompressingIstream(const char* begin, const char* end)
+      : std::istream(nullptr), buf_(begin, end) {
+    rdbuf(&buf_);
+  }
+
+  inline CompressionType Compression() const { return buf_.Compression(); }
+
+ private:
+  DecompressingStreamBuf buf_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_DECOMPRESSINGSTREAM_H_
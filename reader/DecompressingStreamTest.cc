@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+
+#include "reader/DecompressingStream.h"
+
+using kws::reader::CompressionType;
+using kws::reader::DecompressingIstream;
+using kws::reader::DetectCompression;
+using kws::reader::kGzipCompression;
+using kws::reader::kNoCompression;
+using kws::reader::kZstdCompression;
+
+static std::string MakeInput(size_t num_lines) {
+  std::ostringstream oss;
+  for (size_t i = 0; i < num_lines; ++i) {
+    oss << "q" << i % 13 << " d" << i % 17 << " " << i << " 10 20 30\n";
+  }
+  return oss.str();
+}
+
+static std::string ReadAll(std::istream* is) {
+  std::ostringstream oss;
+  char buf[1000];
+  while (is->read(buf, sizeof(buf)) || is->gcount() > 0) {
+    oss.write(buf, is->gcount());
+  }
+  return oss.str();
+}
+
+static CompressionType Detect(const std::string& s) {
+  return DetectCompression(s.data(), s.data() + s.size());
+}
+
+TEST(DecompressingStream, DetectCompression) {
+  EXPECT_EQ(kNoCompression, Detect(""));
+  EXPECT_EQ(kNoCompression, Detect("q1 d1 1 2 3 4"));
+  EXPECT_EQ(kNoCompression, Detect("\x1f"));
+  EXPECT_EQ(kGzipCompression, Detect("\x1f\x8b"));
+  EXPECT_EQ(kNoCompression, Detect("\x28\xb5\x2f"));
+  EXPECT_EQ(kZstdCompression, Detect("\x28\xb5\x2f\xfd"));
+}
+
+TEST(DecompressingStream, PassThrough) {
+  const std::string input = MakeInput(100000);
+  std::istringstream iss(input);
+  DecompressingIstream is(&iss);
+  EXPECT_EQ(kNoCompression, is.Compression());
+  EXPECT_EQ(input, ReadAll(&is));
+  EXPECT_TRUE(is.eof());
+  EXPECT_FALSE(is.bad());
+
+  // The first characters can be given separately.
+  std::istringstream rest(input.substr(3));
+  DecompressingIstream is2(&rest, input.substr(0, 3));
+  EXPECT_EQ(input, ReadAll(&is2));
+
+  // Memory sources.
+  DecompressingIstream is3(input.data(), input.data() + input.size());
+  EXPECT_EQ(input, ReadAll(&is3));
+}
+
+TEST(DecompressingStream, Empty) {
+  std::istringstream iss("");
+  DecompressingIstream is(&iss);
+  EXPECT_EQ("", ReadAll(&is));
+  EXPECT_TRUE(is.eof());
+  EXPECT_FALSE(is.bad());
+}
+
+TEST(DecompressingStream, Lines) {
+  std::istringstream iss("a b\n\nc d\n");
+  DecompressingIstream is(&iss);
+  std::string line;
+  EXPECT_TRUE(std::getline(is, line));
+  EXPECT_EQ("a b", line);
+  EXPECT_TRUE(std::getline(is, line));
+  EXPECT_EQ("", line);
+  EXPECT_TRUE(std::getline(is, line));
+  EXPECT_EQ("c d", line);
+  EXPECT_FALSE(std::getline(is, line));
+}
+
+#ifdef WITH_ZLIB
+static std::string Gzip(const std::string& input) {
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  EXPECT_EQ(Z_OK, deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               15 + 16, 8, Z_DEFAULT_STRATEGY));
+  std::string output(deflateBound(&zs, input.size()), '\0');
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  zs.avail_in = input.size();
+  zs.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  zs.avail_out = output.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+  output.resize(zs.total_out);
+  deflateEnd(&zs);
+  return output;
+}
+
+TEST(DecompressingStream, Gzip) {
+  const std::string input = MakeInput(100000);
+  const std::string compressed = Gzip(input);
+  std::istringstream iss(compressed);
+  DecompressingIstream is(&iss);
+  EXPECT_EQ(kGzipCompression, is.Compression());
+  EXPECT_EQ(input, ReadAll(&is));
+  EXPECT_FALSE(is.bad());
+
+  DecompressingIstream is2(compressed.data(),
+                           compressed.data() + compressed.size());
+  EXPECT_EQ(input, ReadAll(&is2));
+
+  // Concatenated members.
+  std::istringstream iss3(compressed + Gzip("foo\n"));
+  DecompressingIstream is3(&iss3);
+  EXPECT_EQ(input + "foo\n", ReadAll(&is3));
+  EXPECT_FALSE(is3.bad());
+}
+
+TEST(DecompressingStream, GzipTruncated) {
+  const std::string compressed = Gzip(MakeInput(1000));
+  std::istringstream iss(compressed.substr(0, compressed.size() / 2));
+  DecompressingIstream is(&iss);
+  ::testing::internal::CaptureStderr();
+  ReadAll(&is);
+  EXPECT_EQ("ERROR: Unexpected end of gzip-compressed input\n",
+            ::testing::internal::GetCapturedStderr());
+  EXPECT_TRUE(is.bad());
+}
+#endif  // WITH_ZLIB
+
+#ifdef WITH_ZSTD
+static std::string Zstd(const std::string& input) {
+  std::string output(ZSTD_compressBound(input.size()), '\0');
+  const size_t size = ZSTD_compress(&output[0], output.size(),
+                                    input.data(), input.size(), 3);
+  EXPECT_FALSE(ZSTD_isError(size));
+  output.resize(size);
+  return output;
+}
+
+TEST(DecompressingStream, Zstd) {
+  const std::string input = MakeInput(100000);
+  const std::string compressed = Zstd(input);
+  std::istringstream iss(compressed);
+  DecompressingIstream is(&iss);
+  EXPECT_EQ(kZstdCompression, is.Compression());
+  EXPECT_EQ(input, ReadAll(&is));
+  EXPECT_FALSE(is.bad());
+
+  // Concatenated frames.
+  std::istringstream iss2(compressed + Zstd("foo\n"));
+  DecompressingIstream is2(&iss2);
+  EXPECT_EQ(input + "foo\n", ReadAll(&is2));
+  EXPECT_FALSE(is2.bad());
+}
+
+TEST(DecompressingStream, ZstdTruncated) {
+  const std::string compressed = Zstd(MakeInput(1000));
+  std::istringstream iss(compressed.substr(0, compressed.size() / 2));
+  DecompressingIstream is(&iss);
+  ::testing::internal::CaptureStderr();
+  ReadAll(&is);
+  EXPECT_EQ("ERROR: Unexpected end of zstd-compressed input\n",
+            ::testing::internal::GetCapturedStderr());
+  EXPECT_TRUE(is.bad());
+}
+#else
+TEST(DecompressingStream, Unsupported) {
+  std::istringstream iss(std::string("\x28\xb5\x2f\xfd") + "foo");
+  DecompressingIstream is(&iss);
+  ::testing::internal::CaptureStderr();
+  EXPECT_EQ("", ReadAll(&is));
+  EXPECT_EQ("ERROR: Cannot read zstd-compressed input, compile with "
+            "-DWITH_ZSTD=ON\n", ::testing::internal::GetCapturedStderr());
+  EXPECT_TRUE(is.bad());
+}
+#endif  // WITH_ZSTD
@@ -0,0 +1,95 @@
+#ifndef READER_EVENTFILTER_H_
+#define READER_EVENTFILTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "core/PlainScoredEvent.h"
+#include "core/ScoredEvent.h"
+#include "mapper/StringInternTable.h"
+
+namespace kws {
+namespace reader {
+
+// Selects the events that readers keep, so that the rest of events are
+// discarded while parsing the input, without building them.
+//
+// Events are selected by their query, before the rest of the line is
+// parsed, and by their score (only for scored events), after parsing it.
+// Queries are compared in their textual form, before being mapped.
+// Lines rejected by their query are not parsed, thus they are not checked
+// for errors either.
+class EventFilter {
+ public:
+  EventFilter()
+      : min_score_(-std::numeric_limits<float>::infinity()), num_rejected_(0) {}
+
+  EventFilter(const EventFilter&) = delete;
+
+  EventFilter& operator=(const EventFilter&) = delete;
+
+  // Once some query is added, only events of the added queries are kept.
+  void AddQuery(const std::string& query) {
+    uint32_t id;
+    if (!queries_.Find(query.data(), query.size(), &id)) {
+      queries_.Insert(query.data(), query.size());
+    }
+  }
+
+  // Events with a lower score are discarded.
+  void SetMinScore(float min_score) { min_score_ = min_score; }
+
+  inline float MinScore() const { return min_score_; }
+
+  inline bool FiltersQueries() const { return !queries_.empty(); }
+
+  // Returns true if events with the query [begin, end) must be kept. The
+  // query is looked up in place, without copying it.
+  bool KeepQuery(const char* begin, const char* end) const {
+    uint32_t id;
+    return queries_.empty() || queries_.Find(begin, end - begin, &id);
+  }
+
+  bool KeepQuery(const std::string& query) const {
+    return KeepQuery(query.data(), query.data() + query.size());
+  }
+
+  inline bool KeepScore(float score) const { return score >= min_score_; }
+
+  // Returns true if the (already parsed) event must be kept. Only the
+  // score of the events is checked.
+  template <typename E>
+  bool KeepParsed(const E&) const { return true; }
+
+  template <typename E>
+  bool KeepParsed(const core::ScoredEvent<E>& event) const {
+    return KeepScore(event.Score());
+  }
+
+  template <typename E>
+  bool KeepParsed(const core::PlainScoredEvent<E>& event) const {
+    return KeepScore(event.score);
+  }
+
+  // Readers report the number of events they discarded. This is
+  // thread-safe.
+  void AddRejected(size_t n) const {
+    if (n > 0) num_rejected_ += n;
+  }
+
+  inline size_t NumRejected() const { return num_rejected_; }
+
+  void ResetRejected() { num_rejected_ = 0; }
+
+ private:
+  mapper::StringInternTable<uint32_t> queries_;
+  float min_score_;
+  mutable std::atomic<size_t> num_rejected_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_EVENTFILTER_H_
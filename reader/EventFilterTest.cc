@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/Event.h"
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "reader/AutoFormatReader.h"
+#include "reader/BinaryEventFormat.h"
+#include "reader/EventFilter.h"
+#include "reader/MmapTextReader.h"
+#include "reader/ParallelTextReader.h"
+#include "reader/PlainTextReader.h"
+#include "reader/TextFieldParser.h"
+
+using kws::core::DocumentBoundingBox;
+using kws::core::Event;
+using kws::core::PlainEvent;
+using kws::core::PlainScoredEvent;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::reader::AutoFormatReader;
+using kws::reader::EventFilter;
+using kws::reader::MmapTextReader;
+using kws::reader::ParseFilteredLine;
+using kws::reader::ParallelTextReader;
+using kws::reader::PlainTextReader;
+using kws::reader::Reader;
+using kws::reader::WriteBinaryEvents;
+
+using testing::ElementsAre;
+
+typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+
+static const char kInput[] =
+    "# header\n"
+    "q1 d1 1 2 3 4 0.9\n"
+    "q2 d1 1 2 3 4 0.8\n"
+    "q3 this line is not parsed\n"
+    "q1 d2 1 2 3 4 0.1\n"
+    "\n"
+    "q2 d2 5 6 7 8 0.5\n";
+
+static std::vector<HypEvent> ReadWithFilter(Reader<HypEvent>* reader,
+                                            const EventFilter& filter) {
+  reader->SetFilter(&filter);
+  std::istringstream iss(kInput);
+  std::vector<HypEvent> events;
+  EXPECT_TRUE(reader->Read(&iss, &events));
+  // Same result reading in batches.
+  std::istringstream iss2(kInput);
+  auto batches = reader->OpenBatches(&iss2);
+  std::vector<HypEvent> all, batch;
+  while (batches->Next(1, &batch)) {
+    all.insert(all.end(), batch.begin(), batch.end());
+  }
+  EXPECT_FALSE(batches->Fail());
+  EXPECT_EQ(events, all);
+  return events;
+}
+
+TEST(EventFilter, KeepAll) {
+  EventFilter filter;
+  EXPECT_FALSE(filter.FiltersQueries());
+  EXPECT_TRUE(filter.KeepQuery("q1"));
+  EXPECT_TRUE(filter.KeepScore(-1e9f));
+  EXPECT_TRUE(filter.KeepParsed(RefEvent()));
+}
+
+TEST(EventFilter, Queries) {
+  EventFilter filter;
+  filter.AddQuery("q1");
+  filter.AddQuery("query 2");
+  filter.AddQuery("q1");
+  EXPECT_TRUE(filter.FiltersQueries());
+  EXPECT_TRUE(filter.KeepQuery("q1"));
+  EXPECT_TRUE(filter.KeepQuery("query 2"));
+  EXPECT_FALSE(filter.KeepQuery("q"));
+  EXPECT_FALSE(filter.KeepQuery("q12"));
+  EXPECT_FALSE(filter.KeepQuery(""));
+  // Queries are looked up in place, within a larger buffer.
+  static const char kLine[] = "q12 d1";
+  EXPECT_TRUE(filter.KeepQuery(kLine, kLine + 2));
+  EXPECT_FALSE(filter.KeepQuery(kLine, kLine + 3));
+}
+
+TEST(EventFilter, PlainScoredEvents) {
+  // Plain and virtual scored events are filtered by their score alike.
+  static const char kLine[] = "q l 0.1";
+  const char* end = kLine + sizeof(kLine) - 1;
+  EventFilter filter;
+  PlainScoredEvent<PlainEvent<std::string, std::string>> plain;
+  ScoredEvent<Event<std::string, std::string>> scored;
+  bool keep = false;
+  EXPECT_TRUE(ParseFilteredLine(kLine, end, &filter, &plain, &keep));
+  EXPECT_TRUE(keep);
+  EXPECT_TRUE(ParseFilteredLine(kLine, end, &filter, &scored, &keep));
+  EXPECT_TRUE(keep);
+  filter.SetMinScore(0.5f);
+  EXPECT_TRUE(ParseFilteredLine(kLine, end, &filter, &plain, &keep));
+  EXPECT_FALSE(keep);
+  EXPECT_TRUE(ParseFilteredLine(kLine, end, &filter, &scored, &keep));
+  EXPECT_FALSE(keep);
+  EXPECT_EQ(0.1f, plain.score);
+}
+
+TEST(EventFilter, Readers) {
+  EventFilter filter;
+  filter.AddQuery("q1");
+  filter.AddQuery("q2");
+  filter.SetMinScore(0.5f);
+  const std::vector<HypEvent> expected{
+    HypEvent("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4), 0.9f),
+    HypEvent("q2", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4), 0.8f),
+    HypEvent("q2", DocumentBoundingBox<uint32_t>("d2", 5, 6, 7, 8), 0.5f)};
+  PlainTextReader<HypEvent> plain_reader;
+  MmapTextReader<HypEvent> mmap_reader;
+  ParallelTextReader<HypEvent> parallel_reader(3, 1);
+  AutoFormatReader<HypEvent> auto_reader;
+  EXPECT_EQ(expected, ReadWithFilter(&plain_reader, filter));
+  EXPECT_EQ(expected, ReadWithFilter(&mmap_reader, filter));
+  EXPECT_EQ(expected, ReadWithFilter(&parallel_reader, filter));
+  EXPECT_EQ(expected, ReadWithFilter(&auto_reader, filter));
+  // Each read (and batched read) discards two lines.
+  EXPECT_EQ(16, filter.NumRejected());
+}
+
+TEST(EventFilter, BinaryReader) {
+  std::vector<HypEvent> hyps;
+  for (uint32_t i = 0; i < 100; ++i) {
+    hyps.push_back(HypEvent(
+        "q" + std::to_string(i % 4),
+        DocumentBoundingBox<uint32_t>("d", i, i, 1, 1), i / 100.0f));
+  }
+  std::stringstream ss;
+  EXPECT_TRUE(WriteBinaryEvents(hyps, &ss));
+  EventFilter filter;
+  filter.AddQuery("q3");
+  filter.SetMinScore(0.9f);
+  AutoFormatReader<HypEvent> reader;
+  reader.SetFilter(&filter);
+  auto batches = reader.OpenBatches(&ss);
+  std::vector<HypEvent> batch;
+  EXPECT_TRUE(batches->Next(10, &batch));
+  EXPECT_THAT(batch, ElementsAre(hyps[91], hyps[95], hyps[99]));
+  EXPECT_FALSE(batches->Next(10, &batch));
+  EXPECT_FALSE(batches->Fail());
+  EXPECT_EQ(97, filter.NumRejected());
+}
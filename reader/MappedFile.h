@@ -0,0 +1,132 @@
+#ifndef READER_MAPPEDFILE_H_
+#define READER_MAPPEDFILE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "reader/DecompressingStream.h"
+
+namespace kws {
+namespace reader {
+
+// Read-only view of the full content of a file.
+// Regular files are memory-mapped. Other files (pipes, character devices,
+// etc.) cannot be mapped, so their content is read into an internal buffer.
+// Compressed inputs (see DecompressingStream.h) are decompressed into the
+// internal buffer as well.
+class MappedFile {
+ public:
+  MappedFile() : data_(nullptr), size_(0), mapped_(false) {}
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() { Close(); }
+
+  // If decompress is false, the content of compressed files is not
+  // decompressed (e.g. to decompress it in a streaming fashion instead).
+  bool Open(const std::string& filepath, bool decompress = true) {
+    Close();
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      return false;
+    }
+    bool ok = true;
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+      void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(addr);
+        size_ = st.st_size;
+        mapped_ = true;
+      } else {
+        ok = ReadDescriptor(fd);
+      }
+    } else if (!S_ISREG(st.st_mode)) {
+      ok = ReadDescriptor(fd);
+    }
+    close(fd);
+    if (ok && decompress &&
+        DetectCompression(Begin(), End()) != kNoCompression) {
+      std::vector<char> content;
+      {
+        DecompressingIstream dis(Begin(), End());
+        ok = ReadStream(&dis, &content);
+      }
+      Close();
+      buffer_.swap(content);
+      data_ = buffer_.data();
+      size_ = buffer_.size();
+    }
+    return ok;
+  }
+
+  // Reads the remaining content of the given stream into the internal buffer.
+  // The characters in prefix are placed before those read from the stream.
+  bool Open(std::istream* is, const std::string& prefix = "") {
+    Close();
+    DecompressingIstream dis(is, prefix);
+    const bool ok = ReadStream(&dis, &buffer_);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return ok;
+  }
+
+  void Close() {
+    if (mapped_) munmap(const_cast<char*>(data_), size_);
+    std::vector<char>().swap(buffer_);
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+  }
+
+  inline const char* Data() const { return data_; }
+
+  inline size_t Size() const { return size_; }
+
+  inline const char* Begin() const { return data_; }
+
+  inline const char* End() const { return data_ + size_; }
+
+  inline bool IsMapped() const { return mapped_; }
+
+ private:
+  static bool ReadStream(std::istream* is, std::vector<char>* content) {
+    char buf[1 << 16];
+    while (is->read(buf, sizeof(buf)) || is->gcount() > 0) {
+      content->insert(content->end(), buf, buf + is->gcount());
+    }
+    return is->eof() && !is->bad();
+  }
+
+  bool ReadDescriptor(int fd) {
+    char buf[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      buffer_.insert(buffer_.end(), buf, buf + n);
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return n == 0;
+  }
+
+  const char* data_;
+  size_t size_;
+  bool mapped_;
+  std::vector<char> buffer_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_MAPPEDFILE_H_
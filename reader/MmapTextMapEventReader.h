@@ -0,0 +1,105 @@
+#ifndef READER_MMAPTEXTMAPEVENTREADER_H_
+#define READER_MMAPTEXTMAPEVENTREADER_H_
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "reader/DecompressingStream.h"
+#include "reader/MappedFile.h"
+#include "reader/Reader.h"
+#include "reader/TextBatchReader.h"
+#include "reader/TextEventMapping.h"
+#include "reader/TextFieldParser.h"
+
+namespace kws {
+namespace reader {
+
+// Reads the same plain text format as PlainTextMapEventReader, but the
+// input file is memory-mapped and the fields of each line are parsed in
+// place, without building intermediate strings or streams. Streams and
+// compressed files are parsed in blocks, as they are read (or decompressed).
+template <typename Mapper>
+class MmapTextMapEventReader : public Reader<typename Mapper::OutputType> {
+ public:
+  typedef typename Mapper::InputType E1;
+  typedef typename TextEventMapping<Mapper>::Parsed Parsed;
+  typedef typename Mapper::OutputType E2;
+
+  explicit MmapTextMapEventReader(Mapper& mapper) : mapper_(&mapper) {}
+
+  explicit MmapTextMapEventReader(Mapper* mapper) : mapper_(mapper) {}
+
+  bool Read(std::istream* is, std::vector<E2>* events) const override {
+    DecompressingIstream dis(is);
+    return ReadStream(&dis, events);
+  }
+
+  bool Read(const std::string &filepath, std::vector<E2> *events) const override {
+    MappedFile file;
+    if (!file.Open(filepath, false)) return false;
+    if (DetectCompression(file.Begin(), file.End()) == kNoCompression) {
+      return Read(file.Begin(), file.End(), events);
+    }
+    DecompressingIstream dis(file.Begin(), file.End());
+    return ReadStream(&dis, events);
+  }
+
+  // Events are parsed sequentially, as the batches are requested.
+  std::unique_ptr<BatchReader<E2>> OpenBatches(std::istream* is) const override {
+    return std::unique_ptr<BatchReader<E2>>(
+        new TextMapEventBatchReader<Mapper>(mapper_, is, "", this->filter_));
+  }
+
+  std::unique_ptr<BatchReader<E2>> OpenBatches(
+      const std::string& filepath) const override {
+    return std::unique_ptr<BatchReader<E2>>(
+        new TextMapEventBatchReader<Mapper>(mapper_, filepath,
+                                            this->filter_));
+  }
+
+  bool Read(const char* begin, const char* end, std::vector<E2>* events) const {
+    events->clear();
+    return ReadLines(begin, end, 1, events);
+  }
+
+  bool IsThreadSafe() const override { return mapper_->IsThreadSafe(); }
+
+ protected:
+  static const size_t kBlockSize = 1 << 20;
+
+  bool ReadStream(std::istream* is, std::vector<E2>* events) const {
+    events->clear();
+    return ForEachLineBlock(
+        is, "", kBlockSize,
+        [this, events](const char* begin, const char* end, size_t line) {
+          return ReadLines(begin, end, line, events);
+        });
+  }
+
+  // Parses the lines in [begin, end), whose first line is the given one,
+  // and appends their events to *events.
+  bool ReadLines(const char* begin, const char* end, size_t first_line,
+                 std::vector<E2>* events) const {
+    size_t error_line = 0;
+    Mapper* mapper = mapper_;
+    if (!ParseLines<Parsed>(begin, end, first_line,
+                            [mapper, events](const Parsed& e) {
+                              events->push_back(
+                                  TextEventMapping<Mapper>::Map(mapper, e));
+                            }, &error_line, this->filter_)) {
+      std::cerr << "ERROR: Failed to read event from line " << error_line
+                << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  Mapper* mapper_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_MMAPTEXTMAPEVENTREADER_H_
@@ -0,0 +1,25 @@
+#ifndef READER_MMAPTEXTREADER_H_
+#define READER_MMAPTEXTREADER_H_
+
+#include "reader/MmapTextMapEventReader.h"
+#include "mapper/IdentityMapper.h"
+
+namespace kws {
+namespace reader {
+
+using kws::mapper::IdentityMapper;
+
+template<typename E>
+class MmapTextReader : public MmapTextMapEventReader<IdentityMapper<E>> {
+ public:
+  typedef MmapTextMapEventReader<IdentityMapper<E>> BaseType;
+  MmapTextReader() : BaseType(&mapper) {}
+
+ protected:
+  IdentityMapper<E> mapper;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_MMAPTEXTREADER_H_
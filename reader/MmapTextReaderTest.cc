@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/Event.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "reader/MmapTextReader.h"
+
+using kws::core::DocumentBoundingBox;
+using kws::core::DocumentIdBoundingBox;
+using kws::core::Event;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::reader::MmapTextReader;
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+typedef Event<std::string, DocumentBoundingBox<int>> DocEvent;
+
+TEST(MmapTextReader, Integers) {
+  MmapTextReader<int> reader;
+  std::istringstream iss(
+      "# this is a comment line\n"
+      "1\n2\n3\n"
+      "# this is also a comment line\n"
+      "  -4\t\n"
+      "\n");
+  std::vector<int> v;
+  EXPECT_TRUE(reader.Read(&iss, &v));
+  EXPECT_THAT(v, ElementsAre(1, 2, 3, -4));
+}
+
+TEST(MmapTextReader, EventDocumentBoundingBox) {
+  MmapTextReader<DocEvent> reader;
+  const DocEvent b1("q1", DocumentBoundingBox<int>("d1", 1, 2, 3, 4));
+  const DocEvent b2("q1", DocumentBoundingBox<int>("d2", 4, 3, 2, 1));
+  {
+    // File with comments but no events.
+    std::istringstream iss(
+        "# This is a comment line\n"
+        "# This is another comment line\n");
+    std::vector<DocEvent> v;
+    EXPECT_TRUE(reader.Read(&iss, &v));
+    EXPECT_THAT(v, IsEmpty());
+  }
+  {
+    // Valid case with comments and windows new lines, no final new line
+    std::istringstream iss(
+        "# this is a comment\r\n"
+        "q1 d1 1 2 3 4\r\n"
+        "# this is a comment\n"
+        "q1 d2 4 3 2 1");
+    std::vector<DocEvent> v;
+    EXPECT_TRUE(reader.Read(&iss, &v));
+    EXPECT_THAT(v, ElementsAre(b1, b2));
+  }
+  {
+    // Missing info
+    std::istringstream iss(
+        "# this is a comment\n"
+        "q1 d1 1 2 3 4\n"
+        "q2 d1 5 6 7 8\n"
+        "q1 d2 9 10 11\n"  // <- Missing h coordinate!
+        "q1 d1 13 14 15 16\n");
+    std::vector<DocEvent> v;
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(reader.Read(&iss, &v));
+    EXPECT_EQ("ERROR: Failed to read event from line 4\n",
+              ::testing::internal::GetCapturedStderr());
+  }
+  {
+    // Extra info
+    std::istringstream iss("q1 d1 1 2 3 4 5\n");
+    std::vector<DocEvent> v;
+    ::testing::internal::CaptureStderr();
+    EXPECT_FALSE(reader.Read(&iss, &v));
+    EXPECT_EQ("ERROR: Failed to read event from line 1\n",
+              ::testing::internal::GetCapturedStderr());
+  }
+}
+
+TEST(MmapTextReader, EventDocumentIdBoundingBox) {
+  typedef Event<std::string, DocumentIdBoundingBox<int>> IdEvent;
+  MmapTextReader<IdEvent> reader;
+  std::istringstream iss("q1 d1 1 2 3 4\nq1 d2 4 3 2 1\nq2 d1 5 6 7 8\n");
+  std::vector<IdEvent> v;
+  EXPECT_TRUE(reader.Read(&iss, &v));
+  EXPECT_THAT(v, ElementsAre(
+      IdEvent("q1", DocumentIdBoundingBox<int>("d1", 1, 2, 3, 4)),
+      IdEvent("q1", DocumentIdBoundingBox<int>("d2", 4, 3, 2, 1)),
+      IdEvent("q2", DocumentIdBoundingBox<int>("d1", 5, 6, 7, 8))));
+  EXPECT_EQ(v[0].Location().document, v[2].Location().document);
+  EXPECT_EQ("d2", v[1].Location().DocumentName());
+}
+
+TEST(MmapTextReader, ScoredEventFromFile) {
+  typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+  const std::string filepath = ::testing::TempDir() + "MmapTextReaderTest.txt";
+  {
+    std::ofstream ofs(filepath);
+    ofs << "# QueryID DocumentID x y width height score\n"
+        << "q1 d1 3 5 400 40 0.9\n"
+        << "q2 d2 6 100 350 35 -1.5e-3\n";
+  }
+  MmapTextReader<HypEvent> reader;
+  std::vector<HypEvent> v;
+  EXPECT_TRUE(reader.Read(filepath, &v));
+  EXPECT_THAT(v, ElementsAre(
+      HypEvent("q1", DocumentBoundingBox<uint32_t>("d1", 3, 5, 400, 40), 0.9f),
+      HypEvent("q2", DocumentBoundingBox<uint32_t>("d2", 6, 100, 350, 35),
+               -1.5e-3f)));
+  std::remove(filepath.c_str());
+  // Missing files cannot be read.
+  EXPECT_FALSE(reader.Read(filepath, &v));
+}
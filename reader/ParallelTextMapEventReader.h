@@ -0,0 +1,202 @@
+#ifndef READER_PARALLELTEXTMAPEVENTREADER_H_
+#define READER_PARALLELTEXTMAPEVENTREADER_H_
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapper/IdentityMapper.h"
+#include "reader/DecompressingStream.h"
+#include "reader/MappedFile.h"
+#include "reader/Reader.h"
+#include "reader/TextBatchReader.h"
+#include "reader/TextEventMapping.h"
+#include "reader/TextFieldParser.h"
+
+namespace kws {
+namespace reader {
+
+using kws::mapper::IdentityMapper;
+
+// Splits the buffer [begin, end) into (at most) num_chunks chunks of similar
+// size, each of them ending right after a new line character (except,
+// perhaps, the last one). Returns the boundaries of the chunks: chunk i is
+// [bounds[i], bounds[i + 1]).
+inline std::vector<const char*> SplitLines(
+    const char* begin, const char* end, size_t num_chunks) {
+  std::vector<const char*> bounds{begin};
+  const size_t size = end - begin;
+  for (size_t i = 1; i < num_chunks && bounds.back() < end; ++i) {
+    const char* p = std::max(bounds.back(), begin + size * i / num_chunks);
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    bounds.push_back(eol != nullptr ? eol + 1 : end);
+  }
+  if (bounds.back() < end) bounds.push_back(end);
+  return bounds;
+}
+
+// Applies the mapper to all the parsed events, in order.
+template <typename Mapper>
+void MapEvents(Mapper* mapper,
+               std::vector<typename TextEventMapping<Mapper>::Parsed>* input,
+               std::vector<typename Mapper::OutputType>* output) {
+  for (const auto& e : *input) {
+    output->push_back(TextEventMapping<Mapper>::Map(mapper, e));
+  }
+}
+
+template <typename E>
+void MapEvents(IdentityMapper<E>* mapper, std::vector<E>* input,
+               std::vector<E>* output) {
+  std::move(input->begin(), input->end(), std::back_inserter(*output));
+}
+
+// Reads the same plain text format as PlainTextMapEventReader. The input is
+// split into newline-aligned chunks, which are parsed concurrently by
+// different threads. The parsed events are then mapped sequentially, in the
+// original order of the lines, so the output (and the state of the mapper)
+// is the same as if the file was read by a single thread. Thread-safe mappers
+// (see Mapper::IsThreadSafe()) are instead called by the threads parsing the
+// chunks. Streams and compressed files are read in blocks, which are split
+// and parsed as they are read (or decompressed).
+template <typename Mapper>
+class ParallelTextMapEventReader : public Reader<typename Mapper::OutputType> {
+ public:
+  typedef typename Mapper::InputType E1;
+  typedef typename TextEventMapping<Mapper>::Parsed Parsed;
+  typedef typename Mapper::OutputType E2;
+
+  // If num_threads is 0, use as many threads as hardware threads.
+  // Inputs smaller than min_chunk_size bytes per thread use fewer threads.
+  explicit ParallelTextMapEventReader(Mapper* mapper, size_t num_threads = 0,
+                                      size_t min_chunk_size = 1 << 20)
+      : mapper_(mapper),
+        num_threads_(num_threads > 0
+                     ? num_threads
+                     : std::max<size_t>(std::thread::hardware_concurrency(), 1)),
+        min_chunk_size_(std::max<size_t>(min_chunk_size, 1)) {}
+
+  bool Read(std::istream* is, std::vector<E2>* events) const override {
+    DecompressingIstream dis(is);
+    return ReadStream(&dis, "", events);
+  }
+
+  // Uncompressed files are parsed in place.
+  bool Read(const std::string &filepath, std::vector<E2> *events) const override {
+    MappedFile file;
+    if (!file.Open(filepath, false)) return false;
+    if (DetectCompression(file.Begin(), file.End()) == kNoCompression) {
+      return Read(file.Begin(), file.End(), events);
+    }
+    DecompressingIstream dis(file.Begin(), file.End());
+    return ReadStream(&dis, "", events);
+  }
+
+  // Reads the given (already decompressed) stream, whose first characters
+  // are in prefix. Each block of num_threads * min_chunk_size characters is
+  // parsed while the next one is being read.
+  bool ReadStream(std::istream* is, const std::string& prefix,
+                  std::vector<E2>* events) const {
+    events->clear();
+    return ForEachLineBlock(
+        is, prefix, num_threads_ * min_chunk_size_,
+        [this, events](const char* begin, const char* end, size_t line) {
+          return ReadLines(begin, end, line, events);
+        });
+  }
+
+  // Events are parsed sequentially, as the batches are requested.
+  std::unique_ptr<BatchReader<E2>> OpenBatches(std::istream* is) const override {
+    return std::unique_ptr<BatchReader<E2>>(
+        new TextMapEventBatchReader<Mapper>(mapper_, is, "", this->filter_));
+  }
+
+  std::unique_ptr<BatchReader<E2>> OpenBatches(
+      const std::string& filepath) const override {
+    return std::unique_ptr<BatchReader<E2>>(
+        new TextMapEventBatchReader<Mapper>(mapper_, filepath,
+                                            this->filter_));
+  }
+
+  bool Read(const char* begin, const char* end, std::vector<E2>* events) const {
+    events->clear();
+    return ReadLines(begin, end, 1, events);
+  }
+
+  inline size_t NumThreads() const { return num_threads_; }
+
+  bool IsThreadSafe() const override { return mapper_->IsThreadSafe(); }
+
+ protected:
+  // Parses the lines in [begin, end), whose first line is the given one,
+  // and appends their events to *events.
+  bool ReadLines(const char* begin, const char* end, size_t first_line,
+                 std::vector<E2>* events) const {
+    const size_t num_chunks = std::min<size_t>(
+        num_threads_, (end - begin) / min_chunk_size_ + 1);
+    const auto bounds = SplitLines(begin, end, num_chunks);
+    const size_t n = bounds.size() - 1;
+    const bool map_concurrently = mapper_->IsThreadSafe();
+    std::vector<std::vector<Parsed>> parsed(n);
+    std::vector<std::vector<E2>> mapped(map_concurrently ? n : 0);
+    std::vector<size_t> num_lines(n, 0), error_line(n, 0);
+    std::vector<char> success(n, 1);
+    auto parse_chunk = [&](size_t i) {
+      num_lines[i] = std::count(bounds[i], bounds[i + 1], '\n');
+      std::vector<Parsed>& chunk_events = parsed[i];
+      success[i] = ParseLines<Parsed>(
+          bounds[i], bounds[i + 1], 1,
+          [&chunk_events](const Parsed& e) { chunk_events.push_back(e); },
+          &error_line[i], this->filter_);
+      if (map_concurrently && success[i]) {
+        mapped[i].reserve(parsed[i].size());
+        MapEvents(mapper_, &parsed[i], &mapped[i]);
+        std::vector<Parsed>().swap(parsed[i]);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n; ++i) threads.emplace_back(parse_chunk, i);
+    if (n > 0) parse_chunk(0);
+    for (auto& t : threads) t.join();
+
+    // Report the first error in the input, if any.
+    size_t total_events = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (!success[i]) {
+        std::cerr << "ERROR: Failed to read event from line "
+                  << first_line + error_line[i] - 1 << std::endl;
+        return false;
+      }
+      first_line += num_lines[i];
+      total_events += map_concurrently ? mapped[i].size() : parsed[i].size();
+    }
+
+    // Later blocks of a stream rely on the geometric growth of the vector.
+    if (events->empty()) events->reserve(total_events);
+    for (size_t i = 0; i < n; ++i) {
+      if (map_concurrently) {
+        std::move(mapped[i].begin(), mapped[i].end(),
+                  std::back_inserter(*events));
+        std::vector<E2>().swap(mapped[i]);
+      } else {
+        MapEvents(mapper_, &parsed[i], events);
+        std::vector<Parsed>().swap(parsed[i]);
+      }
+    }
+    return true;
+  }
+
+  Mapper* mapper_;
+  size_t num_threads_;
+  size_t min_chunk_size_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_PARALLELTEXTMAPEVENTREADER_H_
@@ -0,0 +1,28 @@
+#ifndef READER_PARALLELTEXTREADER_H_
+#define READER_PARALLELTEXTREADER_H_
+
+#include "reader/ParallelTextMapEventReader.h"
+#include "mapper/IdentityMapper.h"
+
+namespace kws {
+namespace reader {
+
+using kws::mapper::IdentityMapper;
+
+template<typename E>
+class ParallelTextReader : public ParallelTextMapEventReader<IdentityMapper<E>> {
+ public:
+  typedef ParallelTextMapEventReader<IdentityMapper<E>> BaseType;
+
+  explicit ParallelTextReader(size_t num_threads = 0,
+                              size_t min_chunk_size = 1 << 20)
+      : BaseType(&mapper, num_threads, min_chunk_size) {}
+
+ protected:
+  IdentityMapper<E> mapper;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_PARALLELTEXTREADER_H_
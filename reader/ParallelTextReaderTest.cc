@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <type_traits>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/Event.h"
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
+#include "core/ScoredEvent.h"
+#include "mapper/ConcurrentStringToIntMapper.h"
+#include "mapper/ScoredEventMapper.h"
+#include "mapper/StringEventToIntMapper.h"
+#include "reader/MmapTextMapEventReader.h"
+#include "reader/ParallelTextMapEventReader.h"
+#include "reader/ParallelTextReader.h"
+#include "reader/TextEventMapping.h"
+#include "reader/TextFieldParser.h"
+
+using kws::core::DocumentBoundingBox;
+using kws::core::Event;
+using kws::core::PlainEvent;
+using kws::core::PlainScoredEvent;
+using kws::core::ScoredEvent;
+using kws::mapper::ConcurrentStringToIntMapper;
+using kws::mapper::ScoredEventMapper;
+using kws::mapper::StringEventToIntMapper;
+using kws::reader::EventFilter;
+using kws::reader::MmapTextMapEventReader;
+using kws::reader::ParallelTextMapEventReader;
+using kws::reader::ParallelTextReader;
+using kws::reader::SplitLines;
+using kws::reader::TextEventMapping;
+using kws::reader::TextToken;
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+typedef Event<std::string, DocumentBoundingBox<int>> DocEvent;
+
+static std::string MakeInput(size_t num_lines) {
+  std::ostringstream oss;
+  oss << "# header\n";
+  for (size_t i = 0; i < num_lines; ++i) {
+    if (i % 7 == 0) oss << "# comment " << i << "\n";
+    if (i % 11 == 0) oss << "\n";
+    oss << "q" << i % 13 << " d" << i % 17 << " " << 0.5f / (i + 1) << "\r\n";
+  }
+  return oss.str();
+}
+
+TEST(ParallelTextReader, SplitLines) {
+  const std::string s = "a\nbb\nccc\ndddd\n";
+  const char* b = s.data();
+  const char* e = s.data() + s.size();
+  EXPECT_THAT(SplitLines(b, b, 4), ElementsAre(b));
+  EXPECT_THAT(SplitLines(b, e, 1), ElementsAre(b, e));
+  EXPECT_THAT(SplitLines(b, e, 2), ElementsAre(b, b + 9, e));
+  EXPECT_THAT(SplitLines(b, e, 100),
+              ElementsAre(b, b + 2, b + 5, b + 9, e));
+}
+
+TEST(ParallelTextReader, Empty) {
+  ParallelTextReader<DocEvent> reader(4, 1);
+  std::istringstream iss("");
+  std::vector<DocEvent> v;
+  EXPECT_TRUE(reader.Read(&iss, &v));
+  EXPECT_THAT(v, IsEmpty());
+}
+
+TEST(ParallelTextReader, SameAsSequential) {
+  typedef ScoredEvent<Event<std::string, std::string>> StrEvent;
+  typedef ScoredEvent<Event<int, int>> IntEvent;
+  typedef StringEventToIntMapper<int> RefMapper;
+  typedef ScoredEventMapper<RefMapper> HypMapper;
+  const std::string input = MakeInput(10000);
+
+  RefMapper ref_mapper1, ref_mapper2;
+  HypMapper hyp_mapper1(&ref_mapper1), hyp_mapper2(&ref_mapper2);
+  MmapTextMapEventReader<HypMapper> sequential(&hyp_mapper1);
+  ParallelTextMapEventReader<HypMapper> parallel(&hyp_mapper2, 8, 64);
+  std::vector<IntEvent> expected, actual;
+  EXPECT_TRUE(sequential.Read(input.data(), input.data() + input.size(),
+                              &expected));
+  EXPECT_TRUE(parallel.Read(input.data(), input.data() + input.size(),
+                            &actual));
+  EXPECT_EQ(10000, expected.size());
+  EXPECT_EQ(expected, actual);
+
+  ParallelTextReader<StrEvent> identity(3, 64);
+  std::istringstream iss(input);
+  std::vector<StrEvent> str_events;
+  EXPECT_TRUE(identity.Read(&iss, &str_events));
+  EXPECT_EQ(10000, str_events.size());
+  EXPECT_EQ(StrEvent("q0", "d0", 0.5f), str_events.front());
+  EXPECT_EQ(StrEvent("q2", "d3", 0.5f / 10000), str_events.back());
+}
+
+TEST(ParallelTextReader, StreamBlocks) {
+  // Streams are parsed in blocks of 4 * 16 characters, thus most lines are
+  // split across blocks. The last line has no new line character.
+  typedef ScoredEvent<Event<std::string, std::string>> StrEvent;
+  const std::string input = MakeInput(1000) + "q1 d1 0.25";
+  ParallelTextReader<StrEvent> reader(4, 16);
+  std::vector<StrEvent> expected, actual;
+  EXPECT_TRUE(reader.Read(input.data(), input.data() + input.size(),
+                          &expected));
+  EXPECT_EQ(1001, expected.size());
+  std::istringstream iss(input);
+  EXPECT_TRUE(reader.Read(&iss, &actual));
+  EXPECT_EQ(expected, actual);
+
+  // The prefix is parsed before the rest of the stream.
+  std::istringstream rest(input.substr(5));
+  EXPECT_TRUE(reader.ReadStream(&rest, input.substr(0, 5), &actual));
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(ParallelTextReader, MapsTokens) {
+  typedef ScoredEvent<Event<std::string, std::string>> StrEvent;
+  typedef ScoredEvent<Event<int, int>> IntEvent;
+  typedef StringEventToIntMapper<int> RefMapper;
+  typedef ScoredEventMapper<RefMapper> HypMapper;
+  // Queries and locations are interned from the tokens of the lines.
+  static_assert(
+      std::is_same<TextEventMapping<HypMapper>::Parsed,
+                   PlainScoredEvent<PlainEvent<TextToken, TextToken>>>::value,
+      "Events must be mapped from their tokens");
+  const std::string input = MakeInput(10000);
+  EventFilter filter;
+  filter.AddQuery("q1");
+  filter.AddQuery("q5");
+  filter.SetMinScore(0.0001f);
+
+  // Same ids as mapping the string events.
+  ParallelTextReader<StrEvent> str_reader(4, 64);
+  str_reader.SetFilter(&filter);
+  std::vector<StrEvent> str_events;
+  EXPECT_TRUE(str_reader.Read(input.data(), input.data() + input.size(),
+                              &str_events));
+  RefMapper ref_mapper1, ref_mapper2;
+  HypMapper hyp_mapper1(&ref_mapper1), hyp_mapper2(&ref_mapper2);
+  std::vector<IntEvent> expected, actual;
+  for (const StrEvent& e : str_events) expected.push_back(hyp_mapper1(e));
+  ParallelTextMapEventReader<HypMapper> reader(&hyp_mapper2, 4, 64);
+  reader.SetFilter(&filter);
+  EXPECT_TRUE(reader.Read(input.data(), input.data() + input.size(),
+                          &actual));
+  EXPECT_EQ(770, actual.size());
+  EXPECT_EQ(expected, actual);
+  EXPECT_EQ(ref_mapper1.NumQueries(), ref_mapper2.NumQueries());
+  EXPECT_EQ(ref_mapper1.NumLocations(), ref_mapper2.NumLocations());
+
+  // The batch reader maps the tokens too.
+  std::istringstream iss(input);
+  auto batches = reader.OpenBatches(&iss);
+  std::vector<IntEvent> all, batch;
+  while (batches->Next(100, &batch)) {
+    all.insert(all.end(), batch.begin(), batch.end());
+  }
+  EXPECT_FALSE(batches->Fail());
+  EXPECT_EQ(expected, all);
+}
+
+TEST(ParallelTextReader, ConcurrentMapper) {
+  typedef ScoredEvent<Event<int, int>> IntEvent;
+  typedef ConcurrentStringToIntMapper<int> StrMapper;
+  typedef ScoredEventMapper<StringEventToIntMapper<int>> HypMapper1;
+  typedef ScoredEventMapper<StringEventToIntMapper<int, StrMapper>> HypMapper2;
+  const std::string input = MakeInput(10000);
+
+  StringEventToIntMapper<int> ref_mapper1;
+  HypMapper1 hyp_mapper1(&ref_mapper1);
+  MmapTextMapEventReader<HypMapper1> sequential(&hyp_mapper1);
+  std::vector<IntEvent> expected;
+  EXPECT_TRUE(sequential.Read(input.data(), input.data() + input.size(),
+                              &expected));
+
+  // Events are mapped by the threads parsing each chunk.
+  StrMapper query_mapper, location_mapper;
+  StringEventToIntMapper<int, StrMapper> ref_mapper2(&query_mapper,
+                                                     &location_mapper);
+  HypMapper2 hyp_mapper2(&ref_mapper2);
+  ParallelTextMapEventReader<HypMapper2> parallel(&hyp_mapper2, 8, 64);
+  EXPECT_TRUE(parallel.IsThreadSafe());
+  std::vector<IntEvent> actual;
+  EXPECT_TRUE(parallel.Read(input.data(), input.data() + input.size(),
+                            &actual));
+  ASSERT_EQ(expected.size(), actual.size());
+  EXPECT_EQ(ref_mapper1.NumQueries(), ref_mapper2.NumQueries());
+  EXPECT_EQ(ref_mapper1.NumLocations(), ref_mapper2.NumLocations());
+
+  // Renumbering the ids in the order of the events gives the same ids as
+  // the sequential reader.
+  std::vector<int> query_order, location_order;
+  for (const auto& e : actual) {
+    query_order.push_back(e.Query());
+    location_order.push_back(e.Location());
+  }
+  const std::vector<int> new_query = query_mapper.Renumber(query_order);
+  const std::vector<int> new_location =
+      location_mapper.Renumber(location_order);
+  for (auto& e : actual) {
+    e.Query() = new_query[e.Query()];
+    e.Location() = new_location[e.Location()];
+  }
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(ParallelTextReader, ErrorLine) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) input += "q1 d1 1 2 3 4\n";
+  input += "q1 d1 1 2 3\n";   // <- Line 1001: missing h coordinate
+  for (int i = 0; i < 1000; ++i) input += "q1 d1 1 2 3 4\n";
+  input += "q1 d1 1 2\n";     // <- Line 2002: also wrong, not reported
+  ParallelTextReader<DocEvent> reader(16, 16);
+  std::istringstream iss(input);
+  std::vector<DocEvent> v;
+  ::testing::internal::CaptureStderr();
+  EXPECT_FALSE(reader.Read(&iss, &v));
+  EXPECT_EQ("ERROR: Failed to read event from line 1001\n",
+            ::testing::internal::GetCapturedStderr());
+}
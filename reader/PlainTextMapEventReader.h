@@ -6,7 +6,9 @@
 #include <sstream>
 #include <vector>
 
+#include "reader/DecompressingStream.h"
 #include "reader/Reader.h"
+#include "reader/TextFieldParser.h"
 
 namespace kws {
 namespace reader {
@@ -21,15 +23,21 @@ class PlainTextMapEventReader : public Reader<typename Mapper::OutputType> {
 
   explicit PlainTextMapEventReader(Mapper* mapper) : mapper_(mapper) {}
 
-  bool Read(std::istream* is, std::vector<E2>* events) const override {
+  bool Read(std::istream* source, std::vector<E2>* events) const override {
     events->clear();
+    DecompressingIstream is(source);
     std::string buff;
-    for (size_t n = 1; std::getline(*is, buff); ++n) {
+    size_t num_rejected = 0;
+    for (size_t n = 1; std::getline(is, buff); ++n) {
       std::istringstream iss(buff);
       // Skip whitespaces
       iss >> std::ws;
       if (iss.peek() == '#') continue;   // Comment line
       if (iss.eof()) continue;           // Empty line
+      if (!KeepQuery(buff)) {
+        ++num_rejected;
+        continue;
+      }
       // Read event, and consume all whitespaces at the end of the line.
       E1 event;
       iss >> event;
@@ -38,9 +46,14 @@ class PlainTextMapEventReader : public Reader<typename Mapper::OutputType> {
         std::cerr << "ERROR: Failed to read event from line " << n << std::endl;
         return false;
       }
+      if (this->filter_ != nullptr && !this->filter_->KeepParsed(event)) {
+        ++num_rejected;
+        continue;
+      }
       events->push_back((*mapper_)(event));
     }
-    return is->eof();
+    if (this->filter_ != nullptr) this->filter_->AddRejected(num_rejected);
+    return is.eof() && !is.bad();
   }
 
   bool Read(const std::string &filepath, std::vector<E2> *events) const override {
@@ -51,8 +64,21 @@ class PlainTextMapEventReader : public Reader<typename Mapper::OutputType> {
     return r;
   }
 
+  bool IsThreadSafe() const override { return mapper_->IsThreadSafe(); }
+
  protected:
   Mapper* mapper_;
+
+ private:
+  // Checks the query of the line (its first field) against the filter.
+  bool KeepQuery(const std::string& line) const {
+    if (this->filter_ == nullptr || !this->filter_->FiltersQueries()) {
+      return true;
+    }
+    const char *p = line.data(), *b, *e;
+    NextToken(&p, line.data() + line.size(), &b, &e);
+    return this->filter_->KeepQuery(b, e);
+  }
 };
 
 }  // namespace reader
@@ -2,22 +2,69 @@
 #define READER_READER_H_
 
 #include <fstream>
+#include <memory>
 #include <vector>
 
+#include "reader/BatchReader.h"
+#include "reader/EventFilter.h"
+
 namespace kws {
 namespace reader {
 
 template <typename E>
 class Reader {
  public:
+  Reader() : filter_(nullptr) {}
+
+  virtual ~Reader() {}
+
   virtual
   bool Read(std::istream* is, std::vector<E>* events) const = 0;
 
   virtual
   bool Read(const std::string& filepath, std::vector<E>* events) const = 0;
+
+  // Returns true if reading does not modify any state shared with other
+  // objects (e.g. a mapper assigning ids to strings), so that this reader
+  // can be used concurrently with other readers.
+  virtual
+  bool IsThreadSafe() const { return false; }
+
+  // Returns a BatchReader to read the events incrementally. By default, the
+  // events are read all at once with Read(), see ReaderBatchAdapter.
+  virtual
+  std::unique_ptr<BatchReader<E>> OpenBatches(std::istream* is) const {
+    return std::unique_ptr<BatchReader<E>>(
+        new ReaderBatchAdapter<E>(this, is));
+  }
+
+  virtual
+  std::unique_ptr<BatchReader<E>> OpenBatches(
+      const std::string& filepath) const {
+    return std::unique_ptr<BatchReader<E>>(
+        new ReaderBatchAdapter<E>(this, filepath));
+  }
+
+  // Sets the filter used to discard events while they are read (see
+  // EventFilter). If null, all events are kept. The filter is not owned, and
+  // it is also used by the BatchReaders opened afterwards.
+  virtual
+  void SetFilter(const EventFilter* filter) { filter_ = filter; }
+
+  inline const EventFilter* Filter() const { return filter_; }
+
+  // Enables a cache of snapshots of the files read, stored in the given
+  // directory (see SnapshotCache.h), so that reading the same files again
+  // does not need to parse them. Returns false if the reader does not
+  // support it.
+  virtual
+  bool SetSnapshotDirectory(const std::string& directory) { return false; }
+
+ protected:
+  const EventFilter* filter_;
 };
 
 }  // namespace reader
 }  // namespace kws
 
-#endif  // READER_READER_H_
\ No newline at end of file
+#endif  // READER_READER_H_
@@ -0,0 +1,90 @@
+#ifndef READER_SNAPSHOTCACHE_H_
+#define READER_SNAPSHOTCACHE_H_
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "reader/BinaryEventFormat.h"
+
+namespace kws {
+namespace reader {
+
+// Hash of the content of the buffer [begin, end), used to identify the
+// snapshots of files. This is not a cryptographic hash, but any change in
+// the content of a file changes its hash with overwhelming probability.
+inline uint64_t ContentHash(const char* begin, const char* end) {
+  const uint64_t k1 = 0x87c37b91114253d5ull, k2 = 0x4cf5ad432745937full;
+  uint64_t h = 0x9e3779b97f4a7c15ull ^ static_cast<uint64_t>(end - begin);
+  const char* p = begin;
+  for (; end - p >= 8; p += 8) {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    h ^= w * k1;
+    h = ((h << 31) | (h >> 33)) * k2;
+  }
+  uint64_t w = 0;
+  std::memcpy(&w, p, end - p);
+  h ^= w * k1;
+  // Final avalanche (from MurmurHash3).
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+// Directory of snapshots of event files, stored in the binary columnar
+// format (see BinaryEventFormat.h). Snapshots are keyed by the hash of the
+// content of the original file and by the type of the events, so a snapshot
+// is only used for identical files read with the same event type.
+template <typename E>
+class SnapshotCache {
+ public:
+  typedef BinaryEventTraits<E> Traits;
+
+  explicit SnapshotCache(const std::string& directory)
+      : directory_(directory) {}
+
+  // Returns the path of the snapshot of a file with the content
+  // [begin, end).
+  std::string Path(const char* begin, const char* end) const {
+    char key[64];
+    std::snprintf(key, sizeof(key), "%016llx-%d%s.kwsbin",
+                  static_cast<unsigned long long>(ContentHash(begin, end)),
+                  static_cast<int>(
+                      BinaryCoordType<typename Traits::CoordType>::kCode),
+                  Traits::kScored ? "s" : "");
+    return directory_ + "/" + key;
+  }
+
+  // Stores the snapshot of the given events. The snapshot is first written
+  // to a temporary file, which is then renamed, so that concurrent readers
+  // never see partially written snapshots.
+  bool Store(const std::string& path, const std::vector<E>& events) const {
+    std::ostringstream tmp;
+    tmp << path << ".tmp." << getpid();
+    if (!WriteBinaryEvents(events, tmp.str()) ||
+        std::rename(tmp.str().c_str(), path.c_str()) != 0) {
+      std::remove(tmp.str().c_str());
+      return false;
+    }
+    return true;
+  }
+
+  inline const std::string& Directory() const { return directory_; }
+
+ private:
+  std::string directory_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_SNAPSHOTCACHE_H_
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "core/DocumentBoundingBox.h"
+#include "core/ShapedEvent.h"
+#include "reader/AutoFormatReader.h"
+#include "reader/SnapshotCache.h"
+
+using kws::core::DocumentBoundingBox;
+using kws::core::ShapedEvent;
+using kws::reader::AutoFormatReader;
+using kws::reader::ContentHash;
+using kws::reader::EventFilter;
+using kws::reader::MappedFile;
+using kws::reader::SnapshotCache;
+using kws::reader::WriteBinaryEvents;
+
+using testing::ElementsAre;
+
+typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+
+static uint64_t Hash(const std::string& s) {
+  return ContentHash(s.data(), s.data() + s.size());
+}
+
+static void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream fs(path, std::ios_base::out | std::ios_base::binary);
+  fs << content;
+}
+
+TEST(SnapshotCache, ContentHash) {
+  EXPECT_EQ(Hash("q1 d1 1 2 3 4\n"), Hash("q1 d1 1 2 3 4\n"));
+  EXPECT_NE(Hash("q1 d1 1 2 3 4\n"), Hash("q1 d1 1 2 3 5\n"));
+  EXPECT_NE(Hash("abcdefgh"), Hash("abcdefgh "));
+  EXPECT_NE(Hash(""), Hash(std::string(1, '\0')));
+}
+
+TEST(SnapshotCache, AutoFormatReader) {
+  char dir[] = "/tmp/SnapshotCacheTest.XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != nullptr);
+  const std::string input = "q1 d1 1 2 3 4\nq2 d1 5 6 7 8\n";
+  const std::string filepath = std::string(dir) + "/refs.txt";
+  WriteFile(filepath, input);
+  AutoFormatReader<RefEvent> reader;
+  EXPECT_TRUE(reader.SetSnapshotDirectory(dir));
+  const RefEvent e1("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4));
+  const RefEvent e2("q2", DocumentBoundingBox<uint32_t>("d1", 5, 6, 7, 8));
+
+  // The first read creates the snapshot.
+  std::vector<RefEvent> events;
+  EXPECT_TRUE(reader.Read(filepath, &events));
+  EXPECT_THAT(events, ElementsAre(e1, e2));
+  const std::string snapshot = SnapshotCache<RefEvent>(dir).Path(
+      input.data(), input.data() + input.size());
+  MappedFile file;
+  ASSERT_TRUE(file.Open(snapshot));
+  EXPECT_TRUE(kws::reader::IsBinaryEventData(file.Begin(), file.End()));
+
+  // The filter is applied to the snapshot.
+  EventFilter filter;
+  filter.AddQuery("q2");
+  reader.SetFilter(&filter);
+  EXPECT_TRUE(reader.Read(filepath, &events));
+  EXPECT_THAT(events, ElementsAre(e2));
+  reader.SetFilter(nullptr);
+
+  // Later reads use the snapshot: replace it to check that.
+  EXPECT_TRUE(WriteBinaryEvents(std::vector<RefEvent>{e2}, snapshot));
+  EXPECT_TRUE(reader.Read(filepath, &events));
+  EXPECT_THAT(events, ElementsAre(e2));
+
+  std::remove(snapshot.c_str());
+  std::remove(filepath.c_str());
+  rmdir(dir);
+}
+
+TEST(SnapshotCache, FilterWhenCreated) {
+  char dir[] = "/tmp/SnapshotCacheTest.XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != nullptr);
+  const std::string input = "q1 d1 1 2 3 4\nq2 d1 5 6 7 8\n";
+  const std::string filepath = std::string(dir) + "/refs.txt";
+  WriteFile(filepath, input);
+  AutoFormatReader<RefEvent> reader;
+  EXPECT_TRUE(reader.SetSnapshotDirectory(dir));
+  const RefEvent e1("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4));
+  const RefEvent e2("q2", DocumentBoundingBox<uint32_t>("d1", 5, 6, 7, 8));
+
+  // The events parsed to create the snapshot are filtered, but the snapshot
+  // contains all of them.
+  EventFilter filter;
+  filter.AddQuery("q2");
+  reader.SetFilter(&filter);
+  std::vector<RefEvent> events;
+  EXPECT_TRUE(reader.Read(filepath, &events));
+  EXPECT_THAT(events, ElementsAre(e2));
+  EXPECT_EQ(1, filter.NumRejected());
+  reader.SetFilter(nullptr);
+  EXPECT_TRUE(reader.Read(filepath, &events));
+  EXPECT_THAT(events, ElementsAre(e1, e2));
+
+  std::remove(SnapshotCache<RefEvent>(dir).Path(
+      input.data(), input.data() + input.size()).c_str());
+  std::remove(filepath.c_str());
+  rmdir(dir);
+}
+
+TEST(SnapshotCache, CorruptedSnapshot) {
+  char dir[] = "/tmp/SnapshotCacheTest.XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != nullptr);
+  const std::string input = "q1 d1 1 2 3 4\nq2 d1 5 6 7 8\n";
+  const std::string filepath = std::string(dir) + "/refs.txt";
+  WriteFile(filepath, input);
+  AutoFormatReader<RefEvent> reader;
+  EXPECT_TRUE(reader.SetSnapshotDirectory(dir));
+  const RefEvent e1("q1", DocumentBoundingBox<uint32_t>("d1", 1, 2, 3, 4));
+  const RefEvent e2("q2", DocumentBoundingBox<uint32_t>("d1", 5, 6, 7, 8));
+  const std::string snapshot = SnapshotCache<RefEvent>(dir).Path(
+      input.data(), input.data() + input.size());
+  std::ostringstream oss;
+  ASSERT_TRUE(WriteBinaryEvents(std::vector<RefEvent>{e1, e2}, &oss));
+  const std::string valid = oss.str();
+
+  // Truncated snapshots, and snapshots with garbage after the header, are
+  // replaced with the events parsed from the text file.
+  for (const std::string& corrupted :
+           {valid.substr(0, valid.size() / 2),
+            valid.substr(0, 16) + std::string(valid.size() - 16, '\xff')}) {
+    WriteFile(snapshot, corrupted);
+    std::vector<RefEvent> events;
+    EXPECT_TRUE(reader.Read(filepath, &events));
+    EXPECT_THAT(events, ElementsAre(e1, e2));
+    MappedFile file;
+    ASSERT_TRUE(file.Open(snapshot));
+    EXPECT_EQ(valid, std::string(file.Begin(), file.End()));
+  }
+
+  std::remove(snapshot.c_str());
+  std::remove(filepath.c_str());
+  rmdir(dir);
+}
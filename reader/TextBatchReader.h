@@ -0,0 +1,153 @@
+#ifndef READER_TEXTBATCHREADER_H_
+#define READER_TEXTBATCHREADER_H_
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "reader/BatchReader.h"
+#include "reader/DecompressingStream.h"
+#include "reader/MappedFile.h"
+#include "reader/TextEventMapping.h"
+#include "reader/TextFieldParser.h"
+
+namespace kws {
+namespace reader {
+
+// Reads the same plain text format as PlainTextMapEventReader, in batches.
+// The input is either a MappedFile, which is parsed in place, or a stream,
+// which is read in chunks of a fixed size. In the latter case, only the
+// lines of the current batch are kept in memory. Compressed inputs are
+// decompressed in a streaming fashion too (see DecompressingStream.h).
+template <typename Mapper>
+class TextMapEventBatchReader : public BatchReader<typename Mapper::OutputType> {
+ public:
+  typedef typename Mapper::InputType E1;
+  typedef typename TextEventMapping<Mapper>::Parsed Parsed;
+  typedef typename Mapper::OutputType E2;
+
+  // Reads the given stream. The characters in prefix are processed before
+  // those in the stream (i.e. they were already extracted from the stream).
+  // If filter is not null, the events discarded by it are skipped.
+  TextMapEventBatchReader(Mapper* mapper, std::istream* is,
+                          const std::string& prefix = "",
+                          const EventFilter* filter = nullptr)
+      : mapper_(mapper), filter_(filter),
+        stream_(new DecompressingIstream(is, prefix)), line_(1),
+        failed_(false) {
+    cur_ = end_ = buffer_.data();
+  }
+
+  // Reads the given stream as is (i.e. it is not decompressed).
+  TextMapEventBatchReader(Mapper* mapper, std::unique_ptr<std::istream> is,
+                          const std::string& prefix = "",
+                          const EventFilter* filter = nullptr)
+      : mapper_(mapper), filter_(filter), stream_(std::move(is)),
+        buffer_(prefix), line_(1), failed_(false) {
+    cur_ = buffer_.data();
+    end_ = cur_ + buffer_.size();
+  }
+
+  // If file is null, the reader is created in a failed state.
+  TextMapEventBatchReader(Mapper* mapper, std::unique_ptr<MappedFile> file,
+                          const EventFilter* filter = nullptr)
+      : mapper_(mapper), filter_(filter), file_(std::move(file)), line_(1),
+        failed_(file_ == nullptr) {
+    InitFile();
+  }
+
+  TextMapEventBatchReader(Mapper* mapper, const std::string& filepath,
+                          const EventFilter* filter = nullptr)
+      : mapper_(mapper), filter_(filter), file_(new MappedFile), line_(1),
+        failed_(!file_->Open(filepath, false)) {
+    InitFile();
+  }
+
+  bool Next(size_t max_events, std::vector<E2>* events) override {
+    events->clear();
+    if (failed_) return false;
+    size_t num_rejected = 0;
+    bool keep;
+    while (events->size() < max_events || events->empty()) {
+      const char* eol = cur_ < end_ ? static_cast<const char*>(
+          std::memchr(cur_, '\n', end_ - cur_)) : nullptr;
+      if (eol == nullptr) {
+        if (Refill()) continue;
+        if (failed_ || cur_ == end_) break;
+        eol = end_;  // Last line, without a new line character.
+      }
+      const char* p = SkipBlanks(cur_, eol);
+      if (p < eol && *p != '#') {
+        if (!ParseFilteredLine(p, eol, filter_, &event_, &keep)) {
+          std::cerr << "ERROR: Failed to read event from line " << line_
+                    << std::endl;
+          failed_ = true;
+          break;
+        }
+        if (keep) {
+          events->push_back(TextEventMapping<Mapper>::Map(mapper_, event_));
+        } else {
+          ++num_rejected;
+        }
+      }
+      cur_ = eol < end_ ? eol + 1 : eol;
+      ++line_;
+    }
+    if (filter_ != nullptr) filter_->AddRejected(num_rejected);
+    if (failed_) events->clear();
+    return !events->empty();
+  }
+
+  bool Fail() const override { return failed_; }
+
+ private:
+  static const size_t kChunkSize = 1 << 16;
+
+  // Parses the file in place, unless it is compressed.
+  void InitFile() {
+    cur_ = end_ = buffer_.data();
+    if (failed_) return;
+    if (DetectCompression(file_->Begin(), file_->End()) != kNoCompression) {
+      stream_.reset(new DecompressingIstream(file_->Begin(), file_->End()));
+    } else {
+      cur_ = file_->Begin();
+      end_ = file_->End();
+    }
+  }
+
+  // Discards the lines already processed from the buffer, and reads a new
+  // chunk from the stream. Returns false if no more characters were read.
+  bool Refill() {
+    if (stream_ == nullptr) return false;
+    if (stream_->bad()) failed_ = true;
+    if (!*stream_) return false;
+    buffer_.erase(0, cur_ - buffer_.data());
+    const size_t size = buffer_.size();
+    buffer_.resize(size + kChunkSize);
+    stream_->read(&buffer_[size], kChunkSize);
+    buffer_.resize(size + stream_->gcount());
+    if (stream_->bad()) failed_ = true;
+    cur_ = buffer_.data();
+    end_ = cur_ + buffer_.size();
+    return buffer_.size() > size;
+  }
+
+  Mapper* mapper_;
+  const EventFilter* filter_;
+  std::unique_ptr<MappedFile> file_;
+  // Declared after file_, since it may read from it.
+  std::unique_ptr<std::istream> stream_;
+  std::string buffer_;
+  const char* cur_;
+  const char* end_;
+  size_t line_;
+  bool failed_;
+  Parsed event_;
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_TEXTBATCHREADER_H_
@@ -0,0 +1,58 @@
+#ifndef READER_TEXTEVENTMAPPING_H_
+#define READER_TEXTEVENTMAPPING_H_
+
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
+#include "mapper/ScoredEventMapper.h"
+#include "mapper/StringEventToIntMapper.h"
+#include "reader/TextFieldParser.h"
+
+namespace kws {
+namespace reader {
+
+// Describes how the text readers map the lines of the input with a Mapper:
+// each line is parsed into an object of type Parsed, which is then given to
+// Map(). By default, lines are parsed into the input events of the mapper.
+template <typename Mapper>
+struct TextEventMapping {
+  typedef typename Mapper::InputType Parsed;
+
+  static typename Mapper::OutputType Map(Mapper* mapper,
+                                         const Parsed& event) {
+    return (*mapper)(event);
+  }
+};
+
+// The query and location of the events are interned directly from the
+// tokens of the line, without building the string events.
+template <typename Int, typename StrMapper>
+struct TextEventMapping<mapper::StringEventToIntMapper<Int, StrMapper>> {
+  typedef mapper::StringEventToIntMapper<Int, StrMapper> Mapper;
+  typedef core::PlainEvent<TextToken, TextToken> Parsed;
+
+  static typename Mapper::OutputType Map(Mapper* mapper,
+                                         const Parsed& event) {
+    return (*mapper)(event.query.begin, event.query.size(),
+                     event.location.begin, event.location.size());
+  }
+};
+
+template <typename Int, typename StrMapper>
+struct TextEventMapping<mapper::ScoredEventMapper<
+    mapper::StringEventToIntMapper<Int, StrMapper>>> {
+  typedef mapper::ScoredEventMapper<
+    mapper::StringEventToIntMapper<Int, StrMapper>> Mapper;
+  typedef TextEventMapping<typename Mapper::EventMapper> EventMapping;
+  typedef core::PlainScoredEvent<typename EventMapping::Parsed> Parsed;
+
+  static typename Mapper::OutputType Map(Mapper* mapper,
+                                         const Parsed& event) {
+    return typename Mapper::OutputType(
+        EventMapping::Map(mapper->GetEventMapper(), event), event.score);
+  }
+};
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_TEXTEVENTMAPPING_H_
@@ -0,0 +1,370 @@
+#ifndef READER_TEXTFIELDPARSER_H_
+#define READER_TEXTFIELDPARSER_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <istream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "core/BoundingBox.h"
+#include "core/DocumentBoundingBox.h"
+#include "core/DocumentIdBoundingBox.h"
+#include "core/Event.h"
+#include "core/PlainEvent.h"
+#include "core/PlainScoredEvent.h"
+#include "core/ScoredEvent.h"
+#include "reader/EventFilter.h"
+
+namespace kws {
+namespace reader {
+
+using kws::core::BoundingBox;
+using kws::core::DocumentBoundingBox;
+using kws::core::DocumentIdBoundingBox;
+using kws::core::DocumentTable;
+using kws::core::Event;
+using kws::core::PlainEvent;
+using kws::core::PlainScoredEvent;
+using kws::core::ScoredEvent;
+
+// Parsing functions for the plain text formats of the events, working
+// directly on a memory buffer. These are equivalent to the operator>> of
+// each type, but avoid the std::istream and locale machinery.
+//
+// Each ParseField() skips the blanks preceding the field, parses it and
+// advances *p to the first character after it. Fields must be followed by a
+// blank or by the end of the buffer. New line characters are never skipped,
+// since the buffer is expected to contain (at most) a single line.
+
+inline bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline const char* SkipBlanks(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) ++p;
+  return p;
+}
+
+// Sets [*tb, *te) to the next token and advances *p after it.
+inline bool NextToken(const char** p, const char* end,
+                      const char** tb, const char** te) {
+  const char* b = SkipBlanks(*p, end);
+  const char* e = b;
+  while (e < end && !IsBlank(*e)) ++e;
+  *tb = b;
+  *te = e;
+  *p = e;
+  return b < e;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type
+ParseField(const char** p, const char* end, T* value) {
+  const char *b, *e;
+  if (!NextToken(p, end, &b, &e)) return false;
+  bool negative = false;
+  if (*b == '-' || *b == '+') {
+    negative = (*b == '-');
+    ++b;
+  }
+  if (b == e) return false;
+  uint64_t v = 0;
+  for (; b < e; ++b) {
+    const unsigned d = static_cast<unsigned char>(*b) - '0';
+    if (d > 9) return false;
+    if (v > (std::numeric_limits<uint64_t>::max() - d) / 10) return false;
+    v = v * 10 + d;
+  }
+  if (std::is_signed<T>::value) {
+    const uint64_t max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+    if (v > max + (negative ? 1 : 0)) return false;
+    *value = negative ? static_cast<T>(-static_cast<int64_t>(v - 1) - 1)
+                      : static_cast<T>(v);
+  } else {
+    // Same as std::num_get: negative values are wrapped around.
+    if (v > static_cast<uint64_t>(std::numeric_limits<T>::max())) return false;
+    *value = negative ? static_cast<T>(-static_cast<T>(v)) : static_cast<T>(v);
+  }
+  return true;
+}
+
+namespace internal {
+
+static const double kExactPowersOf10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Returns true if the double d lies exactly between two consecutive floats,
+// in which case rounding it to float would round twice.
+inline bool IsFloatMidpoint(double d) {
+  uint64_t bits;
+  std::memcpy(&bits, &d, sizeof(bits));
+  return (bits & 0x1FFFFFFFull) == 0x10000000ull;
+}
+
+inline bool StringToReal(const std::string& s, float* value) {
+  errno = 0;
+  char* e = nullptr;
+  *value = std::strtof(s.c_str(), &e);
+  return errno != ERANGE || std::fabs(*value) < 1.0f;
+}
+
+inline bool StringToReal(const std::string& s, double* value) {
+  errno = 0;
+  char* e = nullptr;
+  *value = std::strtod(s.c_str(), &e);
+  return errno != ERANGE || std::fabs(*value) < 1.0;
+}
+
+}  // namespace internal
+
+// Decimal numbers with an optional exponent. Numbers with at most 15
+// significant digits and small exponents are converted exactly with a single
+// floating point operation (Clinger's fast path), the remaining ones fall
+// back to strtod/strtof.
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+ParseField(const char** p, const char* end, T* value) {
+  const char *b, *e;
+  if (!NextToken(p, end, &b, &e)) return false;
+  const char* t = b;
+  bool negative = false;
+  if (*t == '-' || *t == '+') {
+    negative = (*t == '-');
+    ++t;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0, exponent = 0, num_digits = 0;
+  for (; t < e && *t >= '0' && *t <= '9'; ++t, ++num_digits) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*t - '0');
+      if (mantissa > 0) ++digits;
+    } else {
+      ++exponent;
+      ++digits;
+    }
+  }
+  if (t < e && *t == '.') {
+    for (++t; t < e && *t >= '0' && *t <= '9'; ++t, ++num_digits) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*t - '0');
+        if (mantissa > 0) ++digits;
+        --exponent;
+      } else {
+        ++digits;
+      }
+    }
+  }
+  if (num_digits == 0) return false;
+  if (t < e && (*t == 'e' || *t == 'E')) {
+    ++t;
+    bool negative_exp = false;
+    if (t < e && (*t == '-' || *t == '+')) {
+      negative_exp = (*t == '-');
+      ++t;
+    }
+    if (t == e) return false;
+    int exp = 0;
+    for (; t < e && *t >= '0' && *t <= '9'; ++t) {
+      if (exp < 100000) exp = exp * 10 + (*t - '0');
+    }
+    exponent += negative_exp ? -exp : exp;
+  }
+  if (t != e) return false;
+
+  if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+    double d = static_cast<double>(mantissa);
+    if (exponent < 0) d /= internal::kExactPowersOf10[-exponent];
+    else d *= internal::kExactPowersOf10[exponent];
+    if (negative) d = -d;
+    if (!std::is_same<T, float>::value || !internal::IsFloatMidpoint(d)) {
+      *value = static_cast<T>(d);
+      return true;
+    }
+  }
+  return internal::StringToReal(std::string(b, e), value);
+}
+
+inline bool ParseField(const char** p, const char* end, std::string* value) {
+  const char *b, *e;
+  if (!NextToken(p, end, &b, &e)) return false;
+  value->assign(b, e);
+  return true;
+}
+
+// Bounds of a token in the buffer being parsed. Readers parse the fields
+// that they map (e.g. intern) into tokens, instead of copying them into
+// strings first. Tokens are only valid while the buffer is.
+struct TextToken {
+  const char* begin;
+  const char* end;
+
+  inline size_t size() const { return end - begin; }
+};
+
+inline bool ParseField(const char** p, const char* end, TextToken* token) {
+  return NextToken(p, end, &token->begin, &token->end);
+}
+
+template <typename T>
+bool ParseField(const char** p, const char* end, BoundingBox<T>* bb) {
+  return ParseField(p, end, &bb->x) && ParseField(p, end, &bb->y) &&
+      ParseField(p, end, &bb->w) && ParseField(p, end, &bb->h);
+}
+
+template <typename T>
+bool ParseField(const char** p, const char* end, DocumentBoundingBox<T>* bb) {
+  return ParseField(p, end, &bb->document) &&
+      ParseField(p, end, static_cast<BoundingBox<T>*>(bb));
+}
+
+// The document is interned directly from the token.
+template <typename T>
+bool ParseField(const char** p, const char* end,
+                DocumentIdBoundingBox<T>* bb) {
+  const char *b, *e;
+  if (!NextToken(p, end, &b, &e)) return false;
+  bb->document = DocumentTable::Global().Intern(b, e - b);
+  return ParseField(p, end, static_cast<BoundingBox<T>*>(bb));
+}
+
+template <typename Q, typename L>
+bool ParseField(const char** p, const char* end, Event<Q, L>* event) {
+  return ParseField(p, end, &event->Query()) &&
+      ParseField(p, end, &event->Location());
+}
+
+template <typename E>
+bool ParseField(const char** p, const char* end, ScoredEvent<E>* event) {
+  return ParseField(p, end, static_cast<E*>(event)) &&
+      ParseField(p, end, &event->Score());
+}
+
+template <typename Q, typename L>
+bool ParseField(const char** p, const char* end, PlainEvent<Q, L>* event) {
+  return ParseField(p, end, &event->query) &&
+      ParseField(p, end, &event->location);
+}
+
+template <typename E>
+bool ParseField(const char** p, const char* end, PlainScoredEvent<E>* event) {
+  return ParseField(p, end, static_cast<E*>(event)) &&
+      ParseField(p, end, &event->score);
+}
+
+// Parses a single object from the line [begin, end). The line is allowed to
+// have leading and trailing blanks, but nothing else.
+template <typename E>
+bool ParseLine(const char* begin, const char* end, E* object) {
+  const char* p = begin;
+  return ParseField(&p, end, object) && SkipBlanks(p, end) == end;
+}
+
+// Same as ParseLine(), but lines discarded by the filter (if not null) are
+// not parsed completely. *keep is set to false if the object was discarded.
+template <typename E>
+bool ParseFilteredLine(const char* begin, const char* end,
+                       const EventFilter* filter, E* object, bool* keep) {
+  *keep = true;
+  if (filter != nullptr && filter->FiltersQueries()) {
+    const char *p = begin, *b, *e;
+    NextToken(&p, end, &b, &e);
+    if (!filter->KeepQuery(b, e)) {
+      *keep = false;
+      return true;
+    }
+  }
+  if (!ParseLine(begin, end, object)) return false;
+  if (filter != nullptr) *keep = filter->KeepParsed(*object);
+  return true;
+}
+
+// Parses all the lines in the buffer [begin, end), with the same rules used
+// by PlainTextMapEventReader: empty lines and lines starting with '#' are
+// skipped, and each of the remaining lines must contain exactly one object.
+// For each object, callback(object) is called, unless the filter (if not
+// null) discards it.
+// If some line cannot be parsed, returns false and stores in *error_line
+// its number (first_line is the number of the first line in the buffer).
+template <typename E, typename Callback>
+bool ParseLines(const char* begin, const char* end, size_t first_line,
+                Callback callback, size_t* error_line,
+                const EventFilter* filter = nullptr) {
+  E object;
+  bool keep;
+  size_t n = first_line, num_rejected = 0;
+  for (const char* line = begin; line < end; ++n) {
+    const char* eol = static_cast<const char*>(
+        std::memchr(line, '\n', end - line));
+    if (eol == nullptr) eol = end;
+    const char* p = SkipBlanks(line, eol);
+    if (p < eol && *p != '#') {
+      if (!ParseFilteredLine(p, eol, filter, &object, &keep)) {
+        *error_line = n;
+        return false;
+      }
+      if (keep) {
+        callback(object);
+      } else {
+        ++num_rejected;
+      }
+    }
+    line = eol + 1;
+  }
+  if (filter != nullptr) filter->AddRejected(num_rejected);
+  return true;
+}
+
+// Reads the stream in blocks of (about) block_size characters, and calls
+// f(begin, end, first_line) with the complete lines of each block, in order.
+// first_line is the number of the first line in [begin, end). The characters
+// in prefix are processed before those in the stream.
+// The next block is read by a separate thread while f processes the current
+// one, so that reading (e.g. decompressing) the stream overlaps with parsing
+// it, and only a couple of blocks are kept in memory.
+// Returns false if f returns false, or if the stream could not be read.
+template <typename F>
+bool ForEachLineBlock(std::istream* is, const std::string& prefix,
+                      size_t block_size, F f) {
+  auto read_block = [is, block_size]() {
+    std::vector<char> block(block_size);
+    is->read(block.data(), block.size());
+    block.resize(is->gcount());
+    return block;
+  };
+  std::vector<char> text(prefix.begin(), prefix.end());
+  std::future<std::vector<char>> next =
+      std::async(std::launch::async, read_block);
+  size_t first_line = 1;
+  for (bool last = false; !last;) {
+    const std::vector<char> block = next.get();
+    last = block.empty();
+    if (!last) next = std::async(std::launch::async, read_block);
+    text.insert(text.end(), block.begin(), block.end());
+    // Incomplete lines are processed with the next block.
+    size_t size = text.size();
+    if (!last) {
+      const auto eol = std::find(text.rbegin(), text.rend(), '\n');
+      size = text.rend() - eol;
+    }
+    if (size == 0) continue;
+    if (!f(text.data(), text.data() + size, first_line)) return false;
+    first_line += std::count(text.begin(), text.begin() + size, '\n');
+    text.erase(text.begin(), text.begin() + size);
+  }
+  return !is->bad();
+}
+
+}  // namespace reader
+}  // namespace kws
+
+#endif  // READER_TEXTFIELDPARSER_H_
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <sstream>
+
+#include "reader/TextFieldParser.h"
+
+using kws::reader::ParseLine;
+
+template <typename T>
+static bool ParseString(const std::string& str, T* value) {
+  return ParseLine(str.data(), str.data() + str.size(), value);
+}
+
+TEST(TextFieldParser, Integers) {
+  int32_t i;
+  EXPECT_TRUE(ParseString(" 123 ", &i));
+  EXPECT_EQ(123, i);
+  EXPECT_TRUE(ParseString("-2147483648", &i));
+  EXPECT_EQ(std::numeric_limits<int32_t>::min(), i);
+  EXPECT_TRUE(ParseString("+2147483647", &i));
+  EXPECT_EQ(std::numeric_limits<int32_t>::max(), i);
+  EXPECT_FALSE(ParseString("2147483648", &i));
+  EXPECT_FALSE(ParseString("-2147483649", &i));
+  EXPECT_FALSE(ParseString("12a", &i));
+  EXPECT_FALSE(ParseString("1.5", &i));
+  EXPECT_FALSE(ParseString("-", &i));
+  EXPECT_FALSE(ParseString("", &i));
+  EXPECT_FALSE(ParseString("1 2", &i));
+
+  uint32_t u;
+  EXPECT_TRUE(ParseString("4294967295", &u));
+  EXPECT_EQ(std::numeric_limits<uint32_t>::max(), u);
+  EXPECT_FALSE(ParseString("4294967296", &u));
+  EXPECT_FALSE(ParseString("99999999999999999999999", &u));
+}
+
+TEST(TextFieldParser, Reals) {
+  float f;
+  EXPECT_TRUE(ParseString("0.5", &f));
+  EXPECT_EQ(0.5f, f);
+  EXPECT_TRUE(ParseString("-.25", &f));
+  EXPECT_EQ(-0.25f, f);
+  EXPECT_TRUE(ParseString("3.", &f));
+  EXPECT_EQ(3.0f, f);
+  EXPECT_TRUE(ParseString("1e-3", &f));
+  EXPECT_EQ(1e-3f, f);
+  EXPECT_TRUE(ParseString("1.0000000000000000000001E+1", &f));
+  EXPECT_EQ(10.0f, f);
+  EXPECT_FALSE(ParseString("inf", &f));
+  EXPECT_FALSE(ParseString("nan", &f));
+  EXPECT_FALSE(ParseString(".", &f));
+  EXPECT_FALSE(ParseString("1e", &f));
+  EXPECT_FALSE(ParseString("1.0.0", &f));
+  EXPECT_FALSE(ParseString("1e99", &f));
+}
+
+TEST(TextFieldParser, RealsMatchStreams) {
+  // The result must be the same as reading the number with a std::istream.
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<int> ndigits(1, 20);
+  std::uniform_int_distribution<int> digit(0, 9);
+  std::uniform_int_distribution<int> exponent(-40, 30);
+  for (int i = 0; i < 100000; ++i) {
+    std::string s = (i % 2 ? "-" : "");
+    const int n = ndigits(rng), dot = ndigits(rng);
+    for (int j = 0; j < n; ++j) {
+      if (j == dot) s += '.';
+      s += static_cast<char>('0' + digit(rng));
+    }
+    if (i % 3 == 0) s += "e" + std::to_string(exponent(rng));
+    float expected_f = 0.0f, f = 0.0f;
+    double expected_d = 0.0, d = 0.0;
+    std::istringstream iss_f(s), iss_d(s);
+    const bool ok_f = static_cast<bool>(iss_f >> expected_f);
+    const bool ok_d = static_cast<bool>(iss_d >> expected_d);
+    ASSERT_EQ(ok_f, ParseString(s, &f)) << s;
+    ASSERT_EQ(ok_d, ParseString(s, &d)) << s;
+    if (ok_f) { EXPECT_EQ(expected_f, f) << s; }
+    if (ok_d) { EXPECT_EQ(expected_d, d) << s; }
+  }
+}
@@ -5,22 +5,25 @@
 #include <glog/logging.h>
 #endif
 
-#include "scorer/Scorer.h"
+#include "scorer/OverlapScorer.h"
 
 namespace kws {
 namespace scorer {
 
 using kws::core::MatchError;
 
+// Overlap(), operator() and their variants given the intersection area are
+// final, so that matchers using this class as their scorer type (see
+// SimpleMatcher) call them without virtual dispatch.
 template <class RE, class HE>
-class IntersectionOverHypothesisAreaScorer : public Scorer<RE, HE> {
+class IntersectionOverHypothesisAreaScorer : public OverlapScorer<RE, HE> {
  public:
   IntersectionOverHypothesisAreaScorer(float threshold) :
-      threshold_(threshold) {}
+      OverlapScorer<RE, HE>(threshold) {}
 
   ~IntersectionOverHypothesisAreaScorer() override {}
 
-  MatchError operator()(const RE& ref, const HE& hyp) override {
+  float Overlap(const RE& ref, const HE& hyp) const final {
     if (ref.Query() == hyp.Query() && hyp.Area() > 0) {
       const float val = IntersectionArea(ref, hyp) / (1.0f * hyp.Area());
 #if defined(WITH_GLOG) && defined(WITH_GLOG_TRACE)
@@ -29,15 +32,32 @@ class IntersectionOverHypothesisAreaScorer : public Scorer<RE, HE> {
                  << "Hyp = " << hyp << std::endl
                  << "Score =" << val;
 #endif
-      if (val >= threshold_) return MatchError{0.0f, 0.0f};
+      return val;
     }
-    return MatchError{1.0f, 1.0f};
+    return -1.0f;
   }
 
-  inline const float& Threshold() const { return threshold_; }
+  // The intersection area is converted back to the type of the areas of the
+  // events, thus the overlap is exactly the same as the one of Overlap().
+  float IntersectionOverlap(const RE& ref, const HE& hyp,
+                            double intersection_area) const final {
+    if (ref.Query() == hyp.Query() && hyp.Area() > 0) {
+      typedef decltype(IntersectionArea(ref, hyp)) AreaType;
+      const AreaType area = static_cast<AreaType>(intersection_area);
+      return area / (1.0f * hyp.Area());
+    }
+    return -1.0f;
+  }
 
- private:
-  const float threshold_;
+  MatchError operator()(const RE& ref, const HE& hyp) final {
+    return this->MatchOverlap(Overlap(ref, hyp));
+  }
+
+  MatchError ScoreIntersection(const RE& ref, const HE& hyp,
+                               double intersection_area) final {
+    return this->MatchOverlap(
+        IntersectionOverlap(ref, hyp, intersection_area));
+  }
 };
 
 }  // namespace scorer
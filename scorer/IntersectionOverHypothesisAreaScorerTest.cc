@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <cstdint>
+#include <random>
+
+#include "core/DocumentIdBoundingBox.h"
 #include "core/MockEvent.h"
+#include "core/ShapedEvent.h"
 #include "scorer/IntersectionOverHypothesisAreaScorer.h"
 
+using kws::core::DocumentIdBoundingBox;
+using kws::core::ShapedEvent;
 using kws::core::testing::MockEvent;
 using kws::core::MatchError;
 using kws::scorer::IntersectionOverHypothesisAreaScorer;
@@ -51,6 +58,7 @@ TEST(IntersectionOverHypothesisAreaScorerTest, All) {
     EXPECT_CALL(ref, IntersectionArea(_)).WillRepeatedly(Return(3));
     EXPECT_CALL(hyp, Area()).WillRepeatedly(Return(10));
     EXPECT_EQ(scorer(ref, hyp), MatchError(1.0f, 1.0f));
+    EXPECT_FLOAT_EQ(0.3f, scorer.Overlap(ref, hyp));
   }
   // Overlap is 50%
   {
@@ -67,3 +75,40 @@ TEST(IntersectionOverHypothesisAreaScorerTest, All) {
     EXPECT_EQ(scorer(ref, hyp), MatchError(0.0f, 0.0f));
   }
 }
+
+TEST(IntersectionOverHypothesisAreaScorerTest, IntersectionOverlap) {
+  // Given the intersection area, the overlap and the errors are exactly the
+  // same, with integer and real coordinates.
+  std::mt19937 rng(12345);
+  {
+    typedef ShapedEvent<int, DocumentIdBoundingBox<uint32_t>> Event;
+    std::uniform_int_distribution<uint32_t> coord(0, 60), size(0, 30);
+    IntersectionOverHypothesisAreaScorer<Event, Event> scorer(0.5);
+    for (int i = 0; i < 1000; ++i) {
+      const Event ref(1, DocumentIdBoundingBox<uint32_t>(
+          7, coord(rng), coord(rng), size(rng), size(rng)));
+      const Event hyp(1, DocumentIdBoundingBox<uint32_t>(
+          7, coord(rng), coord(rng), size(rng), size(rng)));
+      const uint32_t area = IntersectionArea(ref, hyp);
+      EXPECT_EQ(scorer.Overlap(ref, hyp),
+                scorer.IntersectionOverlap(ref, hyp, area));
+      EXPECT_EQ(scorer(ref, hyp), scorer.ScoreIntersection(ref, hyp, area));
+    }
+  }
+  {
+    typedef ShapedEvent<int, DocumentIdBoundingBox<float>> Event;
+    std::uniform_real_distribution<float> coord(0.0f, 60.0f),
+        size(0.0f, 30.0f);
+    IntersectionOverHypothesisAreaScorer<Event, Event> scorer(0.5);
+    for (int i = 0; i < 1000; ++i) {
+      const Event ref(1, DocumentIdBoundingBox<float>(
+          7, coord(rng), coord(rng), size(rng), size(rng)));
+      const Event hyp(1, DocumentIdBoundingBox<float>(
+          7, coord(rng), coord(rng), size(rng), size(rng)));
+      const float area = IntersectionArea(ref, hyp);
+      EXPECT_EQ(scorer.Overlap(ref, hyp),
+                scorer.IntersectionOverlap(ref, hyp, area));
+      EXPECT_EQ(scorer(ref, hyp), scorer.ScoreIntersection(ref, hyp, area));
+    }
+  }
+}
@@ -5,22 +5,24 @@
 #include <glog/logging.h>
 #endif
 
-#include "scorer/Scorer.h"
+#include "scorer/OverlapScorer.h"
 
 namespace kws {
 namespace scorer {
 
 using kws::core::MatchError;
 
+// Overlap(), operator() and their variants are final, see
+// IntersectionOverHypothesisAreaScorer.
 template <class RE, class HE>
-class IntersectionOverUnionAreaScorer : public Scorer<RE, HE> {
+class IntersectionOverUnionAreaScorer : public OverlapScorer<RE, HE> {
  public:
   explicit IntersectionOverUnionAreaScorer(float threshold) :
-      threshold_(threshold) {}
+      OverlapScorer<RE, HE>(threshold) {}
 
   ~IntersectionOverUnionAreaScorer() override {}
 
-  MatchError operator()(const RE& ref, const HE& hyp) override {
+  float Overlap(const RE& ref, const HE& hyp) const final {
     if (ref.Query() == hyp.Query() && hyp.Area() > 0) {
       const float val = IntersectionArea(ref, hyp) / (1.0f * UnionArea(ref, hyp));
 #if defined(WITH_GLOG) && defined(WITH_GLOG_TRACE)
@@ -29,15 +31,34 @@ class IntersectionOverUnionAreaScorer : public Scorer<RE, HE> {
                  << "Hyp = " << hyp << std::endl
                  << "Score =" << val;
 #endif
-      if (val >= threshold_) return MatchError{0.0f, 0.0f};
+      return val;
     }
-    return MatchError{1.0f, 1.0f};
+    return -1.0f;
   }
 
-  inline const float& Threshold() const { return threshold_; }
+  // The union area is computed as UnionArea() does, from the areas of the
+  // events and the given intersection area.
+  float IntersectionOverlap(const RE& ref, const HE& hyp,
+                            double intersection_area) const final {
+    if (ref.Query() == hyp.Query() && hyp.Area() > 0) {
+      typedef decltype(IntersectionArea(ref, hyp)) AreaType;
+      const AreaType area = static_cast<AreaType>(intersection_area);
+      const AreaType union_area =
+          static_cast<AreaType>(ref.Area() + hyp.Area() - area);
+      return area / (1.0f * union_area);
+    }
+    return -1.0f;
+  }
 
- private:
-  const float threshold_;
+  MatchError operator()(const RE& ref, const HE& hyp) final {
+    return this->MatchOverlap(Overlap(ref, hyp));
+  }
+
+  MatchError ScoreIntersection(const RE& ref, const HE& hyp,
+                               double intersection_area) final {
+    return this->MatchOverlap(
+        IntersectionOverlap(ref, hyp, intersection_area));
+  }
 };
 
 }  // namespace scorer
@@ -0,0 +1,59 @@
+#ifndef SCORER_OVERLAPSCORER_H_
+#define SCORER_OVERLAPSCORER_H_
+
+#include "scorer/Scorer.h"
+
+namespace kws {
+namespace scorer {
+
+using kws::core::MatchError;
+
+// Scorer that measures the overlap between the reference and the hypothesis
+// (e.g. their intersection over union), and matches them when the overlap
+// is at least a given threshold. Since the overlap does not depend on the
+// threshold, matchers can compute it once and compare it with several
+// thresholds (see MultiThresholdMatcher).
+template <class RE, class HE>
+class OverlapScorer : public Scorer<RE, HE> {
+ public:
+  explicit OverlapScorer(float threshold) : threshold_(threshold) {}
+
+  ~OverlapScorer() override {}
+
+  // Overlap between the events, or a negative value if they cannot be
+  // matched with any threshold (e.g. they have different queries).
+  virtual float Overlap(const RE& ref, const HE& hyp) const = 0;
+
+  // Same as Overlap(), given the intersection area of the locations of the
+  // events. By default, the area is ignored.
+  virtual float IntersectionOverlap(const RE& ref, const HE& hyp,
+                                    double /* intersection_area */) const {
+    return Overlap(ref, hyp);
+  }
+
+  MatchError operator()(const RE& ref, const HE& hyp) override {
+    return MatchOverlap(Overlap(ref, hyp));
+  }
+
+  MatchError ScoreIntersection(const RE& ref, const HE& hyp,
+                               double intersection_area) override {
+    return MatchOverlap(IntersectionOverlap(ref, hyp, intersection_area));
+  }
+
+  inline const float& Threshold() const { return threshold_; }
+
+ protected:
+  // Errors of a match with the given overlap.
+  inline MatchError MatchOverlap(float overlap) const {
+    return overlap >= threshold_
+        ? MatchError{0.0f, 0.0f} : MatchError{1.0f, 1.0f};
+  }
+
+ private:
+  const float threshold_;
+};
+
+}  // namespace scorer
+}  // namespace kws
+
+#endif  // SCORER_OVERLAPSCORER_H_
@@ -19,6 +19,15 @@ class Scorer {
   virtual ~Scorer() {}
 
   virtual MatchError operator()(const RefEvent& ref, const HypEvent& hyp) = 0;
+
+  // Same as operator(), given the intersection area of the locations of the
+  // events, when the EventSet that found them already computed it (see
+  // EventSet::kOverlapIsIntersectionArea). By default, the area is ignored.
+  virtual MatchError ScoreIntersection(const RefEvent& ref,
+                                       const HypEvent& hyp,
+                                       double /* intersection_area */) {
+    return (*this)(ref, hyp);
+  }
 };
 
 }  // namespace scorer
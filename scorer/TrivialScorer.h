@@ -7,7 +7,8 @@ namespace kws {
 namespace scorer {
 
 // This scorer just checks whether or not the Location & Query of the events
-// matches or not.
+// matches or not. operator() is final, so that matchers using this class as
+// their scorer type (see SimpleMatcher) can inline it.
 template <class RE, class HE>
 class TrivialScorer : public Scorer<RE, HE> {
  public:
@@ -15,7 +16,7 @@ class TrivialScorer : public Scorer<RE, HE> {
 
    ~TrivialScorer() override {}
 
-   MatchError operator()(const RE& ref, const HE& hyp) override {
+   MatchError operator()(const RE& ref, const HE& hyp) final {
      if (ref.Location() == hyp.Location() && ref.Query() == hyp.Query()) {
        return MatchError(0, 0);
      } else {
@@ -1,9 +1,18 @@
 #ifndef TOOLS_GENERICKWSEVALTOOL_H_
 #define TOOLS_GENERICKWSEVALTOOL_H_
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -14,13 +23,22 @@
 #include "cmd/Parser.h"
 #include "core/Assessment.h"
 #include "core/Bootstrapping.h"
+#include "core/BoundedQueue.h"
 #include "core/Statistic.h"
+#include "mapper/ConcurrentStringToIntMapper.h"
+#include "mapper/FrozenVocabulary.h"
 #include "mapper/IdentityMapper.h"
+#include "matcher/MultiThresholdMatcher.h"
+#include "matcher/ParallelMatcher.h"
+#include "reader/BatchReader.h"
+#include "reader/EventFilter.h"
+#include "reader/MappedFile.h"
 
 namespace kws {
 namespace tools {
 
 using kws::cmd::Parser;
+using kws::core::BoundedQueue;
 using kws::core::CollapseMatches;
 using kws::core::ComputeAP;
 using kws::core::ComputePercentileBootstrapCI;
@@ -28,16 +46,14 @@ using kws::core::ComputePrecisionAndRecall;
 using kws::core::Match;
 using kws::core::Statistic;
 using kws::core::GlobalStatistic;
+using kws::mapper::ConcurrentStringToIntMapper;
+using kws::mapper::FrozenVocabulary;
 using kws::mapper::IdentityMapper;
-
-template<typename E, typename C>
-void filter_events(const C &queryset, std::vector<E> *events) {
-  std::vector<E> events_aux = *events;
-  events->clear();
-  for (const auto &e : events_aux) {
-    if (queryset.count(e.Query()) > 0) events->push_back(e);
-  }
-}
+using kws::matcher::MultiThresholdMatcher;
+using kws::matcher::ParallelMatcher;
+using kws::reader::BatchReader;
+using kws::reader::EventFilter;
+using kws::reader::MappedFile;
 
 template<class RefReader, class HypReader, class Matcher, class QueryMapper>
 class GenericKwsEvalTool {
@@ -52,7 +68,26 @@ class GenericKwsEvalTool {
                      Matcher *matcher, QueryMapper *query_mapper,
                      const std::string &description = "") :
       ref_reader_(ref_reader), hyp_reader_(hyp_reader), matcher_(matcher),
-      query_mapper_(query_mapper), description_(description) {}
+      threshold_matcher_(nullptr), active_matcher_(matcher),
+      query_mapper_(query_mapper), location_mapper_(nullptr),
+      description_(description) {}
+
+  // Sets the mapper of the locations of the events, when they are not mapped
+  // by the query mapper (e.g. StringEventToIntMapper with separate query and
+  // location mappers). It is only needed to renumber the ids assigned by
+  // ConcurrentStringToIntMapper.
+  void SetLocationMapper(QueryMapper* location_mapper) {
+    location_mapper_ = location_mapper;
+  }
+
+  // Sets the matcher used to match with several overlap thresholds at once
+  // (option --overlap_thresholds). Its scorer must use the same threshold as
+  // the scorer of the main matcher, since the main results are computed with
+  // it, instead of the main matcher, when the option is given.
+  void SetThresholdMatcher(
+      MultiThresholdMatcher<RefEvent, HypEvent>* threshold_matcher) {
+    threshold_matcher_ = threshold_matcher;
+  }
 
   static void ComputeMeanStatistic(
       const std::string &statistic_name,
@@ -129,10 +164,12 @@ class GenericKwsEvalTool {
 
     std::vector<std::vector<double>> sampled_pr;
     sampled_pr.emplace_back();  // sampled_pr[0] stores the mean precision
+    core::AssessmentBuffers<MatchType> buffers;
+    std::vector<double> pr, rc;
     for (const auto& matches : matches_by_group) {
-      std::vector<double> pr, rc;
       core::ComputePrecisionAndRecall(
-          matches, collapse_matches, interpolated_precision, &pr, &rc);
+          matches, collapse_matches, interpolated_precision, &pr, &rc,
+          &buffers);
       sampled_pr.emplace_back();
       core::SampleCurveAtGivenPoints(
           rc, pr, sampled_rc, &sampled_pr.back(), trapezoid_integral);
@@ -152,6 +189,207 @@ class GenericKwsEvalTool {
     core::WriteCurveToFile(filename, sampled_rc, sampled_pr[0]);
   }
 
+  // Overlap thresholds of a row of the table printed with
+  // --overlap_thresholds: a single threshold, or a range of thresholds whose
+  // statistics are averaged.
+  struct OverlapThresholdsRow {
+    std::string name;
+    std::vector<float> thresholds;
+  };
+
+  // Parses a comma-separated list of overlap thresholds, where each element
+  // is a threshold (e.g. "0.5") or a range "first:step:last" (e.g.
+  // "0.5:0.05:0.95"). Thresholds must be in [0, 1].
+  static bool ParseOverlapThresholds(
+      const std::string& spec, std::vector<OverlapThresholdsRow>* rows) {
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+      std::vector<double> values;
+      std::istringstream item_iss(item);
+      std::string field;
+      while (std::getline(item_iss, field, ':')) {
+        char* end = nullptr;
+        values.push_back(std::strtod(field.c_str(), &end));
+        if (field.empty() || *end != '\0') values.clear();
+        if (values.empty()) break;
+      }
+      OverlapThresholdsRow row;
+      row.name = item;
+      if (values.size() == 1) {
+        row.thresholds.push_back(static_cast<float>(values[0]));
+      } else if (values.size() == 3 && values[1] > 0 &&
+                 values[0] <= values[2]) {
+        const size_t n = static_cast<size_t>(
+            std::floor((values[2] - values[0]) / values[1] + 1e-6)) + 1;
+        for (size_t i = 0; i < n; ++i) {
+          row.thresholds.push_back(
+              static_cast<float>(values[0] + i * values[1]));
+        }
+      }
+      if (row.thresholds.empty() ||
+          row.thresholds.front() < 0.0f || row.thresholds.back() > 1.0f) {
+        std::cerr << "ERROR: Invalid overlap thresholds \"" << item
+                  << "\"!" << std::endl;
+        return false;
+      }
+      rows->push_back(std::move(row));
+    }
+    if (rows->empty()) {
+      std::cerr << "ERROR: No overlap thresholds were given!" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Prints the gAP, mAP, gNDCG and mNDCG with each row of overlap
+  // thresholds, using the matches of the threshold matcher.
+  void PrintOverlapThresholdsTable(
+      const std::vector<OverlapThresholdsRow>& rows,
+      const std::map<QType, QType>& query2group, const bool collapse_matches,
+      const bool interpolated_precision, const bool trapezoid_integral) const {
+    const std::vector<float>& thresholds = threshold_matcher_->Thresholds();
+    std::vector<std::vector<double>> values(thresholds.size());
+    const core::GlobalAP<MatchType> gap(
+        collapse_matches, interpolated_precision, trapezoid_integral);
+    const core::MeanAP<MatchType> map(
+        collapse_matches, interpolated_precision, trapezoid_integral);
+    const core::GlobalNDCG<MatchType> gndcg(collapse_matches);
+    const core::MeanNDCG<MatchType> mndcg(collapse_matches);
+    std::vector<std::vector<MatchType>> matches_by_group;
+    core::MatchGroupingBuffers<MatchType> grouping_buffers;
+    for (size_t t = 0; t < thresholds.size(); ++t) {
+      const auto& matches = threshold_matcher_->GetMatches(t);
+      core::GroupMatchesByQueryGroup(matches, query2group, &matches_by_group,
+                                     &grouping_buffers);
+      values[t] = {gap(matches), map(matches_by_group, false),
+                   gndcg(matches), mndcg(matches_by_group, false)};
+    }
+    std::cout << std::left << std::setw(20) << "Overlap threshold"
+              << std::right << std::setw(10) << "gAP" << std::setw(10)
+              << "mAP" << std::setw(10) << "gNDCG" << std::setw(10)
+              << "mNDCG" << std::endl;
+    for (const OverlapThresholdsRow& row : rows) {
+      std::vector<double> mean(4, 0.0);
+      for (const float threshold : row.thresholds) {
+        const size_t t = std::lower_bound(
+            thresholds.begin(), thresholds.end(), threshold) -
+            thresholds.begin();
+        for (size_t i = 0; i < 4; ++i) {
+          mean[i] += values[t][i] / row.thresholds.size();
+        }
+      }
+      std::cout << std::left << std::setw(20) << row.name << std::right
+                << std::fixed << std::setprecision(4);
+      for (const double v : mean) std::cout << std::setw(10) << v;
+      std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+  }
+
+  static bool WriteMatches(const std::string& filename,
+                           const std::vector<MatchType>& matches,
+                           const std::vector<MatchType>& repeated_matches) {
+    std::ofstream mfs(filename, std::ios_base::out);
+    if (!mfs.is_open()) {
+      std::cerr << "ERROR: Dump matches file \"" << filename
+                << "\" could not be opened for write!" << std::endl;
+      return false;
+    }
+    for (const auto &m : matches) {
+      mfs << m << std::endl;
+    }
+    mfs << "#### REPEATED MATCHES ####" << std::endl;
+    for (const auto &m : repeated_matches) {
+      mfs << "## " << m << std::endl;
+    }
+    mfs.close();
+    return true;
+  }
+
+  // Reads the set of queries (or the query groups) to consider. Each line of
+  // *query_groups contains a group followed by its queries, or a single query
+  // (a group by itself). If none of the files is given, *query_groups is left
+  // empty. The queries are also added to the filters of the readers, so that
+  // the events of other queries are discarded while reading them.
+  bool ReadQueryGroups(
+      const std::string& queryset_filename,
+      const std::string& querygroups_filename,
+      std::vector<std::vector<std::string>>* query_groups) {
+    if (!queryset_filename.empty() && querygroups_filename.empty()) {
+      std::ifstream qfs(queryset_filename, std::ios_base::in);
+      if (!qfs.is_open()) {
+        std::cerr << "ERROR: Query set file \"" << queryset_filename
+                  << "\" could not be read!" << std::endl;
+        return false;
+      }
+      std::string qt;
+      while (qfs >> qt) {
+        AddFilterQuery(qt);
+        query_groups->push_back({qt});
+      }
+      qfs.close();
+    } else if (!querygroups_filename.empty()) {
+      std::ifstream qfs(querygroups_filename, std::ios_base::in);
+      if (!qfs.is_open()) {
+        std::cerr << "ERROR: Query groups file \"" << querygroups_filename
+                  << "\" could not be read!" << std::endl;
+        return false;
+      }
+      std::string line, s;
+      while (std::getline(qfs, line)) {
+        std::vector<std::string> fields;
+        std::istringstream iss(line);
+        while (iss >> s) { fields.push_back(s); }
+        if (fields.size() < 2) {
+          std::cerr << "ERROR: Query groups file \"" << querygroups_filename
+                    << "\" has a wrong format!" << std::endl;
+          return false;
+        }
+        for (size_t i = 1; i < fields.size(); ++i) AddFilterQuery(fields[i]);
+        query_groups->push_back(std::move(fields));
+      }
+      qfs.close();
+    }
+    return true;
+  }
+
+  // Maps the queries and groups read by ReadQueryGroups(), in the same order
+  // as they were read, and fills *query2group.
+  void MapQueryGroups(const std::string& queryset_filename,
+                      const std::string& querygroups_filename,
+                      const std::vector<std::vector<std::string>>& query_groups,
+                      std::map<QType, QType>* query2group) const {
+    if (querygroups_filename.empty()) {
+      for (const auto& qt : query_groups) {
+        auto q = (*query_mapper_)(qt[0]);
+        (*query2group)[q] = q;
+      }
+      if (!queryset_filename.empty()) {
+        std::cerr << "INFO: " << query2group->size()
+                  << " queries were read from \""
+                  << queryset_filename << "\"" << std::endl;
+      }
+      return;
+    }
+    for (const auto& line : query_groups) {
+      std::vector<QType> fields;
+      for (const auto& s : line) { fields.push_back((*query_mapper_)(s)); }
+      for (size_t i = 1; i < fields.size(); ++i) {
+        (*query2group)[fields[i]] = fields[0];
+      }
+    }
+    std::cerr << "INFO: " << query2group->size()
+              << " queries were read from \""
+              << querygroups_filename << "\"" << std::endl;
+    std::map<QType, std::vector<QType>> group2query;
+    for (const auto &kv : *query2group) {
+      group2query.emplace(kv.second, std::vector<QType>())
+          .first->second.push_back(kv.first);
+    }
+    std::cerr << "INFO: " << group2query.size() << " groups were read "
+              << "from \"" << querygroups_filename << "\"" << std::endl;
+  }
+
   int Main(int argc, const char **argv) {
 #ifdef WITH_GLOG
     google::InitGoogleLogging(argv[0]);
@@ -176,6 +414,14 @@ class GenericKwsEvalTool {
     size_t bootstrap_seed = 0x12345;
     double bootstrap_alpha = 0.05;
     size_t curve_samples = 10000;
+    size_t batch_size = 4096;
+    size_t matcher_threads = 0;
+    std::string overlap_thresholds;
+    bool pipeline = true;
+    float min_score = -std::numeric_limits<float>::infinity();
+    std::string snapshot_dir;
+    std::string vocabulary_filename;
+    std::string save_vocabulary_filename;
 
     // Options
     Parser cmd_parser(argv[0], description_);
@@ -196,6 +442,28 @@ class GenericKwsEvalTool {
         "File containing the set of queries to consider. Events regarding "
         "other queries are excluded from both references and hypotheses.",
         &queryset_filename);
+    cmd_parser.RegisterOption(
+        "min_score",
+        "Hypotheses with a lower score are excluded (discarded while they "
+        "are read).",
+        &min_score);
+    cmd_parser.RegisterOption(
+        "reference_cache",
+        "Directory where snapshots of the parsed references are cached, "
+        "keyed by the content of the references file. Later evaluations "
+        "against the same references read the snapshot instead.",
+        &snapshot_dir);
+    cmd_parser.RegisterOption(
+        "vocabulary",
+        "Vocabulary file of queries (see --save_vocabulary). The queries in "
+        "the vocabulary keep their ids from it, which are stable across "
+        "runs. Other queries get new ids.",
+        &vocabulary_filename);
+    cmd_parser.RegisterOption(
+        "save_vocabulary",
+        "Save all the queries mapped in this run, with their ids, to this "
+        "vocabulary file, to be loaded by later runs with --vocabulary.",
+        &save_vocabulary_filename);
     cmd_parser.RegisterOption(
         "dump_matches",
         "Dump the raw matches to this file.",
@@ -252,6 +520,35 @@ class GenericKwsEvalTool {
        "Number of sample points to use to interpolate the mean "
        "recall-precision curve.",
        &curve_samples);
+    cmd_parser.RegisterOption(
+        "batch_size",
+        "When the hypotheses are not sorted (--sort none), they are read and "
+        "matched incrementally, in batches of this number of events.",
+        &batch_size);
+    cmd_parser.RegisterOption(
+        "matcher_threads",
+        "Number of threads used to match the hypotheses against the "
+        "references (0 means as many as hardware threads). The matches are "
+        "the same with any number of threads.",
+        &matcher_threads);
+    if (threshold_matcher_ != nullptr) {
+      cmd_parser.RegisterOption(
+          "overlap_thresholds",
+          "Also match the hypotheses with these overlap thresholds, in the "
+          "same pass, and print a table of the gAP, mAP, gNDCG and mNDCG "
+          "with each of them. Comma-separated list of thresholds or ranges "
+          "\"first:step:last\", whose statistics are averaged (e.g. "
+          "\"0.25,0.5,0.5:0.05:0.95\"). With --dump_matches, the matches "
+          "with each threshold are dumped to the same file, with the "
+          "threshold as suffix.",
+          &overlap_thresholds);
+    }
+    cmd_parser.RegisterOption(
+        "pipeline",
+        "Read the references and hypotheses concurrently, when the readers "
+        "allow it, and match the hypotheses while they are being read "
+        "(--sort none). The results are the same as without this option.",
+        &pipeline);
     // Arguments
     cmd_parser.RegisterArgument(
         "references",
@@ -267,149 +564,101 @@ class GenericKwsEvalTool {
       return 1;
     }
 
-    // Read reference events
-    if (ref_filename.empty()) {
-      std::cerr << "ERROR: Empty filename was given for the references!"
-                << std::endl;
-      return 1;
+    // Events are filtered while they are read.
+    hyp_filter_.SetMinScore(min_score);
+    ref_reader_->SetFilter(&ref_filter_);
+    hyp_reader_->SetFilter(&hyp_filter_);
+    if (!snapshot_dir.empty() &&
+        !ref_reader_->SetSnapshotDirectory(snapshot_dir)) {
+      std::cerr << "WARN: The references reader does not support snapshots, "
+                << "option --reference_cache is ignored." << std::endl;
     }
-    std::vector<RefEvent> ref_events;
-    if (!ref_reader_->Read(ref_filename, &ref_events)) {
-      std::cerr << "ERROR: Failed reading file \"" << ref_filename << "\"!"
-                << std::endl;
-      return 1;
-    }
-    std::cerr << "INFO: Number of reference events read = " << ref_events.size()
-              << std::endl;
-
-    // Read hypothesis events
-    std::vector<HypEvent> hyp_events;
-    if (!(hyp_filename.empty()
-          ? hyp_reader_->Read(&std::cin, &hyp_events)
-          : hyp_reader_->Read(hyp_filename, &hyp_events))) {
-      if (argc == 2) {
-        std::cerr << "ERROR: Failed reading from stdin!" << std::endl;
+    if (!vocabulary_filename.empty()) {
+      if (!vocabulary_file_.Open(vocabulary_filename, false)) {
+        std::cerr << "ERROR: Failed reading vocabulary file \""
+                  << vocabulary_filename << "\"!" << std::endl;
+        return 1;
+      }
+      if (!vocabulary_.Load(vocabulary_file_.Begin(),
+                            vocabulary_file_.End())) {
+        std::cerr << "ERROR: File \"" << vocabulary_filename << "\" is not "
+                  << "a valid vocabulary file!" << std::endl;
+        return 1;
+      }
+      if (!SetVocabulary(query_mapper_, &vocabulary_)) {
+        std::cerr << "WARN: The query mapper does not support vocabularies, "
+                  << "option --vocabulary is ignored." << std::endl;
       } else {
-        std::cerr << "ERROR: Failed reading file \"" << hyp_filename << "\"!"
+        std::cerr << "INFO: " << vocabulary_.size() << " strings were read "
+                  << "from vocabulary \"" << vocabulary_filename << "\""
                   << std::endl;
       }
-      return 1;
     }
-    std::cerr << "INFO: Number of hypothesis events read = "
-              << hyp_events.size()
-              << std::endl;
 
-    std::map<QType, QType> query2group;
-    std::map<QType, std::vector<QType>> group2query;
+    if (!SetMatcherThreads(matcher_, matcher_threads) &&
+        matcher_threads != 0) {
+      std::cerr << "WARN: The matcher is not parallel, option "
+                << "--matcher_threads is ignored." << std::endl;
+    }
 
-    // If a queryset filename was given, filter out events from queries not in
-    // this file.
-    if (!queryset_filename.empty() && querygroups_filename.empty()) {
-      std::ifstream qfs(queryset_filename, std::ios_base::in);
-      if (!qfs.is_open()) {
-        std::cerr << "ERROR: Query set file \"" << queryset_filename
-                  << "\" could not be read!" << std::endl;
-        return 1;
-      }
-      std::string qt;
-      while (qfs >> qt) {
-        auto q = (*query_mapper_)(qt);
-        query2group[q] = q;
-      }
-      qfs.close();
-      std::cerr << "INFO: " << query2group.size()
-                << " queries were read from \""
-                << queryset_filename << "\"" << std::endl;
-    } else if (!querygroups_filename.empty()) {
-      std::ifstream qfs(querygroups_filename, std::ios_base::in);
-      if (!qfs.is_open()) {
-        std::cerr << "ERROR: Query groups file \"" << querygroups_filename
-                  << "\" could not be read!" << std::endl;
+    std::vector<OverlapThresholdsRow> overlap_thresholds_rows;
+    if (!overlap_thresholds.empty()) {
+      if (!ParseOverlapThresholds(overlap_thresholds,
+                                  &overlap_thresholds_rows)) {
         return 1;
       }
-      std::string line, s;
-      while (std::getline(qfs, line)) {
-        std::vector<QType> fields;
-        std::istringstream iss(line);
-        while (iss >> s) { fields.push_back((*query_mapper_)(s)); }
-        if (fields.size() < 2) {
-          std::cerr << "ERROR: Query groups file \"" << querygroups_filename
-                    << "\" has a wrong format!" << std::endl;
-          return 1;
-        }
-        for (size_t i = 1; i < fields.size(); ++i) {
-          query2group[fields[i]] = fields[0];
-        }
-      }
-      qfs.close();
-      std::cerr << "INFO: " << query2group.size()
-                << " queries were read from \""
-                << querygroups_filename << "\"" << std::endl;
-    }
-
-    if (!query2group.empty()) {
-      // Filter out reference events.
-      const size_t num_ref_events = ref_events.size();
-      filter_events(query2group, &ref_events);
-      if (num_ref_events != ref_events.size()) {
-        std::cerr << "INFO: Number of kept reference events = "
-                  << ref_events.size() << std::endl;
-      }
-      // Filter out hypothesis events.
-      const size_t num_hyp_events = hyp_events.size();
-      filter_events(query2group, &hyp_events);
-      if (num_hyp_events != hyp_events.size()) {
-        std::cerr << "INFO: Number of kept hypothesis events = "
-                  << hyp_events.size() << std::endl;
-      }
-      // Add values to the group2query map
-      for (const auto &kv : query2group) {
-        group2query.emplace(kv.second, std::vector<QType>())
-            .first->second.push_back(kv.first);
-      }
-      if (!querygroups_filename.empty()) {
-        std::cerr << "INFO: " << group2query.size() << " groups were read "
-                  << "from \"" << querygroups_filename << "\"" << std::endl;
+      std::vector<float> thresholds;
+      for (const auto& row : overlap_thresholds_rows) {
+        thresholds.insert(thresholds.end(), row.thresholds.begin(),
+                          row.thresholds.end());
       }
+      threshold_matcher_->SetThresholds(thresholds);
+      active_matcher_ = threshold_matcher_;
     }
 
-    if (sort_criterion == "desc") {
-      // Sort hypotheses in descending order of their score.
-      std::sort(hyp_events.begin(), hyp_events.end(),
-                std::greater<HypEvent>());
-    } else if (sort_criterion == "asc") {
-      // Sort hypotheses in ascending order of their score.
-      std::sort(hyp_events.begin(), hyp_events.end(),
-                std::less<HypEvent>());
-    } else if (sort_criterion != "none") {
-      // Unknown sorting criterion.
-      std::cerr << "WARN: Ignoring sorting criterion \"" << sort_criterion
-                << "\". Hypotheses won't be sorted." << std::endl;
-    }
-    const size_t num_hyp_events = hyp_events.size();
-
+    MatchOptions options;
+    options.ref_filename = ref_filename;
+    options.hyp_filename = hyp_filename;
+    options.queryset_filename = queryset_filename;
+    options.querygroups_filename = querygroups_filename;
+    options.sort_criterion = sort_criterion;
+    options.batch_size = batch_size;
 
-    // Match hypothesis events against the references.
-    std::cerr << "INFO: Computing matches..." << std::endl;
-    const auto matches = matcher_->Match(ref_events, hyp_events);
-    ref_events.clear(); hyp_events.clear(); // These are not needed anymore
+    // Read events and match hypotheses against the references.
+    std::map<QType, QType> query2group;
+    std::vector<MatchType> matches;
+    size_t num_hyp_events = 0;
+    if (!(pipeline
+          ? ComputeMatchesPipelined(options, &query2group, &matches,
+                                    &num_hyp_events)
+          : ComputeMatches(options, &query2group, &matches,
+                           &num_hyp_events))) {
+      return 1;
+    }
+    if (!save_vocabulary_filename.empty() &&
+        !SaveVocabulary(query_mapper_, save_vocabulary_filename)) {
+      return 1;
+    }
 
     // Optionally, dump raw matches to the given file.
     if (!matches_filename.empty()) {
-      std::ofstream mfs(matches_filename, std::ios_base::out);
-      if (!mfs.is_open()) {
-        std::cerr << "ERROR: Dump matches file \"" << matches_filename
-                  << "\" could not be opened for write!" << std::endl;
+      if (!WriteMatches(matches_filename, matches,
+                        active_matcher_ == matcher_
+                        ? matcher_->GetRepeatedMatches()
+                        : threshold_matcher_->GetRepeatedMatches())) {
         return 1;
       }
-      for (const auto &m : matches) {
-        mfs << m << std::endl;
-      }
-      mfs << "#### REPEATED MATCHES ####" << std::endl;
-      for (const auto &m : matcher_->GetRepeatedMatches()) {
-        mfs << "## " << m << std::endl;
+      if (active_matcher_ == threshold_matcher_) {
+        const auto& thresholds = threshold_matcher_->Thresholds();
+        for (size_t t = 0; t < thresholds.size(); ++t) {
+          std::ostringstream filename;
+          filename << matches_filename << "." << thresholds[t];
+          if (!WriteMatches(filename.str(), threshold_matcher_->GetMatches(t),
+                            threshold_matcher_->GetRepeatedMatches(t))) {
+            return 1;
+          }
+        }
       }
-      mfs.close();
     }
 
     {
@@ -472,15 +721,391 @@ class GenericKwsEvalTool {
           interpolated_precision, trapezoid_integral);
     }
 
+    if (!overlap_thresholds_rows.empty()) {
+      PrintOverlapThresholdsTable(overlap_thresholds_rows, query2group,
+                                  collapse_matches, interpolated_precision,
+                                  trapezoid_integral);
+    }
+
     return 0;
   }
 
  protected:
+  // Input files and options used to compute the matches.
+  struct MatchOptions {
+    std::string ref_filename;
+    std::string hyp_filename;
+    std::string queryset_filename;
+    std::string querygroups_filename;
+    std::string sort_criterion;
+    size_t batch_size;
+  };
+
+  // Number of batches of hypotheses that can wait to be matched.
+  static const size_t kPipelineQueueSize = 4;
+
+  // Reads the references and the hypotheses, and matches hypotheses against
+  // references. The events of the queries not in the query set (and the
+  // hypotheses below the minimum score) are discarded while reading them.
+  // If the hypotheses are not sorted, they are read and matched in batches.
+  bool ComputeMatches(const MatchOptions& options,
+                      std::map<QType, QType>* query2group,
+                      std::vector<MatchType>* matches,
+                      size_t* num_hyp_events) {
+    // The filters need the query set before reading any event, but the
+    // queries are mapped after the references, as they always were.
+    std::vector<std::vector<std::string>> query_groups;
+    if (!ReadQueryGroups(options.queryset_filename,
+                         options.querygroups_filename, &query_groups)) {
+      return false;
+    }
+    std::vector<RefEvent> ref_events;
+    if (!ReadReferences(options.ref_filename, &ref_events)) return false;
+    MapQueryGroups(options.queryset_filename, options.querygroups_filename,
+                   query_groups, query2group);
+
+    // When the hypotheses do not need to be sorted, they are read and matched
+    // incrementally, instead of reading all of them first.
+    if (options.sort_criterion == "none") {
+      RenumberIds(query_mapper_, location_mapper_, options, query_groups,
+                  &ref_events, nullptr, query2group);
+      std::cerr << "INFO: Computing matches..." << std::endl;
+      auto batches = OpenHypothesesBatches(options.hyp_filename);
+      std::vector<HypEvent> batch;
+      *num_hyp_events = 0;
+      active_matcher_->BeginMatch(ref_events);
+      while (batches->Next(options.batch_size, &batch)) {
+        *num_hyp_events += batch.size();
+        active_matcher_->MatchBatch(batch, matches);
+      }
+      return FinishMatchingBatches(options.hyp_filename, !batches->Fail(),
+                                   *num_hyp_events, matches);
+    }
+
+    std::vector<HypEvent> hyp_events;
+    if (!ReadHypotheses(options.hyp_filename, &hyp_events)) return false;
+    RenumberIds(query_mapper_, location_mapper_, options, query_groups,
+                &ref_events, &hyp_events, query2group);
+    SortHypotheses(options.sort_criterion, &hyp_events);
+    *num_hyp_events = hyp_events.size();
+    // Match hypothesis events against the references.
+    std::cerr << "INFO: Computing matches..." << std::endl;
+    *matches = active_matcher_->Match(ref_events, hyp_events);
+    return true;
+  }
+
+  // Same as ComputeMatches(), but overlapping the different stages:
+  //  - If the readers are thread-safe, the references are read by a
+  //    different thread, concurrently with the hypotheses.
+  //  - If the hypotheses are not sorted, they are read in batches by a
+  //    different thread and passed through a bounded queue to the thread
+  //    matching them.
+  // The mappers are called in the same order as in ComputeMatches() (or the
+  // ids are renumbered in that order, see RenumberIds()), thus the matches
+  // are exactly the same.
+  bool ComputeMatchesPipelined(const MatchOptions& options,
+                               std::map<QType, QType>* query2group,
+                               std::vector<MatchType>* matches,
+                               size_t* num_hyp_events) {
+    const bool stream_hyps = options.sort_criterion == "none";
+    // Ids must be renumbered before matching, thus streamed hypotheses are
+    // only mapped once the references have been read.
+    const bool concurrent_read =
+        ref_reader_->IsThreadSafe() && hyp_reader_->IsThreadSafe() &&
+        !(stream_hyps && RenumbersIds(query_mapper_));
+    if (!stream_hyps && !concurrent_read) {
+      // Nothing can be overlapped.
+      return ComputeMatches(options, query2group, matches, num_hyp_events);
+    }
+
+    std::vector<std::vector<std::string>> query_groups;
+    if (!ReadQueryGroups(options.queryset_filename,
+                         options.querygroups_filename, &query_groups)) {
+      return false;
+    }
+    std::vector<RefEvent> ref_events;
+    bool refs_ok = true;
+    std::thread ref_thread;
+    if (concurrent_read) {
+      // The readers do not modify the state of the query mapper (or the
+      // mapper is thread-safe, and ids are renumbered afterwards), so the
+      // queries can be mapped while the references are read.
+      ref_thread = std::thread([this, &options, &ref_events, &refs_ok]() {
+        refs_ok = ReadReferences(options.ref_filename, &ref_events);
+      });
+    } else if (!ReadReferences(options.ref_filename, &ref_events)) {
+      return false;
+    }
+    MapQueryGroups(options.queryset_filename, options.querygroups_filename,
+                   query_groups, query2group);
+
+    if (!stream_hyps) {
+      std::vector<HypEvent> hyp_events;
+      const bool hyps_ok = ReadHypotheses(options.hyp_filename, &hyp_events);
+      ref_thread.join();
+      if (!refs_ok || !hyps_ok) return false;
+      RenumberIds(query_mapper_, location_mapper_, options, query_groups,
+                  &ref_events, &hyp_events, query2group);
+      SortHypotheses(options.sort_criterion, &hyp_events);
+      *num_hyp_events = hyp_events.size();
+      std::cerr << "INFO: Computing matches..." << std::endl;
+      *matches = active_matcher_->Match(ref_events, hyp_events);
+      return true;
+    }
+
+    if (!concurrent_read) {
+      RenumberIds(query_mapper_, location_mapper_, options, query_groups,
+                  &ref_events, nullptr, query2group);
+    }
+
+    // Producer thread: reads the hypotheses in batches.
+    BoundedQueue<std::vector<HypEvent>> queue(kPipelineQueueSize);
+    bool hyps_ok = true;
+    std::thread hyp_thread([this, &options, &queue, &hyps_ok]() {
+      auto batches = OpenHypothesesBatches(options.hyp_filename);
+      std::vector<HypEvent> batch;
+      while (batches->Next(options.batch_size, &batch)) {
+        if (!queue.Push(std::move(batch))) break;
+      }
+      hyps_ok = !batches->Fail();
+      queue.Close();
+    });
+
+    // Consumer: matches the batches, once the references are available.
+    if (ref_thread.joinable()) ref_thread.join();
+    *num_hyp_events = 0;
+    if (refs_ok) {
+      std::cerr << "INFO: Computing matches..." << std::endl;
+      active_matcher_->BeginMatch(ref_events);
+      std::vector<HypEvent> batch;
+      while (queue.Pop(&batch)) {
+        *num_hyp_events += batch.size();
+        active_matcher_->MatchBatch(batch, matches);
+      }
+    }
+    queue.Close();
+    hyp_thread.join();
+    return refs_ok &&
+        FinishMatchingBatches(options.hyp_filename, hyps_ok, *num_hyp_events,
+                              matches);
+  }
+
+  bool ReadReferences(const std::string& ref_filename,
+                      std::vector<RefEvent>* ref_events) const {
+    if (ref_filename.empty()) {
+      std::cerr << "ERROR: Empty filename was given for the references!"
+                << std::endl;
+      return false;
+    }
+    if (!ref_reader_->Read(ref_filename, ref_events)) {
+      std::cerr << "ERROR: Failed reading file \"" << ref_filename << "\"!"
+                << std::endl;
+      return false;
+    }
+    PrintNumEvents("reference", ref_events->size(), ref_filter_);
+    return true;
+  }
+
+  bool ReadHypotheses(const std::string& hyp_filename,
+                      std::vector<HypEvent>* hyp_events) const {
+    if (!(hyp_filename.empty()
+          ? hyp_reader_->Read(&std::cin, hyp_events)
+          : hyp_reader_->Read(hyp_filename, hyp_events))) {
+      PrintHypothesesReadError(hyp_filename);
+      return false;
+    }
+    PrintNumEvents("hypothesis", hyp_events->size(), hyp_filter_);
+    return true;
+  }
+
+  std::unique_ptr<BatchReader<HypEvent>> OpenHypothesesBatches(
+      const std::string& hyp_filename) const {
+    return hyp_filename.empty()
+        ? hyp_reader_->OpenBatches(&std::cin)
+        : hyp_reader_->OpenBatches(hyp_filename);
+  }
+
+  // Completes the matching of the hypotheses read in batches.
+  bool FinishMatchingBatches(const std::string& hyp_filename, bool hyps_ok,
+                             size_t num_kept,
+                             std::vector<MatchType>* matches) {
+    if (!hyps_ok) {
+      PrintHypothesesReadError(hyp_filename);
+      return false;
+    }
+    active_matcher_->EndMatch(matches);
+    PrintNumEvents("hypothesis", num_kept, hyp_filter_);
+    return true;
+  }
+
+  // Adds a query to the filters of both readers.
+  void AddFilterQuery(const std::string& query) {
+    ref_filter_.AddQuery(query);
+    hyp_filter_.AddQuery(query);
+  }
+
+  // Prints the number of events read, and the number of them that were kept
+  // (if some were discarded by the filter).
+  static void PrintNumEvents(const std::string& type, size_t num_kept,
+                             const EventFilter& filter) {
+    std::cerr << "INFO: Number of " << type << " events read = "
+              << num_kept + filter.NumRejected() << std::endl;
+    if (filter.NumRejected() > 0) {
+      std::cerr << "INFO: Number of kept " << type << " events = "
+                << num_kept << std::endl;
+    }
+  }
+
+  // Ids assigned concurrently by a ConcurrentStringToIntMapper depend on the
+  // interleaving of the threads. They are renumbered in the order in which
+  // a sequential run maps the strings: the references, the query groups and
+  // the hypotheses (before sorting them), so that the results are exactly
+  // the same regardless of the number of threads. If hyp_events is null, the
+  // hypotheses must be mapped sequentially after this call. If locations are
+  // mapped by a different mapper (see SetLocationMapper()), their ids are
+  // renumbered separately. Ids assigned by other mappers are not changed.
+  template <typename M>
+  static bool RenumbersIds(const M*) { return false; }
+
+  template <typename Int>
+  static bool RenumbersIds(const ConcurrentStringToIntMapper<Int>*) {
+    return true;
+  }
+
+  template <typename M>
+  static void RenumberIds(
+      M*, M*, const MatchOptions&,
+      const std::vector<std::vector<std::string>>&, std::vector<RefEvent>*,
+      std::vector<HypEvent>*, std::map<QType, QType>*) {}
+
+  template <typename Int>
+  static void RenumberIds(
+      ConcurrentStringToIntMapper<Int>* mapper,
+      ConcurrentStringToIntMapper<Int>* location_mapper,
+      const MatchOptions& options,
+      const std::vector<std::vector<std::string>>& query_groups,
+      std::vector<RefEvent>* ref_events, std::vector<HypEvent>* hyp_events,
+      std::map<QType, QType>* query2group) {
+    const bool shared =
+        location_mapper == nullptr || location_mapper == mapper;
+    std::vector<Int> order, location_order;
+    std::vector<Int>* locations = shared ? &order : &location_order;
+    // StringEventToIntMapper maps the location of each event before its
+    // query.
+    for (const auto& e : *ref_events) {
+      locations->push_back(e.Location());
+      order.push_back(e.Query());
+    }
+    // Same order as MapQueryGroups(), the strings are already mapped.
+    for (const auto& line : query_groups) {
+      const size_t n = options.querygroups_filename.empty() ? 1 : line.size();
+      for (size_t i = 0; i < n; ++i) order.push_back((*mapper)(line[i]));
+    }
+    if (hyp_events) {
+      for (const auto& e : *hyp_events) {
+        locations->push_back(e.Location());
+        order.push_back(e.Query());
+      }
+    }
+    const std::vector<Int> new_id = mapper->Renumber(order);
+    const std::vector<Int> new_location_id =
+        shared ? new_id : location_mapper->Renumber(location_order);
+    for (auto& e : *ref_events) {
+      e.Query() = new_id[e.Query()];
+      e.Location() = new_location_id[e.Location()];
+    }
+    if (hyp_events) {
+      for (auto& e : *hyp_events) {
+        e.Query() = new_id[e.Query()];
+        e.Location() = new_location_id[e.Location()];
+      }
+    }
+    std::map<QType, QType> renumbered;
+    for (const auto& kv : *query2group) {
+      renumbered[new_id[kv.first]] = new_id[kv.second];
+    }
+    query2group->swap(renumbered);
+  }
+
+  // Only the ParallelMatcher uses several threads.
+  template <typename M>
+  static bool SetMatcherThreads(M*, size_t) { return false; }
+
+  template <class S>
+  static bool SetMatcherThreads(
+      ParallelMatcher<RefEvent, HypEvent, S>* matcher, size_t num_threads) {
+    matcher->SetNumThreads(num_threads);
+    return true;
+  }
+
+  // Only ConcurrentStringToIntMapper supports vocabularies.
+  template <typename M>
+  static bool SetVocabulary(M*, const FrozenVocabulary*) { return false; }
+
+  template <typename Int>
+  static bool SetVocabulary(ConcurrentStringToIntMapper<Int>* mapper,
+                            const FrozenVocabulary* vocabulary) {
+    return mapper->SetVocabulary(vocabulary);
+  }
+
+  template <typename M>
+  static bool SaveVocabulary(const M*, const std::string&) {
+    std::cerr << "WARN: The query mapper does not support vocabularies, "
+              << "option --save_vocabulary is ignored." << std::endl;
+    return true;
+  }
+
+  template <typename Int>
+  static bool SaveVocabulary(const ConcurrentStringToIntMapper<Int>* mapper,
+                             const std::string& filename) {
+    const std::vector<std::string> strings = mapper->Strings();
+    if (!FrozenVocabulary::Write(strings, filename)) return false;
+    std::cerr << "INFO: " << strings.size() << " strings were saved to "
+              << "vocabulary \"" << filename << "\"" << std::endl;
+    return true;
+  }
+
+  static void SortHypotheses(const std::string& sort_criterion,
+                             std::vector<HypEvent>* hyp_events) {
+    if (sort_criterion == "desc") {
+      // Sort hypotheses in descending order of their score.
+      std::sort(hyp_events->begin(), hyp_events->end(),
+                std::greater<HypEvent>());
+    } else if (sort_criterion == "asc") {
+      // Sort hypotheses in ascending order of their score.
+      std::sort(hyp_events->begin(), hyp_events->end(),
+                std::less<HypEvent>());
+    } else if (sort_criterion != "none") {
+      // Unknown sorting criterion.
+      std::cerr << "WARN: Ignoring sorting criterion \"" << sort_criterion
+                << "\". Hypotheses won't be sorted." << std::endl;
+    }
+  }
+
+  static void PrintHypothesesReadError(const std::string& hyp_filename) {
+    if (hyp_filename.empty()) {
+      std::cerr << "ERROR: Failed reading from stdin!" << std::endl;
+    } else {
+      std::cerr << "ERROR: Failed reading file \"" << hyp_filename << "\"!"
+                << std::endl;
+    }
+  }
+
   RefReader *ref_reader_;
   HypReader *hyp_reader_;
   Matcher *matcher_;
+  MultiThresholdMatcher<RefEvent, HypEvent>* threshold_matcher_;
+  // Matcher used to compute the matches: the main matcher, or the threshold
+  // matcher when --overlap_thresholds is given.
+  kws::matcher::Matcher<RefEvent, HypEvent>* active_matcher_;
   QueryMapper* query_mapper_;
+  QueryMapper* location_mapper_;
+  // The vocabulary uses the mapped file in place.
+  MappedFile vocabulary_file_;
+  FrozenVocabulary vocabulary_;
   std::string description_;
+  EventFilter ref_filter_;
+  EventFilter hyp_filter_;
 };
 
 }  // namespace tools
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "core/Event.h"
+#include "core/IntegerEventSet.h"
+#include "core/ScoredEvent.h"
+#include "mapper/ConcurrentStringToIntMapper.h"
+#include "mapper/ScoredEventMapper.h"
+#include "mapper/StringEventToIntMapper.h"
+#include "matcher/ParallelMatcher.h"
+#include "reader/ParallelTextMapEventReader.h"
+#include "scorer/TrivialScorer.h"
+#include "tools/GenericKwsEvalTool.h"
+
+using kws::core::Event;
+using kws::core::ScoredEvent;
+using kws::matcher::ParallelMatcher;
+using kws::reader::ParallelTextMapEventReader;
+using kws::scorer::TrivialScorer;
+using kws::tools::GenericKwsEvalTool;
+
+typedef Event<int32_t, int32_t> RefEvent;
+typedef ScoredEvent<RefEvent> HypEvent;
+typedef kws::mapper::ConcurrentStringToIntMapper<int32_t> StrMapper;
+typedef kws::mapper::StringEventToIntMapper<int32_t, StrMapper> RefMapper;
+typedef kws::mapper::ScoredEventMapper<RefMapper> HypMapper;
+typedef ParallelTextMapEventReader<RefMapper> RefReader;
+typedef ParallelTextMapEventReader<HypMapper> HypReader;
+typedef TrivialScorer<RefEvent, HypEvent> Scorer;
+
+// ParallelMatcher that records the number of matches known after each
+// batch of hypotheses.
+class RecordingMatcher : public ParallelMatcher<RefEvent, HypEvent, Scorer> {
+ public:
+  RecordingMatcher(Scorer* scorer, size_t num_threads)
+      : ParallelMatcher<RefEvent, HypEvent, Scorer>(scorer, num_threads) {}
+
+  void MatchBatch(const std::vector<HypEvent>& hyps, Result* result)
+      override {
+    ParallelMatcher<RefEvent, HypEvent, Scorer>::MatchBatch(hyps, result);
+    num_matches.push_back(result->size());
+  }
+
+  std::vector<size_t> num_matches;
+};
+
+static void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream fs(path);
+  fs << content;
+}
+
+TEST(GenericKwsEvalTool, StreamedHypothesesAreMatchedAsTheyArrive) {
+  char dir[] = "/tmp/GenericKwsEvalToolTest.XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != nullptr);
+  const std::string ref_path = std::string(dir) + "/refs.txt";
+  const std::string hyp_path = std::string(dir) + "/hyps.txt";
+  // 200 references and 1000 hypotheses, of 10 queries. Each hypothesis has a
+  // different location, thus each one gives exactly one match.
+  std::string refs, hyps;
+  for (int i = 0; i < 1000; ++i) {
+    const std::string event =
+        "q" + std::to_string(i % 10) + " l" + std::to_string(i);
+    if (i < 200) refs += event + "\n";
+    hyps += event + " " + std::to_string((1000 - i) / 1000.0) + "\n";
+  }
+  WriteFile(ref_path, refs);
+  WriteFile(hyp_path, hyps);
+
+  StrMapper query_mapper, location_mapper;
+  RefMapper ref_mapper(&query_mapper, &location_mapper);
+  HypMapper hyp_mapper(&ref_mapper);
+  RefReader ref_reader(&ref_mapper);
+  HypReader hyp_reader(&hyp_mapper);
+  Scorer scorer;
+  // Several threads, as the tool uses by default on multi-core machines.
+  RecordingMatcher matcher(&scorer, 4);
+  GenericKwsEvalTool<RefReader, HypReader, RecordingMatcher, StrMapper> tool(
+      &ref_reader, &hyp_reader, &matcher, &query_mapper);
+  tool.SetLocationMapper(&location_mapper);
+  const char* argv[] = {"GenericKwsEvalToolTest", "--sort", "none",
+                        "--pipeline", "true", "--batch_size", "100",
+                        ref_path.c_str(), hyp_path.c_str()};
+  ASSERT_EQ(0, tool.Main(sizeof(argv) / sizeof(argv[0]), argv));
+  ASSERT_EQ(4, matcher.NumThreads());
+  ASSERT_EQ(10, matcher.num_matches.size());
+  for (size_t b = 0; b < matcher.num_matches.size(); ++b) {
+    EXPECT_EQ(100 * (b + 1), matcher.num_matches[b]) << "Batch " << b;
+  }
+  remove(ref_path.c_str());
+  remove(hyp_path.c_str());
+  rmdir(dir);
+}
@@ -1,17 +1,19 @@
-#include "core/DocumentBoundingBox.h"
+#include "core/DocumentIdBoundingBox.h"
 #include "core/DocumentBoundingBoxEventSet.h"
 #include "core/ScoredEvent.h"
 #include "core/ShapedEvent.h"
-#include "matcher/SimpleMatcher.h"
-#include "reader/PlainTextReader.h"
+#include "matcher/MultiThresholdMatcher.h"
+#include "matcher/ParallelMatcher.h"
+#include "reader/AutoFormatReader.h"
 #include "scorer/IntersectionOverHypothesisAreaScorer.h"
 #include "tools/GenericKwsEvalTool.h"
 
-using kws::core::DocumentBoundingBox;
+using kws::core::DocumentIdBoundingBox;
 using kws::core::ShapedEvent;
 using kws::core::ScoredEvent;
-using kws::matcher::SimpleMatcher;
-using kws::reader::PlainTextReader;
+using kws::matcher::MultiThresholdMatcher;
+using kws::matcher::ParallelMatcher;
+using kws::reader::AutoFormatReader;
 using kws::scorer::IntersectionOverHypothesisAreaScorer;
 using kws::tools::GenericKwsEvalTool;
 using kws::mapper::IdentityMapper;
@@ -20,22 +22,27 @@ int main(int argc, const char **argv) {
   const std::string description =
       "  Official evaluation tool for ICDAR2017 H-KWS Competition.";
 
-  typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+  typedef ShapedEvent<std::string, DocumentIdBoundingBox<uint32_t>> RefEvent;
   typedef ScoredEvent<RefEvent> HypEvent;
-  typedef PlainTextReader<RefEvent> RefReader;
-  typedef PlainTextReader<HypEvent> HypReader;
-  typedef SimpleMatcher<RefEvent, HypEvent> Matcher;
+  typedef AutoFormatReader<RefEvent> RefReader;
+  typedef AutoFormatReader<HypEvent> HypReader;
+  // The scorer type is given to the matcher, so that it is not called
+  // through the virtual Scorer interface.
+  typedef IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> Scorer;
+  typedef ParallelMatcher<RefEvent, HypEvent, Scorer> Matcher;
   typedef IdentityMapper<std::string> StrMapper;
 
   RefReader ref_reader;
   HypReader hyp_reader;
 
-  IntersectionOverHypothesisAreaScorer<RefEvent, HypEvent> scorer(0.5);
+  Scorer scorer(0.5);
   Matcher matcher(&scorer);
+  MultiThresholdMatcher<RefEvent, HypEvent> threshold_matcher(&scorer);
 
   StrMapper query_mapper;
   GenericKwsEvalTool<RefReader, HypReader, Matcher, StrMapper> tool(
       &ref_reader, &hyp_reader, &matcher, &query_mapper, description);
+  tool.SetThresholdMatcher(&threshold_matcher);
 
   return tool.Main(argc, argv);
 }
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cmd/Parser.h"
+#include "core/DocumentBoundingBox.h"
+#include "core/ScoredEvent.h"
+#include "core/ShapedEvent.h"
+#include "reader/AutoFormatReader.h"
+#include "reader/BinaryEventFormat.h"
+
+using kws::cmd::Parser;
+using kws::core::DocumentBoundingBox;
+using kws::core::ScoredEvent;
+using kws::core::ShapedEvent;
+using kws::reader::AutoFormatReader;
+using kws::reader::WriteBinaryEvents;
+
+template <typename E>
+int Convert(const std::string& input, const std::string& output,
+            const std::string& output_format) {
+  AutoFormatReader<E> reader;
+  std::vector<E> events;
+  if (!reader.Read(input, &events)) {
+    std::cerr << "ERROR: Failed reading file \"" << input << "\"!"
+              << std::endl;
+    return 1;
+  }
+  std::cerr << "INFO: Number of events read = " << events.size() << std::endl;
+  bool ok = false;
+  if (output_format == "binary") {
+    ok = WriteBinaryEvents(events, output);
+  } else if (output_format == "text") {
+    std::ofstream fs(output, std::ios_base::out);
+    for (const auto& e : events) { fs << e << std::endl; }
+    fs.close();
+    ok = !fs.fail();
+  } else {
+    std::cerr << "ERROR: Unknown output format \"" << output_format << "\"!"
+              << std::endl;
+    return 1;
+  }
+  if (!ok) {
+    std::cerr << "ERROR: Failed writing file \"" << output << "\"!"
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, const char **argv) {
+  const std::string description =
+      "  Convert ICDAR2017 KWS reference or hypothesis files between the "
+      "plain text format and the binary columnar format.\n"
+      "  The format of the input file is detected automatically.";
+
+  typedef ShapedEvent<std::string, DocumentBoundingBox<uint32_t>> RefEvent;
+  typedef ScoredEvent<RefEvent> HypEvent;
+
+  std::string input_filename;
+  std::string output_filename;
+  std::string output_format = "binary";
+  bool scored = false;
+
+  Parser cmd_parser(argv[0], description);
+  cmd_parser.RegisterOption(
+      "scored",
+      "Events have a score (i.e. the input contains hypotheses).",
+      &scored);
+  cmd_parser.RegisterOption(
+      "output_format",
+      "Format of the output file. Values: \"binary\", \"text\"",
+      &output_format);
+  cmd_parser.RegisterArgument(
+      "input", "Input file containing the events.", &input_filename);
+  cmd_parser.RegisterArgument(
+      "output", "Output file.", &output_filename);
+  if (!cmd_parser.Parse(argc, argv)) {
+    std::cerr << std::endl << cmd_parser.Help() << std::endl;
+    return 1;
+  }
+
+  return scored
+      ? Convert<HypEvent>(input_filename, output_filename, output_format)
+      : Convert<RefEvent>(input_filename, output_filename, output_format);
+}
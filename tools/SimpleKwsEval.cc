@@ -1,15 +1,17 @@
+#include "core/IntegerEventSet.h"
 #include "core/ScoredEvent.h"
-#include "matcher/SimpleMatcher.h"
-#include "reader/PlainTextMapEventReader.h"
+#include "matcher/ParallelMatcher.h"
+#include "reader/ParallelTextMapEventReader.h"
 #include "scorer/TrivialScorer.h"
 #include "tools/GenericKwsEvalTool.h"
+#include "mapper/ConcurrentStringToIntMapper.h"
 #include "mapper/StringEventToIntMapper.h"
 #include "mapper/ScoredEventMapper.h"
 
 using kws::core::Event;
 using kws::core::ScoredEvent;
-using kws::matcher::SimpleMatcher;
-using kws::reader::PlainTextMapEventReader;
+using kws::matcher::ParallelMatcher;
+using kws::reader::ParallelTextMapEventReader;
 using kws::scorer::TrivialScorer;
 using kws::tools::GenericKwsEvalTool;
 
@@ -20,29 +22,33 @@ int main(int argc, const char **argv) {
   typedef Event<int32_t, int32_t> RefEvent;
   typedef ScoredEvent<RefEvent> HypEvent;
 
-  typedef kws::mapper::StringToIntMapper<int32_t> StrMapper;
-  typedef kws::mapper::StringEventToIntMapper<int32_t> RefMapper;
+  // References and hypotheses can be parsed concurrently.
+  typedef kws::mapper::ConcurrentStringToIntMapper<int32_t> StrMapper;
+  typedef kws::mapper::StringEventToIntMapper<int32_t, StrMapper> RefMapper;
   typedef kws::mapper::ScoredEventMapper<RefMapper> HypMapper;
 
-  typedef PlainTextMapEventReader<RefMapper> RefReader;
-  typedef PlainTextMapEventReader<HypMapper> HypReader;
-  typedef SimpleMatcher<RefEvent, HypEvent> Matcher;
+  typedef ParallelTextMapEventReader<RefMapper> RefReader;
+  typedef ParallelTextMapEventReader<HypMapper> HypReader;
+  typedef TrivialScorer<RefEvent, HypEvent> Scorer;
+  typedef ParallelMatcher<RefEvent, HypEvent, Scorer> Matcher;
 
-  StrMapper str_mapper;
-  RefMapper ref_mapper(&str_mapper);
+  // Queries and locations have separate (dense) id spaces.
+  StrMapper query_mapper, location_mapper;
+  RefMapper ref_mapper(&query_mapper, &location_mapper);
   HypMapper hyp_mapper(&ref_mapper);
 
   RefReader ref_reader(&ref_mapper);
   HypReader hyp_reader(&hyp_mapper);
 
-  TrivialScorer<RefEvent, HypEvent> scorer;
+  Scorer scorer;
   Matcher matcher(&scorer);
 
   GenericKwsEvalTool<RefReader, HypReader, Matcher, StrMapper> tool(
       &ref_reader,
       &hyp_reader,
       &matcher,
-      &str_mapper,
+      &query_mapper,
       description);
+  tool.SetLocationMapper(&location_mapper);
   return tool.Main(argc, argv);
 }